@@ -17,11 +17,18 @@
 #include <bitset>
 
 #include <boost/config.hpp>
+#include <boost/cstdint.hpp>
 #include <boost/mpl/vector.hpp>
 #include <boost/mpl/size.hpp>
 
 #include <boost/bloom_filter/detail/apply_hash.hpp>
+#include <boost/bloom_filter/detail/batch.hpp>
+#include <boost/bloom_filter/detail/filter_header.hpp>
+#include <boost/bloom_filter/detail/hash_digest.hpp>
+#include <boost/bloom_filter/detail/population.hpp>
 #include <boost/bloom_filter/hash/default.hpp>
+#include <boost/bloom_filter/reduction.hpp>
+#include <boost/bloom_filter/storage.hpp>
 
 #ifndef BOOST_NO_0X_HDR_INITIALIZER_LIST
 #include <initializer_list>
@@ -31,19 +38,23 @@ namespace boost {
   namespace bloom_filters {
     template <typename T,
 	      size_t Size,
-	      class HashFunctions = mpl::vector<boost_hash<T> > >
+	      class HashFunctions = mpl::vector<boost_hash<T> >,
+	      class Reduction = typename default_reduction<Size>::type,
+	      class Storage = inline_storage>
     class basic_bloom_filter {
     public:
       typedef T value_type;
       typedef T key_type;
       typedef std::bitset<Size> bitset_type;
       typedef HashFunctions hash_function_type;
+      typedef Reduction reduction_type;
+      typedef Storage storage_policy;
       typedef basic_bloom_filter<T, Size,
-				 HashFunctions> this_type;
+				 HashFunctions, Reduction, Storage> this_type;
 
     private:
-      typedef detail::apply_hash<mpl::size<HashFunctions>::value - 1,
-				 this_type> apply_hash_type;
+      typedef typename detail::select_apply_hash<
+	HashFunctions, this_type>::type apply_hash_type;
 
     public:
       basic_bloom_filter() {}
@@ -68,20 +79,18 @@ namespace boost {
       }
 
       static BOOST_CONSTEXPR size_t num_hash_functions() {
-        return mpl::size<HashFunctions>::value;
+        return detail::num_hashes<HashFunctions>::value;
       };
 
+      //? estimated from count(), so as cheap to ask
       double false_positive_rate() const {
-        const double n = static_cast<double>(this->bits.count());
-        static const double k = static_cast<double>(num_hash_functions());
-        static const double m = static_cast<double>(Size);
-        static const double e =
-	  2.718281828459045235360287471352662497757247093699959574966;
-        return std::pow(1 - std::pow(e, -k * n / m), k);
+	return detail::estimated_fpr(this->count(), Size,
+				     num_hash_functions());
       };
 
+      //? the number of bits set; kept as keys go in, so free to ask
       size_t count() const {
-        return this->bits.count();
+        return this->population();
       };
 
       bool empty() const {
@@ -91,11 +100,11 @@ namespace boost {
       const bitset_type&
       data() const
       {
-	return this->bits;
+	return this->bits();
       }
 
       void insert(const T& t) {
-        apply_hash_type::insert(t, bits);
+        this->population() += apply_hash_type::insert(t, bits());
       }
 
       template <typename InputIterator>
@@ -106,83 +115,180 @@ namespace boost {
       }
 
       bool probably_contains(const T& t) const {
-        return apply_hash_type::contains(t, bits);
+        return apply_hash_type::contains(t, bits());
+      }
+
+      //* pre-hashed ops
+      //? the unreduced hash values of a key. A digest can be passed to
+      //? insert_hash() and probably_contains_hash() of any filter with
+      //? the same key type and hashing, whatever its size, so a key
+      //? probed against many filters is hashed only once.
+      typedef detail::hash_digest<apply_hash_type::num_positions> digest_type;
+
+      static digest_type hash_key(const T& t) {
+	digest_type digest;
+	apply_hash_type::hashes(t, digest.values);
+	return digest;
+      }
+
+      void insert_hash(const digest_type& digest) {
+	this->population() +=
+	  detail::bitset_insert_digest<reduction_type>(digest, bits());
+      }
+
+      bool probably_contains_hash(const digest_type& digest) const {
+	return detail::bitset_contains_digest<reduction_type>(digest, bits());
+      }
+
+      //? inserts every key in [start, end). Same result as
+      //? insert(start, end), but the probes of a group of keys are
+      //? prefetched together so their cache misses overlap.
+      template <typename InputIterator>
+      void insert_batch(const InputIterator start, const InputIterator end) {
+	this->population() +=
+	  detail::bitset_insert_batch<apply_hash_type>(start, end, bits());
+      }
+
+      //? tests every key in [start, end). Bit i % 64 of out[i / 64] is
+      //? set if the i-th key is probably contained, so out must have
+      //? room for (std::distance(start, end) + 63) / 64 words. Returns
+      //? the number of keys that are probably contained.
+      template <typename InputIterator>
+      size_t probably_contains_batch(const InputIterator start,
+				     const InputIterator end,
+				     boost::uint64_t *const out) const {
+	return detail::bitset_contains_batch<apply_hash_type>(start, end,
+							      bits(), out);
       }
 
       void clear() {
-        this->bits.reset();
+        this->bits().reset();
+	this->population() = 0;
       }
 
       void swap(basic_bloom_filter& other) {
-	basic_bloom_filter tmp = other;
-	other = *this;
-	*this = tmp;
+	this->storage.swap(other.storage);
       }
 
       basic_bloom_filter& operator|=(const basic_bloom_filter& rhs) {
-        this->bits |= rhs.bits;
+        this->bits() |= rhs.bits();
+	this->recount();
         return *this;
       }
 
       basic_bloom_filter& operator&=(const basic_bloom_filter& rhs) {
-        this->bits &= rhs.bits;
+        this->bits() &= rhs.bits();
+	this->recount();
         return *this;
       }
 
-      template<class _T, size_t _Size, class _HashFunctions>
+      template<class _T, size_t _Size, class _HashFunctions,
+	       class _Reduction, class _Storage>
       friend bool
-      operator==(const basic_bloom_filter<_T, _Size, _HashFunctions>&,
-		 const basic_bloom_filter<_T, _Size, _HashFunctions>&);
+      operator==(const basic_bloom_filter<_T, _Size, _HashFunctions,
+					  _Reduction, _Storage>&,
+		 const basic_bloom_filter<_T, _Size, _HashFunctions,
+					  _Reduction, _Storage>&);
 
-      template<class _T, size_t _Size, class _HashFunctions>
+      template<class _T, size_t _Size, class _HashFunctions,
+	       class _Reduction, class _Storage>
       friend bool
-      operator!=(const basic_bloom_filter<_T, _Size, _HashFunctions>&,
-		 const basic_bloom_filter<_T, _Size, _HashFunctions>&);
+      operator!=(const basic_bloom_filter<_T, _Size, _HashFunctions,
+					  _Reduction, _Storage>&,
+		 const basic_bloom_filter<_T, _Size, _HashFunctions,
+					  _Reduction, _Storage>&);
       
     private:
-      bitset_type bits;
+      typedef typename Storage::template apply<
+	detail::counted<bitset_type> >::type storage_type;
+
+      bitset_type& bits() { return this->storage.get().bits; }
+      const bitset_type& bits() const { return this->storage.get().bits; }
+
+      size_t& population() { return this->storage.get().population; }
+      size_t population() const { return this->storage.get().population; }
+
+      //* serialization
+      friend struct detail::filter_access;
+
+      detail::filter_header header() const
+      {
+	return detail::make_header<HashFunctions, Reduction, mpl::vector<> >(
+	  detail::hashed_bits, 1, 0, num_hash_functions(), Size);
+      }
+
+      void reshape(const detail::filter_header& saved, bool)
+      {
+	detail::check_header(saved, this->header());
+      }
+
+      bitset_type& block_storage() { return this->bits(); }
+
+      void recount()
+      {
+	this->population() = detail::count_bits(this->bits());
+      }
+
+      storage_type storage;
     };
 
-    template<class _T, size_t _Size, class _HashFunctions>
+    template<class _T, size_t _Size, class _HashFunctions,
+	     class _Reduction, class _Storage>
     bool
-    operator==(const basic_bloom_filter<_T, _Size, _HashFunctions>& lhs,
-	       const basic_bloom_filter<_T, _Size, _HashFunctions>& rhs)
+    operator==(const basic_bloom_filter<_T, _Size, _HashFunctions,
+					_Reduction, _Storage>& lhs,
+	       const basic_bloom_filter<_T, _Size, _HashFunctions,
+					_Reduction, _Storage>& rhs)
     {
-      return (lhs.bits == rhs.bits);
+      return (lhs.bits() == rhs.bits());
     }
 
-    template<class _T, size_t _Size, class _HashFunctions>
+    template<class _T, size_t _Size, class _HashFunctions,
+	     class _Reduction, class _Storage>
     bool
-    operator!=(const basic_bloom_filter<_T, _Size, _HashFunctions>& lhs,
-	       const basic_bloom_filter<_T, _Size, _HashFunctions>& rhs)
+    operator!=(const basic_bloom_filter<_T, _Size, _HashFunctions,
+					_Reduction, _Storage>& lhs,
+	       const basic_bloom_filter<_T, _Size, _HashFunctions,
+					_Reduction, _Storage>& rhs)
     {
       return !(lhs == rhs);
     }
 
-    template<class _T, size_t _Size, class _HashFunctions>
-    basic_bloom_filter<_T, _Size, _HashFunctions>
-    operator|(const basic_bloom_filter<_T, _Size, _HashFunctions>& lhs,
-	      const basic_bloom_filter<_T, _Size, _HashFunctions>& rhs)
+    template<class _T, size_t _Size, class _HashFunctions,
+	     class _Reduction, class _Storage>
+    basic_bloom_filter<_T, _Size, _HashFunctions, _Reduction, _Storage>
+    operator|(const basic_bloom_filter<_T, _Size, _HashFunctions,
+				       _Reduction, _Storage>& lhs,
+	      const basic_bloom_filter<_T, _Size, _HashFunctions,
+				       _Reduction, _Storage>& rhs)
     {
-      basic_bloom_filter<_T, _Size, _HashFunctions> ret(lhs);
+      basic_bloom_filter<_T, _Size, _HashFunctions,
+			 _Reduction, _Storage> ret(lhs);
       ret |= rhs;
       return ret;
     }
 
-    template<class _T, size_t _Size, class _HashFunctions>
-    basic_bloom_filter<_T, _Size, _HashFunctions>
-    operator&(const basic_bloom_filter<_T, _Size, _HashFunctions>& lhs,
-	      const basic_bloom_filter<_T, _Size, _HashFunctions>& rhs)
+    template<class _T, size_t _Size, class _HashFunctions,
+	     class _Reduction, class _Storage>
+    basic_bloom_filter<_T, _Size, _HashFunctions, _Reduction, _Storage>
+    operator&(const basic_bloom_filter<_T, _Size, _HashFunctions,
+				       _Reduction, _Storage>& lhs,
+	      const basic_bloom_filter<_T, _Size, _HashFunctions,
+				       _Reduction, _Storage>& rhs)
     {
-      basic_bloom_filter<_T, _Size, _HashFunctions> ret(lhs);
+      basic_bloom_filter<_T, _Size, _HashFunctions,
+			 _Reduction, _Storage> ret(lhs);
       ret &= rhs;
       return ret;
     }
 
-    template<class _T, size_t _Size, class _HashFunctions>
+    template<class _T, size_t _Size, class _HashFunctions,
+	     class _Reduction, class _Storage>
     void
-    swap(basic_bloom_filter<_T, _Size, _HashFunctions>& lhs,
-	 basic_bloom_filter<_T, _Size, _HashFunctions>& rhs)
+    swap(basic_bloom_filter<_T, _Size, _HashFunctions,
+			    _Reduction, _Storage>& lhs,
+	 basic_bloom_filter<_T, _Size, _HashFunctions,
+			    _Reduction, _Storage>& rhs)
     {
       lhs.swap(rhs);
     }
@@ -0,0 +1,467 @@
+//////////////////////////////////////////////////////////////////////////////
+//
+// (C) Copyright Alejandro Cabrera 2011.
+// Distributed under the Boost
+// Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or
+// copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// See http://www.boost.org/libs/bloom_filter for documentation.
+//
+//////////////////////////////////////////////////////////////////////////////
+
+#ifndef BOOST_BLOOM_FILTER_BLOCKED_BLOOM_FILTER_HPP
+#define BOOST_BLOOM_FILTER_BLOCKED_BLOOM_FILTER_HPP 1
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+#include <boost/config.hpp>
+#include <boost/cstdint.hpp>
+#include <boost/align/aligned_allocator.hpp>
+
+#include <boost/static_assert.hpp>
+#include <boost/type_traits/is_integral.hpp>
+#include <boost/type_traits/is_unsigned.hpp>
+
+#include <boost/bloom_filter/detail/blocked_apply_hash.hpp>
+#include <boost/bloom_filter/detail/hash_digest.hpp>
+#include <boost/bloom_filter/detail/exceptions.hpp>
+#include <boost/bloom_filter/detail/filter_header.hpp>
+#include <boost/bloom_filter/detail/population.hpp>
+#include <boost/bloom_filter/hash/murmurhash3.hpp>
+
+namespace boost {
+  namespace bloom_filters {
+
+    //! A Bloom filter that keeps all probes of a key inside one
+    //! cache line. A lookup costs at most one cache miss, at the price of
+    //! a slightly higher false positive rate than a classic filter of the
+    //! same size.
+    template <typename T,
+	      size_t HashValues = 4,
+	      class HashFunction = murmurhash3<T>,
+	      typename Block = size_t,
+	      typename Allocator = alignment::aligned_allocator<Block, 64> >
+    class blocked_bloom_filter {
+
+      // Block needs to be an integral type
+      BOOST_STATIC_ASSERT( boost::is_integral<Block>::value == true);
+
+      // Block needs to be an unsigned type
+      BOOST_STATIC_ASSERT( boost::is_unsigned<Block>::value == true);
+
+      // a cache line has to be made up of whole Blocks
+      BOOST_STATIC_ASSERT( (64 % sizeof(Block)) == 0);
+
+      // there are only so many distinct bits in a cache line
+      BOOST_STATIC_ASSERT( HashValues > 0 && HashValues <= 512);
+
+    public:
+      typedef T value_type;
+      typedef T key_type;
+      typedef HashFunction hash_function_type;
+      typedef Block block_type;
+      typedef Allocator allocator_type;
+      typedef blocked_bloom_filter<T, HashValues, HashFunction,
+				   Block, Allocator> this_type;
+
+      typedef std::vector<Block, Allocator> bucket_type;
+      typedef typename bucket_type::iterator bucket_iterator;
+      typedef typename bucket_type::const_iterator bucket_const_iterator;
+
+      static const size_t default_num_blocks = 1;
+
+    private:
+      typedef detail::blocked_apply_hash<HashValues,
+					 this_type> apply_hash_type;
+
+      static size_t bucket_size(const size_t requested_bits) {
+	const size_t blocks =
+	  (requested_bits + block_bits() - 1) / block_bits();
+	return (blocks == 0 ? 1 : blocks) * words_per_block();
+      }
+
+    public:
+      //* constructors
+      blocked_bloom_filter()
+	: bits(default_num_blocks * words_per_block()),
+	  population(0)
+      {
+      }
+
+      //? bit_capacity is rounded up to a whole number of blocks
+      explicit blocked_bloom_filter(const size_t bit_capacity)
+	: bits(bucket_size(bit_capacity)),
+	  population(0)
+      {
+      }
+
+      template <typename InputIterator>
+      blocked_bloom_filter(const InputIterator start,
+			   const InputIterator end)
+	: bits(bucket_size(std::distance(start, end) * 4)),
+	  population(0)
+      {
+	for (InputIterator i = start; i != end; ++i)
+	  this->insert(*i);
+      }
+
+      blocked_bloom_filter(const blocked_bloom_filter& other)
+	: bits(other.bits),
+	  population(other.population)
+      {
+      }
+
+#ifndef BOOST_NO_CXX11_RVALUE_REFERENCES
+      //? takes the blocks of other, leaving it with none
+      blocked_bloom_filter(blocked_bloom_filter&& other) BOOST_NOEXCEPT
+	: population(0)
+      {
+	this->swap(other);
+      }
+#endif
+
+      //* meta functions
+      static BOOST_CONSTEXPR size_t block_bits()
+      {
+	return 512;
+      }
+
+      static BOOST_CONSTEXPR size_t block_bits_log2()
+      {
+	return 9;
+      }
+
+      static BOOST_CONSTEXPR size_t words_per_block()
+      {
+	return block_bits() / (sizeof(block_type) * 8);
+      }
+
+      static size_t blocks_in(const bucket_type& slots)
+      {
+	return slots.size() / words_per_block();
+      }
+
+      static BOOST_CONSTEXPR size_t num_hash_functions()
+      {
+	return HashValues;
+      }
+
+      size_t num_blocks() const
+      {
+	return blocks_in(this->bits);
+      }
+
+      size_t bit_capacity() const
+      {
+	return this->bits.size() * sizeof(block_type) * 8;
+      }
+
+      //? the estimate of a classic filter with the bits set now. Blocks fill unevenly, so the blocked filter's own
+      //? rate is somewhat higher; see the class comment.
+      double false_positive_rate() const
+      {
+	return detail::estimated_fpr(this->count(), this->bit_capacity(),
+				     HashValues);
+      }
+
+      //? the number of bits set; kept as keys go in, so free to ask
+      size_t count() const
+      {
+	return this->population;
+      }
+
+      bool empty() const
+      {
+	return this->count() == 0;
+      }
+
+      const bucket_type&
+      data() const
+      {
+	return this->bits;
+      }
+
+      //* core ops
+      void insert(const T& t)
+      {
+	this->population += apply_hash_type::insert(t, this->bits);
+      }
+
+      template <typename InputIterator>
+      void insert(const InputIterator start, const InputIterator end)
+      {
+	for (InputIterator i = start; i != end; ++i) {
+	  this->insert(*i);
+	}
+      }
+
+      //? inserts every key in [start, end). Same result as
+      //? insert(start, end), but the blocks of a group of keys are
+      //? prefetched together so their cache misses overlap.
+      template <typename InputIterator>
+      void insert_batch(const InputIterator start, const InputIterator end)
+      {
+	this->population +=
+	  apply_hash_type::insert_batch(start, end, this->bits);
+      }
+
+      bool probably_contains(const T& t) const
+      {
+	return apply_hash_type::contains(t, this->bits);
+      }
+
+      //? tests every key in [start, end). Bit i % 64 of out[i / 64] is
+      //? set if the i-th key is probably contained, so out must have
+      //? room for (std::distance(start, end) + 63) / 64 words. Returns
+      //? the number of keys that are probably contained.
+      template <typename InputIterator>
+      size_t probably_contains_batch(const InputIterator start,
+				     const InputIterator end,
+				     boost::uint64_t *const out) const
+      {
+	return apply_hash_type::contains_batch(start, end, this->bits, out);
+      }
+
+      //* pre-hashed ops
+      //? the one hash a key's block and probes come from. A digest can
+      //? be passed to insert_hash() and probably_contains_hash() of any
+      //? blocked filter with the same key type and hashing, whatever
+      //? its size, so a key probed against many filters is hashed once.
+      typedef detail::hash_digest<1> digest_type;
+
+      static digest_type hash_key(const T& t)
+      {
+	const digest_type digest = {{apply_hash_type::key_hash(t)}};
+	return digest;
+      }
+
+      void insert_hash(const digest_type& digest)
+      {
+	this->population +=
+	  apply_hash_type::insert_hashed(digest.values[0], this->bits);
+      }
+
+      bool probably_contains_hash(const digest_type& digest) const
+      {
+	return apply_hash_type::contains_hashed(digest.values[0], this->bits);
+      }
+
+      //* auxiliary ops
+      void clear()
+      {
+	for (bucket_iterator i = bits.begin(), end = bits.end();
+	     i != end; ++i)
+	  *i = 0;
+	this->population = 0;
+      }
+
+      blocked_bloom_filter& operator=(const blocked_bloom_filter& rhs)
+      {
+	this->bits = rhs.bits;
+	this->population = rhs.population;
+	return *this;
+      }
+
+#ifndef BOOST_NO_CXX11_RVALUE_REFERENCES
+      //? takes the blocks of rhs, leaving it with none
+      blocked_bloom_filter& operator=(blocked_bloom_filter&& rhs)
+	BOOST_NOEXCEPT
+      {
+	bucket_type released;
+	released.swap(this->bits);
+	this->bits.swap(rhs.bits);
+	this->population = rhs.population;
+	rhs.population = 0;
+	return *this;
+      }
+#endif
+
+      //? exchanges the blocks of the two filters; no blocks are copied
+      void swap(blocked_bloom_filter& other) BOOST_NOEXCEPT
+      {
+	this->bits.swap(other.bits);
+	std::swap(this->population, other.population);
+      }
+
+      void resize(const size_t new_capacity)
+      {
+	bits.clear();
+	bits.resize(bucket_size(new_capacity));
+	this->population = 0;
+      }
+
+      //* pairwise ops
+      blocked_bloom_filter&
+      operator|=(const blocked_bloom_filter& rhs)
+      {
+	if (this->bit_capacity() != rhs.bit_capacity())
+	  throw detail::incompatible_size_exception();
+
+	for (size_t i = 0; i < this->bits.size(); ++i)
+	  this->bits[i] |= rhs.bits[i];
+
+	this->recount();
+	return *this;
+      }
+
+      blocked_bloom_filter&
+      operator&=(const blocked_bloom_filter& rhs)
+      {
+	if (this->bit_capacity() != rhs.bit_capacity())
+	  throw detail::incompatible_size_exception();
+
+	for (size_t i = 0; i < this->bits.size(); ++i)
+	  this->bits[i] &= rhs.bits[i];
+
+	this->recount();
+	return *this;
+      }
+
+      template <typename _T, size_t _HashValues, class _HashFunction,
+		typename _Block, typename _Allocator>
+      friend bool
+      operator==(const blocked_bloom_filter<_T, _HashValues, _HashFunction,
+					    _Block, _Allocator>&,
+		 const blocked_bloom_filter<_T, _HashValues, _HashFunction,
+					    _Block, _Allocator>&);
+
+    private:
+      //* serialization
+      friend struct detail::filter_access;
+
+      static detail::filter_header header_for(const size_t bit_capacity)
+      {
+	return detail::make_header<HashFunction, void, mpl::vector<> >(
+	  detail::blocked_bits, sizeof(Block), 0, HashValues, bit_capacity);
+      }
+
+      detail::filter_header header() const
+      {
+	return header_for(this->bit_capacity());
+      }
+
+      //? the saved capacity has to be a whole number of blocks
+      void reshape(const detail::filter_header& saved, bool)
+      {
+	const size_t capacity = static_cast<size_t>(saved.capacity);
+	if (capacity == 0 || capacity % block_bits() != 0)
+	  throw detail::serialization_exception();
+	detail::check_header(saved, header_for(capacity));
+
+	if (this->bit_capacity() != capacity) {
+	  bucket_type fresh(bucket_size(capacity));
+	  this->bits.swap(fresh);
+	}
+      }
+
+      bucket_type& block_storage() { return this->bits; }
+
+      void recount()
+      {
+	this->population = this->bits.empty() ? 0 :
+	  detail::popcount(&this->bits[0], &this->bits[0] + this->bits.size());
+      }
+
+      bucket_type bits;
+      size_t population;
+    };
+
+    template <typename T, size_t HashValues, class HashFunction,
+	      typename Block, typename Allocator>
+    blocked_bloom_filter<T, HashValues, HashFunction, Block, Allocator>
+    operator|(const blocked_bloom_filter<T, HashValues, HashFunction,
+					 Block, Allocator>& lhs,
+	      const blocked_bloom_filter<T, HashValues, HashFunction,
+					 Block, Allocator>& rhs)
+    {
+      blocked_bloom_filter<T, HashValues, HashFunction,
+			   Block, Allocator> result(lhs);
+
+      result |= rhs;
+      return result;
+    }
+
+    template <typename T, size_t HashValues, class HashFunction,
+	      typename Block, typename Allocator>
+    blocked_bloom_filter<T, HashValues, HashFunction, Block, Allocator>
+    operator&(const blocked_bloom_filter<T, HashValues, HashFunction,
+					 Block, Allocator>& lhs,
+	      const blocked_bloom_filter<T, HashValues, HashFunction,
+					 Block, Allocator>& rhs)
+    {
+      blocked_bloom_filter<T, HashValues, HashFunction,
+			   Block, Allocator> result(lhs);
+
+      result &= rhs;
+      return result;
+    }
+
+#ifndef BOOST_NO_CXX11_RVALUE_REFERENCES
+    //? the result takes the blocks of lhs instead of copying them, so
+    //? a | b | c copies only once
+    template <typename T, size_t HashValues, class HashFunction,
+	      typename Block, typename Allocator>
+    blocked_bloom_filter<T, HashValues, HashFunction, Block, Allocator>
+    operator|(blocked_bloom_filter<T, HashValues, HashFunction,
+				   Block, Allocator>&& lhs,
+	      const blocked_bloom_filter<T, HashValues, HashFunction,
+					 Block, Allocator>& rhs)
+    {
+      lhs |= rhs;
+      return std::move(lhs);
+    }
+
+    template <typename T, size_t HashValues, class HashFunction,
+	      typename Block, typename Allocator>
+    blocked_bloom_filter<T, HashValues, HashFunction, Block, Allocator>
+    operator&(blocked_bloom_filter<T, HashValues, HashFunction,
+				   Block, Allocator>&& lhs,
+	      const blocked_bloom_filter<T, HashValues, HashFunction,
+					 Block, Allocator>& rhs)
+    {
+      lhs &= rhs;
+      return std::move(lhs);
+    }
+#endif
+
+    template <typename T, size_t HashValues, class HashFunction,
+	      typename Block, typename Allocator>
+    bool
+    operator==(const blocked_bloom_filter<T, HashValues, HashFunction,
+					  Block, Allocator>& lhs,
+	       const blocked_bloom_filter<T, HashValues, HashFunction,
+					  Block, Allocator>& rhs)
+    {
+      if (lhs.bit_capacity() != rhs.bit_capacity())
+	throw detail::incompatible_size_exception();
+
+      return lhs.bits == rhs.bits;
+    }
+
+    template <typename T, size_t HashValues, class HashFunction,
+	      typename Block, typename Allocator>
+    bool
+    operator!=(const blocked_bloom_filter<T, HashValues, HashFunction,
+					  Block, Allocator>& lhs,
+	       const blocked_bloom_filter<T, HashValues, HashFunction,
+					  Block, Allocator>& rhs)
+    {
+      return !(lhs == rhs);
+    }
+
+    template <typename T, size_t HashValues, class HashFunction,
+	      typename Block, typename Allocator>
+    void
+    swap(blocked_bloom_filter<T, HashValues, HashFunction,
+			      Block, Allocator>& lhs,
+	 blocked_bloom_filter<T, HashValues, HashFunction,
+			      Block, Allocator>& rhs) BOOST_NOEXCEPT
+    {
+      lhs.swap(rhs);
+    }
+  } // namespace bloom_filters
+} // namespace boost
+#endif
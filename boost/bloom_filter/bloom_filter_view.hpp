@@ -0,0 +1,379 @@
+//////////////////////////////////////////////////////////////////////////////
+//
+// (C) Copyright Alejandro Cabrera 2011.
+// Distributed under the Boost
+// Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or
+// copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// See http://www.boost.org/libs/bloom_filter for documentation.
+//
+//////////////////////////////////////////////////////////////////////////////
+
+#ifndef BOOST_BLOOM_FILTER_BLOOM_FILTER_VIEW_HPP
+#define BOOST_BLOOM_FILTER_BLOOM_FILTER_VIEW_HPP 1
+
+#include <cstddef>
+
+#include <boost/config.hpp>
+#include <boost/cstdint.hpp>
+#include <boost/mpl/vector.hpp>
+#include <boost/type_traits/alignment_of.hpp>
+
+#include <boost/bloom_filter/detail/apply_hash.hpp>
+#include <boost/bloom_filter/detail/batch.hpp>
+#include <boost/bloom_filter/detail/bit_span.hpp>
+#include <boost/bloom_filter/detail/exceptions.hpp>
+#include <boost/bloom_filter/detail/filter_header.hpp>
+#include <boost/bloom_filter/detail/hash_digest.hpp>
+#include <boost/bloom_filter/detail/payload.hpp>
+#include <boost/bloom_filter/detail/twohash_apply_hash.hpp>
+#include <boost/bloom_filter/dynamic_bloom_filter.hpp>
+#include <boost/bloom_filter/reduction.hpp>
+#include <boost/bloom_filter/serialization.hpp>
+#include <boost/bloom_filter/twohash_dynamic_basic_bloom_filter.hpp>
+
+/**
+ * Read-only Bloom filters over bits that live somewhere else.
+ *
+ * A view answers probably_contains() straight from blocks it is
+ * given: those of a filter, of a buffer or file save() wrote, or any
+ * the caller laid out as dynamic_bitset does. It never owns, allocates
+ * or copies them, and copying a view copies a pointer, so one set of
+ * bits in shared memory can be probed by any number of views.
+ *
+ * bloom_filter_view hashes and lays out its bits as
+ * dynamic_bloom_filter does, twohash_bloom_filter_view as
+ * twohash_dynamic_basic_bloom_filter does; a view gives the same
+ * answers as the filter with the same parameters would.
+ *
+ *   std::vector<char> image(serialized_size(filter));
+ *   save(filter, &image[0], image.size());
+ *   bloom_filter_view<int> view(filter_image(&image[0], image.size()));
+ *
+ * The blocks have to outlive the view and not move. Changing them
+ * while the view is in use is up to the caller to order.
+ */
+namespace boost {
+  namespace bloom_filters {
+
+    //! the size bytes at data, as save() wrote them
+    struct filter_image {
+      filter_image(const void *const data, const size_t size)
+	: data(data), size(size) {}
+
+      const void *data;
+      size_t size;
+    };
+
+    namespace detail {
+
+      //? the bits of a filter, where they are
+      template <typename Block, typename Bits>
+      const_bit_span<Block> view_bits(const Bits& bits)
+      {
+	const block_span<Block> blocks = span_of(const_cast<Bits&>(bits));
+	return const_bit_span<Block>(blocks.data, bits.size());
+      }
+
+      //? the header of image, which the view checks before taking its
+      //? bits with image_bits
+      inline filter_header image_header(const filter_image& image)
+      {
+	return read_header(static_cast<const unsigned char *>(image.data),
+			   image.size);
+      }
+
+      //? the bits saved in image, where they are. Any Block will do on
+      //? a little-endian machine, so long as the blocks are aligned for
+      //? it; otherwise throws serialization_exception.
+      template <typename Block>
+      const_bit_span<Block> image_bits(const filter_image& image,
+				       const filter_header& saved)
+      {
+	const unsigned char *const payload =
+	  static_cast<const unsigned char *>(image.data) +
+	  encoded_header_size;
+	const size_t num_bits = static_cast<size_t>(saved.capacity);
+	const size_t needed =
+	  const_bit_span<Block>::blocks_for(num_bits) * sizeof(Block);
+
+	if (!native_payload() ||
+	    reinterpret_cast<boost::uintptr_t>(payload) %
+	      alignment_of<Block>::value != 0 ||
+	    padded_payload(saved.payload_bytes) < needed)
+	  throw serialization_exception();
+
+	return const_bit_span<Block>(
+	  reinterpret_cast<const Block *>(payload), num_bits);
+      }
+
+    } // namespace detail
+
+    //! dynamic_bloom_filter, read only, over bits it doesn't own
+    template <typename T,
+	      class HashFunctions = mpl::vector<boost_hash<T> >,
+	      class Block = size_t,
+	      class Reduction = modulo_reduction>
+    class bloom_filter_view {
+    public:
+      typedef T value_type;
+      typedef T key_type;
+      typedef HashFunctions hash_function_type;
+      typedef Block block_type;
+      typedef Reduction reduction_type;
+      typedef detail::const_bit_span<Block> bitset_type;
+      typedef bloom_filter_view<T, HashFunctions,
+				Block, Reduction> this_type;
+
+    private:
+      typedef typename detail::select_apply_hash<
+	HashFunctions, this_type>::type apply_hash_type;
+
+    public:
+      //* constructors
+      bloom_filter_view() {}
+
+      //? the bit_capacity bits in the blocks at blocks
+      bloom_filter_view(const Block *const blocks, const size_t bit_capacity)
+	: bits(blocks, detail::checked_range<Reduction>(bit_capacity)) {}
+
+      //? the bits of filter, for as long as it keeps them
+      template <typename Allocator>
+      explicit bloom_filter_view(
+	const dynamic_bloom_filter<T, HashFunctions,
+				   Block, Allocator, Reduction>& filter)
+	: bits(detail::view_bits<Block>(filter.data())) {}
+
+      //? the bits of the filter save() wrote to image. Throws
+      //? serialization_exception if it isn't a filter this view can
+      //? read in place; see detail::image_bits.
+      explicit bloom_filter_view(const filter_image& image)
+	: bits(bits_of(image)) {}
+
+      //* query functions
+      static BOOST_CONSTEXPR size_t num_hash_functions() {
+        return detail::num_hashes<HashFunctions>::value;
+      }
+
+      size_t count() const {
+        return this->bits.count();
+      }
+
+      size_t bit_capacity() const {
+	return this->bits.size();
+      }
+
+      bool empty() const {
+	return this->count() == 0;
+      }
+
+      const bitset_type&
+      data() const
+      {
+	return this->bits;
+      }
+
+      //* core operations
+      bool probably_contains(const T& t) const {
+	return apply_hash_type::contains(t, bits);
+      }
+
+      //* pre-hashed ops
+      //? digests are those of dynamic_bloom_filter
+      typedef detail::hash_digest<apply_hash_type::num_positions> digest_type;
+
+      static digest_type hash_key(const T& t) {
+	digest_type digest;
+	apply_hash_type::hashes(t, digest.values);
+	return digest;
+      }
+
+      bool probably_contains_hash(const digest_type& digest) const {
+	return detail::bitset_contains_digest<reduction_type>(digest, bits);
+      }
+
+      //? as dynamic_bloom_filter::probably_contains_batch
+      template <typename InputIterator>
+      size_t probably_contains_batch(const InputIterator start,
+				     const InputIterator end,
+				     boost::uint64_t *const out) const {
+	return detail::bitset_contains_batch<apply_hash_type>(start, end,
+							      bits, out);
+      }
+
+    private:
+      static bitset_type bits_of(const filter_image& image) {
+	const detail::filter_header saved = detail::image_header(image);
+	detail::check_header(
+	  saved,
+	  detail::make_header<HashFunctions, Reduction, mpl::vector<> >(
+	    detail::hashed_bits, sizeof(Block), 0, num_hash_functions(), 0));
+	detail::checked_range<Reduction>(static_cast<size_t>(saved.capacity));
+	return detail::image_bits<Block>(image, saved);
+      }
+
+      bitset_type bits;
+    };
+
+    //! twohash_dynamic_basic_bloom_filter, read only, over bits it
+    //! doesn't own
+    template <typename T,
+	      size_t HashValues = 2,
+	      class HashFunction1 = boost_hash<T>,
+	      class HashFunction2 = murmurhash3<T>,
+	      typename ExtensionFunction = detail::square,
+	      typename Block = size_t,
+	      class Reduction = modulo_reduction>
+    class twohash_bloom_filter_view {
+    public:
+      typedef T value_type;
+      typedef T key_type;
+      typedef Block block_type;
+      typedef detail::const_bit_span<Block> bitset_type;
+      typedef HashFunction1 hash_function1_type;
+      typedef HashFunction2 hash_function2_type;
+      typedef ExtensionFunction extension_function_type;
+      typedef Reduction reduction_type;
+      typedef twohash_bloom_filter_view<T, HashValues,
+					HashFunction1, HashFunction2,
+					ExtensionFunction,
+					Block, Reduction> this_type;
+
+    private:
+      typedef detail::twohash_apply_hash<HashValues,
+					 this_type> apply_hash_type;
+
+    public:
+      //* constructors
+      twohash_bloom_filter_view() : hash_values(HashValues) {}
+
+      //? the bit_capacity bits in the blocks at blocks, probed with
+      //? hash_values hash values. Only runtime_hash_values takes
+      //? hash_values, which has to be in [1, max_runtime_hash_values],
+      //? else throws invalid_parameter_exception.
+      twohash_bloom_filter_view(const Block *const blocks,
+				const size_t bit_capacity,
+				const size_t hash_values = HashValues)
+	: bits(blocks, detail::checked_range<Reduction>(bit_capacity)),
+	  hash_values(checked_hash_values(hash_values))
+      {
+      }
+
+      //? the bits of filter, for as long as it keeps them
+      template <size_t ExpectedInsertionCount, typename Allocator>
+      explicit twohash_bloom_filter_view(
+	const twohash_dynamic_basic_bloom_filter<T, HashValues,
+						 ExpectedInsertionCount,
+						 HashFunction1, HashFunction2,
+						 ExtensionFunction,
+						 Block, Allocator,
+						 Reduction>& filter)
+	: bits(detail::view_bits<Block>(filter.data())),
+	  hash_values(filter.num_hash_functions())
+      {
+      }
+
+      //? the bits of the filter save() wrote to image. With
+      //? runtime_hash_values the saved number of hash values is
+      //? taken on. Throws serialization_exception if it isn't a
+      //? filter this view can read in place.
+      explicit twohash_bloom_filter_view(const filter_image& image)
+	: hash_values(HashValues)
+      {
+	const detail::filter_header saved = detail::image_header(image);
+	const size_t k = HashValues == runtime_hash_values ?
+	  static_cast<size_t>(saved.hash_functions) : HashValues;
+	if (k == 0 || k > detail::max_runtime_hash_values)
+	  throw detail::serialization_exception();
+	detail::check_header(
+	  saved,
+	  detail::make_header<HashFunction1, Reduction,
+			      mpl::vector<HashFunction2,
+					  ExtensionFunction> >(
+	    detail::twohash_bits, sizeof(Block), 0, k, 0));
+	detail::checked_range<Reduction>(static_cast<size_t>(saved.capacity));
+
+	this->bits = detail::image_bits<Block>(image, saved);
+	this->hash_values = k;
+      }
+
+      //* meta-ops
+      size_t bit_capacity() const
+      {
+	return bits.size();
+      }
+
+      size_t num_hash_functions() const
+      {
+	return HashValues == runtime_hash_values ? hash_values : HashValues;
+      }
+
+      size_t count() const
+      {
+	return this->bits.count();
+      }
+
+      bool empty() const
+      {
+	return this->count() == 0;
+      }
+
+      const bitset_type&
+      data() const
+      {
+	return this->bits;
+      }
+
+      //* core ops
+      bool probably_contains(const T& t) const
+      {
+	return apply_hash_type::contains(t, this->num_hash_functions(), bits);
+      }
+
+      //* pre-hashed ops
+      //? digests are those of twohash_dynamic_basic_bloom_filter
+      typedef detail::hash_digest<apply_hash_type::num_positions> digest_type;
+
+      static digest_type hash_key(const T& t)
+      {
+	digest_type digest;
+	apply_hash_type::hashes(t, digest.values);
+	return digest;
+      }
+
+      bool probably_contains_hash(const digest_type& digest) const
+      {
+	return detail::bitset_contains_digest<reduction_type>(
+	  digest, bits, this->num_hash_functions());
+      }
+
+      //? as twohash_dynamic_basic_bloom_filter::probably_contains_batch
+      template <typename InputIterator>
+      size_t probably_contains_batch(const InputIterator start,
+				     const InputIterator end,
+				     boost::uint64_t *const out) const
+      {
+	return detail::bitset_contains_batch<apply_hash_type>(
+	  start, end, bits, out, this->num_hash_functions());
+      }
+
+    private:
+      static size_t checked_hash_values(const size_t hash_values)
+      {
+	if (HashValues != runtime_hash_values)
+	  return HashValues;
+
+	if (hash_values == 0 || hash_values > detail::max_runtime_hash_values)
+	  throw detail::invalid_parameter_exception();
+
+	return hash_values;
+      }
+
+      bitset_type bits;
+      size_t hash_values;
+    };
+
+  } // namespace bloom_filters
+} // namespace boost
+#endif
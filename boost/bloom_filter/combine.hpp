@@ -0,0 +1,203 @@
+//////////////////////////////////////////////////////////////////////////////
+//
+// (C) Copyright Alejandro Cabrera 2011.
+// Distributed under the Boost
+// Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or
+// copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// See http://www.boost.org/libs/bloom_filter for documentation.
+//
+//////////////////////////////////////////////////////////////////////////////
+
+#ifndef BOOST_BLOOM_FILTER_COMBINE_HPP
+#define BOOST_BLOOM_FILTER_COMBINE_HPP 1
+
+#include <algorithm>
+#include <iterator>
+#include <vector>
+
+#include <boost/thread/thread.hpp>
+
+#include <boost/bloom_filter/detail/combine.hpp>
+#include <boost/bloom_filter/detail/exceptions.hpp>
+#include <boost/bloom_filter/serialization.hpp>
+
+/**
+ * Union and intersection of large dynamic_bloom_filters and
+ * twohash_dynamic_basic_bloom_filters with a pool of threads, and the
+ * union of any number of filters at once.
+ *
+ * The filters' own operator|=() and operator&=() use the same AVX2 or
+ * AVX-512 kernels from one thread. Here the bytes of the filters are
+ * split into one contiguous range per thread, so each thread streams
+ * through its own part of every filter. union_all() combines a tile of
+ * every input into a tile of the result while that stays in cache, so
+ * each input is read from memory once however many there are. Each
+ * thread counts the bits of its part of the result as it writes it,
+ * so the result isn't read again to count them.
+ *
+ * Needs Boost.Thread. None of the filters may be changed by other
+ * threads until these return.
+ */
+namespace boost {
+  namespace bloom_filters {
+    namespace detail {
+
+      //! combines the sources into the destination, one byte range
+      //! per thread
+      class parallel_combiner {
+      public:
+	parallel_combiner(unsigned char *const dst,
+			  const std::vector<const unsigned char *>& srcs,
+			  const size_t n, const combine_op op)
+	  : dst(dst), srcs(srcs), n(n), op(op) {}
+
+	//? returns the number of bits set in the destination, each
+	//? thread counting its own range as it combines it
+	size_t run(size_t num_threads)
+	{
+	  // each range a whole number of cache lines
+	  const size_t lines = (this->n + 63) / 64;
+	  num_threads = std::max<size_t>(std::min(num_threads, lines), 1);
+	  if (num_threads == 1)
+	    return combine(0, this->n);
+
+	  std::vector<size_t> counts(num_threads);
+	  boost::thread_group threads;
+	  for (size_t t = 0; t < num_threads; ++t) {
+	    const size_t first = std::min(this->n, lines * t / num_threads * 64);
+	    const size_t last =
+	      std::min(this->n, lines * (t + 1) / num_threads * 64);
+	    threads.create_thread(range(*this, first, last, counts[t]));
+	  }
+	  threads.join_all();
+
+	  size_t set = 0;
+	  for (size_t t = 0; t < num_threads; ++t)
+	    set += counts[t];
+	  return set;
+	}
+
+      private:
+	size_t combine(const size_t first, const size_t last) const
+	{
+	  std::vector<const unsigned char *> from(this->srcs);
+	  for (size_t i = 0; i < from.size(); ++i)
+	    from[i] += first;
+	  return combine_bytes(this->dst + first,
+			       from.empty() ? 0 : &from[0], from.size(),
+			       last - first, this->op, true);
+	}
+
+	struct range {
+	  range(const parallel_combiner& shared, const size_t first,
+		const size_t last, size_t& set)
+	    : shared(&shared), first(first), last(last), set(&set) {}
+
+	  void operator()() const
+	  {
+	    *this->set = this->shared->combine(this->first, this->last);
+	  }
+
+	  const parallel_combiner *shared;
+	  size_t first;
+	  size_t last;
+	  size_t *set;
+	};
+
+	unsigned char *const dst;
+	const std::vector<const unsigned char *>& srcs;
+	const size_t n;
+	const combine_op op;
+      };
+
+      //! what filter_access runs on the blocks of the result; returns
+      //! the bits set in them, so they needn't be counted again
+      class combine_blocks {
+      public:
+	combine_blocks(const std::vector<const unsigned char *>& srcs,
+		       const combine_op op, const size_t num_threads)
+	  : srcs(srcs), op(op), num_threads(num_threads) {}
+
+	template <typename Bits>
+	size_t operator()(Bits& bits)
+	{
+	  return parallel_combiner(block_bytes(bits), this->srcs,
+				   payload_size(bits), this->op)
+	    .run(this->num_threads);
+	}
+
+      private:
+	const std::vector<const unsigned char *>& srcs;
+	const combine_op op;
+	const size_t num_threads;
+      };
+
+      template <typename Filter>
+      void check_combinable(const Filter& lhs, const Filter& rhs)
+      {
+	if (lhs.bit_capacity() != rhs.bit_capacity() ||
+	    lhs.num_hash_functions() != rhs.num_hash_functions())
+	  throw incompatible_size_exception();
+      }
+
+      template <typename Filter>
+      void parallel_combine(Filter& filter, const Filter& rhs,
+			    const combine_op op, const size_t num_threads)
+      {
+	check_combinable(filter, rhs);
+
+	const std::vector<const unsigned char *> srcs(
+	  1, filter_access::block_bytes(rhs));
+	combine_blocks combiner(srcs, op, num_threads);
+	filter_access::update_counted_blocks(filter, combiner);
+      }
+
+    } // namespace detail
+
+    //? filter |= rhs, with num_threads threads
+    template <typename Filter>
+    void unite(Filter& filter, const Filter& rhs, const size_t num_threads)
+    {
+      detail::parallel_combine(filter, rhs, detail::combine_or, num_threads);
+    }
+
+    //? filter &= rhs, with num_threads threads
+    template <typename Filter>
+    void intersect(Filter& filter, const Filter& rhs,
+		   const size_t num_threads)
+    {
+      detail::parallel_combine(filter, rhs, detail::combine_and,
+			       num_threads);
+    }
+
+    //? the union of every filter in [start, end), which must all have
+    //? the same size and hash functions; a default constructed filter
+    //? if there are none. The first is copied, and the rest are each
+    //? read once.
+    template <typename ForwardIterator>
+    typename std::iterator_traits<ForwardIterator>::value_type
+    union_all(const ForwardIterator start, const ForwardIterator end,
+	      const size_t num_threads = 1)
+    {
+      typedef typename std::iterator_traits<ForwardIterator>::value_type
+	filter_type;
+
+      if (start == end)
+	return filter_type();
+
+      std::vector<const unsigned char *> srcs;
+      for (ForwardIterator i = start; ++i != end; ) {
+	detail::check_combinable(*start, *i);
+	srcs.push_back(detail::filter_access::block_bytes(*i));
+      }
+
+      filter_type ret(*start);
+      detail::combine_blocks combiner(srcs, detail::combine_or, num_threads);
+      detail::filter_access::update_counted_blocks(ret, combiner);
+      return ret;
+    }
+  } // namespace bloom_filters
+} // namespace boost
+#endif
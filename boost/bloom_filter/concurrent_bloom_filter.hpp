@@ -0,0 +1,241 @@
+//////////////////////////////////////////////////////////////////////////////
+//
+// (C) Copyright Alejandro Cabrera 2011.
+// Distributed under the Boost
+// Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or
+// copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// See http://www.boost.org/libs/bloom_filter for documentation.
+//
+//////////////////////////////////////////////////////////////////////////////
+
+#ifndef BOOST_BLOOM_FILTER_CONCURRENT_BLOOM_FILTER_HPP
+#define BOOST_BLOOM_FILTER_CONCURRENT_BLOOM_FILTER_HPP 1
+
+#include <boost/config.hpp>
+#include <boost/cstdint.hpp>
+#include <boost/mpl/vector.hpp>
+
+#include <boost/bloom_filter/detail/apply_hash.hpp>
+#include <boost/bloom_filter/detail/atomic_bits.hpp>
+#include <boost/bloom_filter/detail/batch.hpp>
+#include <boost/bloom_filter/detail/hash_digest.hpp>
+#include <boost/bloom_filter/detail/population.hpp>
+#include <boost/bloom_filter/hash/default.hpp>
+#include <boost/bloom_filter/reduction.hpp>
+#include <boost/bloom_filter/storage.hpp>
+
+/**
+ * basic_bloom_filter for many threads at once.
+ *
+ * The bits are atomic Block words. insert() sets its bits with relaxed
+ * fetch_or and probably_contains() reads them with relaxed loads, so
+ * any number of threads may insert and probe together without a lock.
+ * A Bloom filter only ever gains bits, so that is all the
+ * synchronization it needs: once an insert has returned, every later
+ * probe of its key answers true.
+ *
+ * The same bits are set as by a basic_bloom_filter with the same
+ * parameters. count() is counted afresh on each call, since keeping a
+ * shared count would make every insert write one hot word.
+ *
+ * Copying, assignment, clear() and swap() are word by word too; they
+ * are well defined while other threads insert, but only a snapshot of
+ * a filter nobody is changing is exact.
+ */
+namespace boost {
+  namespace bloom_filters {
+    template <typename T,
+	      size_t Size,
+	      class HashFunctions = mpl::vector<boost_hash<T> >,
+	      class Block = size_t,
+	      class Reduction = typename default_reduction<Size>::type,
+	      class Storage = inline_storage>
+    class concurrent_bloom_filter {
+    public:
+      typedef T value_type;
+      typedef T key_type;
+      typedef detail::atomic_bitset<Size, Block> bitset_type;
+      typedef HashFunctions hash_function_type;
+      typedef Block block_type;
+      typedef Reduction reduction_type;
+      typedef Storage storage_policy;
+      typedef concurrent_bloom_filter<T, Size, HashFunctions,
+				      Block, Reduction, Storage> this_type;
+
+    private:
+      typedef typename detail::select_apply_hash<
+	HashFunctions, this_type>::type apply_hash_type;
+
+    public:
+      concurrent_bloom_filter() {}
+
+      template <typename InputIterator>
+      concurrent_bloom_filter(const InputIterator start,
+			      const InputIterator end) {
+	this->insert(start, end);
+      }
+
+      static BOOST_CONSTEXPR size_t bit_capacity() {
+        return Size;
+      }
+
+      static BOOST_CONSTEXPR size_t num_hash_functions() {
+        return detail::num_hashes<HashFunctions>::value;
+      }
+
+      //? estimated from count()
+      double false_positive_rate() const {
+	return detail::estimated_fpr(this->count(), Size,
+				     num_hash_functions());
+      }
+
+      //? the number of bits set, counted now
+      size_t count() const {
+        return this->bits().count();
+      }
+
+      bool empty() const {
+	return this->count() == 0;
+      }
+
+      const bitset_type&
+      data() const
+      {
+	return this->bits();
+      }
+
+      //* core operations; safe from any number of threads
+      void insert(const T& t) {
+        apply_hash_type::insert(t, bits());
+      }
+
+      template <typename InputIterator>
+      void insert(const InputIterator start, const InputIterator end) {
+	for (InputIterator i = start; i != end; ++i) {
+	  this->insert(*i);
+	}
+      }
+
+      bool probably_contains(const T& t) const {
+        return apply_hash_type::contains(t, bits());
+      }
+
+      //* pre-hashed ops
+      //? digests are those of basic_bloom_filter
+      typedef detail::hash_digest<apply_hash_type::num_positions> digest_type;
+
+      static digest_type hash_key(const T& t) {
+	digest_type digest;
+	apply_hash_type::hashes(t, digest.values);
+	return digest;
+      }
+
+      void insert_hash(const digest_type& digest) {
+	detail::bitset_insert_digest<reduction_type>(digest, bits());
+      }
+
+      bool probably_contains_hash(const digest_type& digest) const {
+	return detail::bitset_contains_digest<reduction_type>(digest, bits());
+      }
+
+      //? as basic_bloom_filter::insert_batch
+      template <typename InputIterator>
+      void insert_batch(const InputIterator start, const InputIterator end) {
+	detail::bitset_insert_batch<apply_hash_type>(start, end, bits());
+      }
+
+      //? as basic_bloom_filter::probably_contains_batch
+      template <typename InputIterator>
+      size_t probably_contains_batch(const InputIterator start,
+				     const InputIterator end,
+				     boost::uint64_t *const out) const {
+	return detail::bitset_contains_batch<apply_hash_type>(start, end,
+							      bits(), out);
+      }
+
+      //* whole filter operations
+      void clear() {
+        this->bits().reset();
+      }
+
+      void swap(concurrent_bloom_filter& other) {
+	this->storage.swap(other.storage);
+      }
+
+      //? safe while either filter is inserted into
+      concurrent_bloom_filter& operator|=(const concurrent_bloom_filter& rhs) {
+	detail::or_words(this->bits().data(), rhs.bits().data(),
+			 bitset_type::num_words);
+        return *this;
+      }
+
+      concurrent_bloom_filter& operator&=(const concurrent_bloom_filter& rhs) {
+	detail::and_words(this->bits().data(), rhs.bits().data(),
+			  bitset_type::num_words);
+        return *this;
+      }
+
+      bool operator==(const concurrent_bloom_filter& rhs) const {
+	return detail::equal_words(this->bits().data(), rhs.bits().data(),
+				   bitset_type::num_words);
+      }
+
+      bool operator!=(const concurrent_bloom_filter& rhs) const {
+	return !(*this == rhs);
+      }
+
+    private:
+      typedef typename Storage::template apply<bitset_type>::type
+	storage_type;
+
+      bitset_type& bits() { return this->storage.get(); }
+      const bitset_type& bits() const { return this->storage.get(); }
+
+      storage_type storage;
+    };
+
+    template<class _T, size_t _Size, class _HashFunctions,
+	     class _Block, class _Reduction, class _Storage>
+    concurrent_bloom_filter<_T, _Size, _HashFunctions,
+			    _Block, _Reduction, _Storage>
+    operator|(const concurrent_bloom_filter<_T, _Size, _HashFunctions,
+					    _Block, _Reduction, _Storage>& lhs,
+	      const concurrent_bloom_filter<_T, _Size, _HashFunctions,
+					    _Block, _Reduction, _Storage>& rhs)
+    {
+      concurrent_bloom_filter<_T, _Size, _HashFunctions,
+			      _Block, _Reduction, _Storage> ret(lhs);
+      ret |= rhs;
+      return ret;
+    }
+
+    template<class _T, size_t _Size, class _HashFunctions,
+	     class _Block, class _Reduction, class _Storage>
+    concurrent_bloom_filter<_T, _Size, _HashFunctions,
+			    _Block, _Reduction, _Storage>
+    operator&(const concurrent_bloom_filter<_T, _Size, _HashFunctions,
+					    _Block, _Reduction, _Storage>& lhs,
+	      const concurrent_bloom_filter<_T, _Size, _HashFunctions,
+					    _Block, _Reduction, _Storage>& rhs)
+    {
+      concurrent_bloom_filter<_T, _Size, _HashFunctions,
+			      _Block, _Reduction, _Storage> ret(lhs);
+      ret &= rhs;
+      return ret;
+    }
+
+    template<class _T, size_t _Size, class _HashFunctions,
+	     class _Block, class _Reduction, class _Storage>
+    void
+    swap(concurrent_bloom_filter<_T, _Size, _HashFunctions,
+				 _Block, _Reduction, _Storage>& lhs,
+	 concurrent_bloom_filter<_T, _Size, _HashFunctions,
+				 _Block, _Reduction, _Storage>& rhs)
+    {
+      lhs.swap(rhs);
+    }
+  } // namespace bloom_filters
+} // namespace boost
+#endif
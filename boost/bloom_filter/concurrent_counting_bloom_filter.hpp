@@ -0,0 +1,311 @@
+//////////////////////////////////////////////////////////////////////////////
+//
+// (C) Copyright Alejandro Cabrera 2011.
+// Distributed under the Boost
+// Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or
+// copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// See http://www.boost.org/libs/bloom_filter for documentation.
+//
+//////////////////////////////////////////////////////////////////////////////
+
+#ifndef BOOST_BLOOM_FILTER_CONCURRENT_COUNTING_BLOOM_FILTER_HPP
+#define BOOST_BLOOM_FILTER_CONCURRENT_COUNTING_BLOOM_FILTER_HPP 1
+
+#include <boost/config.hpp>
+#include <boost/cstdint.hpp>
+#include <boost/mpl/vector.hpp>
+#include <boost/static_assert.hpp>
+#include <boost/type_traits/is_integral.hpp>
+#include <boost/type_traits/is_unsigned.hpp>
+
+#include <boost/bloom_filter/detail/atomic_bits.hpp>
+#include <boost/bloom_filter/detail/counting_apply_hash.hpp>
+#include <boost/bloom_filter/detail/counting_ops.hpp>
+#include <boost/bloom_filter/detail/hash_digest.hpp>
+#include <boost/bloom_filter/detail/population.hpp>
+#include <boost/bloom_filter/hash/default.hpp>
+#include <boost/bloom_filter/reduction.hpp>
+#include <boost/bloom_filter/storage.hpp>
+
+/**
+ * counting_bloom_filter for many threads at once.
+ *
+ * The bins are packed into atomic Block words as counting_bloom_filter
+ * packs them, and every increment or decrement is a compare-and-swap
+ * loop on the word that holds the bin. Threads inserting and removing
+ * keys whose bins share a word never lose each other's updates.
+ *
+ * An exception can't be thrown from halfway through a key's bins
+ * without leaving the others changed, so insert() and remove() report
+ * instead: they return false if some bin of the key was already full
+ * (or empty). Unlike counting_bloom_filter, which stops at the first
+ * full bin, the key's other bins are still updated, so the key is
+ * probably contained after an insert that overflowed.
+ *
+ * A full bin has lost count of its keys, so it is sticky: remove()
+ * leaves it full. A later remove() of a key that overflowed takes
+ * back exactly the increments its insert made, and no bin drops below
+ * the keys still counted in it, so removals never cause false
+ * negatives. The price is that a full bin stays in use until clear().
+ *
+ * count() is counted afresh on each call. Copying, assignment, clear()
+ * and swap() are word by word; they are well defined while other
+ * threads update the filter, but only exact when none do.
+ */
+namespace boost {
+  namespace bloom_filters {
+    template <typename T,
+	      size_t NumBins,
+	      size_t BitsPerBin = 4,
+	      class HashFunctions = mpl::vector<boost_hash<T> >,
+	      typename Block = size_t,
+	      class Reduction = typename default_reduction<NumBins>::type,
+	      class Storage = inline_storage>
+    class concurrent_counting_bloom_filter {
+
+      // as for counting_bloom_filter
+      BOOST_STATIC_ASSERT( boost::is_integral<Block>::value == true);
+      BOOST_STATIC_ASSERT( boost::is_unsigned<Block>::value == true);
+      BOOST_STATIC_ASSERT( BitsPerBin > 0);
+      BOOST_STATIC_ASSERT( (BitsPerBin < (sizeof(Block) * 8) ) );
+      BOOST_STATIC_ASSERT( ((sizeof(Block) * 8) % BitsPerBin) == 0);
+
+      static const size_t slot_bits = sizeof(Block) * 8;
+      static const size_t array_size =
+	(NumBins * BitsPerBin + slot_bits - 1) / slot_bits;
+
+    public:
+      typedef T value_type;
+      typedef T key_type;
+      typedef HashFunctions hash_function_type;
+      typedef Block block_type;
+      typedef Reduction reduction_type;
+      typedef Storage storage_policy;
+      typedef concurrent_counting_bloom_filter<T, NumBins, BitsPerBin,
+					       HashFunctions, Block,
+					       Reduction, Storage> this_type;
+
+      typedef detail::atomic_blocks<array_size, Block> bucket_type;
+
+    private:
+      typedef typename detail::select_counting_apply_hash<
+	HashFunctions, this_type>::type apply_hash_type;
+
+    public:
+      //* constructors
+      concurrent_counting_bloom_filter() {}
+
+      template <typename InputIterator>
+      concurrent_counting_bloom_filter(const InputIterator start,
+				       const InputIterator end)
+      {
+	this->insert(start, end);
+      }
+
+      //* meta functions
+      static BOOST_CONSTEXPR size_t num_bins()
+      {
+	return NumBins;
+      }
+
+      static BOOST_CONSTEXPR size_t bits_per_bin()
+      {
+	return BitsPerBin;
+      }
+
+      static BOOST_CONSTEXPR size_t bins_per_slot()
+      {
+	return sizeof(block_type) * 8 / BitsPerBin;
+      }
+
+      static BOOST_CONSTEXPR size_t mask()
+      {
+	return static_cast<Block>(0 - 1) >> (slot_bits - BitsPerBin);
+      }
+
+      static BOOST_CONSTEXPR size_t bit_capacity()
+      {
+        return NumBins * BitsPerBin;
+      }
+
+      static BOOST_CONSTEXPR size_t num_hash_functions()
+      {
+        return detail::num_hashes<HashFunctions>::value;
+      }
+
+      //? estimated from count()
+      double false_positive_rate() const
+      {
+	return detail::estimated_fpr(this->count(), NumBins,
+				     num_hash_functions());
+      }
+
+      //? the number of bins in use, counted now
+      size_t count() const
+      {
+	return detail::count_nonzero_bins<this_type>(this->bits(), NumBins);
+      }
+
+      bool empty() const
+      {
+	return this->count() == 0;
+      }
+
+      const bucket_type&
+      data() const
+      {
+	return this->bits();
+      }
+
+      //* core operations; safe from any number of threads
+      //? false if a bin of t was full, and so left as it was
+      bool insert(const T& t)
+      {
+	size_t bins[apply_hash_type::num_positions];
+	apply_hash_type::positions(t, NumBins, bins);
+	return this->step(bins, true);
+      }
+
+      //? returns the number of keys with a full bin
+      template <typename InputIterator>
+      size_t insert(const InputIterator start, const InputIterator end)
+      {
+	size_t overflows = 0;
+	for (InputIterator i = start; i != end; ++i)
+	  if (!this->insert(*i))
+	    ++overflows;
+	return overflows;
+      }
+
+      //? false if a bin of t was empty, and so left as it was; full
+      //? bins stay full
+      bool remove(const T& t)
+      {
+	size_t bins[apply_hash_type::num_positions];
+	apply_hash_type::positions(t, NumBins, bins);
+	return this->step(bins, false);
+      }
+
+      //? returns the number of keys with an empty bin
+      template <typename InputIterator>
+      size_t remove(const InputIterator start, const InputIterator end)
+      {
+	size_t underflows = 0;
+	for (InputIterator i = start; i != end; ++i)
+	  if (!this->remove(*i))
+	    ++underflows;
+	return underflows;
+      }
+
+      bool probably_contains(const T& t) const
+      {
+	size_t bins[apply_hash_type::num_positions];
+	apply_hash_type::positions(t, NumBins, bins);
+	return this->all_in_use(bins);
+      }
+
+      //* pre-hashed ops
+      //? digests are those of counting_bloom_filter
+      typedef detail::hash_digest<apply_hash_type::num_positions> digest_type;
+
+      static digest_type hash_key(const T& t)
+      {
+	digest_type digest;
+	apply_hash_type::hashes(t, digest.values);
+	return digest;
+      }
+
+      bool insert_hash(const digest_type& digest)
+      {
+	size_t bins[apply_hash_type::num_positions];
+	this->reduce(digest, bins);
+	return this->step(bins, true);
+      }
+
+      bool remove_hash(const digest_type& digest)
+      {
+	size_t bins[apply_hash_type::num_positions];
+	this->reduce(digest, bins);
+	return this->step(bins, false);
+      }
+
+      bool probably_contains_hash(const digest_type& digest) const
+      {
+	size_t bins[apply_hash_type::num_positions];
+	this->reduce(digest, bins);
+	return this->all_in_use(bins);
+      }
+
+      //* auxiliary operations
+      void clear()
+      {
+	this->bits().reset();
+      }
+
+      void swap(concurrent_counting_bloom_filter& other)
+      {
+	this->storage.swap(other.storage);
+      }
+
+      bool operator==(const concurrent_counting_bloom_filter& rhs) const
+      {
+	return detail::equal_words(this->bits().data(), rhs.bits().data(),
+				   array_size);
+      }
+
+      bool operator!=(const concurrent_counting_bloom_filter& rhs) const
+      {
+	return !(*this == rhs);
+      }
+
+    private:
+      typedef typename Storage::template apply<bucket_type>::type
+	storage_type;
+
+      bucket_type& bits() { return this->storage.get(); }
+      const bucket_type& bits() const { return this->storage.get(); }
+
+      static void reduce(const digest_type& digest, size_t *const bins)
+      {
+	for (size_t i = 0; i < apply_hash_type::num_positions; ++i)
+	  bins[i] = reduction_type::reduce(digest.values[i], NumBins);
+      }
+
+      bool step(const size_t *const bins, const bool up)
+      {
+	bool stepped = true;
+	for (size_t i = 0; i < apply_hash_type::num_positions; ++i)
+	  if (!detail::atomic_step_bin<this_type>(this->bits().data(),
+						  bins[i], up))
+	    stepped = false;
+	return stepped;
+      }
+
+      bool all_in_use(const size_t *const bins) const
+      {
+	for (size_t i = 0; i < apply_hash_type::num_positions; ++i)
+	  if (detail::read_bin<this_type>(this->bits(), bins[i]) == 0)
+	    return false;
+	return true;
+      }
+
+      storage_type storage;
+    };
+
+    template<class T, size_t NumBins, size_t BitsPerBin,
+	     class HashFunctions, class Block, class Reduction, class Storage>
+    void
+    swap(concurrent_counting_bloom_filter<T, NumBins, BitsPerBin,
+					  HashFunctions, Block,
+					  Reduction, Storage>& lhs,
+	 concurrent_counting_bloom_filter<T, NumBins, BitsPerBin,
+					  HashFunctions, Block,
+					  Reduction, Storage>& rhs)
+    {
+      lhs.swap(rhs);
+    }
+  } // namespace bloom_filters
+} // namespace boost
+#endif
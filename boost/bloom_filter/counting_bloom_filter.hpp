@@ -16,6 +16,7 @@
 #include <cmath>
 
 #include <boost/config.hpp>
+#include <boost/cstdint.hpp>
 #include <boost/array.hpp>
 
 #include <boost/mpl/vector.hpp>
@@ -26,7 +27,13 @@
 #include <boost/type_traits/is_unsigned.hpp>
 
 #include <boost/bloom_filter/detail/counting_apply_hash.hpp>
+#include <boost/bloom_filter/detail/batch.hpp>
+#include <boost/bloom_filter/detail/filter_header.hpp>
+#include <boost/bloom_filter/detail/hash_digest.hpp>
+#include <boost/bloom_filter/detail/population.hpp>
 #include <boost/bloom_filter/hash/default.hpp>
+#include <boost/bloom_filter/reduction.hpp>
+#include <boost/bloom_filter/storage.hpp>
 
 #ifndef BOOST_NO_0X_HDR_INITIALIZER_LIST
 #include <initializer_list>
@@ -38,7 +45,9 @@ namespace boost {
 	      size_t NumBins,
 	      size_t BitsPerBin = 4,
 	      class HashFunctions = mpl::vector<boost_hash<T> >,
-	      typename Block = size_t>
+	      typename Block = size_t,
+	      class Reduction = typename default_reduction<NumBins>::type,
+	      class Storage = inline_storage>
     class counting_bloom_filter {
 
       // Block needs to be an integral type
@@ -75,16 +84,18 @@ namespace boost {
       typedef T key_type;
       typedef HashFunctions hash_function_type;
       typedef Block block_type;
-      typedef counting_bloom_filter<T, NumBins, BitsPerBin, 
-				    HashFunctions, Block> this_type;
+      typedef Reduction reduction_type;
+      typedef Storage storage_policy;
+      typedef counting_bloom_filter<T, NumBins, BitsPerBin, HashFunctions,
+				    Block, Reduction, Storage> this_type;
 
       typedef boost::array<Block, array_size> bucket_type;
       typedef typename bucket_type::iterator bucket_iterator;
       typedef typename bucket_type::const_iterator bucket_const_iterator;
 
     private:
-      typedef detail::counting_apply_hash<mpl::size<HashFunctions>::value - 1,
-					  this_type> apply_hash_type;
+      typedef typename detail::select_counting_apply_hash<
+	HashFunctions, this_type>::type apply_hash_type;
 
     public:
       //* constructors
@@ -143,37 +154,21 @@ namespace boost {
 
       static BOOST_CONSTEXPR size_t num_hash_functions() 
       {
-        return mpl::size<HashFunctions>::value;
+        return detail::num_hashes<HashFunctions>::value;
       }
 
+      //? estimated from count(), so as cheap to ask
       double false_positive_rate() const 
       {
-        const double n = static_cast<double>(this->count());
-        static const double k = static_cast<double>(num_hash_functions());
-        static const double m = static_cast<double>(NumBins);
-        static const double e =
-	  2.718281828459045235360287471352662497757247093699959574966;
-        return std::pow(1 - std::pow(e, -k * n / m), k);
+	return detail::estimated_fpr(this->count(), NumBins,
+				     num_hash_functions());
       }
 
-      //? returns the number of bins that have at least 1 bit set
+      //? returns the number of bins that have at least 1 bit set; kept
+      //? as keys go in and out, so free to ask
       size_t count() const 
       {
-	size_t ret = 0;
-
-	for (bucket_const_iterator i = this->bits.begin(), 
-	       end = this->bits.end(); 
-	     i != end; ++i) {
-	  for (size_t bin = 0; bin < this->bins_per_slot(); ++bin) {
-	    const size_t offset_bits = bin * BitsPerBin;
-	    const size_t target_bits = (*i >> offset_bits) & this->mask();
-
-	    if (target_bits > 0)
-	      ++ret;
-	  }
-	}
-
-        return ret;
+        return this->population();
       }
 
       bool empty() const
@@ -184,15 +179,16 @@ namespace boost {
       const bucket_type&
       data() const
       {
-	return this->bits;
+	return this->bits();
       }
 
       //* core ops
       void insert(const T& t)
       {
 	apply_hash_type::insert(t, 
-				this->bits,
-				this->num_bins());
+				this->bits(),
+				this->num_bins(),
+				this->population());
       }
 
       template <typename InputIterator>
@@ -206,8 +202,9 @@ namespace boost {
       void remove(const T& t)
       {
 	apply_hash_type::remove(t, 
-				this->bits,
-				this->num_bins());
+				this->bits(),
+				this->num_bins(),
+				this->population());
       }
 
       template <typename InputIterator>
@@ -221,78 +218,182 @@ namespace boost {
       bool probably_contains(const T& t) const
       {
 	return apply_hash_type::contains(t,
-					 this->bits,
+					 this->bits(),
 					 this->num_bins());
       }
 
+      //* pre-hashed ops
+      //? the unreduced hash values of a key. A digest can be passed to
+      //? insert_hash() and probably_contains_hash() of any filter with
+      //? the same key type and hashing, whatever its size, so a key
+      //? probed against many filters is hashed only once.
+      typedef detail::hash_digest<apply_hash_type::num_positions> digest_type;
+
+      static digest_type hash_key(const T& t)
+      {
+	digest_type digest;
+	apply_hash_type::hashes(t, digest.values);
+	return digest;
+      }
+
+      void insert_hash(const digest_type& digest)
+      {
+	detail::counting_update_digest<this_type>(
+	  digest, this->bits(), this->num_bins(),
+	  detail::increment(this->population()),
+	  (static_cast<size_t>(1) << BitsPerBin) - 1);
+      }
+
+      void remove_hash(const digest_type& digest)
+      {
+	detail::counting_update_digest<this_type>(
+	  digest, this->bits(), this->num_bins(),
+	  detail::decrement(this->population()), 0);
+      }
+
+      bool probably_contains_hash(const digest_type& digest) const
+      {
+	return detail::counting_contains_digest<this_type>(
+	  digest, this->bits(), this->num_bins());
+      }
+
+      //? inserts every key in [start, end). Same result as
+      //? insert(start, end), but the bins of a group of keys are
+      //? prefetched together so their cache misses overlap.
+      template <typename InputIterator>
+      void insert_batch(const InputIterator start, const InputIterator end)
+      {
+	detail::counting_update_batch<apply_hash_type, this_type>(
+	  start, end, this->bits(), this->num_bins(),
+	  detail::increment(this->population()),
+	  (static_cast<size_t>(1) << BitsPerBin) - 1);
+      }
+
+      //? tests every key in [start, end). Bit i % 64 of out[i / 64] is
+      //? set if the i-th key is probably contained, so out must have
+      //? room for (std::distance(start, end) + 63) / 64 words. Returns
+      //? the number of keys that are probably contained.
+      template <typename InputIterator>
+      size_t probably_contains_batch(const InputIterator start,
+				     const InputIterator end,
+				     boost::uint64_t *const out) const
+      {
+	return detail::counting_contains_batch<apply_hash_type, this_type>(
+	  start, end, this->bits(), this->num_bins(), out);
+      }
+
       //* auxiliary ops
       void clear()
       {
-	for (bucket_iterator i = bits.begin(), end = bits.end();
+	for (bucket_iterator i = bits().begin(), end = bits().end();
 	     i != end; ++i) {
 	  *i = 0;
 	}
+	this->population() = 0;
       }
 
       void swap(counting_bloom_filter& other)
       {
-	counting_bloom_filter tmp = other;
-	other = *this;
-	*this = tmp;
+	this->storage.swap(other.storage);
       }
 
       //* equality comparison operators
       template <typename _T, size_t _Bins, size_t _BitsPerBin,
-		typename _HashFns, typename _Block>
+		typename _HashFns, typename _Block,
+		typename _Reduction, typename _Storage>
       friend bool
       operator==(const counting_bloom_filter<_T, _Bins, _BitsPerBin,
-					     _HashFns, _Block>& lhs,
+					     _HashFns, _Block,
+					     _Reduction, _Storage>& lhs,
 		 const counting_bloom_filter<_T, _Bins, _BitsPerBin,
-					     _HashFns, _Block>& rhs);
+					     _HashFns, _Block,
+					     _Reduction, _Storage>& rhs);
 
       template <typename _T, size_t _Bins, size_t _BitsPerBin,
-		typename _HashFns, typename _Block>
+		typename _HashFns, typename _Block,
+		typename _Reduction, typename _Storage>
       friend bool
       operator!=(const counting_bloom_filter<_T, _Bins, _BitsPerBin,
-					     _HashFns, _Block>& lhs,
+					     _HashFns, _Block,
+					     _Reduction, _Storage>& lhs,
 		 const counting_bloom_filter<_T, _Bins, _BitsPerBin,
-					     _HashFns, _Block>& rhs);
+					     _HashFns, _Block,
+					     _Reduction, _Storage>& rhs);
 
 
     private:
-      bucket_type bits;
+      typedef typename Storage::template apply<
+	detail::counted<bucket_type> >::type storage_type;
+
+      bucket_type& bits() { return this->storage.get().bits; }
+      const bucket_type& bits() const { return this->storage.get().bits; }
+
+      size_t& population() { return this->storage.get().population; }
+      size_t population() const { return this->storage.get().population; }
+
+      //* serialization
+      friend struct detail::filter_access;
+
+      detail::filter_header header() const
+      {
+	return detail::make_header<HashFunctions, Reduction, mpl::vector<> >(
+	  detail::hashed_bins, sizeof(Block), BitsPerBin,
+	  num_hash_functions(), NumBins);
+      }
+
+      void reshape(const detail::filter_header& saved, bool)
+      {
+	detail::check_header(saved, this->header());
+      }
+
+      bucket_type& block_storage() { return this->bits(); }
+
+      void recount()
+      {
+	this->population() =
+	  detail::count_nonzero_bins<this_type>(this->bits(), NumBins);
+      }
+
+      storage_type storage;
     };
 
     template<class T, size_t NumBins, size_t BitsPerBin, class HashFunctions,
-	     typename Block>
+	     typename Block,
+	     typename Reduction, typename Storage>
     void
     swap(counting_bloom_filter<T, NumBins, BitsPerBin, 
-			       HashFunctions, Block>& lhs,
+			       HashFunctions, Block, Reduction, Storage>& lhs,
 	 counting_bloom_filter<T, NumBins, BitsPerBin,
-			       HashFunctions, Block>& rhs)
+			       HashFunctions, Block, Reduction, Storage>& rhs)
 
     {
       lhs.swap(rhs);
     }
 
     template<class T, size_t NumBins, size_t BitsPerBin, class HashFunctions,
-	     typename Block>
+	     typename Block,
+	     typename Reduction, typename Storage>
     bool
     operator==(const counting_bloom_filter<T, NumBins, BitsPerBin, 
-					   HashFunctions, Block>& lhs,
+					   HashFunctions, Block,
+					   Reduction, Storage>& lhs,
 	       const counting_bloom_filter<T, NumBins, BitsPerBin,
-					   HashFunctions, Block>& rhs)
+					   HashFunctions, Block,
+					   Reduction, Storage>& rhs)
     {
-      return (lhs.bits == rhs.bits);
+      return (lhs.bits() == rhs.bits());
     }
 
     template<class T, size_t NumBins, size_t BitsPerBin, class HashFunctions,
-	     typename Block>
+	     typename Block,
+	     typename Reduction, typename Storage>
     bool
     operator!=(const counting_bloom_filter<T, NumBins, BitsPerBin, 
-					   HashFunctions, Block>& lhs,
+					   HashFunctions, Block,
+					   Reduction, Storage>& lhs,
 	       const counting_bloom_filter<T, NumBins, BitsPerBin,
-					   HashFunctions, Block>& rhs)
+					   HashFunctions, Block,
+					   Reduction, Storage>& rhs)
     {
       return !(lhs == rhs);
     }
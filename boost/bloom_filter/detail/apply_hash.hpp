@@ -14,6 +14,11 @@
 #define BOOST_BLOOM_FILTER_APPLY_HASH_HPP
 
 #include <boost/mpl/at.hpp>
+#include <boost/mpl/if.hpp>
+
+#include <boost/bloom_filter/detail/engine_apply_hash.hpp>
+#include <boost/bloom_filter/detail/hash_engine.hpp>
+#include <boost/bloom_filter/detail/population.hpp>
 
 namespace boost {
   namespace bloom_filters {
@@ -26,15 +31,42 @@ namespace boost {
 	typedef typename Container::value_type value_type;
 	typedef typename Container::bitset_type bitset_type;
 	typedef typename Container::hash_function_type hash_function_type;
+	typedef typename Container::reduction_type reduction_type;
+
+	static const size_t num_positions = N + 1;
+
+	//? writes the num_positions bit positions of t to out
+	static void positions(const value_type& t,
+			      const size_t size,
+			      size_t *const out)
+	{
+	  typedef typename boost::mpl::at_c<hash_function_type, N>::type Hash;
+	  static Hash hasher;
+
+	  out[N] = reduction_type::reduce(hasher(t), size);
+	  apply_hash<N-1, Container>::positions(t, size, out);
+	}
 
-        static void insert(const value_type& t, 
-			   bitset_type& _bits) 
+	//? writes the num_positions unreduced hash values of t to out
+	static void hashes(const value_type& t, size_t *const out)
 	{
 	  typedef typename boost::mpl::at_c<hash_function_type, N>::type Hash;
 	  static Hash hasher;
 
-	  _bits[hasher(t) % _bits.size()] = true;
-	  apply_hash<N-1, Container>::insert(t, _bits);
+	  out[N] = hasher(t);
+	  apply_hash<N-1, Container>::hashes(t, out);
+	}
+
+	//? sets the bits of t; returns how many of them were clear
+        static size_t insert(const value_type& t, 
+			     bitset_type& _bits) 
+	{
+	  typedef typename boost::mpl::at_c<hash_function_type, N>::type Hash;
+	  static Hash hasher;
+
+	  const size_t set =
+	    set_bit(_bits, reduction_type::reduce(hasher(t), _bits.size()));
+	  return set + apply_hash<N-1, Container>::insert(t, _bits);
         }
 
         static bool contains(const value_type& t, 
@@ -43,7 +75,7 @@ namespace boost {
 	  typedef typename boost::mpl::at_c<hash_function_type, N>::type Hash;
 	  static Hash hasher;
 
-	  return (_bits[hasher(t) % _bits.size()] && 
+	  return (_bits[reduction_type::reduce(hasher(t), _bits.size())] && 
 		  apply_hash<N-1, Container>::contains(t, _bits));
         }
       };
@@ -54,14 +86,35 @@ namespace boost {
 	typedef typename Container::value_type value_type;
 	typedef typename Container::bitset_type bitset_type;
 	typedef typename Container::hash_function_type hash_function_type;
+	typedef typename Container::reduction_type reduction_type;
+
+	static const size_t num_positions = 1;
 
-        static void insert(const value_type& t, 
-			   bitset_type& _bits) 
+	static void positions(const value_type& t,
+			      const size_t size,
+			      size_t *const out)
 	{
 	  typedef typename boost::mpl::at_c<hash_function_type, 0>::type Hash;
 	  static Hash hasher;
 
-	  _bits[hasher(t) % _bits.size()] = true;
+	  out[0] = reduction_type::reduce(hasher(t), size);
+	}
+
+	static void hashes(const value_type& t, size_t *const out)
+	{
+	  typedef typename boost::mpl::at_c<hash_function_type, 0>::type Hash;
+	  static Hash hasher;
+
+	  out[0] = hasher(t);
+	}
+
+        static size_t insert(const value_type& t, 
+			     bitset_type& _bits) 
+	{
+	  typedef typename boost::mpl::at_c<hash_function_type, 0>::type Hash;
+	  static Hash hasher;
+
+	  return set_bit(_bits, reduction_type::reduce(hasher(t), _bits.size()));
         }
 
         static bool contains(const value_type& t, 
@@ -70,10 +123,22 @@ namespace boost {
 	  typedef typename boost::mpl::at_c<hash_function_type, 0>::type Hash;
 	  static Hash hasher;
 
-	  return (_bits[hasher(t) % _bits.size()]);
+	  return (_bits[reduction_type::reduce(hasher(t), _bits.size())]);
         }
       };
 
+      //? apply_hash for an mpl sequence of hash functions,
+      //? engine_apply_hash for a hashing engine
+      template <typename HashFunctions, typename Container>
+      struct select_apply_hash
+      {
+	typedef typename mpl::if_<
+	  is_hash_engine<HashFunctions>,
+	  engine_apply_hash<Container>,
+	  apply_hash<num_hashes<HashFunctions>::value - 1, Container>
+	  >::type type;
+      };
+
     } // namespace detail
   } // namespace bloom_filter
 } // namespace boost
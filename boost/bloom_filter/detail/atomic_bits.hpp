@@ -0,0 +1,393 @@
+//////////////////////////////////////////////////////////////////////////////
+//
+// (C) Copyright Alejandro Cabrera 2011.
+// Distributed under the Boost
+// Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or
+// copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// See http://www.boost.org/libs/bloom_filter for documentation.
+//
+//////////////////////////////////////////////////////////////////////////////
+
+#ifndef BOOST_BLOOM_FILTER_DETAIL_ATOMIC_BITS_HPP
+#define BOOST_BLOOM_FILTER_DETAIL_ATOMIC_BITS_HPP
+
+#include <algorithm>
+#include <climits>
+#include <cstddef>
+#include <memory>
+
+#include <boost/atomic.hpp>
+#include <boost/config.hpp>
+#include <boost/core/allocator_access.hpp>
+#include <boost/cstdint.hpp>
+#include <boost/static_assert.hpp>
+#include <boost/type_traits/is_unsigned.hpp>
+
+#include <boost/bloom_filter/detail/popcount.hpp>
+
+namespace boost {
+  namespace bloom_filters {
+    namespace detail {
+
+      // Bits in atomic blocks, laid out as dynamic_bitset lays them
+      // out: bit i is bit i % bits_per_block of block i / bits_per_block.
+      // Setting a bit is a relaxed fetch_or, and testing one a relaxed
+      // load, so any number of threads may set and test bits at once.
+      // A set bit is never cleared by an insert, so no ordering beyond
+      // the atomicity of each word is needed: a key is found by every
+      // probe that happens after its insert returned.
+      //
+      // The bins of the concurrent counting filters are updated in
+      // place with compare-and-swap loops on the word that holds them.
+      //
+      // Whole-array operations -- copying, clearing, swapping -- are
+      // made of the same relaxed word operations, and are only a
+      // consistent snapshot when no thread is inserting.
+
+      //* word loops
+      template <typename Block>
+      bool test_bit(const boost::atomic<Block> *const words, const size_t i)
+      {
+	static const size_t bits_per_block = sizeof(Block) * CHAR_BIT;
+	return (words[i / bits_per_block].load(boost::memory_order_relaxed)
+		>> (i % bits_per_block)) & 1;
+      }
+
+      //? sets bit i; true if this call is the one that set it
+      template <typename Block>
+      bool fetch_set_bit(boost::atomic<Block> *const words, const size_t i)
+      {
+	static const size_t bits_per_block = sizeof(Block) * CHAR_BIT;
+	const Block mask = static_cast<Block>(
+	  static_cast<Block>(1) << (i % bits_per_block));
+	return (words[i / bits_per_block].fetch_or(
+		  mask, boost::memory_order_relaxed) & mask) == 0;
+      }
+
+      template <typename Block>
+      void store_words(boost::atomic<Block> *const words, const size_t n,
+		       const boost::atomic<Block> *const from)
+      {
+	for (size_t i = 0; i < n; ++i)
+	  words[i].store(from == 0 ? 0 :
+			 from[i].load(boost::memory_order_relaxed),
+			 boost::memory_order_relaxed);
+      }
+
+      template <typename Block>
+      size_t count_words(const boost::atomic<Block> *const words,
+			 const size_t n)
+      {
+	size_t ret = 0;
+	for (size_t i = 0; i < n; ++i)
+	  ret += popcount(static_cast<boost::uint64_t>(
+	    words[i].load(boost::memory_order_relaxed)));
+	return ret;
+      }
+
+      template <typename Block>
+      bool equal_words(const boost::atomic<Block> *const lhs,
+		       const boost::atomic<Block> *const rhs, const size_t n)
+      {
+	for (size_t i = 0; i < n; ++i)
+	  if (lhs[i].load(boost::memory_order_relaxed) !=
+	      rhs[i].load(boost::memory_order_relaxed))
+	    return false;
+	return true;
+      }
+
+      //? or-s (or and-s) rhs into lhs word by word; safe against
+      //? concurrent inserts into either
+      template <typename Block>
+      void or_words(boost::atomic<Block> *const lhs,
+		    const boost::atomic<Block> *const rhs, const size_t n)
+      {
+	for (size_t i = 0; i < n; ++i)
+	  lhs[i].fetch_or(rhs[i].load(boost::memory_order_relaxed),
+			  boost::memory_order_relaxed);
+      }
+
+      template <typename Block>
+      void and_words(boost::atomic<Block> *const lhs,
+		     const boost::atomic<Block> *const rhs, const size_t n)
+      {
+	for (size_t i = 0; i < n; ++i)
+	  lhs[i].fetch_and(rhs[i].load(boost::memory_order_relaxed),
+			   boost::memory_order_relaxed);
+      }
+
+      //* word containers
+      //! N atomic blocks inside the object
+      template <size_t N, typename Block>
+      class atomic_blocks {
+	BOOST_STATIC_ASSERT(N > 0);
+	BOOST_STATIC_ASSERT(is_unsigned<Block>::value);
+
+      public:
+	typedef Block value_type;
+	typedef boost::atomic<Block> word_type;
+
+	atomic_blocks() { store_words<Block>(this->words, N, 0); }
+
+	atomic_blocks(const atomic_blocks& other)
+	{
+	  store_words(this->words, N, other.words);
+	}
+
+	atomic_blocks& operator=(const atomic_blocks& rhs)
+	{
+	  store_words(this->words, N, rhs.words);
+	  return *this;
+	}
+
+	static BOOST_CONSTEXPR size_t size() { return N; }
+
+	//? block i, loaded relaxed
+	Block operator[](const size_t i) const
+	{
+	  return this->words[i].load(boost::memory_order_relaxed);
+	}
+
+	void reset() { store_words<Block>(this->words, N, 0); }
+
+	word_type *data() { return this->words; }
+	const word_type *data() const { return this->words; }
+
+      private:
+	word_type words[N];
+      };
+
+      //! atomic blocks in one allocation made with Allocator
+      template <typename Block, typename Allocator = std::allocator<Block> >
+      class atomic_block_array {
+	BOOST_STATIC_ASSERT(is_unsigned<Block>::value);
+
+      public:
+	typedef Block value_type;
+	typedef boost::atomic<Block> word_type;
+	typedef typename boost::allocator_rebind<Allocator, word_type>::type
+	  allocator_type;
+
+	atomic_block_array() : words(0), n(0) {}
+
+	explicit atomic_block_array(const size_t n)
+	  : words(allocate(n, 0)), n(n)
+	{}
+
+	atomic_block_array(const atomic_block_array& other)
+	  : words(allocate(other.n, other.words)), n(other.n)
+	{}
+
+	~atomic_block_array()
+	{
+	  release(this->words, this->n);
+	}
+
+	atomic_block_array& operator=(const atomic_block_array& rhs)
+	{
+	  if (this->n == rhs.n)
+	    store_words(this->words, this->n, rhs.words);
+	  else {
+	    atomic_block_array copy(rhs);
+	    this->swap(copy);
+	  }
+	  return *this;
+	}
+
+	size_t size() const { return this->n; }
+
+	Block operator[](const size_t i) const
+	{
+	  return this->words[i].load(boost::memory_order_relaxed);
+	}
+
+	void reset() { store_words<Block>(this->words, this->n, 0); }
+
+	//? exchanges the allocations; no blocks are copied
+	void swap(atomic_block_array& other) BOOST_NOEXCEPT
+	{
+	  std::swap(this->words, other.words);
+	  std::swap(this->n, other.n);
+	}
+
+	word_type *data() { return this->words; }
+	const word_type *data() const { return this->words; }
+
+      private:
+	static word_type *allocate(const size_t n,
+				   const word_type *const from)
+	{
+	  if (n == 0)
+	    return 0;
+
+	  word_type *const ret = &*allocator_type().allocate(n);
+	  for (size_t i = 0; i < n; ++i)
+	    ::new (static_cast<void *>(ret + i)) word_type(0);
+	  store_words(ret, n, from);
+	  return ret;
+	}
+
+	static void release(word_type *const words, const size_t n)
+	{
+	  if (words == 0)
+	    return;
+
+	  for (size_t i = 0; i < n; ++i)
+	    words[i].~word_type();
+	  allocator_type().deallocate(words, n);
+	}
+
+	word_type *words;
+	size_t n;
+      };
+
+      //* bit containers
+      //! Size atomic bits inside the object, for the fixed size
+      //! concurrent filter
+      template <size_t Size, typename Block>
+      class atomic_bitset {
+	static const size_t bits_per_block = sizeof(Block) * CHAR_BIT;
+
+      public:
+	typedef boost::atomic<Block> word_type;
+	static const size_t num_words =
+	  (Size + bits_per_block - 1) / bits_per_block;
+
+	static BOOST_CONSTEXPR size_t size() { return Size; }
+
+	bool operator[](const size_t i) const
+	{
+	  return test_bit(this->data(), i);
+	}
+
+	bool set(const size_t i) { return fetch_set_bit(this->data(), i); }
+
+	size_t count() const { return count_words(this->data(), num_words); }
+
+	void reset() { this->words.reset(); }
+
+	word_type *data() { return this->words.data(); }
+	const word_type *data() const { return this->words.data(); }
+
+      private:
+	atomic_blocks<num_words, Block> words;
+      };
+
+      //! atomic bits in one allocation made with Allocator, for the
+      //! dynamic concurrent filter
+      template <typename Block, typename Allocator = std::allocator<Block> >
+      class atomic_bit_array {
+	static const size_t bits_per_block = sizeof(Block) * CHAR_BIT;
+
+      public:
+	typedef boost::atomic<Block> word_type;
+
+	static size_t blocks_for(const size_t num_bits)
+	{
+	  return (num_bits + bits_per_block - 1) / bits_per_block;
+	}
+
+	atomic_bit_array() : num_bits(0) {}
+
+	explicit atomic_bit_array(const size_t num_bits)
+	  : words(blocks_for(num_bits)), num_bits(num_bits)
+	{}
+
+	size_t size() const { return this->num_bits; }
+
+	size_t num_blocks() const { return this->words.size(); }
+
+	bool operator[](const size_t i) const
+	{
+	  return test_bit(this->data(), i);
+	}
+
+	bool set(const size_t i) { return fetch_set_bit(this->data(), i); }
+
+	size_t count() const
+	{
+	  return count_words(this->data(), this->num_blocks());
+	}
+
+	void reset() { this->words.reset(); }
+
+	//? exchanges the allocations; no bits are copied
+	void swap(atomic_bit_array& other) BOOST_NOEXCEPT
+	{
+	  this->words.swap(other.words);
+	  std::swap(this->num_bits, other.num_bits);
+	}
+
+	word_type *data() { return this->words.data(); }
+	const word_type *data() const { return this->words.data(); }
+
+      private:
+	atomic_block_array<Block, Allocator> words;
+	size_t num_bits;
+      };
+
+      //* counting bins
+      //? adds 1 to bin (or, with up false, takes 1 from it) with a CAS
+      //? loop on its word. false, leaving the bin as it is, if it is
+      //? already full (or empty): the concurrent counting filters
+      //? report overflow and underflow instead of throwing. A full bin
+      //? is sticky: it may have missed increments, so taking 1 from it
+      //? leaves it full rather than under its true count.
+      template <typename CBF, typename Block>
+      bool atomic_step_bin(boost::atomic<Block> *const slots,
+			   const size_t bin, const bool up)
+      {
+	boost::atomic<Block>& word = slots[bin / CBF::bins_per_slot()];
+	const size_t offset_bits =
+	  (bin % CBF::bins_per_slot()) * CBF::bits_per_bin();
+	const Block one = static_cast<Block>(static_cast<Block>(1) <<
+					     offset_bits);
+
+	Block old = word.load(boost::memory_order_relaxed);
+	for (;;) {
+	  const size_t value = (old >> offset_bits) & CBF::mask();
+	  if (value == CBF::mask())
+	    return !up;
+	  if (!up && value == 0)
+	    return false;
+
+	  const Block next = static_cast<Block>(up ? old + one : old - one);
+	  if (word.compare_exchange_weak(old, next,
+					 boost::memory_order_relaxed,
+					 boost::memory_order_relaxed))
+	    return true;
+	}
+      }
+
+      //* the bit container interface apply_hash and batch.hpp use
+      template <size_t Size, typename Block>
+      size_t set_bit(atomic_bitset<Size, Block>& bits, const size_t pos)
+      {
+	return bits.set(pos) ? 1 : 0;
+      }
+
+      template <typename Block, typename Allocator>
+      size_t set_bit(atomic_bit_array<Block, Allocator>& bits,
+		     const size_t pos)
+      {
+	return bits.set(pos) ? 1 : 0;
+      }
+
+      template <size_t Size, typename Block>
+      const char *bit_storage(const atomic_bitset<Size, Block>& bits)
+      {
+	return reinterpret_cast<const char *>(bits.data());
+      }
+
+      template <typename Block, typename Allocator>
+      const char *bit_storage(const atomic_bit_array<Block, Allocator>& bits)
+      {
+	return reinterpret_cast<const char *>(bits.data());
+      }
+
+    } // namespace detail
+  } // namespace bloom_filters
+} // namespace boost
+#endif
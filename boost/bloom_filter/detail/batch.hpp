@@ -0,0 +1,295 @@
+//////////////////////////////////////////////////////////////////////////////
+//
+// (C) Copyright Alejandro Cabrera 2011.
+// Distributed under the Boost
+// Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or
+// copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// See http://www.boost.org/libs/bloom_filter for documentation.
+//
+//////////////////////////////////////////////////////////////////////////////
+
+#ifndef BOOST_BLOOM_FILTER_DETAIL_BATCH_HPP
+#define BOOST_BLOOM_FILTER_DETAIL_BATCH_HPP
+
+#include <climits>
+
+#include <boost/cstdint.hpp>
+#include <boost/mpl/bool.hpp>
+#include <boost/mpl/eval_if.hpp>
+#include <boost/mpl/has_xxx.hpp>
+
+#include <boost/bloom_filter/detail/counting_ops.hpp>
+#include <boost/bloom_filter/detail/population.hpp>
+#include <boost/bloom_filter/detail/prefetch.hpp>
+
+namespace boost {
+  namespace bloom_filters {
+    namespace detail {
+
+      // Batched operations work on groups of batch_size keys: every key
+      // of a group is hashed first, a prefetch is issued for each of its
+      // probe locations, and only then is the filter touched. The cache
+      // misses of a group overlap instead of being paid one at a time.
+      static const size_t batch_size = 16;
+
+      BOOST_MPL_HAS_XXX_TRAIT_DEF(multi_key)
+
+      template <typename ApplyHash>
+      struct apply_hash_multi_key {
+	typedef typename ApplyHash::multi_key type;
+      };
+
+      //? true_ if ApplyHash can hash a group of keys in one call
+      template <typename ApplyHash>
+      struct is_multi_key_apply_hash
+	: mpl::eval_if<has_multi_key<ApplyHash>,
+		       apply_hash_multi_key<ApplyHash>,
+		       mpl::false_>::type
+      {};
+
+      BOOST_MPL_HAS_XXX_TRAIT_DEF(runtime_count)
+
+      template <typename ApplyHash>
+      struct apply_hash_runtime_count {
+	typedef typename ApplyHash::runtime_count type;
+      };
+
+      //? true_ if ApplyHash takes the number of positions per key as
+      //? an argument; num_positions is then only an upper bound
+      template <typename ApplyHash>
+      struct is_runtime_count_apply_hash
+	: mpl::eval_if<has_runtime_count<ApplyHash>,
+		       apply_hash_runtime_count<ApplyHash>,
+		       mpl::false_>::type
+      {};
+
+      template <typename ApplyHash, typename T>
+      void key_positions(const T& t, const size_t, const size_t size,
+			 size_t *const out, mpl::false_)
+      {
+	ApplyHash::positions(t, size, out);
+      }
+
+      template <typename ApplyHash, typename T>
+      void key_positions(const T& t, const size_t k, const size_t size,
+			 size_t *const out, mpl::true_)
+      {
+	ApplyHash::positions(t, k, size, out);
+      }
+
+      //? one key at a time
+      template <typename ApplyHash, typename InputIterator>
+      size_t hash_batch(InputIterator& i,
+			const InputIterator end,
+			const size_t size,
+			size_t *positions,
+			const size_t k,
+			mpl::false_)
+      {
+	size_t n = 0;
+
+	for (; n < batch_size && i != end; ++n, ++i, positions += k)
+	  key_positions<ApplyHash>(
+	    *i, k, size, positions,
+	    typename is_runtime_count_apply_hash<ApplyHash>::type());
+
+	return n;
+      }
+
+      //? the keys of a group are gathered and hashed together
+      template <typename ApplyHash, typename InputIterator>
+      size_t hash_batch(InputIterator& i,
+			const InputIterator end,
+			const size_t size,
+			size_t *const positions,
+			const size_t,
+			mpl::true_)
+      {
+	typename ApplyHash::value_type keys[batch_size];
+	size_t n = 0;
+
+	for (; n < batch_size && i != end; ++n, ++i)
+	  keys[n] = *i;
+
+	ApplyHash::positions(keys, n, size, positions);
+	return n;
+      }
+
+      // ApplyHash::positions(t, size, out) writes the k probe
+      // locations of t, each in [0, size), to out; k is
+      // ApplyHash::num_positions unless ApplyHash takes it at run
+      // time. Returns the number of keys consumed.
+      template <typename ApplyHash, typename InputIterator>
+      size_t hash_batch(InputIterator& i,
+			const InputIterator end,
+			const size_t size,
+			size_t *const positions,
+			const size_t k)
+      {
+	return hash_batch<ApplyHash>(
+	  i, end, size, positions, k,
+	  typename is_multi_key_apply_hash<ApplyHash>::type());
+      }
+
+      // collects one found/not found flag per key into out, 64 per word
+      class batch_result {
+      public:
+	explicit batch_result(boost::uint64_t *const out)
+	  : out(out), word(0), bit(0), found(0)
+	{}
+
+	void push(const bool hit)
+	{
+	  this->word |= static_cast<boost::uint64_t>(hit) << this->bit;
+	  this->found += hit;
+
+	  if (++this->bit == 64) {
+	    *this->out++ = this->word;
+	    this->word = 0;
+	    this->bit = 0;
+	  }
+	}
+
+	//? flushes the last partial word; returns the number of hits
+	size_t finish()
+	{
+	  if (this->bit != 0)
+	    *this->out = this->word;
+
+	  return this->found;
+	}
+
+      private:
+	boost::uint64_t *out;
+	boost::uint64_t word;
+	size_t bit;
+	size_t found;
+      };
+
+      //* std::bitset and dynamic_bitset backed filters
+      //? returns the number of bits that were clear
+      template <typename ApplyHash, typename Bitset, typename InputIterator>
+      size_t bitset_insert_batch(InputIterator i,
+				 const InputIterator end,
+				 Bitset& bits,
+				 const size_t k = ApplyHash::num_positions)
+      {
+	const char *const storage = bit_storage(bits);
+	size_t positions[batch_size * ApplyHash::num_positions];
+	size_t set = 0;
+
+	while (i != end) {
+	  const size_t n =
+	    hash_batch<ApplyHash>(i, end, bits.size(), positions, k) * k;
+
+	  for (size_t j = 0; j < n; ++j)
+	    prefetch_write(storage + positions[j] / CHAR_BIT);
+
+	  for (size_t j = 0; j < n; ++j)
+	    set += set_bit(bits, positions[j]);
+	}
+
+	return set;
+      }
+
+      template <typename ApplyHash, typename Bitset, typename InputIterator>
+      size_t bitset_contains_batch(InputIterator i,
+				   const InputIterator end,
+				   const Bitset& bits,
+				   boost::uint64_t *const out,
+				   const size_t k = ApplyHash::num_positions)
+      {
+	const char *const storage = bit_storage(bits);
+	size_t positions[batch_size * ApplyHash::num_positions];
+	batch_result result(out);
+
+	while (i != end) {
+	  const size_t n =
+	    hash_batch<ApplyHash>(i, end, bits.size(), positions, k) * k;
+
+	  for (size_t j = 0; j < n; ++j)
+	    prefetch_read(storage + positions[j] / CHAR_BIT);
+
+	  for (size_t key = 0; key < n; key += k) {
+	    bool hit = true;
+
+	    for (size_t j = key; j < key + k && hit; ++j)
+	      hit = bits[positions[j]];
+
+	    result.push(hit);
+	  }
+	}
+
+	return result.finish();
+      }
+
+      //* counting filters; positions are bin indices
+      template <typename CBF, typename Bucket>
+      const void *bin_address(const Bucket& slots, const size_t bin)
+      {
+	return &slots[bin / CBF::bins_per_slot()];
+      }
+
+      //? applies Op to every bin of every key, exactly as the single
+      //? key update does; Op may throw, leaving earlier keys applied
+      template <typename ApplyHash, typename CBF, typename Op,
+		typename InputIterator>
+      void counting_update_batch(InputIterator i,
+				 const InputIterator end,
+				 typename CBF::bucket_type& slots,
+				 const size_t num_bins,
+				 Op op,
+				 const size_t limit,
+				 const size_t k = ApplyHash::num_positions)
+      {
+	size_t bins[batch_size * ApplyHash::num_positions];
+
+	while (i != end) {
+	  const size_t n =
+	    hash_batch<ApplyHash>(i, end, num_bins, bins, k) * k;
+
+	  for (size_t j = 0; j < n; ++j)
+	    prefetch_write(bin_address<CBF>(slots, bins[j]));
+
+	  for (size_t j = 0; j < n; ++j)
+	    update_bin<CBF>(slots, bins[j], op, limit);
+	}
+      }
+
+      template <typename ApplyHash, typename CBF, typename InputIterator>
+      size_t counting_contains_batch(InputIterator i,
+				     const InputIterator end,
+				     const typename CBF::bucket_type& slots,
+				     const size_t num_bins,
+				     boost::uint64_t *const out,
+				     const size_t k = ApplyHash::num_positions)
+      {
+	size_t bins[batch_size * ApplyHash::num_positions];
+	batch_result result(out);
+
+	while (i != end) {
+	  const size_t n =
+	    hash_batch<ApplyHash>(i, end, num_bins, bins, k) * k;
+
+	  for (size_t j = 0; j < n; ++j)
+	    prefetch_read(bin_address<CBF>(slots, bins[j]));
+
+	  for (size_t key = 0; key < n; key += k) {
+	    bool hit = true;
+
+	    for (size_t j = key; j < key + k && hit; ++j)
+	      hit = read_bin<CBF>(slots, bins[j]) != 0;
+
+	    result.push(hit);
+	  }
+	}
+
+	return result.finish();
+      }
+
+    } // namespace detail
+  } // namespace bloom_filter
+} // namespace boost
+#endif
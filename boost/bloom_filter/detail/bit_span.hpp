@@ -0,0 +1,85 @@
+//////////////////////////////////////////////////////////////////////////////
+//
+// (C) Copyright Alejandro Cabrera 2011.
+// Distributed under the Boost
+// Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or
+// copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// See http://www.boost.org/libs/bloom_filter for documentation.
+//
+//////////////////////////////////////////////////////////////////////////////
+
+#ifndef BOOST_BLOOM_FILTER_DETAIL_BIT_SPAN_HPP
+#define BOOST_BLOOM_FILTER_DETAIL_BIT_SPAN_HPP
+
+#include <climits>
+#include <cstddef>
+
+#include <boost/bloom_filter/detail/popcount.hpp>
+
+namespace boost {
+  namespace bloom_filters {
+    namespace detail {
+
+      // Bits in blocks someone else owns, read only. Laid out as a
+      // dynamic_bitset lays them out: bit i is bit i % bits_per_block
+      // of block i / bits_per_block. Copying copies the pointer.
+      template <typename Block>
+      class const_bit_span {
+	static const size_t bits_per_block = sizeof(Block) * CHAR_BIT;
+
+      public:
+	static size_t blocks_for(const size_t num_bits)
+	{
+	  return (num_bits + bits_per_block - 1) / bits_per_block;
+	}
+
+	const_bit_span() : blocks(0), num_bits(0) {}
+
+	const_bit_span(const Block *const blocks, const size_t num_bits)
+	  : blocks(blocks), num_bits(num_bits)
+	{}
+
+	size_t size() const { return this->num_bits; }
+
+	size_t num_blocks() const { return blocks_for(this->num_bits); }
+
+	bool operator[](const size_t i) const
+	{
+	  return (this->blocks[i / bits_per_block] >>
+		  (i % bits_per_block)) & 1;
+	}
+
+	//? bits past size() in the last block are not counted
+	size_t count() const
+	{
+	  const size_t full = this->num_bits / bits_per_block;
+	  size_t ret = popcount(this->blocks, this->blocks + full);
+
+	  if (this->num_bits % bits_per_block != 0)
+	    ret += popcount(static_cast<boost::uint64_t>(
+	      this->blocks[full] &
+	      ((static_cast<Block>(1) << (this->num_bits % bits_per_block))
+	       - 1)));
+
+	  return ret;
+	}
+
+	const Block *data() const { return this->blocks; }
+
+      private:
+	const Block *blocks;
+	size_t num_bits;
+      };
+
+      template <typename Block>
+      const char *bit_storage(const const_bit_span<Block>& bits)
+      {
+	return reinterpret_cast<const char *>(bits.data());
+      }
+
+    } // namespace detail
+  } // namespace bloom_filter
+} // namespace boost
+#endif
@@ -0,0 +1,195 @@
+//////////////////////////////////////////////////////////////////////////////
+//
+// (C) Copyright Alejandro Cabrera 2011.
+// Distributed under the Boost
+// Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or
+// copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// See http://www.boost.org/libs/bloom_filter for documentation.
+//
+//////////////////////////////////////////////////////////////////////////////
+
+#ifndef BOOST_BLOOM_FILTER_BLOCKED_APPLY_HASH_HPP
+#define BOOST_BLOOM_FILTER_BLOCKED_APPLY_HASH_HPP
+
+#include <boost/cstdint.hpp>
+
+#include <boost/bloom_filter/detail/batch.hpp>
+#include <boost/bloom_filter/detail/blocked_simd.hpp>
+#include <boost/bloom_filter/detail/popcount.hpp>
+#include <boost/bloom_filter/detail/prefetch.hpp>
+
+namespace boost {
+  namespace bloom_filters {
+    namespace detail {
+
+      // All N probes of a key land in the same block of
+      // Container::block_bits() bits. The hash picks the block; its upper
+      // half is used as the start and stride of the probes inside it. The
+      // stride is odd and block_bits() a power of two, so the N probes of
+      // one key never collide with each other.
+      template <size_t N,
+		typename Container>
+      struct blocked_apply_hash
+      {
+
+      private:
+	typedef typename Container::value_type value_type;
+	typedef typename Container::block_type block_type;
+	typedef typename Container::bucket_type bucket_type;
+	typedef typename Container::hash_function_type hash_function_type;
+
+	static const size_t half_hash_bits = sizeof(size_t) * 4;
+	static const size_t word_bits = sizeof(block_type) * 8;
+
+      public:
+	static size_t block_index(const size_t hash, const size_t num_blocks)
+	{
+	  return hash % num_blocks;
+	}
+
+	static size_t probe_start(const size_t hash)
+	{
+	  return hash >> half_hash_bits;
+	}
+
+	static size_t probe_step(const size_t hash)
+	{
+	  return (probe_start(hash) >> Container::block_bits_log2()) | 1;
+	}
+
+	//? sets the bits of t; returns how many of them were clear
+        static size_t insert(const value_type& t,
+			     bucket_type& slots)
+	{
+	  static hash_function_type hasher;
+
+	  return insert_hashed(hasher(t), slots);
+        }
+
+	// hashes a group of keys and prefetches their blocks before
+	// setting any bits
+	template <typename InputIterator>
+	static size_t insert_batch(InputIterator i,
+				   const InputIterator end,
+				   bucket_type& slots)
+	{
+	  static hash_function_type hasher;
+
+	  const size_t num_blocks = Container::blocks_in(slots);
+	  size_t hashes[batch_size];
+	  size_t set = 0;
+
+	  while (i != end) {
+	    size_t n = 0;
+
+	    for (; n < batch_size && i != end; ++n, ++i) {
+	      hashes[n] = hasher(*i);
+	      prefetch_write(&slots[block_index(hashes[n], num_blocks) *
+				    Container::words_per_block()]);
+	    }
+
+	    for (size_t j = 0; j < n; ++j)
+	      set += insert_hashed(hashes[j], slots);
+	  }
+
+	  return set;
+	}
+
+        static bool contains(const value_type& t,
+			     const bucket_type& slots)
+	{
+	  static hash_function_type hasher;
+
+	  return contains_hashed(hasher(t), slots);
+        }
+
+	//? the one hash value a key's block and probes come from
+	static size_t key_hash(const value_type& t)
+	{
+	  static hash_function_type hasher;
+
+	  return hasher(t);
+	}
+
+	static bool contains_hashed(const size_t hash,
+				    const bucket_type& slots)
+	{
+	  const block_type *const block =
+	    &slots[block_index(hash, Container::blocks_in(slots)) *
+		   Container::words_per_block()];
+	  const size_t step = probe_step(hash);
+	  size_t probe = probe_start(hash);
+
+	  for (size_t i = 0; i < N; ++i, probe += step) {
+	    const size_t bit = probe & (Container::block_bits() - 1);
+	    if (((block[bit / word_bits] >> (bit % word_bits)) & 1) == 0)
+	      return false;
+	  }
+
+	  return true;
+        }
+
+	// hashes up to 64 keys at a time, prefetching their blocks, then
+	// hands them to the widest lookup kernel the host supports
+	template <typename InputIterator>
+	static size_t contains_batch(InputIterator i,
+				     const InputIterator end,
+				     const bucket_type& slots,
+				     boost::uint64_t *out)
+	{
+	  static hash_function_type hasher;
+	  static const blocked_contains_kernel kernel =
+	    select_blocked_contains_kernel<N, block_type>();
+
+	  const size_t num_blocks = Container::blocks_in(slots);
+	  boost::uint64_t blocks[64];
+	  boost::uint64_t seeds[64];
+	  size_t ret = 0;
+
+	  while (i != end) {
+	    size_t n = 0;
+
+	    for (; n < 64 && i != end; ++n, ++i) {
+	      const size_t hash = hasher(*i);
+	      blocks[n] = block_index(hash, num_blocks);
+	      seeds[n] = probe_start(hash);
+	      prefetch_read(&slots[blocks[n] * Container::words_per_block()]);
+	    }
+
+	    const boost::uint64_t found = kernel(&slots[0], blocks, seeds, n);
+	    ret += popcount(found);
+	    *out++ = found;
+	  }
+
+	  return ret;
+	}
+
+	// the probes of a key never collide, so a bit is newly set
+	// exactly when it was clear
+	static size_t insert_hashed(const size_t hash,
+				    bucket_type& slots)
+	{
+	  block_type *const block =
+	    &slots[block_index(hash, Container::blocks_in(slots)) *
+		   Container::words_per_block()];
+	  const size_t step = probe_step(hash);
+	  size_t probe = probe_start(hash);
+	  size_t set = 0;
+
+	  for (size_t i = 0; i < N; ++i, probe += step) {
+	    const size_t bit = probe & (Container::block_bits() - 1);
+	    const block_type mask =
+	      static_cast<block_type>(1) << (bit % word_bits);
+	    set += (block[bit / word_bits] & mask) == 0;
+	    block[bit / word_bits] |= mask;
+	  }
+
+	  return set;
+	}
+      };
+    } // namespace detail
+  } // namespace bloom_filter
+} // namespace boost
+#endif
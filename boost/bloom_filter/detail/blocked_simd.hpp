@@ -0,0 +1,232 @@
+//////////////////////////////////////////////////////////////////////////////
+//
+// (C) Copyright Alejandro Cabrera 2011.
+// Distributed under the Boost
+// Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or
+// copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// See http://www.boost.org/libs/bloom_filter for documentation.
+//
+//////////////////////////////////////////////////////////////////////////////
+
+#ifndef BOOST_BLOOM_FILTER_DETAIL_BLOCKED_SIMD_HPP
+#define BOOST_BLOOM_FILTER_DETAIL_BLOCKED_SIMD_HPP
+
+#include <cstddef>
+
+#include <boost/cstdint.hpp>
+
+#include <boost/bloom_filter/detail/cpu_dispatch.hpp>
+
+namespace boost {
+  namespace bloom_filters {
+    namespace detail {
+
+      // Batched lookup kernels for blocked_bloom_filter. Each one tests
+      // n <= 64 keys, given the block each key maps to and the probe seed
+      // (upper half of its hash), and returns a mask with bit i set if
+      // key i is probably contained. Probe j of a key is bit
+      // (seed + j * step) % 512 of its block, step = (seed >> 9) | 1;
+      // this has to stay in sync with blocked_apply_hash.
+      typedef boost::uint64_t (*blocked_contains_kernel)(
+	const void *const words,
+	const boost::uint64_t *const blocks,
+	const boost::uint64_t *const seeds,
+	const size_t n);
+
+      template <size_t K, typename Block>
+      boost::uint64_t
+      blocked_contains_scalar(const void *const words,
+			      const boost::uint64_t *const blocks,
+			      const boost::uint64_t *const seeds,
+			      const size_t n)
+      {
+	static const size_t word_bits = sizeof(Block) * 8;
+	static const size_t words_per_block = 512 / word_bits;
+
+	const Block *const slots = static_cast<const Block *>(words);
+	boost::uint64_t ret = 0;
+
+	for (size_t i = 0; i < n; ++i) {
+	  const Block *const block = slots + blocks[i] * words_per_block;
+	  const boost::uint64_t step = (seeds[i] >> 9) | 1;
+	  boost::uint64_t probe = seeds[i];
+	  bool found = true;
+
+	  for (size_t j = 0; j < K && found; ++j, probe += step) {
+	    const size_t bit = static_cast<size_t>(probe & 511);
+	    found = ((block[bit / word_bits] >> (bit % word_bits)) & 1) != 0;
+	  }
+
+	  ret |= static_cast<boost::uint64_t>(found) << i;
+	}
+
+	return ret;
+      }
+
+#ifdef BOOST_BLOOM_FILTER_HAS_SIMD_DISPATCH
+      // The SIMD kernels read the filter as 64-bit words. On x86 the bit
+      // numbering of a block is the same whatever its Block type.
+
+      // 4 keys per iteration: one 64-bit lane per key
+      template <size_t K, typename Block>
+      BOOST_BLOOM_FILTER_TARGET("avx2")
+      boost::uint64_t
+      blocked_contains_avx2(const void *const words,
+			    const boost::uint64_t *const blocks,
+			    const boost::uint64_t *const seeds,
+			    const size_t n)
+      {
+	const long long *const base = static_cast<const long long *>(words);
+	const __m256i one = _mm256_set1_epi64x(1);
+	const __m256i bit_mask = _mm256_set1_epi64x(511);
+	const __m256i word_mask = _mm256_set1_epi64x(63);
+	boost::uint64_t ret = 0;
+	size_t i = 0;
+
+	for (; i + 4 <= n; i += 4) {
+	  const __m256i first_word = _mm256_slli_epi64(
+	    _mm256_loadu_si256(reinterpret_cast<const __m256i *>(blocks + i)),
+	    3);
+	  __m256i probe =
+	    _mm256_loadu_si256(reinterpret_cast<const __m256i *>(seeds + i));
+	  const __m256i step =
+	    _mm256_or_si256(_mm256_srli_epi64(probe, 9), one);
+	  __m256i found = one;
+
+	  for (size_t j = 0; j < K; ++j) {
+	    const __m256i bit = _mm256_and_si256(probe, bit_mask);
+	    const __m256i index =
+	      _mm256_add_epi64(first_word, _mm256_srli_epi64(bit, 6));
+	    const __m256i word = _mm256_i64gather_epi64(base, index, 8);
+
+	    found = _mm256_and_si256(
+	      found,
+	      _mm256_srlv_epi64(word, _mm256_and_si256(bit, word_mask)));
+
+	    if (_mm256_testz_si256(found, one))
+	      break;
+
+	    probe = _mm256_add_epi64(probe, step);
+	  }
+
+	  const int lanes = _mm256_movemask_pd(
+	    _mm256_castsi256_pd(_mm256_cmpeq_epi64(
+	      _mm256_and_si256(found, one), one)));
+	  ret |= static_cast<boost::uint64_t>(lanes) << i;
+	}
+
+	if (i < n) {
+	  ret |= blocked_contains_scalar<K, Block>(
+	    words, blocks + i, seeds + i, n - i) << i;
+	}
+
+	return ret;
+      }
+
+      //! 8 keys in the lanes of AVX-512 vectors, probed one bit at a
+      //! time; lanes that already missed stop gathering
+      struct blocked_lanes_avx512 {
+	BOOST_BLOOM_FILTER_TARGET("avx512f")
+	blocked_lanes_avx512(const boost::uint64_t *const blocks,
+			     const boost::uint64_t *const seeds)
+	  : first_word(slli_epi64_avx512<3>(_mm512_loadu_si512(blocks))),
+	    probe(_mm512_loadu_si512(seeds)),
+	    step(_mm512_or_si512(srli_epi64_avx512<9>(this->probe),
+				 _mm512_set1_epi64(1))),
+	    found(0xff)
+	{}
+
+	//? tests the next probe of every lane still found
+	BOOST_BLOOM_FILTER_TARGET("avx512f")
+	void next(const void *const words)
+	{
+	  const __m512i one = _mm512_set1_epi64(1);
+	  const __m512i bit =
+	    _mm512_and_si512(this->probe, _mm512_set1_epi64(511));
+	  const __m512i index =
+	    _mm512_add_epi64(this->first_word, srli_epi64_avx512<6>(bit));
+	  const __m512i word =
+	    _mm512_mask_i64gather_epi64(_mm512_setzero_si512(), this->found,
+					index, words, 8);
+
+	  this->found = _mm512_mask_test_epi64_mask(
+	    this->found,
+	    srlv_epi64_avx512(word,
+			      _mm512_and_si512(bit, _mm512_set1_epi64(63))),
+	    one);
+	  this->probe = _mm512_add_epi64(this->probe, this->step);
+	}
+
+	__m512i first_word;
+	__m512i probe;
+	__m512i step;
+	__mmask8 found;
+      };
+
+      // 16 keys per iteration, as two vectors of 8 whose gathers are
+      // in flight together; then 8, then the AVX2 kernel for the rest
+      template <size_t K, typename Block>
+      BOOST_BLOOM_FILTER_TARGET("avx512f")
+      boost::uint64_t
+      blocked_contains_avx512(const void *const words,
+			      const boost::uint64_t *const blocks,
+			      const boost::uint64_t *const seeds,
+			      const size_t n)
+      {
+	boost::uint64_t ret = 0;
+	size_t i = 0;
+
+	for (; i + 16 <= n; i += 16) {
+	  blocked_lanes_avx512 low(blocks + i, seeds + i);
+	  blocked_lanes_avx512 high(blocks + i + 8, seeds + i + 8);
+
+	  for (size_t j = 0; j < K && (low.found | high.found); ++j) {
+	    low.next(words);
+	    high.next(words);
+	  }
+
+	  ret |= (static_cast<boost::uint64_t>(low.found) |
+		  static_cast<boost::uint64_t>(high.found) << 8) << i;
+	}
+
+	if (i + 8 <= n) {
+	  blocked_lanes_avx512 lanes(blocks + i, seeds + i);
+	  for (size_t j = 0; j < K && lanes.found; ++j)
+	    lanes.next(words);
+
+	  ret |= static_cast<boost::uint64_t>(lanes.found) << i;
+	  i += 8;
+	}
+
+	if (i < n) {
+	  ret |= blocked_contains_avx2<K, Block>(
+	    words, blocks + i, seeds + i, n - i) << i;
+	}
+
+	return ret;
+      }
+#endif
+
+      //? the fastest kernel this host supports
+      template <size_t K, typename Block>
+      blocked_contains_kernel select_blocked_contains_kernel()
+      {
+#ifdef BOOST_BLOOM_FILTER_HAS_SIMD_DISPATCH
+	switch (cpu_simd_level()) {
+	case simd_avx512:
+	  return &blocked_contains_avx512<K, Block>;
+	case simd_avx2:
+	  return &blocked_contains_avx2<K, Block>;
+	default:
+	  break;
+	}
+#endif
+	return &blocked_contains_scalar<K, Block>;
+      }
+
+    } // namespace detail
+  } // namespace bloom_filter
+} // namespace boost
+#endif
@@ -0,0 +1,217 @@
+//////////////////////////////////////////////////////////////////////////////
+//
+// (C) Copyright Alejandro Cabrera 2011.
+// Distributed under the Boost
+// Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or
+// copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// See http://www.boost.org/libs/bloom_filter for documentation.
+//
+//////////////////////////////////////////////////////////////////////////////
+
+#ifndef BOOST_BLOOM_FILTER_DETAIL_COMBINE_HPP
+#define BOOST_BLOOM_FILTER_DETAIL_COMBINE_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+
+#include <boost/config.hpp>
+#include <boost/cstdint.hpp>
+
+#include <boost/bloom_filter/detail/cpu_dispatch.hpp>
+#include <boost/bloom_filter/detail/payload.hpp>
+#include <boost/bloom_filter/detail/popcount.hpp>
+
+namespace boost {
+  namespace bloom_filters {
+    namespace detail {
+
+      // Union and intersection of filters' bits. Or-ing and and-ing
+      // don't care how bytes group into blocks, so the blocks of any
+      // two containers of the same type are combined as bytes, with
+      // AVX2 or AVX-512 where the host has them (see cpu_dispatch.hpp).
+      // The population of the result is counted a tile at a time
+      // while the tile is still in cache, rather than by a second pass
+      // over the whole filter.
+
+      enum combine_op {
+	combine_or,
+	combine_and
+      };
+
+      //? dst op= src over n bytes
+      typedef void (*combine_kernel)(unsigned char *const dst,
+				     const unsigned char *const src,
+				     const size_t n);
+
+      inline void store_word(unsigned char *const bytes,
+			     const boost::uint64_t word)
+      {
+	std::memcpy(bytes, &word, sizeof(word));
+      }
+
+      inline void or_bytes_scalar(unsigned char *const dst,
+				  const unsigned char *const src,
+				  const size_t n)
+      {
+	size_t i = 0;
+	for (; i + 8 <= n; i += 8)
+	  store_word(dst + i, load_word(dst + i) | load_word(src + i));
+	for (; i < n; ++i)
+	  dst[i] |= src[i];
+      }
+
+      inline void and_bytes_scalar(unsigned char *const dst,
+				   const unsigned char *const src,
+				   const size_t n)
+      {
+	size_t i = 0;
+	for (; i + 8 <= n; i += 8)
+	  store_word(dst + i, load_word(dst + i) & load_word(src + i));
+	for (; i < n; ++i)
+	  dst[i] &= src[i];
+      }
+
+#ifdef BOOST_BLOOM_FILTER_HAS_SIMD_DISPATCH
+      // two vectors an iteration, so a load of each operand is always
+      // in flight
+      BOOST_BLOOM_FILTER_TARGET("avx2")
+      inline void or_bytes_avx2(unsigned char *const dst,
+				const unsigned char *const src,
+				const size_t n)
+      {
+	size_t i = 0;
+	for (; i + 64 <= n; i += 64) {
+	  __m256i *const d = reinterpret_cast<__m256i *>(dst + i);
+	  const __m256i *const s = reinterpret_cast<const __m256i *>(src + i);
+	  const __m256i a = _mm256_or_si256(_mm256_loadu_si256(d),
+					    _mm256_loadu_si256(s));
+	  const __m256i b = _mm256_or_si256(_mm256_loadu_si256(d + 1),
+					    _mm256_loadu_si256(s + 1));
+	  _mm256_storeu_si256(d, a);
+	  _mm256_storeu_si256(d + 1, b);
+	}
+	or_bytes_scalar(dst + i, src + i, n - i);
+      }
+
+      BOOST_BLOOM_FILTER_TARGET("avx2")
+      inline void and_bytes_avx2(unsigned char *const dst,
+				 const unsigned char *const src,
+				 const size_t n)
+      {
+	size_t i = 0;
+	for (; i + 64 <= n; i += 64) {
+	  __m256i *const d = reinterpret_cast<__m256i *>(dst + i);
+	  const __m256i *const s = reinterpret_cast<const __m256i *>(src + i);
+	  const __m256i a = _mm256_and_si256(_mm256_loadu_si256(d),
+					     _mm256_loadu_si256(s));
+	  const __m256i b = _mm256_and_si256(_mm256_loadu_si256(d + 1),
+					     _mm256_loadu_si256(s + 1));
+	  _mm256_storeu_si256(d, a);
+	  _mm256_storeu_si256(d + 1, b);
+	}
+	and_bytes_scalar(dst + i, src + i, n - i);
+      }
+
+      BOOST_BLOOM_FILTER_TARGET("avx512f")
+      inline void or_bytes_avx512(unsigned char *const dst,
+				  const unsigned char *const src,
+				  const size_t n)
+      {
+	size_t i = 0;
+	for (; i + 128 <= n; i += 128) {
+	  const __m512i a = _mm512_or_si512(_mm512_loadu_si512(dst + i),
+					    _mm512_loadu_si512(src + i));
+	  const __m512i b = _mm512_or_si512(_mm512_loadu_si512(dst + i + 64),
+					    _mm512_loadu_si512(src + i + 64));
+	  _mm512_storeu_si512(dst + i, a);
+	  _mm512_storeu_si512(dst + i + 64, b);
+	}
+	or_bytes_scalar(dst + i, src + i, n - i);
+      }
+
+      BOOST_BLOOM_FILTER_TARGET("avx512f")
+      inline void and_bytes_avx512(unsigned char *const dst,
+				   const unsigned char *const src,
+				   const size_t n)
+      {
+	size_t i = 0;
+	for (; i + 128 <= n; i += 128) {
+	  const __m512i a = _mm512_and_si512(_mm512_loadu_si512(dst + i),
+					     _mm512_loadu_si512(src + i));
+	  const __m512i b = _mm512_and_si512(
+	    _mm512_loadu_si512(dst + i + 64),
+	    _mm512_loadu_si512(src + i + 64));
+	  _mm512_storeu_si512(dst + i, a);
+	  _mm512_storeu_si512(dst + i + 64, b);
+	}
+	and_bytes_scalar(dst + i, src + i, n - i);
+      }
+#endif
+
+      inline combine_kernel select_combine_kernel(const combine_op op)
+      {
+#ifdef BOOST_BLOOM_FILTER_HAS_SIMD_DISPATCH
+	if (cpu_simd_level() >= simd_avx512)
+	  return op == combine_or ? &or_bytes_avx512 : &and_bytes_avx512;
+	if (cpu_simd_level() >= simd_avx2)
+	  return op == combine_or ? &or_bytes_avx2 : &and_bytes_avx2;
+#endif
+	return op == combine_or ? &or_bytes_scalar : &and_bytes_scalar;
+      }
+
+      inline combine_kernel combine_kernel_for(const combine_op op)
+      {
+	static const combine_kernel or_kernel =
+	  select_combine_kernel(combine_or);
+	static const combine_kernel and_kernel =
+	  select_combine_kernel(combine_and);
+	return op == combine_or ? or_kernel : and_kernel;
+      }
+
+      // small enough for the tile of dst to stay in L1 while each
+      // source is combined into it
+      static const size_t combine_tile_bytes = 16384;
+
+      //? combines the n bytes at each of srcs[0, num_srcs) into the n
+      //? at dst: with keep_dst, dst op= each in turn; without, dst
+      //? becomes srcs[0] op srcs[1] op ..., and isn't read. A tile at
+      //? a time, so every source is read once and dst written once.
+      //? Returns the number of bits set in dst.
+      inline size_t combine_bytes(unsigned char *const dst,
+				  const unsigned char *const *const srcs,
+				  const size_t num_srcs, const size_t n,
+				  const combine_op op, const bool keep_dst)
+      {
+	const combine_kernel kernel = combine_kernel_for(op);
+	size_t set = 0;
+
+	for (size_t at = 0; at < n; at += combine_tile_bytes) {
+	  const size_t tile = std::min(combine_tile_bytes, n - at);
+	  size_t i = 0;
+	  if (!keep_dst && num_srcs != 0)
+	    std::memcpy(dst + at, srcs[i++] + at, tile);
+	  for (; i < num_srcs; ++i)
+	    kernel(dst + at, srcs[i] + at, tile);
+	  set += popcount_bytes(dst + at, tile);
+	}
+	return set;
+      }
+
+      //? lhs op= rhs for two bit containers of the same size; returns
+      //? the number of bits set in lhs
+      template <typename Bits>
+      size_t combine_bits(Bits& lhs, const Bits& rhs, const combine_op op)
+      {
+	const unsigned char *const src =
+	  block_bytes(const_cast<Bits&>(rhs));
+	return combine_bytes(block_bytes(lhs), &src, 1, payload_size(lhs),
+			     op, true);
+      }
+
+    } // namespace detail
+  } // namespace bloom_filter
+} // namespace boost
+#endif
@@ -14,32 +14,17 @@
 #define BOOST_BLOOM_FILTER_COUNTING_APPLY_HASH_HPP
 
 #include <boost/mpl/at.hpp>
+#include <boost/mpl/if.hpp>
 
-#include <boost/bloom_filter/detail/exceptions.hpp>
+#include <boost/bloom_filter/detail/counting_ops.hpp>
+#include <boost/bloom_filter/detail/engine_apply_hash.hpp>
+#include <boost/bloom_filter/detail/hash_engine.hpp>
 
 namespace boost {
   namespace bloom_filters {
     namespace detail {
 
-      struct decrement {
-	size_t operator()(const size_t val, const size_t limit) {
-	  if (val == limit)
-	    throw bin_underflow_exception();
-
-	  return val - 1;
-	}
-      };
- 
-      struct increment {
-	size_t operator()(const size_t val, const size_t limit) {
-	  if (val == limit)
-	    throw bin_overflow_exception();
-
-	  return val+1;
-	}
-      };
-
-      template <size_t N, class CBF, class Op = void>
+      template <size_t N, class CBF>
       struct BloomOp {
 	typedef typename boost::mpl::at_c<typename CBF::hash_function_type, 
 					  N>::type Hash;
@@ -49,16 +34,16 @@ namespace boost {
 		const typename CBF::bucket_type& slots,
 		const size_t num_bins)
 	  :
-	  hash_val(hasher(t) % num_bins),
+	  hash_val(CBF::reduction_type::reduce(hasher(t), num_bins)),
 	  pos(hash_val / CBF::bins_per_slot()),
 	  offset_bits((hash_val % CBF::bins_per_slot()) * CBF::bits_per_bin()),
 	  target_bits((slots[pos] >> offset_bits) & CBF::mask())
 	{}
 
+	template <typename Op>
 	void update(typename CBF::bucket_type& slots,
+		    Op op,
 		    const size_t limit) const {
-	  static Op op;
-
 	  const size_t final_bits = op(target_bits, limit);
 	  slots[pos] &= ~(CBF::mask() << offset_bits);
 	  slots[pos] |= (final_bits << offset_bits);
@@ -80,24 +65,54 @@ namespace boost {
 		class CBF>
       struct counting_apply_hash
       {
+	static const size_t num_positions = N + 1;
+
+	//? writes the num_positions bins of t to out
+	static void positions(const typename CBF::value_type& t,
+			      const size_t num_bins,
+			      size_t *const out)
+	{
+	  typedef typename boost::mpl::at_c<typename CBF::hash_function_type,
+					    N>::type Hash;
+	  static Hash hasher;
+
+	  out[N] = CBF::reduction_type::reduce(hasher(t), num_bins);
+	  counting_apply_hash<N-1, CBF>::positions(t, num_bins, out);
+	}
+
+	//? writes the num_positions unreduced hash values of t to out
+	static void hashes(const typename CBF::value_type& t,
+			   size_t *const out)
+	{
+	  typedef typename boost::mpl::at_c<typename CBF::hash_function_type,
+					    N>::type Hash;
+	  static Hash hasher;
+
+	  out[N] = hasher(t);
+	  counting_apply_hash<N-1, CBF>::hashes(t, out);
+	}
+
 	static void insert(const typename CBF::value_type& t, 
 			   typename CBF::bucket_type& slots,
-			   const size_t num_bins)
+			   const size_t num_bins,
+			   size_t& in_use)
 	{
-	  BloomOp<N, CBF, increment> inserter(t, slots, num_bins);
-	  inserter.update(slots, (1ull << CBF::bits_per_bin()) - 1ull);
+	  BloomOp<N, CBF> inserter(t, slots, num_bins);
+	  inserter.update(slots, increment(in_use),
+			  (1ull << CBF::bits_per_bin()) - 1ull);
 
-	  counting_apply_hash<N-1, CBF>::insert(t, slots);
+	  counting_apply_hash<N-1, CBF>::insert(t, slots, num_bins, in_use);
 	}
 
 	static void remove(const typename CBF::value_type& t, 
 			   typename CBF::bucket_type& slots,
-			   const size_t num_bins)
+			   const size_t num_bins,
+			   size_t& in_use)
 	{
-	  BloomOp<N, CBF, decrement> remover(t, slots, num_bins);
-	  remover.update(slots, 0);
+	  BloomOp<N, CBF> remover(t, slots, num_bins);
+	  remover.update(slots, decrement(in_use), 0);
 
-	  counting_apply_hash<N-1, CBF>::remove(t, slots);
+	  counting_apply_hash<N-1, CBF>::remove(t, slots, num_bins, in_use);
 	}
 
 	static bool contains(const typename CBF::value_type& t, 
@@ -106,27 +121,53 @@ namespace boost {
 	{
 	  BloomOp<N, CBF> checker(t, slots, num_bins);
 	  return (checker.check() && 
-		  counting_apply_hash<N-1, CBF>::contains(t, slots));
+		  counting_apply_hash<N-1, CBF>::contains(t, slots, num_bins));
 	}
       };
 
       template <class CBF>
       struct counting_apply_hash<0, CBF>
       {
+	static const size_t num_positions = 1;
+
+	static void positions(const typename CBF::value_type& t,
+			      const size_t num_bins,
+			      size_t *const out)
+	{
+	  typedef typename boost::mpl::at_c<typename CBF::hash_function_type,
+					    0>::type Hash;
+	  static Hash hasher;
+
+	  out[0] = CBF::reduction_type::reduce(hasher(t), num_bins);
+	}
+
+	static void hashes(const typename CBF::value_type& t,
+			   size_t *const out)
+	{
+	  typedef typename boost::mpl::at_c<typename CBF::hash_function_type,
+					    0>::type Hash;
+	  static Hash hasher;
+
+	  out[0] = hasher(t);
+	}
+
 	static void insert(const typename CBF::value_type& t, 
 			   typename CBF::bucket_type& slots,
-			   const size_t num_bins)
+			   const size_t num_bins,
+			   size_t& in_use)
 	{
-	  BloomOp<0, CBF, increment> inserter(t, slots, num_bins);
-	  inserter.update(slots, (1ull << CBF::bits_per_bin()) - 1ull);
+	  BloomOp<0, CBF> inserter(t, slots, num_bins);
+	  inserter.update(slots, increment(in_use),
+			  (1ull << CBF::bits_per_bin()) - 1ull);
 	}
 
 	static void remove(const typename CBF::value_type& t, 
 			   typename CBF::bucket_type& slots,
-			   const size_t num_bins)
+			   const size_t num_bins,
+			   size_t& in_use)
 	{
-	  BloomOp<0, CBF, decrement> remover(t, slots, num_bins);
-	  remover.update(slots, 0);
+	  BloomOp<0, CBF> remover(t, slots, num_bins);
+	  remover.update(slots, decrement(in_use), 0);
 	}
 
 	static bool contains(const typename CBF::value_type& t, 
@@ -138,6 +179,18 @@ namespace boost {
 	}
       };
 
+      //? counting_apply_hash for an mpl sequence of hash functions,
+      //? engine_counting_apply_hash for a hashing engine
+      template <typename HashFunctions, typename CBF>
+      struct select_counting_apply_hash
+      {
+	typedef typename mpl::if_<
+	  is_hash_engine<HashFunctions>,
+	  engine_counting_apply_hash<CBF>,
+	  counting_apply_hash<num_hashes<HashFunctions>::value - 1, CBF>
+	  >::type type;
+      };
+
     } // namespace detail
   } // namespace bloom_filter
 } // namespace boost
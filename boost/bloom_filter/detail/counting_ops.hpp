@@ -0,0 +1,84 @@
+//////////////////////////////////////////////////////////////////////////////
+//
+// (C) Copyright Alejandro Cabrera 2011.
+// Distributed under the Boost
+// Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or
+// copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// See http://www.boost.org/libs/bloom_filter for documentation.
+//
+//////////////////////////////////////////////////////////////////////////////
+
+#ifndef BOOST_BLOOM_FILTER_DETAIL_COUNTING_OPS_HPP
+#define BOOST_BLOOM_FILTER_DETAIL_COUNTING_OPS_HPP
+
+#include <cstddef>
+
+#include <boost/bloom_filter/detail/exceptions.hpp>
+
+namespace boost {
+  namespace bloom_filters {
+    namespace detail {
+
+      // The bin ops keep in_use, the filter's count of bins that
+      // aren't zero, in step with the bins they change.
+      struct decrement {
+	explicit decrement(size_t& in_use) : in_use(&in_use) {}
+
+	size_t operator()(const size_t val, const size_t limit) {
+	  if (val == limit)
+	    throw bin_underflow_exception();
+
+	  if (val == 1)
+	    --*this->in_use;
+	  return val - 1;
+	}
+
+	size_t *in_use;
+      };
+ 
+      struct increment {
+	explicit increment(size_t& in_use) : in_use(&in_use) {}
+
+	size_t operator()(const size_t val, const size_t limit) {
+	  if (val == limit)
+	    throw bin_overflow_exception();
+
+	  if (val == 0)
+	    ++*this->in_use;
+	  return val + 1;
+	}
+
+	size_t *in_use;
+      };
+
+      //? the value of bin number bin of a CBF bucket
+      template <typename CBF, typename Bucket>
+      size_t read_bin(const Bucket& slots, const size_t bin)
+      {
+	const size_t offset_bits =
+	  (bin % CBF::bins_per_slot()) * CBF::bits_per_bin();
+
+	return (slots[bin / CBF::bins_per_slot()] >> offset_bits) &
+	  CBF::mask();
+      }
+
+      //? replaces bin number bin with op(bin, limit)
+      template <typename CBF, typename Bucket, typename Op>
+      void update_bin(Bucket& slots, const size_t bin,
+		      Op op, const size_t limit)
+      {
+	const size_t pos = bin / CBF::bins_per_slot();
+	const size_t offset_bits =
+	  (bin % CBF::bins_per_slot()) * CBF::bits_per_bin();
+	const size_t final_bits = op(read_bin<CBF>(slots, bin), limit);
+
+	slots[pos] &= ~(CBF::mask() << offset_bits);
+	slots[pos] |= (final_bits << offset_bits);
+      }
+
+    } // namespace detail
+  } // namespace bloom_filter
+} // namespace boost
+#endif
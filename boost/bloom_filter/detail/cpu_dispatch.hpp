@@ -0,0 +1,98 @@
+//////////////////////////////////////////////////////////////////////////////
+//
+// (C) Copyright Alejandro Cabrera 2011.
+// Distributed under the Boost
+// Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or
+// copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// See http://www.boost.org/libs/bloom_filter for documentation.
+//
+//////////////////////////////////////////////////////////////////////////////
+
+#ifndef BOOST_BLOOM_FILTER_DETAIL_CPU_DISPATCH_HPP
+#define BOOST_BLOOM_FILTER_DETAIL_CPU_DISPATCH_HPP
+
+#include <boost/config.hpp>
+
+/**
+ * SIMD kernels are compiled with per-function target attributes and
+ * selected at run time, so a single binary runs on any x86-64 host
+ * while still using AVX2/AVX-512 where present. Define
+ * BOOST_BLOOM_FILTER_NO_SIMD to always use the portable scalar code.
+ */
+#if !defined(BOOST_BLOOM_FILTER_NO_SIMD) && defined(__x86_64__) && \
+  (defined(__clang__) || \
+   (defined(__GNUC__) && (__GNUC__ > 4 || \
+			  (__GNUC__ == 4 && __GNUC_MINOR__ >= 9))))
+#define BOOST_BLOOM_FILTER_HAS_SIMD_DISPATCH 1
+#define BOOST_BLOOM_FILTER_TARGET(isa) __attribute__((target(isa)))
+#include <immintrin.h>
+#endif
+
+namespace boost {
+  namespace bloom_filters {
+    namespace detail {
+
+      enum simd_level {
+	simd_none = 0,
+	simd_avx2 = 1,
+	simd_avx512 = 2
+      };
+
+      inline simd_level detect_simd_level()
+      {
+#ifdef BOOST_BLOOM_FILTER_HAS_SIMD_DISPATCH
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx512f"))
+	  return simd_avx512;
+	if (__builtin_cpu_supports("avx2"))
+	  return simd_avx2;
+#endif
+	return simd_none;
+      }
+
+      //? the widest instruction set usable on this host, detected once
+      inline simd_level cpu_simd_level()
+      {
+	static const simd_level level = detect_simd_level();
+	return level;
+      }
+
+#ifdef BOOST_BLOOM_FILTER_HAS_SIMD_DISPATCH
+      //* AVX-512 shifts and multiplies for the kernels. GCC implements
+      //* the plain intrinsics with an _mm512_undefined_epi32()
+      //* pass-through that it then warns about under
+      //* -Wmaybe-uninitialized; these are the same instructions with
+      //* every lane selected and a zero pass-through.
+      template <unsigned int Count>
+      BOOST_BLOOM_FILTER_TARGET("avx512f")
+      inline __m512i slli_epi64_avx512(const __m512i a)
+      {
+	return _mm512_maskz_slli_epi64(static_cast<__mmask8>(0xff), a, Count);
+      }
+
+      template <unsigned int Count>
+      BOOST_BLOOM_FILTER_TARGET("avx512f")
+      inline __m512i srli_epi64_avx512(const __m512i a)
+      {
+	return _mm512_maskz_srli_epi64(static_cast<__mmask8>(0xff), a, Count);
+      }
+
+      BOOST_BLOOM_FILTER_TARGET("avx512f")
+      inline __m512i srlv_epi64_avx512(const __m512i a, const __m512i count)
+      {
+	return _mm512_maskz_srlv_epi64(static_cast<__mmask8>(0xff), a, count);
+      }
+
+      BOOST_BLOOM_FILTER_TARGET("avx512f")
+      inline __m512i mul_epu32_avx512(const __m512i a, const __m512i b)
+      {
+	return _mm512_maskz_mul_epu32(static_cast<__mmask8>(0xff), a, b);
+      }
+#endif
+
+    } // namespace detail
+  } // namespace bloom_filter
+} // namespace boost
+#endif
@@ -0,0 +1,45 @@
+//////////////////////////////////////////////////////////////////////////////
+//
+// (C) Copyright Alejandro Cabrera 2011.
+// Distributed under the Boost
+// Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or
+// copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// See http://www.boost.org/libs/bloom_filter for documentation.
+//
+//////////////////////////////////////////////////////////////////////////////
+
+#ifndef BOOST_BLOOM_FILTER_DETAIL_DYNAMIC_STORAGE_HPP
+#define BOOST_BLOOM_FILTER_DETAIL_DYNAMIC_STORAGE_HPP
+
+#include <vector>
+
+#include <boost/dynamic_bitset.hpp>
+
+namespace boost {
+  namespace bloom_filters {
+
+    // see boost/bloom_filter/mapped_file.hpp
+    struct mapped_file;
+    struct mapped_file_params;
+
+    namespace detail {
+
+      // The containers behind the dynamic filters. Allocator is almost
+      // always an allocator; mapped_file.hpp specializes these for
+      // mapped_file, which puts the bits in a memory-mapped file.
+      template <typename Block, typename Allocator>
+      struct dynamic_bits {
+	typedef dynamic_bitset<Block, Allocator> type;
+      };
+
+      template <typename Block, typename Allocator>
+      struct dynamic_buckets {
+	typedef std::vector<Block, Allocator> type;
+      };
+
+    } // namespace detail
+  } // namespace bloom_filter
+} // namespace boost
+#endif
@@ -0,0 +1,189 @@
+//////////////////////////////////////////////////////////////////////////////
+//
+// (C) Copyright Alejandro Cabrera 2011.
+// Distributed under the Boost
+// Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or
+// copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// See http://www.boost.org/libs/bloom_filter for documentation.
+//
+//////////////////////////////////////////////////////////////////////////////
+
+#ifndef BOOST_BLOOM_FILTER_ENGINE_APPLY_HASH_HPP
+#define BOOST_BLOOM_FILTER_ENGINE_APPLY_HASH_HPP
+
+#include <boost/bloom_filter/detail/counting_ops.hpp>
+#include <boost/bloom_filter/detail/hash_engine.hpp>
+#include <boost/bloom_filter/detail/population.hpp>
+
+namespace boost {
+  namespace bloom_filters {
+    namespace detail {
+
+      // apply_hash for filters whose hash_function_type is a hashing
+      // engine: one engine call yields all the positions of a key
+      template <typename Container>
+      struct engine_apply_hash
+      {
+	typedef typename Container::value_type value_type;
+	typedef typename Container::bitset_type bitset_type;
+	typedef typename Container::hash_function_type hash_function_type;
+	typedef typename Container::reduction_type reduction_type;
+
+	static const size_t num_positions = hash_function_type::num_hashes;
+
+	// true_ if the engine hashes several keys per call
+	typedef typename is_multi_key_engine<hash_function_type>::type
+	  multi_key;
+
+	static void positions(const value_type& t,
+			      const size_t size,
+			      size_t *const out)
+	{
+	  static hash_function_type engine;
+
+	  engine(t, out);
+	  for (size_t i = 0; i < num_positions; ++i)
+	    out[i] = reduction_type::reduce(out[i], size);
+	}
+
+	//? writes the num_positions unreduced hash values of t to out
+	static void hashes(const value_type& t, size_t *const out)
+	{
+	  static hash_function_type engine;
+
+	  engine(t, out);
+	}
+
+	//? the positions of n keys, key after key; multi-key engines only
+	static void positions(const value_type *const keys,
+			      const size_t n,
+			      const size_t size,
+			      size_t *const out)
+	{
+	  static hash_function_type engine;
+
+	  engine(keys, n, out);
+	  for (size_t i = 0; i < n * num_positions; ++i)
+	    out[i] = reduction_type::reduce(out[i], size);
+	}
+
+	//? sets the bits of t; returns how many of them were clear
+        static size_t insert(const value_type& t, 
+			     bitset_type& bits) 
+	{
+	  size_t pos[num_positions];
+	  size_t set = 0;
+
+	  positions(t, bits.size(), pos);
+	  for (size_t i = 0; i < num_positions; ++i)
+	    set += set_bit(bits, pos[i]);
+	  return set;
+        }
+
+	// reduces lazily: most negative lookups end after a probe or two
+        static bool contains(const value_type& t, 
+			     const bitset_type& bits)
+	{
+	  static hash_function_type engine;
+	  size_t hashes[num_positions];
+
+	  engine(t, hashes);
+	  for (size_t i = 0; i < num_positions; ++i)
+	    if (!bits[reduction_type::reduce(hashes[i], bits.size())])
+	      return false;
+
+	  return true;
+        }
+      };
+
+      // CBF : Counting Bloom Filter
+      template <class CBF>
+      struct engine_counting_apply_hash
+      {
+	typedef typename CBF::value_type value_type;
+	typedef typename CBF::hash_function_type hash_function_type;
+
+	static const size_t num_positions = hash_function_type::num_hashes;
+
+	typedef typename is_multi_key_engine<hash_function_type>::type
+	  multi_key;
+
+	static void positions(const typename CBF::value_type& t,
+			      const size_t num_bins,
+			      size_t *const out)
+	{
+	  static hash_function_type engine;
+
+	  engine(t, out);
+	  for (size_t i = 0; i < num_positions; ++i)
+	    out[i] = CBF::reduction_type::reduce(out[i], num_bins);
+	}
+
+	static void hashes(const value_type& t, size_t *const out)
+	{
+	  static hash_function_type engine;
+
+	  engine(t, out);
+	}
+
+	static void positions(const typename CBF::value_type *const keys,
+			      const size_t n,
+			      const size_t num_bins,
+			      size_t *const out)
+	{
+	  static hash_function_type engine;
+
+	  engine(keys, n, out);
+	  for (size_t i = 0; i < n * num_positions; ++i)
+	    out[i] = CBF::reduction_type::reduce(out[i], num_bins);
+	}
+
+	static void insert(const typename CBF::value_type& t, 
+			   typename CBF::bucket_type& slots,
+			   const size_t num_bins,
+			   size_t& in_use)
+	{
+	  size_t bins[num_positions];
+
+	  positions(t, num_bins, bins);
+	  for (size_t i = 0; i < num_positions; ++i)
+	    update_bin<CBF>(slots, bins[i], increment(in_use),
+			    (static_cast<size_t>(1) << CBF::bits_per_bin()) - 1);
+	}
+
+	static void remove(const typename CBF::value_type& t, 
+			   typename CBF::bucket_type& slots,
+			   const size_t num_bins,
+			   size_t& in_use)
+	{
+	  size_t bins[num_positions];
+
+	  positions(t, num_bins, bins);
+	  for (size_t i = 0; i < num_positions; ++i)
+	    update_bin<CBF>(slots, bins[i], decrement(in_use), 0);
+	}
+
+	static bool contains(const typename CBF::value_type& t, 
+			     const typename CBF::bucket_type& slots,
+			     const size_t num_bins)
+	{
+	  static hash_function_type engine;
+	  size_t hashes[num_positions];
+
+	  engine(t, hashes);
+	  for (size_t i = 0; i < num_positions; ++i) {
+	    const size_t bin = CBF::reduction_type::reduce(hashes[i], num_bins);
+	    if (read_bin<CBF>(slots, bin) == 0)
+	      return false;
+	  }
+
+	  return true;
+	}
+      };
+
+    } // namespace detail
+  } // namespace bloom_filter
+} // namespace boost
+#endif
@@ -40,6 +40,27 @@ namespace boost {
 	}	
       };
 
+      class invalid_parameter_exception : public std::exception {
+	virtual const char *
+	what() const throw() {
+	  return "boost::bloom_filters::detail::invalid_parameter_exception";
+	}
+      };
+
+      class mapped_file_exception : public std::exception {
+	virtual const char *
+	what() const throw() {
+	  return "boost::bloom_filters::detail::mapped_file_exception";
+	}
+      };
+
+      class serialization_exception : public std::exception {
+	virtual const char *
+	what() const throw() {
+	  return "boost::bloom_filters::detail::serialization_exception";
+	}
+      };
+
     } // namespace detail
   } // namespace bloom_filter
 } // namespace boost
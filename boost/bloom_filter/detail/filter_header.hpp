@@ -0,0 +1,388 @@
+//////////////////////////////////////////////////////////////////////////////
+//
+// (C) Copyright Alejandro Cabrera 2011.
+// Distributed under the Boost
+// Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or
+// copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// See http://www.boost.org/libs/bloom_filter for documentation.
+//
+//////////////////////////////////////////////////////////////////////////////
+
+#ifndef BOOST_BLOOM_FILTER_DETAIL_FILTER_HEADER_HPP
+#define BOOST_BLOOM_FILTER_DETAIL_FILTER_HEADER_HPP
+
+#include <cstddef>
+#include <cstring>
+
+#include <boost/config.hpp>
+#include <boost/cstdint.hpp>
+#include <boost/core/ref.hpp>
+#include <boost/endian/conversion.hpp>
+#include <boost/mpl/for_each.hpp>
+#include <boost/mpl/is_sequence.hpp>
+#include <boost/mpl/placeholders.hpp>
+#include <boost/mpl/vector.hpp>
+#include <boost/type_traits/add_pointer.hpp>
+
+#include <boost/bloom_filter/detail/exceptions.hpp>
+
+namespace boost {
+  namespace bloom_filters {
+
+    // Only named here, so that a filter header doesn't pull in every
+    // hash function to describe the one it uses.
+    template <typename T, size_t Seed> struct boost_hash;
+    template <typename T, size_t Seed, bool Use128Mode> struct murmurhash3;
+    template <typename T, size_t Seed> struct murmurhash3_128;
+    template <typename T, size_t Seed> struct wyhash;
+    template <typename T, size_t Seed> struct wyhash_128;
+    template <typename T, size_t HashValues, class WideHash>
+    struct enhanced_double_hashing;
+    template <typename T, size_t HashValues, size_t Seed>
+    struct fixed_width_hashing;
+
+    struct modulo_reduction;
+    struct mask_reduction;
+    struct fastrange_reduction;
+
+    namespace detail {
+
+      struct square;
+      struct cube;
+      struct fourth;
+      struct zero;
+
+      // see boost/bloom_filter/serialization.hpp
+      struct filter_access;
+
+      // How the bits of a saved filter are laid out and probed. A
+      // fixed-size filter and its dynamic counterpart share a kind,
+      // so either can load what the other saved.
+      enum filter_kind {
+	hashed_bits = 1,	// basic_ and dynamic_bloom_filter
+	hashed_bins = 2,	// counting_ and dynamic_counting_bloom_filter
+	twohash_bits = 3,	// twohash_basic_ and twohash_dynamic_basic_
+	twohash_bins = 4,	// twohash_counting_ and twohash_dynamic_counting_
+	blocked_bits = 5	// blocked_bloom_filter
+      };
+
+      // How the payload holds the blocks. Only raw_blocks can be used
+      // in place.
+      enum payload_encoding {
+	raw_blocks = 0,		// the blocks themselves
+	golomb_gaps = 1		// see golomb.hpp
+      };
+
+      // What a filter records about itself in front of its blocks.
+      // capacity is the number of bits, or of bins for a counting
+      // filter; payload_bytes the size of the payload that follows,
+      // encoded as encoding says.
+      struct filter_header {
+	boost::uint8_t kind;
+	boost::uint8_t block_bytes;
+	boost::uint8_t reduction;
+	boost::uint8_t bits_per_bin;
+	boost::uint32_t hash_functions;
+	boost::uint8_t encoding;
+	boost::uint64_t capacity;
+	boost::uint64_t hash_identity;
+	boost::uint64_t seed;
+	boost::uint64_t payload_bytes;
+      };
+
+      //* the encoded header
+      // 64 bytes, all fields little-endian, so that blocks stored right
+      // after it start on a cache line:
+      //   0  magic "bstbloom"     24  u64 capacity
+      //   8  u16 version          32  u64 hash identity
+      //  10  u16 header size      40  u64 seed
+      //  12  u8  kind             48  u64 payload bytes
+      //  13  u8  block bytes      56  reserved, zero
+      //  14  u8  reduction
+      //  15  u8  bits per bin
+      //  16  u32 hash functions
+      //  20  u8  encoding
+      //  21  reserved, zero
+      // The raw_blocks payload is the blocks, each little-endian, zero-padded to a
+      // multiple of 8 bytes. For the bit kinds that makes bit i bit
+      // i % 8 of payload byte i / 8 whatever the Block type.
+      static const size_t encoded_header_size = 64;
+      static const char filter_magic[8] =
+	{'b', 's', 't', 'b', 'l', 'o', 'o', 'm'};
+      static const boost::uint16_t filter_format_version = 1;
+
+      //? bytes of payload for bytes of blocks
+      inline boost::uint64_t padded_payload(const boost::uint64_t bytes)
+      {
+	return (bytes + 7) / 8 * 8;
+      }
+
+      //? true when the blocks in memory already are the payload
+      inline bool native_payload()
+      {
+	return endian::order::native == endian::order::little;
+      }
+
+      template <typename Int>
+      void put_le(unsigned char *const out, const Int value)
+      {
+	endian::endian_store<Int, sizeof(Int), endian::order::little>(
+	  out, value);
+      }
+
+      template <typename Int>
+      Int get_le(const unsigned char *const in)
+      {
+	return endian::endian_load<Int, sizeof(Int),
+				   endian::order::little>(in);
+      }
+
+      inline void encode_header(const filter_header& header,
+				unsigned char *const out)
+      {
+	std::memset(out, 0, encoded_header_size);
+	std::memcpy(out, filter_magic, sizeof(filter_magic));
+	put_le<boost::uint16_t>(out + 8, filter_format_version);
+	put_le<boost::uint16_t>(out + 10, encoded_header_size);
+	out[12] = header.kind;
+	out[13] = header.block_bytes;
+	out[14] = header.reduction;
+	out[15] = header.bits_per_bin;
+	put_le<boost::uint32_t>(out + 16, header.hash_functions);
+	out[20] = header.encoding;
+	put_le<boost::uint64_t>(out + 24, header.capacity);
+	put_le<boost::uint64_t>(out + 32, header.hash_identity);
+	put_le<boost::uint64_t>(out + 40, header.seed);
+	put_le<boost::uint64_t>(out + 48, header.payload_bytes);
+      }
+
+      //? false unless in holds a header this version can read
+      inline bool decode_header(const unsigned char *const in,
+				filter_header& header)
+      {
+	if (std::memcmp(in, filter_magic, sizeof(filter_magic)) != 0 ||
+	    get_le<boost::uint16_t>(in + 8) != filter_format_version ||
+	    get_le<boost::uint16_t>(in + 10) != encoded_header_size ||
+	    in[20] > golomb_gaps)
+	  return false;
+
+	header.kind = in[12];
+	header.block_bytes = in[13];
+	header.reduction = in[14];
+	header.bits_per_bin = in[15];
+	header.hash_functions = get_le<boost::uint32_t>(in + 16);
+	header.encoding = in[20];
+	header.capacity = get_le<boost::uint64_t>(in + 24);
+	header.hash_identity = get_le<boost::uint64_t>(in + 32);
+	header.seed = get_le<boost::uint64_t>(in + 40);
+	header.payload_bytes = get_le<boost::uint64_t>(in + 48);
+	return true;
+      }
+
+      //? true if a filter described by expected can use the blocks
+      //? described by saved. A capacity of 0 in expected accepts any.
+      //? The bit kinds don't depend on the Block type.
+      inline bool header_matches(const filter_header& saved,
+				 const filter_header& expected)
+      {
+	const bool any_block = expected.kind == hashed_bits ||
+	  expected.kind == twohash_bits || expected.kind == blocked_bits;
+
+	return saved.kind == expected.kind &&
+	  saved.reduction == expected.reduction &&
+	  saved.bits_per_bin == expected.bits_per_bin &&
+	  saved.hash_functions == expected.hash_functions &&
+	  saved.encoding == expected.encoding &&
+	  saved.hash_identity == expected.hash_identity &&
+	  saved.seed == expected.seed &&
+	  (any_block || saved.block_bytes == expected.block_bytes) &&
+	  (expected.capacity == 0 || saved.capacity == expected.capacity);
+      }
+
+      //? throws serialization_exception unless header_matches
+      inline void check_header(const filter_header& saved,
+			       const filter_header& expected)
+      {
+	if (!header_matches(saved, expected))
+	  throw serialization_exception();
+      }
+
+      //* hash identity
+      // A code for each hash function the library ships, and its seed.
+      // Anything else is 0: filters hashing with their own functions
+      // can't tell them apart, and have to agree on them some other way.
+      template <typename Hash>
+      struct hash_identity {
+	static boost::uint64_t family() { return 0; }
+	static boost::uint64_t seed() { return 0; }
+      };
+
+      template <typename T, size_t Seed>
+      struct hash_identity<boost_hash<T, Seed> > {
+	static boost::uint64_t family() { return 1; }
+	static boost::uint64_t seed() { return Seed; }
+      };
+
+      template <typename T, size_t Seed, bool Use128Mode>
+      struct hash_identity<murmurhash3<T, Seed, Use128Mode> > {
+	static boost::uint64_t family() { return Use128Mode ? 2 : 3; }
+	static boost::uint64_t seed() { return Seed; }
+      };
+
+      template <typename T, size_t Seed>
+      struct hash_identity<murmurhash3_128<T, Seed> > {
+	static boost::uint64_t family() { return 4; }
+	static boost::uint64_t seed() { return Seed; }
+      };
+
+      template <typename T, size_t Seed>
+      struct hash_identity<wyhash<T, Seed> > {
+	static boost::uint64_t family() { return 5; }
+	static boost::uint64_t seed() { return Seed; }
+      };
+
+      template <typename T, size_t Seed>
+      struct hash_identity<wyhash_128<T, Seed> > {
+	static boost::uint64_t family() { return 6; }
+	static boost::uint64_t seed() { return Seed; }
+      };
+
+      template <typename T, size_t HashValues, class WideHash>
+      struct hash_identity<enhanced_double_hashing<T, HashValues,
+						   WideHash> > {
+	static boost::uint64_t family()
+	{
+	  return 7 | hash_identity<WideHash>::family() << 8;
+	}
+	static boost::uint64_t seed()
+	{
+	  return hash_identity<WideHash>::seed();
+	}
+      };
+
+      template <typename T, size_t HashValues, size_t Seed>
+      struct hash_identity<fixed_width_hashing<T, HashValues, Seed> > {
+	static boost::uint64_t family() { return 8; }
+	static boost::uint64_t seed() { return Seed; }
+      };
+
+      // the extension functions of the twohash filters
+      template <> struct hash_identity<square> {
+	static boost::uint64_t family() { return 32; }
+	static boost::uint64_t seed() { return 0; }
+      };
+
+      template <> struct hash_identity<cube> {
+	static boost::uint64_t family() { return 33; }
+	static boost::uint64_t seed() { return 0; }
+      };
+
+      template <> struct hash_identity<fourth> {
+	static boost::uint64_t family() { return 34; }
+	static boost::uint64_t seed() { return 0; }
+      };
+
+      template <> struct hash_identity<zero> {
+	static boost::uint64_t family() { return 35; }
+	static boost::uint64_t seed() { return 0; }
+      };
+
+      // mask_reduction agrees with modulo_reduction wherever it works
+      template <typename Reduction>
+      struct reduction_identity {
+	static const boost::uint8_t value = 0;
+      };
+
+      template <> struct reduction_identity<modulo_reduction> {
+	static const boost::uint8_t value = 1;
+      };
+
+      template <> struct reduction_identity<mask_reduction> {
+	static const boost::uint8_t value = 1;
+      };
+
+      template <> struct reduction_identity<fastrange_reduction> {
+	static const boost::uint8_t value = 2;
+      };
+
+      // Folds the identities of a list of hash functions, in order,
+      // into one value; seed is the seed of the first.
+      class identity_accumulator {
+      public:
+	identity_accumulator() : identity(0xcbf29ce484222325ull),
+				 first_seed(0), count(0) {}
+
+	template <typename Hash>
+	void operator()(Hash *)
+	{
+	  this->mix(hash_identity<Hash>::family());
+	  this->mix(hash_identity<Hash>::seed());
+	  if (this->count++ == 0)
+	    this->first_seed = hash_identity<Hash>::seed();
+	}
+
+	void mix(const boost::uint64_t value)
+	{
+	  this->identity = (this->identity ^ value) * 0x100000001b3ull;
+	}
+
+	boost::uint64_t identity;
+	boost::uint64_t first_seed;
+	size_t count;
+      };
+
+      template <typename HashFunctions>
+      void accumulate_hashes(identity_accumulator& acc, mpl::true_)
+      {
+	// for_each copies its function, unless it is a reference
+	mpl::for_each<HashFunctions, add_pointer<mpl::_1> >(boost::ref(acc));
+      }
+
+      template <typename HashFunction>
+      void accumulate_hashes(identity_accumulator& acc, mpl::false_)
+      {
+	acc(static_cast<HashFunction *>(0));
+      }
+
+      template <typename HashFunctions>
+      void accumulate_hashes(identity_accumulator& acc)
+      {
+	accumulate_hashes<HashFunctions>(
+	  acc, typename mpl::is_sequence<HashFunctions>::type());
+      }
+
+      //? the header of a filter of the given kind hashing with
+      //? HashFunctions, a list or a single function, then the list
+      //? Extra (the second hash and extension of a twohash filter)
+      template <typename HashFunctions, typename Reduction,
+		typename Extra>
+      filter_header make_header(const filter_kind kind,
+				const size_t block_bytes,
+				const size_t bits_per_bin,
+				const size_t hash_functions,
+				const size_t capacity)
+      {
+	identity_accumulator acc;
+	accumulate_hashes<HashFunctions>(acc);
+	accumulate_hashes<Extra>(acc);
+
+	filter_header header;
+	header.kind = static_cast<boost::uint8_t>(kind);
+	header.block_bytes = static_cast<boost::uint8_t>(block_bytes);
+	header.reduction = reduction_identity<Reduction>::value;
+	header.bits_per_bin = static_cast<boost::uint8_t>(bits_per_bin);
+	header.hash_functions = static_cast<boost::uint32_t>(hash_functions);
+	header.encoding = raw_blocks;
+	header.capacity = capacity;
+	header.hash_identity = acc.identity;
+	header.seed = acc.first_seed;
+	header.payload_bytes = 0;
+	return header;
+      }
+
+    } // namespace detail
+  } // namespace bloom_filters
+} // namespace boost
+#endif
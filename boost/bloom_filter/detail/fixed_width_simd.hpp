@@ -0,0 +1,210 @@
+//////////////////////////////////////////////////////////////////////////////
+//
+// (C) Copyright Alejandro Cabrera 2011.
+// Distributed under the Boost
+// Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or
+// copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// See http://www.boost.org/libs/bloom_filter for documentation.
+//
+//////////////////////////////////////////////////////////////////////////////
+
+#ifndef BOOST_BLOOM_FILTER_DETAIL_FIXED_WIDTH_SIMD_HPP
+#define BOOST_BLOOM_FILTER_DETAIL_FIXED_WIDTH_SIMD_HPP
+
+#include <cstddef>
+
+#include <boost/cstdint.hpp>
+
+#include <boost/bloom_filter/detail/cpu_dispatch.hpp>
+#include <boost/bloom_filter/hash/murmurhash3.hpp>
+
+namespace boost {
+  namespace bloom_filters {
+    namespace detail {
+
+      // Multi-key kernels for fixed_width_hashing. A key is Words 64 bit
+      // words; word j of key i is words[j][i]. Each kernel writes the
+      // two halves of the hash of key i to x[i] and y[i]:
+      //   x = fmix(w0 ^ seed_x), y = fmix(w0 ^ seed_y)
+      //   and for two word keys x = fmix(x ^ w1), y = fmix(y ^ w1)
+      // fmix is murmurhash3's 64 bit finalizer. All the kernels must
+      // give exactly what fixed_width_hash_scalar gives.
+      typedef void (*fixed_width_kernel)(
+	const boost::uint64_t *const *const words,
+	const size_t n,
+	const boost::uint64_t seed_x,
+	const boost::uint64_t seed_y,
+	boost::uint64_t *const x,
+	boost::uint64_t *const y);
+
+      template <size_t Words>
+      void fixed_width_hash_scalar(const boost::uint64_t *const *const words,
+				   const size_t n,
+				   const boost::uint64_t seed_x,
+				   const boost::uint64_t seed_y,
+				   boost::uint64_t *const x,
+				   boost::uint64_t *const y)
+      {
+	for (size_t i = 0; i < n; ++i) {
+	  x[i] = fmix(static_cast<boost::uint64_t>(words[0][i] ^ seed_x));
+	  y[i] = fmix(static_cast<boost::uint64_t>(words[0][i] ^ seed_y));
+
+	  for (size_t j = 1; j < Words; ++j) {
+	    x[i] = fmix(static_cast<boost::uint64_t>(x[i] ^ words[j][i]));
+	    y[i] = fmix(static_cast<boost::uint64_t>(y[i] ^ words[j][i]));
+	  }
+	}
+      }
+
+#ifdef BOOST_BLOOM_FILTER_HAS_SIMD_DISPATCH
+      // 64 bit multiplies are built from three 32x32 -> 64 bit ones;
+      // neither AVX2 nor AVX-512F has a 64 bit low multiply.
+
+      BOOST_BLOOM_FILTER_TARGET("avx2")
+      inline __m256i mullo64_avx2(const __m256i a, const __m256i b)
+      {
+	const __m256i lo = _mm256_mul_epu32(a, b);
+	const __m256i cross = _mm256_add_epi64(
+	  _mm256_mul_epu32(_mm256_srli_epi64(a, 32), b),
+	  _mm256_mul_epu32(a, _mm256_srli_epi64(b, 32)));
+	return _mm256_add_epi64(lo, _mm256_slli_epi64(cross, 32));
+      }
+
+      BOOST_BLOOM_FILTER_TARGET("avx2")
+      inline __m256i fmix_avx2(__m256i k)
+      {
+	const __m256i c1 = _mm256_set1_epi64x(0xff51afd7ed558ccdll);
+	const __m256i c2 = _mm256_set1_epi64x(0xc4ceb9fe1a85ec53ll);
+
+	k = _mm256_xor_si256(k, _mm256_srli_epi64(k, 33));
+	k = mullo64_avx2(k, c1);
+	k = _mm256_xor_si256(k, _mm256_srli_epi64(k, 33));
+	k = mullo64_avx2(k, c2);
+	return _mm256_xor_si256(k, _mm256_srli_epi64(k, 33));
+      }
+
+      // 4 keys per iteration
+      template <size_t Words>
+      BOOST_BLOOM_FILTER_TARGET("avx2")
+      void fixed_width_hash_avx2(const boost::uint64_t *const *const words,
+				 const size_t n,
+				 const boost::uint64_t seed_x,
+				 const boost::uint64_t seed_y,
+				 boost::uint64_t *const x,
+				 boost::uint64_t *const y)
+      {
+	const __m256i sx = _mm256_set1_epi64x(static_cast<long long>(seed_x));
+	const __m256i sy = _mm256_set1_epi64x(static_cast<long long>(seed_y));
+	size_t i = 0;
+
+	for (; i + 4 <= n; i += 4) {
+	  const __m256i w0 = _mm256_loadu_si256(
+	    reinterpret_cast<const __m256i *>(words[0] + i));
+	  __m256i vx = fmix_avx2(_mm256_xor_si256(w0, sx));
+	  __m256i vy = fmix_avx2(_mm256_xor_si256(w0, sy));
+
+	  for (size_t j = 1; j < Words; ++j) {
+	    const __m256i w = _mm256_loadu_si256(
+	      reinterpret_cast<const __m256i *>(words[j] + i));
+	    vx = fmix_avx2(_mm256_xor_si256(vx, w));
+	    vy = fmix_avx2(_mm256_xor_si256(vy, w));
+	  }
+
+	  _mm256_storeu_si256(reinterpret_cast<__m256i *>(x + i), vx);
+	  _mm256_storeu_si256(reinterpret_cast<__m256i *>(y + i), vy);
+	}
+
+	if (i < n) {
+	  const boost::uint64_t *rest[Words];
+	  for (size_t j = 0; j < Words; ++j)
+	    rest[j] = words[j] + i;
+	  fixed_width_hash_scalar<Words>(rest, n - i, seed_x, seed_y,
+					 x + i, y + i);
+	}
+      }
+
+      BOOST_BLOOM_FILTER_TARGET("avx512f")
+      inline __m512i mullo64_avx512(const __m512i a, const __m512i b)
+      {
+	const __m512i lo = mul_epu32_avx512(a, b);
+	const __m512i cross = _mm512_add_epi64(
+	  mul_epu32_avx512(srli_epi64_avx512<32>(a), b),
+	  mul_epu32_avx512(a, srli_epi64_avx512<32>(b)));
+	return _mm512_add_epi64(lo, slli_epi64_avx512<32>(cross));
+      }
+
+      BOOST_BLOOM_FILTER_TARGET("avx512f")
+      inline __m512i fmix_avx512(__m512i k)
+      {
+	const __m512i c1 = _mm512_set1_epi64(0xff51afd7ed558ccdll);
+	const __m512i c2 = _mm512_set1_epi64(0xc4ceb9fe1a85ec53ll);
+
+	k = _mm512_xor_si512(k, srli_epi64_avx512<33>(k));
+	k = mullo64_avx512(k, c1);
+	k = _mm512_xor_si512(k, srli_epi64_avx512<33>(k));
+	k = mullo64_avx512(k, c2);
+	return _mm512_xor_si512(k, srli_epi64_avx512<33>(k));
+      }
+
+      // 8 keys per iteration
+      template <size_t Words>
+      BOOST_BLOOM_FILTER_TARGET("avx512f")
+      void fixed_width_hash_avx512(const boost::uint64_t *const *const words,
+				   const size_t n,
+				   const boost::uint64_t seed_x,
+				   const boost::uint64_t seed_y,
+				   boost::uint64_t *const x,
+				   boost::uint64_t *const y)
+      {
+	const __m512i sx = _mm512_set1_epi64(static_cast<long long>(seed_x));
+	const __m512i sy = _mm512_set1_epi64(static_cast<long long>(seed_y));
+	size_t i = 0;
+
+	for (; i + 8 <= n; i += 8) {
+	  const __m512i w0 = _mm512_loadu_si512(words[0] + i);
+	  __m512i vx = fmix_avx512(_mm512_xor_si512(w0, sx));
+	  __m512i vy = fmix_avx512(_mm512_xor_si512(w0, sy));
+
+	  for (size_t j = 1; j < Words; ++j) {
+	    const __m512i w = _mm512_loadu_si512(words[j] + i);
+	    vx = fmix_avx512(_mm512_xor_si512(vx, w));
+	    vy = fmix_avx512(_mm512_xor_si512(vy, w));
+	  }
+
+	  _mm512_storeu_si512(x + i, vx);
+	  _mm512_storeu_si512(y + i, vy);
+	}
+
+	if (i < n) {
+	  const boost::uint64_t *rest[Words];
+	  for (size_t j = 0; j < Words; ++j)
+	    rest[j] = words[j] + i;
+	  fixed_width_hash_avx2<Words>(rest, n - i, seed_x, seed_y,
+				       x + i, y + i);
+	}
+      }
+#endif
+
+      //? the fastest kernel this host supports
+      template <size_t Words>
+      fixed_width_kernel select_fixed_width_kernel()
+      {
+#ifdef BOOST_BLOOM_FILTER_HAS_SIMD_DISPATCH
+	switch (cpu_simd_level()) {
+	case simd_avx512:
+	  return &fixed_width_hash_avx512<Words>;
+	case simd_avx2:
+	  return &fixed_width_hash_avx2<Words>;
+	default:
+	  break;
+	}
+#endif
+	return &fixed_width_hash_scalar<Words>;
+      }
+
+    } // namespace detail
+  } // namespace bloom_filter
+} // namespace boost
+#endif
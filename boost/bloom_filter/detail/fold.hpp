@@ -0,0 +1,80 @@
+//////////////////////////////////////////////////////////////////////////////
+//
+// (C) Copyright Alejandro Cabrera 2011.
+// Distributed under the Boost
+// Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or
+// copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// See http://www.boost.org/libs/bloom_filter for documentation.
+//
+//////////////////////////////////////////////////////////////////////////////
+
+#ifndef BOOST_BLOOM_FILTER_DETAIL_FOLD_HPP
+#define BOOST_BLOOM_FILTER_DETAIL_FOLD_HPP
+
+#include <climits>
+#include <cstddef>
+#include <vector>
+
+#include <boost/mpl/bool.hpp>
+
+#include <boost/bloom_filter/detail/combine.hpp>
+#include <boost/bloom_filter/detail/payload.hpp>
+#include <boost/bloom_filter/detail/population.hpp>
+#include <boost/bloom_filter/reduction.hpp>
+
+namespace boost {
+  namespace bloom_filters {
+    namespace detail {
+
+      // Folding a filter of m bits by a factor f that divides m ors
+      // bit i into bit i % (m / f). A key's bits land where probes of
+      // the folded filter look for them when the reduction satisfies
+      //   reduce(h, m / f) == reduce(h, m) % (m / f)
+      // as modulo_reduction does for any such m and f, and
+      // mask_reduction for the powers of two it allows. Multiply-shift
+      // reductions use the high bits of the hash and can't be folded.
+      template <typename Reduction>
+      struct foldable : mpl::false_ {};
+
+      template <>
+      struct foldable<modulo_reduction> : mpl::true_ {};
+
+      template <>
+      struct foldable<mask_reduction> : mpl::true_ {};
+
+      //? ors every bit i of from into bit i % into.size(), where
+      //? into.size() divides from.size(); returns the bits set in into
+      template <typename Bits>
+      size_t fold_bits(Bits& into, const Bits& from)
+      {
+	const size_t size = into.size();
+	if (size == 0)
+	  return 0;
+
+	Bits& source = const_cast<Bits&>(from);
+	const size_t block_bits = payload_block_bytes(into) * CHAR_BIT;
+
+	// whole blocks: every segment is or-ed in a tile at a time
+	if (size % block_bits == 0) {
+	  const size_t bytes = size / CHAR_BIT;
+	  const unsigned char *const first = block_bytes(source);
+	  std::vector<const unsigned char *> segments;
+	  for (size_t at = 0; at < from.size(); at += size)
+	    segments.push_back(first + at / CHAR_BIT);
+
+	  return combine_bytes(block_bytes(into), &segments[0],
+			       segments.size(), bytes, combine_or, true);
+	}
+
+	for (size_t i = 0; i < from.size(); ++i)
+	  if (from[i])
+	    set_bit(into, i % size);
+	return count_bits(into);
+      }
+
+    } // namespace detail
+  } // namespace bloom_filters
+} // namespace boost
+#endif
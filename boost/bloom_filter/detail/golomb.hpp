@@ -0,0 +1,308 @@
+//////////////////////////////////////////////////////////////////////////////
+//
+// (C) Copyright Alejandro Cabrera 2011.
+// Distributed under the Boost
+// Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or
+// copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// See http://www.boost.org/libs/bloom_filter for documentation.
+//
+//////////////////////////////////////////////////////////////////////////////
+
+#ifndef BOOST_BLOOM_FILTER_DETAIL_GOLOMB_HPP
+#define BOOST_BLOOM_FILTER_DETAIL_GOLOMB_HPP
+
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+
+#include <boost/cstdint.hpp>
+
+#include <boost/bloom_filter/detail/exceptions.hpp>
+#include <boost/bloom_filter/detail/filter_header.hpp>
+#include <boost/bloom_filter/detail/popcount.hpp>
+
+namespace boost {
+  namespace bloom_filters {
+    namespace detail {
+
+      // Golomb-Rice coding of a sparse bit array, as in Mitzenmacher's
+      // compressed Bloom filters. The array is written as the gaps
+      // between its set bits: a gap g as g >> r in unary (that many 1
+      // bits, then a 0), then its low r bits, with 2^r near ln(2) times
+      // the mean gap. Bits are packed low bit first:
+      //   0  u64 set bits
+      //   8  u8  r
+      //   9  the gaps
+      // Bit i of the array is bit i % 8 of byte i / 8, as in a payload.
+      static const size_t golomb_prefix_size = 9;
+      static const size_t golomb_max_parameter = 48;
+
+      //? r for ones set bits spread over bits bits
+      inline size_t rice_parameter(const boost::uint64_t ones,
+				   const boost::uint64_t bits)
+      {
+	if (ones == 0 || bits <= ones)
+	  return 0;
+
+	const double target = std::log(2.0) *
+	  static_cast<double>(bits - ones) / static_cast<double>(ones);
+	size_t r = 0;
+	while (r < golomb_max_parameter &&
+	       std::ldexp(1.0, static_cast<int>(r + 1)) <= target)
+	  ++r;
+	return r;
+      }
+
+      //? the bytes golomb_encode is expected to write for bits bits
+      //? with ones of them set at random
+      inline double golomb_estimate(const double ones, const double bits)
+      {
+	const size_t r = rice_parameter(
+	  static_cast<boost::uint64_t>(ones),
+	  static_cast<boost::uint64_t>(bits));
+	if (ones <= 0.0)
+	  return static_cast<double>(golomb_prefix_size);
+
+	// with geometric gaps, each quotient is on average
+	// s / (1 - s) for s = P(gap >= 2^r)
+	const double stay = std::pow(1.0 - ones / bits,
+				     std::ldexp(1.0, static_cast<int>(r)));
+	const double coded =
+	  ones * (static_cast<double>(r + 1) + stay / (1.0 - stay));
+	return static_cast<double>(golomb_prefix_size) + coded / 8.0;
+      }
+
+      //? golomb_estimate for bits bits after probes random probes
+      inline double golomb_estimate_for(const size_t bits,
+					const double probes)
+      {
+	const double m = static_cast<double>(bits);
+	return golomb_estimate(m * (1.0 - std::exp(-probes / m)), m);
+      }
+
+      //? calls visit(i) for every set bit i of the size bytes at in,
+      //? in order
+      template <typename Visit>
+      void for_each_one(const unsigned char *const in, const size_t size,
+			Visit& visit)
+      {
+	size_t i = 0;
+	for (; i + 8 <= size; i += 8) {
+	  boost::uint64_t word = get_le<boost::uint64_t>(in + i);
+	  while (word != 0) {
+	    const boost::uint64_t low = word & (~word + 1);
+	    visit(i * 8 + popcount(low - 1));
+	    word ^= low;
+	  }
+	}
+
+	for (; i < size; ++i)
+	  for (size_t bit = 0; bit < 8; ++bit)
+	    if ((in[i] >> bit) & 1)
+	      visit(i * 8 + bit);
+      }
+
+      struct one_counter {
+	one_counter() : ones(0) {}
+	void operator()(size_t) { ++this->ones; }
+	boost::uint64_t ones;
+      };
+
+      // sums the coded length of every gap, in bits
+      struct gap_sizer {
+	explicit gap_sizer(const size_t r) : r(r), next(0), bits(0) {}
+
+	void operator()(const size_t i)
+	{
+	  this->bits += ((i - this->next) >> this->r) + 1 + this->r;
+	  this->next = i + 1;
+	}
+
+	size_t r;
+	size_t next;
+	boost::uint64_t bits;
+      };
+
+      class golomb_writer {
+      public:
+	golomb_writer(unsigned char *const out, const size_t r)
+	  : out(out), r(r), next(0), acc(0), fill(0)
+	{}
+
+	void operator()(const size_t i)
+	{
+	  const boost::uint64_t gap = i - this->next;
+	  this->next = i + 1;
+
+	  boost::uint64_t q = gap >> this->r;
+	  for (; q >= 32; q -= 32)
+	    this->put(0xffffffffull, 32);
+	  this->put((static_cast<boost::uint64_t>(1) << q) - 1, q + 1);
+	  this->put(gap & ((static_cast<boost::uint64_t>(1) << this->r) - 1),
+		    this->r);
+	}
+
+	//? writes out the last partial byte; returns the end
+	unsigned char *finish()
+	{
+	  if (this->fill != 0)
+	    *this->out++ = static_cast<unsigned char>(this->acc);
+	  return this->out;
+	}
+
+      private:
+	// n <= golomb_max_parameter, and fill < 8 between calls
+	void put(const boost::uint64_t value, const size_t n)
+	{
+	  this->acc |= value << this->fill;
+	  this->fill += n;
+	  for (; this->fill >= 8; this->fill -= 8, this->acc >>= 8)
+	    *this->out++ = static_cast<unsigned char>(this->acc);
+	}
+
+	unsigned char *out;
+	size_t r;
+	size_t next;
+	boost::uint64_t acc;
+	size_t fill;
+      };
+
+      // reads what golomb_writer wrote; throws serialization_exception
+      // rather than read past end
+      class golomb_reader {
+      public:
+	golomb_reader(const unsigned char *const in,
+		      const unsigned char *const end)
+	  : in(in), end(end), acc(0), fill(0)
+	{}
+
+	boost::uint64_t get(const size_t n)
+	{
+	  if (n == 0)
+	    return 0;
+
+	  this->refill(n);
+	  const boost::uint64_t value =
+	    this->acc & ((static_cast<boost::uint64_t>(1) << n) - 1);
+	  this->acc >>= n;
+	  this->fill -= n;
+	  return value;
+	}
+
+	//? the number of 1 bits before the next 0
+	boost::uint64_t unary()
+	{
+	  boost::uint64_t q = 0;
+
+	  for (;;) {
+	    if (this->fill == 0)
+	      this->refill(1);
+
+	    const boost::uint64_t zeros = ~this->acc &
+	      ((static_cast<boost::uint64_t>(1) << this->fill) - 1);
+	    if (zeros == 0) {
+	      q += this->fill;
+	      this->acc = 0;
+	      this->fill = 0;
+	      continue;
+	    }
+
+	    const size_t ones = popcount((zeros & (~zeros + 1)) - 1);
+	    this->acc >>= ones + 1;
+	    this->fill -= ones + 1;
+	    return q + ones;
+	  }
+	}
+
+      private:
+	void refill(const size_t n)
+	{
+	  for (; this->fill < n; this->fill += 8) {
+	    if (this->in == this->end)
+	      throw serialization_exception();
+	    this->acc |=
+	      static_cast<boost::uint64_t>(*this->in++) << this->fill;
+	  }
+	}
+
+	const unsigned char *in;
+	const unsigned char *end;
+	boost::uint64_t acc;
+	size_t fill;
+      };
+
+      //? the number of bytes golomb_encode writes for the size bytes
+      //? at in
+      inline size_t golomb_size(const unsigned char *const in,
+				const size_t size)
+      {
+	one_counter counter;
+	for_each_one(in, size, counter);
+
+	gap_sizer sizer(rice_parameter(counter.ones,
+				       static_cast<boost::uint64_t>(size) * 8));
+	for_each_one(in, size, sizer);
+	return golomb_prefix_size + static_cast<size_t>((sizer.bits + 7) / 8);
+      }
+
+      //? codes the size bytes at in to out, which has room for
+      //? golomb_size(in, size) bytes; returns the number written
+      inline size_t golomb_encode(const unsigned char *const in,
+				  const size_t size,
+				  unsigned char *const out)
+      {
+	one_counter counter;
+	for_each_one(in, size, counter);
+	const size_t r = rice_parameter(
+	  counter.ones, static_cast<boost::uint64_t>(size) * 8);
+
+	put_le<boost::uint64_t>(out, counter.ones);
+	out[8] = static_cast<unsigned char>(r);
+
+	golomb_writer writer(out + golomb_prefix_size, r);
+	for_each_one(in, size, writer);
+	return static_cast<size_t>(writer.finish() - out);
+      }
+
+      //? decodes the bytes at in into the size bytes at out. Throws
+      //? serialization_exception if they aren't golomb_encode's, or
+      //? set a bit past out; out is then left partly written.
+      inline void golomb_decode(const unsigned char *const in,
+				const size_t bytes,
+				unsigned char *const out,
+				const size_t size)
+      {
+	if (bytes < golomb_prefix_size)
+	  throw serialization_exception();
+
+	const boost::uint64_t ones = get_le<boost::uint64_t>(in);
+	const size_t r = in[8];
+	const boost::uint64_t bits = static_cast<boost::uint64_t>(size) * 8;
+	if (r > golomb_max_parameter || ones > bits)
+	  throw serialization_exception();
+
+	if (size != 0)
+	  std::memset(out, 0, size);
+
+	golomb_reader reader(in + golomb_prefix_size, in + bytes);
+	boost::uint64_t next = 0;
+	for (boost::uint64_t n = 0; n < ones; ++n) {
+	  const boost::uint64_t q = reader.unary();
+	  if (q > (bits >> r))
+	    throw serialization_exception();
+
+	  const boost::uint64_t i = next + ((q << r) | reader.get(r));
+	  if (i >= bits)
+	    throw serialization_exception();
+
+	  out[i / 8] |= static_cast<unsigned char>(1u << (i % 8));
+	  next = i + 1;
+	}
+      }
+
+    } // namespace detail
+  } // namespace bloom_filters
+} // namespace boost
+#endif
@@ -0,0 +1,116 @@
+//////////////////////////////////////////////////////////////////////////////
+//
+// (C) Copyright Alejandro Cabrera 2011.
+// Distributed under the Boost
+// Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or
+// copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// See http://www.boost.org/libs/bloom_filter for documentation.
+//
+//////////////////////////////////////////////////////////////////////////////
+
+#ifndef BOOST_BLOOM_FILTER_DETAIL_HASH_DIGEST_HPP
+#define BOOST_BLOOM_FILTER_DETAIL_HASH_DIGEST_HPP
+
+#include <cstddef>
+
+#include <boost/bloom_filter/detail/counting_ops.hpp>
+#include <boost/bloom_filter/detail/population.hpp>
+
+namespace boost {
+  namespace bloom_filters {
+    namespace detail {
+
+      // The N hash values of a key before they are reduced to bit or
+      // bin positions, as returned by a filter's hash_key(). The
+      // reduction happens when the digest is used, so a digest fits
+      // every filter with the same key type and hashing, whatever its
+      // size.
+      template <size_t N>
+      struct hash_digest {
+	static const size_t size = N;
+
+	size_t values[N];
+      };
+
+      template <size_t N>
+      bool operator==(const hash_digest<N>& lhs, const hash_digest<N>& rhs)
+      {
+	for (size_t i = 0; i < N; ++i)
+	  if (lhs.values[i] != rhs.values[i])
+	    return false;
+
+	return true;
+      }
+
+      template <size_t N>
+      bool operator!=(const hash_digest<N>& lhs, const hash_digest<N>& rhs)
+      {
+	return !(lhs == rhs);
+      }
+
+      // The helpers use the first k values of a digest; k is N except
+      // for filters that choose their number of hash values at run time.
+
+      //* std::bitset and dynamic_bitset backed filters
+      //? returns the number of bits that were clear
+      template <typename Reduction, size_t N, typename Bitset>
+      size_t bitset_insert_digest(const hash_digest<N>& digest, Bitset& bits,
+				  const size_t k = N)
+      {
+	size_t set = 0;
+	for (size_t i = 0; i < k; ++i)
+	  set += set_bit(bits,
+			 Reduction::reduce(digest.values[i], bits.size()));
+	return set;
+      }
+
+      template <typename Reduction, size_t N, typename Bitset>
+      bool bitset_contains_digest(const hash_digest<N>& digest,
+				  const Bitset& bits,
+				  const size_t k = N)
+      {
+	for (size_t i = 0; i < k; ++i)
+	  if (!bits[Reduction::reduce(digest.values[i], bits.size())])
+	    return false;
+
+	return true;
+      }
+
+      //* counting filters
+      template <typename CBF, typename Op, size_t N>
+      void counting_update_digest(const hash_digest<N>& digest,
+				  typename CBF::bucket_type& slots,
+				  const size_t num_bins,
+				  Op op,
+				  const size_t limit,
+				  const size_t k = N)
+      {
+	for (size_t i = 0; i < k; ++i)
+	  update_bin<CBF>(slots,
+			  CBF::reduction_type::reduce(digest.values[i],
+						      num_bins),
+			  op, limit);
+      }
+
+      template <typename CBF, size_t N>
+      bool counting_contains_digest(const hash_digest<N>& digest,
+				    const typename CBF::bucket_type& slots,
+				    const size_t num_bins,
+				    const size_t k = N)
+      {
+	for (size_t i = 0; i < k; ++i) {
+	  const size_t bin =
+	    CBF::reduction_type::reduce(digest.values[i], num_bins);
+	  if (read_bin<CBF>(slots, bin) == 0)
+	    return false;
+	}
+
+	return true;
+      }
+
+    } // namespace detail
+  } // namespace bloom_filter
+} // namespace boost
+#endif
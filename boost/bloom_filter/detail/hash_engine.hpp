@@ -0,0 +1,76 @@
+//////////////////////////////////////////////////////////////////////////////
+//
+// (C) Copyright Alejandro Cabrera 2011.
+// Distributed under the Boost
+// Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or
+// copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// See http://www.boost.org/libs/bloom_filter for documentation.
+//
+//////////////////////////////////////////////////////////////////////////////
+
+#ifndef BOOST_BLOOM_FILTER_DETAIL_HASH_ENGINE_HPP
+#define BOOST_BLOOM_FILTER_DETAIL_HASH_ENGINE_HPP
+
+#include <cstddef>
+
+#include <boost/mpl/and.hpp>
+#include <boost/mpl/eval_if.hpp>
+#include <boost/mpl/has_xxx.hpp>
+#include <boost/mpl/size.hpp>
+#include <boost/mpl/size_t.hpp>
+#include <boost/type_traits/is_convertible.hpp>
+
+namespace boost {
+  namespace bloom_filters {
+    namespace detail {
+
+      // A hashing engine can be used wherever a filter takes an
+      // mpl::vector of hash functions. Engines are marked with
+      //   typedef hash_engine_tag engine_category;
+      // and provide
+      //   static const size_t num_hashes;
+      //   void operator()(const T&, size_t *out);
+      // which writes num_hashes hash values of a key to out.
+      struct hash_engine_tag {};
+
+      // Engines tagged with multi_key_engine_tag also provide
+      //   void operator()(const T *keys, size_t n, size_t *out);
+      // which writes the num_hashes hash values of each of the n keys
+      // to out, key after key, with the same values the single key
+      // call gives. The batch operations hand them groups of keys.
+      struct multi_key_engine_tag : hash_engine_tag {};
+
+      BOOST_MPL_HAS_XXX_TRAIT_DEF(engine_category)
+
+      template <typename HashFunctions>
+      struct is_hash_engine : has_engine_category<HashFunctions> {};
+
+      template <typename Engine>
+      struct engine_is_multi_key
+	: is_convertible<typename Engine::engine_category *,
+			 multi_key_engine_tag *> {};
+
+      template <typename HashFunctions>
+      struct is_multi_key_engine
+	: mpl::and_<is_hash_engine<HashFunctions>,
+		    engine_is_multi_key<HashFunctions> > {};
+
+      template <typename Engine>
+      struct engine_num_hashes {
+	typedef mpl::size_t<Engine::num_hashes> type;
+      };
+
+      //? number of hash values per key, for engines and mpl sequences
+      template <typename HashFunctions>
+      struct num_hashes
+	: mpl::eval_if<is_hash_engine<HashFunctions>,
+		       engine_num_hashes<HashFunctions>,
+		       mpl::size<HashFunctions> >::type
+      {};
+
+    } // namespace detail
+  } // namespace bloom_filter
+} // namespace boost
+#endif
@@ -0,0 +1,526 @@
+//////////////////////////////////////////////////////////////////////////////
+//
+// (C) Copyright Alejandro Cabrera 2011.
+// Distributed under the Boost
+// Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or
+// copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// See http://www.boost.org/libs/bloom_filter for documentation.
+//
+//////////////////////////////////////////////////////////////////////////////
+
+#ifndef BOOST_BLOOM_FILTER_DETAIL_MAPPED_BLOCKS_HPP
+#define BOOST_BLOOM_FILTER_DETAIL_MAPPED_BLOCKS_HPP
+
+#include <algorithm>
+#include <climits>
+#include <cstddef>
+#include <cstring>
+#include <fstream>
+#include <ios>
+#include <string>
+
+#include <boost/config.hpp>
+#include <boost/cstdint.hpp>
+#include <boost/static_assert.hpp>
+#include <boost/interprocess/anonymous_shared_memory.hpp>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+#include <boost/bloom_filter/detail/dynamic_storage.hpp>
+#include <boost/bloom_filter/detail/exceptions.hpp>
+#include <boost/bloom_filter/detail/filter_header.hpp>
+#include <boost/bloom_filter/detail/payload.hpp>
+#include <boost/bloom_filter/detail/popcount.hpp>
+#include <boost/bloom_filter/detail/population.hpp>
+
+namespace boost {
+  namespace bloom_filters {
+
+    //! How a filter maps its file.
+    enum mapped_file_mode {
+      //? the file is never written; changes to the filter stay in
+      //? private copies of the pages they touch
+      mapped_read_only,
+      //? changes to the filter go to the file
+      mapped_read_write
+    };
+
+    //! The file behind a filter whose Allocator is mapped_file.
+    struct mapped_file_params {
+      explicit mapped_file_params(const std::string& path,
+				  const mapped_file_mode mode =
+				    mapped_read_write)
+	: path(path), mode(mode) {}
+
+      std::string path;
+      mapped_file_mode mode;
+    };
+
+    namespace detail {
+
+      // Blocks in a memory mapping: anonymous memory, a file after a
+      // filter_header (the format save() writes), or memory borrowed
+      // from the caller. Copies are anonymous.
+      template <typename Block>
+      class mapped_blocks {
+      public:
+	typedef Block value_type;
+	typedef Block *iterator;
+	typedef const Block *const_iterator;
+
+	mapped_blocks()
+	  : blocks(0), num_blocks(0), mode(mapped_read_write)
+	{
+	  std::memset(&this->file_layout, 0, sizeof(this->file_layout));
+	}
+
+	//? n zeroed blocks of anonymous memory
+	explicit mapped_blocks(const size_t n)
+	  : blocks(0), num_blocks(0), mode(mapped_read_write)
+	{
+	  std::memset(&this->file_layout, 0, sizeof(this->file_layout));
+	  this->map_anonymous(n);
+	}
+
+	//? creates file.path, replacing any file there, with n zeroed
+	//? blocks described by layout
+	mapped_blocks(const mapped_file_params& file, const size_t n,
+		      const filter_header& layout)
+	  : blocks(0), num_blocks(0), file_layout(layout),
+	    path(file.path), mode(file.mode)
+	{
+	  if (file.mode != mapped_read_write)
+	    throw invalid_parameter_exception();
+
+	  // the blocks are the payload only in little-endian memory
+	  if (!native_payload())
+	    throw mapped_file_exception();
+
+	  this->file_layout.block_bytes = sizeof(Block);
+	  this->file_layout.payload_bytes = n * sizeof(Block);
+	  unsigned char header[encoded_header_size];
+	  encode_header(this->file_layout, header);
+
+	  // a sparse file: the blocks read as zero until written
+	  std::filebuf out;
+	  if (!out.open(file.path.c_str(), std::ios_base::out |
+			std::ios_base::trunc | std::ios_base::binary))
+	    throw mapped_file_exception();
+
+	  const std::streamoff bytes = static_cast<std::streamoff>(
+	    sizeof(header) + padded_payload(n * sizeof(Block)));
+	  out.sputn(reinterpret_cast<const char *>(header), sizeof(header));
+	  if (n > 0) {
+	    out.pubseekoff(bytes - 1, std::ios_base::beg);
+	    out.sputc(0);
+	  }
+	  if (out.close() == 0)
+	    throw mapped_file_exception();
+
+	  this->map_file(file.path, file.mode);
+	}
+
+	//? maps the existing file.path, which has to match layout in
+	//? everything but capacity when layout.capacity is 0
+	mapped_blocks(const mapped_file_params& file,
+		      const filter_header& layout)
+	  : blocks(0), num_blocks(0), file_layout(layout),
+	    path(file.path), mode(file.mode)
+	{
+	  this->map_file(file.path, file.mode);
+	}
+
+	//? the n blocks at borrowed, which stay the caller's: they have
+	//? to outlive this, and are never freed
+	mapped_blocks(Block *const borrowed, const size_t n,
+		      const filter_header& layout)
+	  : blocks(borrowed), num_blocks(n), file_layout(layout),
+	    mode(mapped_read_write)
+	{
+	  this->file_layout.block_bytes = sizeof(Block);
+	  this->file_layout.payload_bytes = n * sizeof(Block);
+	}
+
+	mapped_blocks(const mapped_blocks& other)
+	  : blocks(0), num_blocks(0), file_layout(other.file_layout),
+	    mode(mapped_read_write)
+	{
+	  this->map_anonymous(other.num_blocks);
+	  std::copy(other.begin(), other.end(), this->begin());
+	}
+
+	//? copies into the existing mapping when the sizes match, so a
+	//? file backed container stays on its file
+	mapped_blocks& operator=(const mapped_blocks& rhs)
+	{
+	  if (this == &rhs)
+	    return *this;
+
+	  if (this->num_blocks == rhs.num_blocks) {
+	    std::copy(rhs.begin(), rhs.end(), this->begin());
+	    this->file_layout.capacity = rhs.file_layout.capacity;
+	  }
+	  else {
+	    mapped_blocks copy(rhs);
+	    this->swap(copy);
+	  }
+
+	  return *this;
+	}
+
+	void swap(mapped_blocks& other) BOOST_NOEXCEPT
+	{
+	  this->region.swap(other.region);
+	  std::swap(this->blocks, other.blocks);
+	  std::swap(this->num_blocks, other.num_blocks);
+	  std::swap(this->file_layout, other.file_layout);
+	  this->path.swap(other.path);
+	  std::swap(this->mode, other.mode);
+	}
+
+	size_t size() const { return this->num_blocks; }
+	bool empty() const { return this->num_blocks == 0; }
+
+	Block& operator[](const size_t i) { return this->blocks[i]; }
+	const Block& operator[](const size_t i) const
+	{
+	  return this->blocks[i];
+	}
+
+	iterator begin() { return this->blocks; }
+	iterator end() { return this->blocks + this->num_blocks; }
+	const_iterator begin() const { return this->blocks; }
+	const_iterator end() const { return this->blocks + this->num_blocks; }
+
+	const filter_header& layout() const { return this->file_layout; }
+	void set_capacity(const size_t capacity)
+	{
+	  this->file_layout.capacity = capacity;
+	}
+
+	//? the file this maps read-write, or an empty string
+	const std::string& file() const
+	{
+	  static const std::string none;
+	  return this->mode == mapped_read_write ? this->path : none;
+	}
+
+	//? writes changed pages back to the file (msync); returns at
+	//? once when async is true, else when the data is on disk.
+	//? Nothing to do unless the file is mapped read-write.
+	void flush(const bool async)
+	{
+	  if (this->file().empty())
+	    return;
+
+	  if (!this->region.flush(0, 0, async))
+	    throw mapped_file_exception();
+	}
+
+	//? drops the mapping; keeps the file name for a later resize
+	void release()
+	{
+	  interprocess::mapped_region none;
+	  this->region.swap(none);
+	  this->blocks = 0;
+	  this->num_blocks = 0;
+	  this->file_layout.capacity = 0;
+	}
+
+      private:
+	void map_anonymous(const size_t n)
+	{
+	  if (n == 0)
+	    return;
+
+	  interprocess::mapped_region anonymous =
+	    interprocess::anonymous_shared_memory(n * sizeof(Block));
+	  this->region.swap(anonymous);
+	  this->blocks = static_cast<Block *>(this->region.get_address());
+	  this->num_blocks = n;
+	}
+
+	void map_file(const std::string& name, const mapped_file_mode how)
+	{
+	  const interprocess::file_mapping file(
+	    name.c_str(),
+	    how == mapped_read_write ? interprocess::read_write :
+	                               interprocess::read_only);
+	  interprocess::mapped_region mapped(
+	    file,
+	    how == mapped_read_write ? interprocess::read_write :
+	                               interprocess::copy_on_write);
+
+	  unsigned char *const base =
+	    static_cast<unsigned char *>(mapped.get_address());
+	  filter_header header;
+
+	  if (!native_payload() ||
+	      mapped.get_size() < encoded_header_size ||
+	      !decode_header(base, header) ||
+	      header.block_bytes != sizeof(Block) ||
+	      !header_matches(header, this->file_layout) ||
+	      header.payload_bytes % sizeof(Block) != 0 ||
+	      mapped.get_size() - encoded_header_size < header.payload_bytes)
+	    throw mapped_file_exception();
+
+	  this->region.swap(mapped);
+	  this->blocks = reinterpret_cast<Block *>(base + encoded_header_size);
+	  this->num_blocks =
+	    static_cast<size_t>(header.payload_bytes / sizeof(Block));
+	  this->file_layout = header;
+	}
+
+	interprocess::mapped_region region;
+	Block *blocks;
+	size_t num_blocks;
+	filter_header file_layout;
+	std::string path;
+	mapped_file_mode mode;
+      };
+
+      template <typename Block>
+      bool operator==(const mapped_blocks<Block>& lhs,
+		      const mapped_blocks<Block>& rhs)
+      {
+	return lhs.size() == rhs.size() &&
+	  std::equal(lhs.begin(), lhs.end(), rhs.begin());
+      }
+
+      template <typename Block>
+      bool operator!=(const mapped_blocks<Block>& lhs,
+		      const mapped_blocks<Block>& rhs)
+      {
+	return !(lhs == rhs);
+      }
+
+      // The dynamic_bitset operations a dynamic_bloom_filter uses, over
+      // mapped_blocks. Bit i is bit i % bits_per_block of block
+      // i / bits_per_block, as in dynamic_bitset.
+      template <typename Block>
+      class mapped_bitset {
+	static const size_t bits_per_block = sizeof(Block) * CHAR_BIT;
+
+	static size_t blocks_for(const size_t num_bits)
+	{
+	  return (num_bits + bits_per_block - 1) / bits_per_block;
+	}
+
+	static filter_header with_capacity(filter_header layout,
+					   const size_t num_bits)
+	{
+	  layout.capacity = num_bits;
+	  return layout;
+	}
+
+      public:
+	class reference {
+	public:
+	  reference(Block& block, const Block mask)
+	    : block(block), mask(mask) {}
+
+	  operator bool() const { return (this->block & this->mask) != 0; }
+
+	  reference& operator=(const bool value)
+	  {
+	    if (value)
+	      this->block |= this->mask;
+	    else
+	      this->block &= ~this->mask;
+	    return *this;
+	  }
+
+	private:
+	  Block& block;
+	  const Block mask;
+	};
+
+	mapped_bitset() {}
+
+	explicit mapped_bitset(const size_t num_bits)
+	  : blocks(blocks_for(num_bits))
+	{
+	  this->blocks.set_capacity(num_bits);
+	}
+
+	mapped_bitset(const mapped_file_params& file, const size_t num_bits,
+		      const filter_header& layout)
+	  : blocks(file, blocks_for(num_bits), with_capacity(layout, num_bits))
+	{}
+
+	mapped_bitset(const mapped_file_params& file,
+		      const filter_header& layout)
+	  : blocks(file, layout)
+	{
+	  if (this->blocks.size() != blocks_for(this->size()))
+	    throw mapped_file_exception();
+	}
+
+	//? num_bits bits in the caller's blocks at borrowed
+	mapped_bitset(Block *const borrowed, const size_t num_bits,
+		      const filter_header& layout)
+	  : blocks(borrowed, blocks_for(num_bits),
+		   with_capacity(layout, num_bits))
+	{}
+
+	size_t size() const
+	{
+	  return static_cast<size_t>(this->blocks.layout().capacity);
+	}
+
+	size_t num_blocks() const { return this->blocks.size(); }
+
+	bool operator[](const size_t i) const
+	{
+	  return (this->blocks[i / bits_per_block] >>
+		  (i % bits_per_block)) & 1;
+	}
+
+	reference operator[](const size_t i)
+	{
+	  return reference(this->blocks[i / bits_per_block],
+			   static_cast<Block>(1) << (i % bits_per_block));
+	}
+
+	size_t count() const
+	{
+	  return this->blocks.empty() ? 0 :
+	    popcount(this->blocks.begin(), this->blocks.end());
+	}
+
+	mapped_bitset& reset()
+	{
+	  std::fill(this->blocks.begin(), this->blocks.end(), Block(0));
+	  return *this;
+	}
+
+	mapped_bitset& operator|=(const mapped_bitset& rhs)
+	{
+	  for (size_t i = 0; i < this->blocks.size(); ++i)
+	    this->blocks[i] |= rhs.blocks[i];
+	  return *this;
+	}
+
+	mapped_bitset& operator&=(const mapped_bitset& rhs)
+	{
+	  for (size_t i = 0; i < this->blocks.size(); ++i)
+	    this->blocks[i] &= rhs.blocks[i];
+	  return *this;
+	}
+
+	void swap(mapped_bitset& other) BOOST_NOEXCEPT
+	{
+	  this->blocks.swap(other.blocks);
+	}
+
+	//? empties the bitset, as dynamic_bitset::clear() does
+	void clear()
+	{
+	  this->blocks.release();
+	}
+
+	//? num_bits zeroed bits, in a new file of the same name if this
+	//? mapped one read-write; the old bits are discarded
+	void resize(const size_t num_bits)
+	{
+	  if (this->blocks.file().empty()) {
+	    mapped_bitset fresh(num_bits);
+	    this->swap(fresh);
+	  }
+	  else {
+	    // unmap before the file is truncated
+	    const std::string file = this->blocks.file();
+	    const filter_header layout = this->blocks.layout();
+	    this->blocks.release();
+
+	    mapped_bitset fresh(mapped_file_params(file), num_bits, layout);
+	    this->swap(fresh);
+	  }
+	}
+
+	void flush(const bool async) { this->blocks.flush(async); }
+
+	mapped_blocks<Block>& data() { return this->blocks; }
+	const mapped_blocks<Block>& data() const { return this->blocks; }
+
+	friend bool operator==(const mapped_bitset& lhs,
+			       const mapped_bitset& rhs)
+	{
+	  return lhs.size() == rhs.size() && lhs.blocks == rhs.blocks;
+	}
+
+	friend bool operator!=(const mapped_bitset& lhs,
+			       const mapped_bitset& rhs)
+	{
+	  return !(lhs == rhs);
+	}
+
+      private:
+	mapped_blocks<Block> blocks;
+      };
+
+      template <typename Block>
+      const char *bit_storage(const mapped_bitset<Block>& bits)
+      {
+	return bits.num_blocks() == 0 ? 0 :
+	  reinterpret_cast<const char *>(&*bits.data().begin());
+      }
+
+      // a mapping may be a file other processes write, or the
+      // caller's buffer (see population.hpp)
+      template <typename Block>
+      struct shared_storage<mapped_blocks<Block> > : mpl::true_ {};
+
+      template <typename Block>
+      struct shared_storage<mapped_bitset<Block> > : mpl::true_ {};
+
+      //* payload (see payload.hpp)
+      template <typename Block>
+      block_span<Block> span_of(mapped_blocks<Block>& blocks)
+      {
+	return make_span(blocks.empty() ? 0 : &*blocks.begin(), blocks.size());
+      }
+
+      template <typename Block>
+      block_span<Block> span_of(mapped_bitset<Block>& bits)
+      {
+	return span_of(bits.data());
+      }
+
+      //? the blocks of a filter saved at image + encoded_header_size,
+      //? used where they are
+      template <typename Block>
+      void borrow_payload(mapped_blocks<Block>& blocks,
+			  unsigned char *const image,
+			  const filter_header& saved)
+      {
+	check_borrowed<Block>(image, saved,
+			      static_cast<size_t>(saved.payload_bytes));
+	mapped_blocks<Block> borrowed(
+	  reinterpret_cast<Block *>(image + encoded_header_size),
+	  static_cast<size_t>(saved.payload_bytes / sizeof(Block)), saved);
+	blocks.swap(borrowed);
+      }
+
+      template <typename Block>
+      void borrow_payload(mapped_bitset<Block>& bits,
+			  unsigned char *const image,
+			  const filter_header& saved)
+      {
+	const size_t block_bits = sizeof(Block) * CHAR_BIT;
+	const size_t num_bits = static_cast<size_t>(saved.capacity);
+	check_borrowed<Block>(image, saved,
+			      (num_bits + block_bits - 1) / block_bits *
+			        sizeof(Block));
+	mapped_bitset<Block> borrowed(
+	  reinterpret_cast<Block *>(image + encoded_header_size),
+	  num_bits, saved);
+	bits.swap(borrowed);
+      }
+
+    } // namespace detail
+  } // namespace bloom_filter
+} // namespace boost
+#endif
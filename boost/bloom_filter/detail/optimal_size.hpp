@@ -0,0 +1,77 @@
+//////////////////////////////////////////////////////////////////////////////
+//
+// (C) Copyright Alejandro Cabrera 2011.
+// Distributed under the Boost
+// Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or
+// copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// See http://www.boost.org/libs/bloom_filter for documentation.
+//
+//////////////////////////////////////////////////////////////////////////////
+
+#ifndef BOOST_BLOOM_FILTER_DETAIL_OPTIMAL_SIZE_HPP
+#define BOOST_BLOOM_FILTER_DETAIL_OPTIMAL_SIZE_HPP
+
+#include <cmath>
+#include <cstddef>
+
+#include <boost/bloom_filter/detail/exceptions.hpp>
+#include <boost/bloom_filter/reduction.hpp>
+
+namespace boost {
+  namespace bloom_filters {
+    namespace detail {
+
+      // Run time sizing for the filters whose size is a constructor
+      // argument; optimal_parameters does the same at compile time.
+      // n is the expected number of insertions, p the target false
+      // positive rate, k the number of hash values per key.
+
+      inline void check_sizing(const size_t n, const double p)
+      {
+	if (n == 0 || !(p > 0.0 && p < 1.0))
+	  throw invalid_parameter_exception();
+      }
+
+      //? round(-log2(p)), at least 1
+      inline size_t optimal_hash_count(const double p)
+      {
+	check_sizing(1, p);
+	const double k = std::floor(-std::log(p) / std::log(2.0) + 0.5);
+	return k < 1.0 ? 1 : static_cast<size_t>(k);
+      }
+
+      //? ceil(-n * ln(p) / ln(2)^2): the bits needed when the number
+      //? of hash values is optimal_hash_count(p)
+      inline size_t optimal_bit_count(const size_t n, const double p)
+      {
+	check_sizing(n, p);
+	const double ln2 = std::log(2.0);
+	return static_cast<size_t>(
+	  std::ceil(-static_cast<double>(n) * std::log(p) / (ln2 * ln2)));
+      }
+
+      //? the fewest bits that keep the rate at or below p when k is
+      //? fixed: p = (1 - e^(-kn/m))^k  =>  m = -kn / ln(1 - p^(1/k)),
+      //? rounded up to a range Reduction can reduce onto
+      template <typename Reduction>
+      size_t bit_count_for(const size_t n,
+			   const double p,
+			   const size_t k)
+      {
+	check_sizing(n, p);
+	const double kd = static_cast<double>(k);
+	const double m = -kd * static_cast<double>(n) /
+	  std::log(1.0 - std::pow(p, 1.0 / kd));
+	const size_t bits = range_for<Reduction>(
+	  static_cast<size_t>(std::ceil(m)));
+	if (bits == 0)
+	  throw invalid_parameter_exception();
+	return bits;
+      }
+
+    } // namespace detail
+  } // namespace bloom_filter
+} // namespace boost
+#endif
@@ -0,0 +1,193 @@
+//////////////////////////////////////////////////////////////////////////////
+//
+// (C) Copyright Alejandro Cabrera 2011.
+// Distributed under the Boost
+// Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or
+// copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// See http://www.boost.org/libs/bloom_filter for documentation.
+//
+//////////////////////////////////////////////////////////////////////////////
+
+#ifndef BOOST_BLOOM_FILTER_DETAIL_PAGE_MEMORY_HPP
+#define BOOST_BLOOM_FILTER_DETAIL_PAGE_MEMORY_HPP
+
+#include <cstddef>
+#include <new>
+
+#include <boost/config.hpp>
+#include <boost/align/aligned_alloc.hpp>
+
+#if defined(BOOST_HAS_UNISTD_H)
+#include <sys/mman.h>
+#include <unistd.h>
+#if defined(MAP_ANONYMOUS)
+#define BOOST_BLOOM_FILTER_HAS_MMAP 1
+#endif
+#endif
+
+namespace boost {
+  namespace bloom_filters {
+
+    //! Placement flags for page_allocator, or-ed together.
+    //? ask for transparent huge pages (madvise(MADV_HUGEPAGE))
+    static const unsigned transparent_huge_pages = 1;
+    //? try pages from the hugetlbfs pool first (MAP_HUGETLB); falls
+    //? back to transparent huge pages if the pool is empty
+    static const unsigned explicit_huge_pages = 2;
+    //? fault every page in when the memory is allocated
+    static const unsigned prefault_pages = 4;
+    //? keep 4 KiB pages even if the system default is huge pages
+    static const unsigned no_huge_pages = 8;
+
+    namespace detail {
+
+      static const size_t huge_page_size = static_cast<size_t>(2) << 20;
+
+      inline size_t round_up(const size_t n, const size_t multiple)
+      {
+	return (n + multiple - 1) / multiple * multiple;
+      }
+
+      inline size_t system_page_size()
+      {
+#if defined(BOOST_BLOOM_FILTER_HAS_MMAP)
+	const long size = sysconf(_SC_PAGESIZE);
+	if (size > 0)
+	  return static_cast<size_t>(size);
+#endif
+	return 4096;
+      }
+
+      // writes one byte per page of memory that nothing lives in yet
+      inline void touch_pages(void *const p, const size_t bytes)
+      {
+	volatile char *const c = static_cast<char *>(p);
+	const size_t page = system_page_size();
+
+	for (size_t i = 0; i < bytes; i += page)
+	  c[i] = 0;
+      }
+
+      // Allocations of at least a huge page are mapped directly, aligned
+      // to a huge page boundary so transparent huge pages can back all
+      // of them; smaller ones come from aligned_alloc.
+      inline bool maps_pages(const size_t bytes)
+      {
+#if defined(BOOST_BLOOM_FILTER_HAS_MMAP)
+	return bytes >= huge_page_size;
+#else
+	(void)bytes;
+	return false;
+#endif
+      }
+
+      inline size_t mapped_alignment(const size_t align_to)
+      {
+	return align_to > huge_page_size ? align_to : huge_page_size;
+      }
+
+#if defined(BOOST_BLOOM_FILTER_HAS_MMAP)
+      inline void *map_aligned(const size_t length, const size_t align_to)
+      {
+	const size_t page = system_page_size();
+	const size_t padded = length + align_to - page;
+	void *const raw = mmap(0, padded, PROT_READ | PROT_WRITE,
+			       MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (raw == MAP_FAILED)
+	  return 0;
+
+	// trim the mapping to an aligned window of length bytes
+	char *const start = static_cast<char *>(raw);
+	const size_t address = reinterpret_cast<size_t>(start);
+	char *const aligned = start + (round_up(address, align_to) - address);
+	char *const end = start + padded;
+
+	if (aligned != start)
+	  munmap(start, aligned - start);
+	if (aligned + length != end)
+	  munmap(aligned + length, end - (aligned + length));
+
+	return aligned;
+      }
+
+      inline void *map_pages(const size_t bytes, const size_t align_to,
+			     const unsigned placement)
+      {
+	const size_t length = round_up(bytes, huge_page_size);
+	void *p = 0;
+
+#if defined(MAP_HUGETLB)
+	// hugetlbfs mappings are huge page aligned by construction
+	if ((placement & explicit_huge_pages) &&
+	    align_to <= huge_page_size) {
+	  p = mmap(0, length, PROT_READ | PROT_WRITE,
+		   MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+	  if (p == MAP_FAILED)
+	    p = 0;
+	}
+#endif
+
+	if (p == 0) {
+	  p = map_aligned(length, mapped_alignment(align_to));
+	  if (p == 0)
+	    throw std::bad_alloc();
+
+#if defined(MADV_HUGEPAGE) && defined(MADV_NOHUGEPAGE)
+	  if (placement & no_huge_pages)
+	    madvise(p, length, MADV_NOHUGEPAGE);
+	  else if (placement & (transparent_huge_pages | explicit_huge_pages))
+	    madvise(p, length, MADV_HUGEPAGE);
+#endif
+	}
+
+	if (placement & prefault_pages) {
+#if defined(MADV_POPULATE_WRITE)
+	  if (madvise(p, length, MADV_POPULATE_WRITE) != 0)
+	    touch_pages(p, length);
+#else
+	  touch_pages(p, length);
+#endif
+	}
+
+	return p;
+      }
+#endif
+
+      //? bytes of memory aligned to align_to, placed as placement asks
+      inline void *allocate_pages(const size_t bytes, const size_t align_to,
+				  const unsigned placement)
+      {
+#if defined(BOOST_BLOOM_FILTER_HAS_MMAP)
+	if (maps_pages(bytes))
+	  return map_pages(bytes, align_to, placement);
+#endif
+
+	void *const p = alignment::aligned_alloc(align_to, bytes ? bytes : 1);
+	if (p == 0)
+	  throw std::bad_alloc();
+
+	if (placement & prefault_pages)
+	  touch_pages(p, bytes);
+
+	return p;
+      }
+
+      //? releases what allocate_pages(bytes, ...) returned
+      inline void deallocate_pages(void *const p, const size_t bytes)
+      {
+#if defined(BOOST_BLOOM_FILTER_HAS_MMAP)
+	if (maps_pages(bytes)) {
+	  munmap(p, round_up(bytes, huge_page_size));
+	  return;
+	}
+#endif
+
+	alignment::aligned_free(p);
+      }
+
+    } // namespace detail
+  } // namespace bloom_filter
+} // namespace boost
+#endif
@@ -0,0 +1,309 @@
+//////////////////////////////////////////////////////////////////////////////
+//
+// (C) Copyright Alejandro Cabrera 2011.
+// Distributed under the Boost
+// Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or
+// copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// See http://www.boost.org/libs/bloom_filter for documentation.
+//
+//////////////////////////////////////////////////////////////////////////////
+
+#ifndef BOOST_BLOOM_FILTER_DETAIL_PAYLOAD_HPP
+#define BOOST_BLOOM_FILTER_DETAIL_PAYLOAD_HPP
+
+#include <algorithm>
+#include <bitset>
+#include <climits>
+#include <cstddef>
+#include <cstring>
+#include <vector>
+
+#include <boost/array.hpp>
+#include <boost/config.hpp>
+#include <boost/cstdint.hpp>
+#include <boost/dynamic_bitset.hpp>
+#include <boost/type_traits/alignment_of.hpp>
+
+#include <boost/bloom_filter/detail/filter_header.hpp>
+#include <boost/bloom_filter/detail/prefetch.hpp>
+
+// The standard libraries that keep a std::bitset as nothing but an
+// array of words, bit i in word i / word bits. In little-endian memory
+// those are the payload byte for byte.
+#if defined(__GLIBCXX__) || defined(_LIBCPP_VERSION) || \
+    defined(_CPPLIB_VER)
+#define BOOST_BLOOM_FILTER_BITSET_WORDS 1
+#endif
+
+namespace boost {
+  namespace bloom_filters {
+    namespace detail {
+
+      // The blocks of a filter, as the payload sees them.
+      template <typename Block>
+      struct block_span {
+	Block *data;
+	size_t size;
+      };
+
+      template <typename Block>
+      block_span<Block> make_span(Block *const data, const size_t size)
+      {
+	const block_span<Block> span = {data, size};
+	return span;
+      }
+
+      //* what the payload does with a span
+      template <typename Block>
+      size_t span_bytes(const block_span<Block>& span)
+      {
+	return span.size * sizeof(Block);
+      }
+
+      template <typename Block>
+      size_t span_block_bytes(const block_span<Block>&)
+      {
+	return sizeof(Block);
+      }
+
+      //? the blocks themselves, if they already are the payload
+      template <typename Block>
+      unsigned char *span_native(const block_span<Block>& span)
+      {
+	return native_payload() && span.size != 0 ?
+	  reinterpret_cast<unsigned char *>(span.data) : 0;
+      }
+
+      //? writes the blocks to out as span_bytes of payload
+      template <typename Block>
+      void span_out(const block_span<Block>& span, unsigned char *const out)
+      {
+	if (span.size == 0)
+	  return;
+
+	if (native_payload()) {
+	  std::memcpy(out, span.data, span_bytes(span));
+	  return;
+	}
+
+	for (size_t i = 0; i < span.size; ++i)
+	  put_le<Block>(out + i * sizeof(Block), span.data[i]);
+      }
+
+      //? zeroes the blocks from byte have on, and for a bit container
+      //? (used_bits != 0) any bit from used_bits on
+      template <typename Block>
+      void span_finish(const block_span<Block>& span, const size_t have,
+		       const size_t used_bits)
+      {
+	const size_t bytes = span_bytes(span);
+	if (have < bytes)
+	  std::memset(reinterpret_cast<unsigned char *>(span.data) + have, 0,
+		      bytes - have);
+
+	if (used_bits == 0)
+	  return;
+
+	const size_t block_bits = sizeof(Block) * CHAR_BIT;
+	size_t i = used_bits / block_bits;
+	if (i < span.size && used_bits % block_bits != 0) {
+	  span.data[i] &= static_cast<Block>(
+	    (static_cast<Block>(1) << (used_bits % block_bits)) - 1);
+	  ++i;
+	}
+	for (; i < span.size; ++i)
+	  span.data[i] = 0;
+      }
+
+      //? fills the blocks from bytes of payload; see span_finish
+      template <typename Block>
+      void span_in(const block_span<Block>& span,
+		   const unsigned char *const in, const size_t bytes,
+		   const size_t used_bits)
+      {
+	const size_t have = std::min(bytes, span_bytes(span));
+
+	if (native_payload()) {
+	  if (have != 0)
+	    std::memcpy(span.data, in, have);
+	  span_finish(span, have, used_bits);
+	  return;
+	}
+
+	// a short last block is padded with zero bytes
+	size_t i = 0;
+	for (; i * sizeof(Block) < have; ++i) {
+	  unsigned char block[sizeof(Block)] = {0};
+	  std::memcpy(block, in + i * sizeof(Block),
+		      std::min(sizeof(Block), have - i * sizeof(Block)));
+	  span.data[i] = get_le<Block>(block);
+	}
+	span_finish(span, i * sizeof(Block), used_bits);
+      }
+
+      //? throws serialization_exception unless the payload after the
+      //? header at image, described by saved, can be used in place as
+      //? needed bytes of Blocks
+      template <typename Block>
+      void check_borrowed(const unsigned char *const image,
+			  const filter_header& saved, const size_t needed)
+      {
+	const boost::uintptr_t blocks =
+	  reinterpret_cast<boost::uintptr_t>(image + encoded_header_size);
+
+	if (!native_payload() || saved.encoding != raw_blocks ||
+	    saved.block_bytes != sizeof(Block) ||
+	    blocks % alignment_of<Block>::value != 0 ||
+	    saved.payload_bytes < needed)
+	  throw serialization_exception();
+      }
+
+      //* the containers behind the filters
+      template <typename Block, typename Allocator>
+      block_span<Block> span_of(std::vector<Block, Allocator>& blocks)
+      {
+	return make_span(blocks.empty() ? 0 : &blocks[0], blocks.size());
+      }
+
+      template <typename Block, size_t N>
+      block_span<Block> span_of(boost::array<Block, N>& blocks)
+      {
+	return make_span(blocks.data(), N);
+      }
+
+      template <typename Block, typename Allocator>
+      block_span<Block> span_of(dynamic_bitset<Block, Allocator>& bits)
+      {
+	return span_of(blocks_of(bits));
+      }
+
+      //* payload of any container span_of knows
+      template <typename Blocks>
+      size_t payload_size(Blocks& blocks)
+      {
+	return span_bytes(span_of(blocks));
+      }
+
+      template <typename Blocks>
+      size_t payload_block_bytes(Blocks& blocks)
+      {
+	return span_block_bytes(span_of(blocks));
+      }
+
+      template <typename Blocks>
+      unsigned char *native_bytes(Blocks& blocks)
+      {
+	return span_native(span_of(blocks));
+      }
+
+      //? the blocks as bytes in whatever order the host keeps them;
+      //? for combining containers of the same type byte by byte
+      template <typename Blocks>
+      unsigned char *block_bytes(Blocks& blocks)
+      {
+	return reinterpret_cast<unsigned char *>(span_of(blocks).data);
+      }
+
+      template <typename Blocks>
+      void write_payload(Blocks& blocks, unsigned char *const out)
+      {
+	span_out(span_of(blocks), out);
+      }
+
+      template <typename Blocks>
+      void read_payload(Blocks& blocks, const unsigned char *const in,
+			const size_t bytes, const size_t used_bits)
+      {
+	span_in(span_of(blocks), in, bytes, used_bits);
+      }
+
+      template <typename Blocks>
+      void finish_payload(Blocks& blocks, const size_t have,
+			  const size_t used_bits)
+      {
+	span_finish(span_of(blocks), have, used_bits);
+      }
+
+      //* std::bitset
+      // Saved as bytes: the words themselves where their layout is
+      // known, else a bit at a time.
+      template <size_t Size>
+      block_span<unsigned char> bitset_span(std::bitset<Size>& bits)
+      {
+#ifdef BOOST_BLOOM_FILTER_BITSET_WORDS
+	if (native_payload())
+	  return make_span(reinterpret_cast<unsigned char *>(&bits),
+			   sizeof(bits));
+#else
+	(void)bits;
+#endif
+	return make_span(static_cast<unsigned char *>(0), 0);
+      }
+
+      template <size_t Size>
+      size_t payload_size(std::bitset<Size>& bits)
+      {
+	const block_span<unsigned char> span = bitset_span(bits);
+	return span.data != 0 ? span.size : (Size + CHAR_BIT - 1) / CHAR_BIT;
+      }
+
+      template <size_t Size>
+      size_t payload_block_bytes(std::bitset<Size>&)
+      {
+	return 1;
+      }
+
+      template <size_t Size>
+      unsigned char *native_bytes(std::bitset<Size>& bits)
+      {
+	return bitset_span(bits).data;
+      }
+
+      template <size_t Size>
+      void write_payload(std::bitset<Size>& bits, unsigned char *const out)
+      {
+	const block_span<unsigned char> span = bitset_span(bits);
+	if (span.data != 0) {
+	  span_out(span, out);
+	  return;
+	}
+
+	std::memset(out, 0, payload_size(bits));
+	for (size_t i = 0; i < Size; ++i)
+	  if (bits[i])
+	    out[i / CHAR_BIT] |=
+	      static_cast<unsigned char>(1u << (i % CHAR_BIT));
+      }
+
+      template <size_t Size>
+      void read_payload(std::bitset<Size>& bits,
+			const unsigned char *const in, const size_t bytes,
+			size_t)
+      {
+	const block_span<unsigned char> span = bitset_span(bits);
+	if (span.data != 0) {
+	  span_in(span, in, bytes, Size);
+	  return;
+	}
+
+	bits.reset();
+	for (size_t i = 0; i < Size && i / CHAR_BIT < bytes; ++i)
+	  if ((in[i / CHAR_BIT] >> (i % CHAR_BIT)) & 1)
+	    bits.set(i);
+      }
+
+      template <size_t Size>
+      void finish_payload(std::bitset<Size>& bits, const size_t have,
+			  size_t)
+      {
+	const block_span<unsigned char> span = bitset_span(bits);
+	if (span.data != 0)
+	  span_finish(span, have, Size);
+      }
+
+    } // namespace detail
+  } // namespace bloom_filters
+} // namespace boost
+#endif
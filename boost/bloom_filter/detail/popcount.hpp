@@ -0,0 +1,162 @@
+//////////////////////////////////////////////////////////////////////////////
+//
+// (C) Copyright Alejandro Cabrera 2011.
+// Distributed under the Boost
+// Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or
+// copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// See http://www.boost.org/libs/bloom_filter for documentation.
+//
+//////////////////////////////////////////////////////////////////////////////
+
+#ifndef BOOST_BLOOM_FILTER_DETAIL_POPCOUNT_HPP
+#define BOOST_BLOOM_FILTER_DETAIL_POPCOUNT_HPP
+
+#include <cstddef>
+#include <cstring>
+
+#include <boost/config.hpp>
+#include <boost/cstdint.hpp>
+
+#include <boost/bloom_filter/detail/cpu_dispatch.hpp>
+
+namespace boost {
+  namespace bloom_filters {
+    namespace detail {
+
+      inline size_t popcount(boost::uint64_t x)
+      {
+#if defined(__GNUC__) || defined(__clang__)
+	return static_cast<size_t>(__builtin_popcountll(x));
+#else
+	x = x - ((x >> 1) & 0x5555555555555555ull);
+	x = (x & 0x3333333333333333ull) + ((x >> 2) & 0x3333333333333333ull);
+	x = (x + (x >> 4)) & 0x0f0f0f0f0f0f0f0full;
+	return static_cast<size_t>((x * 0x0101010101010101ull) >> 56);
+#endif
+      }
+
+      //* popcount of whole arrays
+      // The number of set bits in n bytes doesn't depend on how they
+      // group into blocks, so arrays of any unsigned Block are counted
+      // as bytes, eight at a time. Where the host has them, the
+      // hardware popcount instruction or AVX2 count much faster than
+      // the portable code; they are selected at run time as the
+      // blocked filter's kernels are (see cpu_dispatch.hpp).
+      typedef size_t (*popcount_kernel)(const unsigned char *const bytes,
+					const size_t n);
+
+      inline boost::uint64_t load_word(const unsigned char *const bytes)
+      {
+	boost::uint64_t word;
+	std::memcpy(&word, bytes, sizeof(word));
+	return word;
+      }
+
+      inline size_t popcount_tail(const unsigned char *const bytes,
+				  const size_t n)
+      {
+	boost::uint64_t word = 0;
+	std::memcpy(&word, bytes, n);
+	return popcount(word);
+      }
+
+      inline size_t popcount_scalar(const unsigned char *const bytes,
+				    const size_t n)
+      {
+	size_t ret = 0;
+	size_t i = 0;
+
+	for (; i + 8 <= n; i += 8)
+	  ret += popcount(load_word(bytes + i));
+
+	return ret + popcount_tail(bytes + i, n - i);
+      }
+
+#ifdef BOOST_BLOOM_FILTER_HAS_SIMD_DISPATCH
+      // four independent sums keep the popcnt unit busy
+      BOOST_BLOOM_FILTER_TARGET("popcnt")
+      inline size_t popcount_popcnt(const unsigned char *const bytes,
+				    const size_t n)
+      {
+	boost::uint64_t sums[4] = {0, 0, 0, 0};
+	size_t i = 0;
+
+	for (; i + 32 <= n; i += 32) {
+	  sums[0] += __builtin_popcountll(load_word(bytes + i));
+	  sums[1] += __builtin_popcountll(load_word(bytes + i + 8));
+	  sums[2] += __builtin_popcountll(load_word(bytes + i + 16));
+	  sums[3] += __builtin_popcountll(load_word(bytes + i + 24));
+	}
+	for (; i + 8 <= n; i += 8)
+	  sums[0] += __builtin_popcountll(load_word(bytes + i));
+
+	return static_cast<size_t>(sums[0] + sums[1] + sums[2] + sums[3]) +
+	  popcount_tail(bytes + i, n - i);
+      }
+
+      // Mula's nibble lookup: a byte shuffle counts the bits of each
+      // nibble, and a sum of absolute differences against zero adds
+      // them up per 64-bit lane every 32 bytes
+      BOOST_BLOOM_FILTER_TARGET("avx2,popcnt")
+      inline size_t popcount_avx2(const unsigned char *const bytes,
+				  const size_t n)
+      {
+	const __m256i lookup = _mm256_setr_epi8(
+	  0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+	  0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+	const __m256i low_nibbles = _mm256_set1_epi8(0x0f);
+	__m256i sums = _mm256_setzero_si256();
+	size_t i = 0;
+
+	for (; i + 32 <= n; i += 32) {
+	  const __m256i v = _mm256_loadu_si256(
+	    reinterpret_cast<const __m256i *>(bytes + i));
+	  const __m256i counts = _mm256_add_epi8(
+	    _mm256_shuffle_epi8(lookup, _mm256_and_si256(v, low_nibbles)),
+	    _mm256_shuffle_epi8(lookup, _mm256_and_si256(
+				  _mm256_srli_epi16(v, 4), low_nibbles)));
+	  sums = _mm256_add_epi64(
+	    sums, _mm256_sad_epu8(counts, _mm256_setzero_si256()));
+	}
+
+	boost::uint64_t lanes[4];
+	_mm256_storeu_si256(reinterpret_cast<__m256i *>(lanes), sums);
+	return static_cast<size_t>(lanes[0] + lanes[1] + lanes[2] + lanes[3]) +
+	  popcount_popcnt(bytes + i, n - i);
+      }
+#endif
+
+      inline popcount_kernel select_popcount_kernel()
+      {
+#ifdef BOOST_BLOOM_FILTER_HAS_SIMD_DISPATCH
+	if (cpu_simd_level() >= simd_avx2)
+	  return &popcount_avx2;
+	if (__builtin_cpu_supports("popcnt"))
+	  return &popcount_popcnt;
+#endif
+	return &popcount_scalar;
+      }
+
+      //? number of set bits in the n bytes at bytes
+      inline size_t popcount_bytes(const unsigned char *const bytes,
+				   const size_t n)
+      {
+	static const popcount_kernel kernel = select_popcount_kernel();
+	return n == 0 ? 0 : kernel(bytes, n);
+      }
+
+      //? number of set bits in [first, last) of unsigned blocks
+      template <typename Block>
+      size_t popcount(const Block *first, const Block *const last)
+      {
+	return popcount_bytes(reinterpret_cast<const unsigned char *>(first),
+			      static_cast<size_t>(last - first) *
+			        sizeof(Block));
+      }
+
+    } // namespace detail
+  } // namespace bloom_filter
+} // namespace boost
+#endif
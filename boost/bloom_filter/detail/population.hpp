@@ -0,0 +1,139 @@
+//////////////////////////////////////////////////////////////////////////////
+//
+// (C) Copyright Alejandro Cabrera 2011.
+// Distributed under the Boost
+// Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or
+// copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// See http://www.boost.org/libs/bloom_filter for documentation.
+//
+//////////////////////////////////////////////////////////////////////////////
+
+#ifndef BOOST_BLOOM_FILTER_DETAIL_POPULATION_HPP
+#define BOOST_BLOOM_FILTER_DETAIL_POPULATION_HPP
+
+#include <bitset>
+#include <climits>
+#include <cmath>
+#include <cstddef>
+
+#include <boost/cstdint.hpp>
+#include <boost/dynamic_bitset.hpp>
+#include <boost/mpl/bool.hpp>
+
+#include <boost/bloom_filter/detail/payload.hpp>
+#include <boost/bloom_filter/detail/popcount.hpp>
+
+namespace boost {
+  namespace bloom_filters {
+    namespace detail {
+
+      // The filters keep their population -- set bits, or bins that
+      // aren't zero -- up to date as they change, so count(), empty()
+      // and false_positive_rate() don't look at the bits. A full count
+      // is only needed when the bits are replaced wholesale: by a
+      // union or intersection, or by load().
+
+      //? sets bit pos; 1 if it was clear, else 0
+      template <typename Bitset>
+      size_t set_bit(Bitset& bits, const size_t pos)
+      {
+	const bool was_set = bits[pos];
+	bits[pos] = true;
+	return was_set ? 0 : 1;
+      }
+
+      //* full counts
+      template <typename Bitset>
+      size_t count_bits(const Bitset& bits)
+      {
+	return bits.count();
+      }
+
+      template <size_t Size>
+      size_t count_bits(const std::bitset<Size>& bits)
+      {
+#ifdef BOOST_BLOOM_FILTER_BITSET_WORDS
+	// the unused bits of the last word are kept clear
+	return popcount_bytes(reinterpret_cast<const unsigned char *>(&bits),
+			      sizeof(bits));
+#else
+	return bits.count();
+#endif
+      }
+
+      template <typename Block, typename Allocator>
+      size_t count_bits(const dynamic_bitset<Block, Allocator>& bits)
+      {
+	const std::vector<Block, Allocator>& blocks = blocks_of(bits);
+	return blocks.empty() ? 0 :
+	  popcount(&blocks[0], &blocks[0] + blocks.size());
+      }
+
+      //? the bins of a CBF bucket that aren't zero. Each bin's bits are
+      //? or-ed down into its lowest bit, which leaves one bit per
+      //? nonzero bin to count.
+      template <typename CBF, typename Bucket>
+      size_t count_nonzero_bins(const Bucket& slots, const size_t num_bins)
+      {
+	typedef typename Bucket::value_type slot_type;
+
+	const size_t width = CBF::bits_per_bin();
+	const size_t per_slot = CBF::bins_per_slot();
+	slot_type lows = 0;
+	for (size_t i = 0; i < per_slot; ++i)
+	  lows |= static_cast<slot_type>(static_cast<slot_type>(1) <<
+					 (i * width));
+
+	size_t ret = 0;
+	const size_t full = num_bins / per_slot;
+	for (size_t i = 0; i < full; ++i) {
+	  slot_type slot = slots[i];
+	  for (size_t shift = 1; shift < width; shift <<= 1)
+	    slot |= static_cast<slot_type>(slot >> shift);
+	  ret += popcount(static_cast<boost::uint64_t>(slot & lows));
+	}
+
+	for (size_t bin = full * per_slot; bin < num_bins; ++bin)
+	  if (((slots[full] >> ((bin % per_slot) * width)) & CBF::mask()) != 0)
+	    ++ret;
+
+	return ret;
+      }
+
+      //? the false positive rate the filters report: that of k hashes
+      //? over size bits or bins, of which set are in use, as
+      //? (1 - e^(-k set / size))^k
+      inline double estimated_fpr(const size_t set, const size_t size,
+				  const size_t k)
+      {
+	if (size == 0)
+	  return 0.0;
+
+	const double kd = static_cast<double>(k);
+	return std::pow(1.0 - std::exp(-kd * static_cast<double>(set) /
+				       static_cast<double>(size)), kd);
+      }
+
+      // The bits of a fixed size filter with their population, so a
+      // storage policy holds, copies and swaps the two together.
+      template <typename Bits>
+      struct counted {
+	counted() : bits(), population(0) {}
+
+	Bits bits;
+	size_t population;
+      };
+
+      // true_ for storage other writers may change behind the filter's
+      // back -- a file other processes map, or the caller's buffer --
+      // whose population has to be counted every time it is asked for.
+      // mapped_blocks.hpp sets it for its containers.
+      template <typename Storage>
+      struct shared_storage : mpl::false_ {};
+
+    } // namespace detail
+  } // namespace bloom_filters
+} // namespace boost
+#endif
@@ -0,0 +1,123 @@
+//////////////////////////////////////////////////////////////////////////////
+//
+// (C) Copyright Alejandro Cabrera 2011.
+// Distributed under the Boost
+// Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or
+// copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// See http://www.boost.org/libs/bloom_filter for documentation.
+//
+//////////////////////////////////////////////////////////////////////////////
+
+#ifndef BOOST_BLOOM_FILTER_DETAIL_PREFETCH_HPP
+#define BOOST_BLOOM_FILTER_DETAIL_PREFETCH_HPP
+
+#include <bitset>
+#include <climits>
+#include <vector>
+
+#include <boost/assert.hpp>
+#include <boost/config.hpp>
+#include <boost/core/nvp.hpp>
+#include <boost/dynamic_bitset/serialization.hpp>
+#include <boost/static_assert.hpp>
+
+namespace boost {
+  namespace bloom_filters {
+    namespace detail {
+
+      //? hint that addr is about to be read
+      inline void prefetch_read(const void *const addr)
+      {
+#if defined(__GNUC__) || defined(__clang__)
+	__builtin_prefetch(addr, 0, 3);
+#else
+	(void)addr;
+#endif
+      }
+
+      //? hint that addr is about to be written
+      inline void prefetch_write(const void *const addr)
+      {
+#if defined(__GNUC__) || defined(__clang__)
+	__builtin_prefetch(addr, 1, 3);
+#else
+	(void)addr;
+#endif
+      }
+
+      // dynamic_bitset doesn't expose its blocks, but it hands them to
+      // any archive through its zero-copy serialization hook. This
+      // "archive" only remembers where they are. It relies on the
+      // layout every dynamic_bitset with that hook has had: a
+      // std::vector of blocks and a bit count, the vector serialized as
+      // one nvp. blocks_of() checks what it can of that.
+      template <typename Block, typename Allocator>
+      class block_locator {
+      public:
+	typedef std::vector<Block, Allocator> buffer_type;
+
+	block_locator() : buffer(0) {}
+
+	template <typename U>
+	block_locator& operator&(const serialization::nvp<U>&)
+	{
+	  return *this;
+	}
+
+	block_locator& operator&(const serialization::nvp<buffer_type>& v)
+	{
+	  this->buffer = &v.value();
+	  return *this;
+	}
+
+	buffer_type *buffer;
+      };
+
+      //? the block storage of a dynamic_bitset
+      template <typename Block, typename Allocator>
+      std::vector<Block, Allocator>&
+      blocks_of(dynamic_bitset<Block, Allocator>& bits)
+      {
+	typedef dynamic_bitset<Block, Allocator> bitset_type;
+	BOOST_STATIC_ASSERT(sizeof(bitset_type) ==
+			    sizeof(std::vector<Block, Allocator>) +
+			    sizeof(typename bitset_type::size_type));
+
+	block_locator<Block, Allocator> locator;
+	bitset_type::serialize_impl::serialize(locator, bits, 0);
+	BOOST_ASSERT(locator.buffer != 0);
+	BOOST_ASSERT(locator.buffer->size() == bits.num_blocks());
+	return *locator.buffer;
+      }
+
+      template <typename Block, typename Allocator>
+      const std::vector<Block, Allocator>&
+      blocks_of(const dynamic_bitset<Block, Allocator>& bits)
+      {
+	return blocks_of(const_cast<dynamic_bitset<Block, Allocator>&>(bits));
+      }
+
+      // Start of the storage behind a bitset, such that bit pos lives
+      // near bit_storage(bits) + pos / CHAR_BIT. For std::bitset this is
+      // only a guess at the layout, so the result must never be
+      // dereferenced: it is only good enough for prefetching.
+      template <size_t Size>
+      const char *bit_storage(const std::bitset<Size>& bits)
+      {
+	return reinterpret_cast<const char *>(&bits);
+      }
+
+      template <typename Block, typename Allocator>
+      const char *bit_storage(const dynamic_bitset<Block, Allocator>& bits)
+      {
+	const std::vector<Block, Allocator>& blocks = blocks_of(bits);
+	return blocks.empty() ? 0 :
+	  reinterpret_cast<const char *>(&blocks[0]);
+      }
+
+    } // namespace detail
+  } // namespace bloom_filter
+} // namespace boost
+#endif
@@ -13,25 +13,165 @@
 #ifndef BOOST_BLOOM_FILTER_TWOHASH_APPLY_HASH_HPP
 #define BOOST_BLOOM_FILTER_TWOHASH_APPLY_HASH_HPP
 
+#include <cmath>
+#include <cstddef>
+
+#include <boost/config.hpp>
+#include <boost/mpl/bool.hpp>
+#include <boost/static_assert.hpp>
+
+#include <boost/bloom_filter/detail/optimal_size.hpp>
+#include <boost/bloom_filter/detail/population.hpp>
+
 namespace boost {
   namespace bloom_filters {
+
+    //! Pass as HashValues to twohash_dynamic_basic_bloom_filter or
+    //! twohash_dynamic_counting_bloom_filter to choose the number of
+    //! hash values per key at run time instead.
+    static const size_t runtime_hash_values = 0;
+
     namespace detail {
 
+      // the most hash values a filter with runtime_hash_values uses;
+      // the optimal number for a false positive rate of 1e-9 is 30
+      static const size_t max_runtime_hash_values = 32;
+
+      //? N, or max_runtime_hash_values if N is runtime_hash_values
+      template <size_t N>
+      struct twohash_num_positions {
+	static const size_t value =
+	  N == runtime_hash_values ? max_runtime_hash_values : N;
+      };
+
+      // used with runtime_hash_values when neither a false positive
+      // rate nor an expected insertion count is given
+      static const size_t default_runtime_hash_values = 2;
+
+      inline size_t clamp_runtime_hash_values(const double k)
+      {
+	if (k < 1.0)
+	  return 1;
+	if (k > static_cast<double>(max_runtime_hash_values))
+	  return max_runtime_hash_values;
+	return static_cast<size_t>(k);
+      }
+
+      //! num_hash_functions() of the two-hash dynamic filters: static
+      //! and constexpr for a fixed HashValues, as it always was
+      template <size_t HashValues>
+      class twohash_hash_values {
+      public:
+	static BOOST_CONSTEXPR size_t num_hash_functions()
+	{
+	  return HashValues;
+	}
+
+      protected:
+	explicit twohash_hash_values(size_t) {}
+
+	void set_num_hash_functions(size_t) {}
+      };
+
+      //! and with runtime_hash_values, stored in each filter
+      template <>
+      class twohash_hash_values<runtime_hash_values> {
+      public:
+	size_t num_hash_functions() const
+	{
+	  return this->hash_values;
+	}
+
+      protected:
+	explicit twohash_hash_values(const size_t k) : hash_values(k) {}
+
+	void set_num_hash_functions(const size_t k)
+	{
+	  this->hash_values = k;
+	}
+
+      private:
+	size_t hash_values;
+      };
+
+      //? the hash values per key of a filter sized for false positive
+      //? rate p
+      template <size_t N>
+      size_t twohash_hash_count(const double p)
+      {
+	if (N != runtime_hash_values)
+	  return N;
+
+	return clamp_runtime_hash_values(
+	  static_cast<double>(optimal_hash_count(p)));
+      }
+
+      //? the hash values per key of a filter of m bits or bins: optimal
+      //? for ExpectedInsertionCount keys when that is given
+      template <size_t N, size_t ExpectedInsertionCount>
+      size_t twohash_hash_count_for_size(const size_t m)
+      {
+	if (N != runtime_hash_values)
+	  return N;
+	if (ExpectedInsertionCount == 0)
+	  return default_runtime_hash_values;
+
+	return clamp_runtime_hash_values(
+	  std::floor(static_cast<double>(m) / ExpectedInsertionCount *
+		     std::log(2.0) + 0.5));
+      }
+
+      // The probe loops take the number of hash values k as an
+      // argument. The overloads without it pass N, a constant, so the
+      // fixed size filters still get loops the compiler can unroll.
       template <size_t N,
 		typename Container>
       struct twohash_apply_hash
       {
 
       private:
-	typedef typename Container::value_type value_type;
 	typedef typename Container::bitset_type bitset_type;
 	typedef typename Container::hash_function1_type hash_function1_type;
 	typedef typename Container::hash_function2_type hash_function2_type;
 	typedef typename Container::extension_function_type extension_function_type;
+	typedef typename Container::reduction_type reduction_type;
 
       public:
-        static void insert(const value_type& t, 
-			   bitset_type& bits) 
+	typedef typename Container::value_type value_type;
+	typedef mpl::bool_<N == runtime_hash_values> runtime_count;
+
+	static const size_t num_positions = twohash_num_positions<N>::value;
+
+	//? writes the N bit positions of t to out
+	static void positions(const value_type& t,
+			      const size_t size,
+			      size_t *const out)
+	{
+	  BOOST_STATIC_ASSERT(N != runtime_hash_values);
+	  positions(t, N, size, out);
+	}
+
+	//? writes the first k bit positions of t to out
+	static void positions(const value_type& t,
+			      const size_t k,
+			      const size_t size,
+			      size_t *const out)
+	{
+	  static hash_function1_type hasher1;
+	  static hash_function2_type hasher2;
+	  static extension_function_type extender;
+
+	  const size_t hash1 = hasher1(t);
+	  const size_t hash2 = hasher2(t);
+
+	  for (size_t i = 0; i < k; ++i)
+	    out[i] = reduction_type::reduce(hash1 + i * hash2 + extender(i),
+					   size);
+	}
+
+	//? writes the num_positions unreduced hash values of t to out;
+	//? the first k of them are the hash values of a k probe filter
+	static void hashes(const value_type& t, size_t *const out)
 	{
 	  static hash_function1_type hasher1;
 	  static hash_function2_type hasher2;
@@ -40,14 +180,47 @@ namespace boost {
 	  const size_t hash1 = hasher1(t);
 	  const size_t hash2 = hasher2(t);
 
-	  for (size_t i = 0; i < N; ++i) {
+	  for (size_t i = 0; i < num_positions; ++i)
+	    out[i] = hash1 + i * hash2 + extender(i);
+	}
+
+	//? sets the bits of t; returns how many of them were clear
+        static size_t insert(const value_type& t, 
+			     bitset_type& bits) 
+	{
+	  BOOST_STATIC_ASSERT(N != runtime_hash_values);
+	  return insert(t, N, bits);
+	}
+
+        static size_t insert(const value_type& t, 
+			     const size_t k,
+			     bitset_type& bits) 
+	{
+	  static hash_function1_type hasher1;
+	  static hash_function2_type hasher2;
+	  static extension_function_type extender;
+
+	  const size_t hash1 = hasher1(t);
+	  const size_t hash2 = hasher2(t);
+	  size_t set = 0;
+
+	  for (size_t i = 0; i < k; ++i) {
 	    const size_t hash_val = hash1 + i * hash2 + extender(i);
-	    bits[hash_val % bits.size()] = true;
+	    set += set_bit(bits, reduction_type::reduce(hash_val, bits.size()));
 	  }
+	  return set;
         }
 
         static bool contains(const value_type& t, 
 			     const bitset_type& bits)
+	{
+	  BOOST_STATIC_ASSERT(N != runtime_hash_values);
+	  return contains(t, N, bits);
+	}
+
+        static bool contains(const value_type& t, 
+			     const size_t k,
+			     const bitset_type& bits)
 	{
 	  static hash_function1_type hasher1;
 	  static hash_function2_type hasher2;
@@ -56,9 +229,9 @@ namespace boost {
 	  const size_t hash1 = hasher1(t);
 	  const size_t hash2 = hasher2(t);
 	  
-	  for (size_t i = 0; i < N; ++i) {
+	  for (size_t i = 0; i < k; ++i) {
 	    const size_t hash_val = hash1 + i * hash2 + extender(i);
-	    if (bits[hash_val % bits.size()] != true)
+	    if (bits[reduction_type::reduce(hash_val, bits.size())] != true)
 	      return false;
 	  }
 
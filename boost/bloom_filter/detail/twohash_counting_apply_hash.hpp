@@ -13,51 +13,41 @@
 #ifndef BOOST_BLOOM_FILTER_TWOHASH_COUNTING_APPLY_HASH_HPP
 #define BOOST_BLOOM_FILTER_TWOHASH_COUNTING_APPLY_HASH_HPP
 
-#include <boost/bloom_filter/detail/exceptions.hpp>
+#include <boost/mpl/bool.hpp>
+#include <boost/static_assert.hpp>
+
+#include <boost/bloom_filter/detail/counting_ops.hpp>
+#include <boost/bloom_filter/detail/twohash_apply_hash.hpp>
 
 namespace boost {
   namespace bloom_filters {
     namespace detail {
 
-      struct decrement {
-	size_t operator()(const size_t val, const size_t limit) {
-	  if (val == limit)
-	    throw bin_underflow_exception();
-
-	  return val - 1;
-	}
-      };
- 
-      struct increment {
-	size_t operator()(const size_t val, const size_t limit) {
-	  if (val == limit)
-	    throw bin_overflow_exception();
-
-	  return val + 1;
-	}
-      };
-
-      template <size_t N, typename CBF, typename Op = void>
-      struct BloomOp {
+      template <size_t N, typename CBF>
+      struct twohash_bloom_op {
 	typedef typename CBF::hash_function1_type hash_function1_type;
 	typedef typename CBF::hash_function2_type hash_function2_type;
 	typedef typename CBF::extension_function_type extension_function_type;
+	typedef typename CBF::reduction_type reduction_type;
 	
-	BloomOp(const typename CBF::value_type& t)
+	twohash_bloom_op(const typename CBF::value_type& t,
+			 const size_t k = N)
 	  : hash1_val(hash1(t)),
-	    hash2_val(hash2(t))
+	    hash2_val(hash2(t)),
+	    k(k)
 	{
 	}
 
+	template <typename Op>
 	void update(typename CBF::bucket_type& slots,
 		    const size_t num_bins,
+		    Op op,
 		    const size_t limit)
 	{
-	  static Op op;
-	  
-	  for (size_t i = 0; i < N; ++i) {
+	  for (size_t i = 0; i < k; ++i) {
 	    const size_t hash = 
-	      (hash1_val + i * hash2_val + ext(i)) % num_bins;
+	      reduction_type::reduce(hash1_val + i * hash2_val + ext(i),
+				     num_bins);
 	    const size_t pos = hash / CBF::bins_per_slot();
 	    const size_t offset_bits = 
 	      (hash % CBF::bins_per_slot()) * CBF::bits_per_bin();
@@ -73,9 +63,10 @@ namespace boost {
 	bool check(const typename CBF::bucket_type& slots,
 		   const size_t num_bins)
 	{
-	  for (size_t i = 0; i < N; ++i) {
+	  for (size_t i = 0; i < k; ++i) {
 	    const size_t hash = 
-	      (hash1_val + i * hash2_val + ext(i)) % num_bins;
+	      reduction_type::reduce(hash1_val + i * hash2_val + ext(i),
+				     num_bins);
 	    const size_t pos = hash / CBF::bins_per_slot();
 	    const size_t offset_bits = 
 	      (hash % CBF::bins_per_slot()) * CBF::bits_per_bin();
@@ -91,38 +82,92 @@ namespace boost {
 
 	size_t hash1_val;
 	size_t hash2_val;
+	size_t k;
 	hash_function1_type hash1;
 	hash_function2_type hash2;
 	extension_function_type ext;
       };
 
       // CBF : Counting Bloom Filter
+      // As in twohash_apply_hash, the overloads without k pass N.
       template <size_t N, 
 		class CBF>
       struct twohash_counting_apply_hash
       {
-	static void insert(const typename CBF::value_type& t, 
+	typedef typename CBF::value_type value_type;
+	typedef mpl::bool_<N == runtime_hash_values> runtime_count;
+
+	static const size_t num_positions = twohash_num_positions<N>::value;
+
+	//? writes the N bins of t to out
+	static void positions(const value_type& t,
+			      const size_t num_bins,
+			      size_t *const out)
+	{
+	  BOOST_STATIC_ASSERT(N != runtime_hash_values);
+	  positions(t, N, num_bins, out);
+	}
+
+	//? writes the first k bins of t to out
+	static void positions(const value_type& t,
+			      const size_t k,
+			      const size_t num_bins,
+			      size_t *const out)
+	{
+	  static typename CBF::hash_function1_type hasher1;
+	  static typename CBF::hash_function2_type hasher2;
+	  static typename CBF::extension_function_type extender;
+
+	  const size_t hash1 = hasher1(t);
+	  const size_t hash2 = hasher2(t);
+
+	  for (size_t i = 0; i < k; ++i)
+	    out[i] = CBF::reduction_type::reduce(hash1 + i * hash2 + extender(i),
+						 num_bins);
+	}
+
+	//? writes the num_positions unreduced hash values of t to out
+	static void hashes(const value_type& t,
+			   size_t *const out)
+	{
+	  static typename CBF::hash_function1_type hasher1;
+	  static typename CBF::hash_function2_type hasher2;
+	  static typename CBF::extension_function_type extender;
+
+	  const size_t hash1 = hasher1(t);
+	  const size_t hash2 = hasher2(t);
+
+	  for (size_t i = 0; i < num_positions; ++i)
+	    out[i] = hash1 + i * hash2 + extender(i);
+	}
+
+	static void insert(const value_type& t, 
 			   typename CBF::bucket_type& slots,
-			   const size_t num_bins)
+			   const size_t num_bins,
+			   size_t& in_use,
+			   const size_t k = N)
 	{
-	  BloomOp<N, CBF, increment> inserter(t);
-	  inserter.update(slots, num_bins, 
+	  twohash_bloom_op<N, CBF> inserter(t, k);
+	  inserter.update(slots, num_bins, increment(in_use),
 			  (static_cast<size_t>(1) << CBF::bits_per_bin()) - 1);
 	}
 
-	static void remove(const typename CBF::value_type& t, 
+	static void remove(const value_type& t, 
 			   typename CBF::bucket_type& slots,
-			   const size_t num_bins)
+			   const size_t num_bins,
+			   size_t& in_use,
+			   const size_t k = N)
 	{
-	  BloomOp<N, CBF, decrement> remover(t);
-	  remover.update(slots, num_bins, 0);
+	  twohash_bloom_op<N, CBF> remover(t, k);
+	  remover.update(slots, num_bins, decrement(in_use), 0);
 	}
 
-	static bool contains(const typename CBF::value_type& t, 
+	static bool contains(const value_type& t, 
 			     const typename CBF::bucket_type& slots,
-			     const size_t num_bins)
+			     const size_t num_bins,
+			     const size_t k = N)
 	{
-	  BloomOp<N, CBF> checker(t);
+	  twohash_bloom_op<N, CBF> checker(t, k);
 	  return checker.check(slots, num_bins);
 		
 	}
@@ -13,23 +13,36 @@
 #ifndef BOOST_BLOOM_FILTER_DYNAMIC_BLOOM_FILTER_HPP
 #define BOOST_BLOOM_FILTER_DYNAMIC_BLOOM_FILTER_HPP 1
 
-#include <cmath>
+#include <algorithm>
+#include <utility>
 
 #include <boost/config.hpp>
+#include <boost/cstdint.hpp>
 #include <boost/mpl/vector.hpp>
 #include <boost/mpl/size.hpp>
 #include <boost/dynamic_bitset.hpp>
+#include <boost/static_assert.hpp>
 
 #include <boost/bloom_filter/detail/apply_hash.hpp>
+#include <boost/bloom_filter/detail/batch.hpp>
+#include <boost/bloom_filter/detail/combine.hpp>
+#include <boost/bloom_filter/detail/dynamic_storage.hpp>
+#include <boost/bloom_filter/detail/hash_digest.hpp>
 #include <boost/bloom_filter/detail/exceptions.hpp>
+#include <boost/bloom_filter/detail/filter_header.hpp>
+#include <boost/bloom_filter/detail/fold.hpp>
+#include <boost/bloom_filter/detail/optimal_size.hpp>
+#include <boost/bloom_filter/detail/population.hpp>
 #include <boost/bloom_filter/hash/default.hpp>
+#include <boost/bloom_filter/reduction.hpp>
 
 namespace boost {
   namespace bloom_filters {
     template <typename T,
 	      class HashFunctions = mpl::vector<boost_hash<T> >,
 	      class Block = size_t,
-	      class Allocator = std::allocator<Block> >
+	      class Allocator = std::allocator<Block>,
+	      class Reduction = modulo_reduction>
     class dynamic_bloom_filter {
     public:
       typedef T value_type;
@@ -37,47 +50,92 @@ namespace boost {
       typedef HashFunctions hash_function_type;
       typedef Block block_type;
       typedef Allocator allocator_type;
-      typedef dynamic_bitset<block_type, allocator_type> bitset_type;
+      typedef Reduction reduction_type;
+      typedef typename detail::dynamic_bits<block_type,
+					    allocator_type>::type bitset_type;
       typedef dynamic_bloom_filter<T, HashFunctions,
-				   Block, Allocator> this_type;
+				   Block, Allocator, Reduction> this_type;
 
     private:
-      typedef detail::apply_hash<mpl::size<HashFunctions>::value - 1,
-				 this_type> apply_hash_type;
+      typedef typename detail::select_apply_hash<
+	HashFunctions, this_type>::type apply_hash_type;
 
     public:
       
       //* constructors
-      dynamic_bloom_filter() {}
+      dynamic_bloom_filter() : population(0) {}
       
       explicit dynamic_bloom_filter(const size_t bit_capacity) : 
-	bits(bit_capacity) {}
+	bits(detail::checked_range<Reduction>(bit_capacity)),
+	population(0) {}
+
+      //? sized to hold expected_insertions keys at no more than
+      //? false_positive_rate, for the number of hash functions fixed
+      //? by HashFunctions
+      dynamic_bloom_filter(const size_t expected_insertions,
+			   const double false_positive_rate)
+	: bits(detail::bit_count_for<Reduction>(expected_insertions,
+						false_positive_rate,
+						num_hash_functions())),
+	  population(0) {}
       
+      //? with Allocator = mapped_file: creates file.path, replacing any
+      //? file there, for a filter of bit_capacity bits
+      dynamic_bloom_filter(const mapped_file_params& file,
+			   const size_t bit_capacity)
+	: bits(file, detail::checked_range<Reduction>(bit_capacity),
+	       header_for(bit_capacity)),
+	  population(0) {}
+
+      //? with Allocator = mapped_file: maps the filter in file.path
+      explicit dynamic_bloom_filter(const mapped_file_params& file)
+	: bits(file, header_for(0)), population(0)
+      {
+	detail::checked_range<Reduction>(this->bit_capacity());
+	this->recount();
+      }
+
       template <typename InputIterator>
       dynamic_bloom_filter(const InputIterator start, 
 			   const InputIterator end) 
-	: bits(std::distance(start, end) * 4)
+	: bits(detail::range_for<Reduction>(std::distance(start, end) * 4)),
+	  population(0)
       {
 	for (InputIterator i = start; i != end; ++i)
 	  this->insert(*i);
       }
 
+      dynamic_bloom_filter(const dynamic_bloom_filter& other)
+	: bits(other.bits), population(other.population) {}
+
+#ifndef BOOST_NO_CXX11_RVALUE_REFERENCES
+      //? takes the bits of other, leaving it with none
+      dynamic_bloom_filter(dynamic_bloom_filter&& other) BOOST_NOEXCEPT
+	: population(0)
+      {
+	this->swap(other);
+      }
+#endif
+
       //* query functions
       static BOOST_CONSTEXPR size_t num_hash_functions() {
-        return mpl::size<HashFunctions>::value;
+        return detail::num_hashes<HashFunctions>::value;
       }
 
+      //? estimated from count(), so as cheap to ask
       double false_positive_rate() const {
-        const double n = static_cast<double>(this->bits.count());
-        static const double k = static_cast<double>(num_hash_functions());
-        static const double m = static_cast<double>(this->bits.size());
-        static const double e =
-	  2.718281828459045235360287471352662497757247093699959574966;
-        return std::pow(1 - std::pow(e, -k * n / m), k);
+	return detail::estimated_fpr(this->count(), this->bit_capacity(),
+				     num_hash_functions());
       }
 
+      //? the number of bits set; kept as keys go in, so free to ask.
+      //? With Allocator = mapped_file it is counted afresh each time:
+      //? other processes may be writing the file, or the caller the
+      //? buffer loaded in place.
       size_t count() const {
-        return this->bits.count();
+	if (detail::shared_storage<bitset_type>::value)
+	  return detail::count_bits(this->bits);
+        return this->population;
       }
 
       size_t bit_capacity() const {
@@ -96,7 +154,7 @@ namespace boost {
 
       //* core operations
       void insert(const T& t) {
-	apply_hash_type::insert(t, bits);
+	this->population += apply_hash_type::insert(t, bits);
       }
 
       template <typename InputIterator>
@@ -110,46 +168,162 @@ namespace boost {
 	return apply_hash_type::contains(t, bits);
       }
 
+      //* pre-hashed ops
+      //? the unreduced hash values of a key. A digest can be passed to
+      //? insert_hash() and probably_contains_hash() of any filter with
+      //? the same key type and hashing, whatever its size, so a key
+      //? probed against many filters is hashed only once.
+      typedef detail::hash_digest<apply_hash_type::num_positions> digest_type;
+
+      static digest_type hash_key(const T& t) {
+	digest_type digest;
+	apply_hash_type::hashes(t, digest.values);
+	return digest;
+      }
+
+      void insert_hash(const digest_type& digest) {
+	this->population +=
+	  detail::bitset_insert_digest<reduction_type>(digest, bits);
+      }
+
+      bool probably_contains_hash(const digest_type& digest) const {
+	return detail::bitset_contains_digest<reduction_type>(digest, bits);
+      }
+
+      //? inserts every key in [start, end). Same result as
+      //? insert(start, end), but the probes of a group of keys are
+      //? prefetched together so their cache misses overlap.
+      template <typename InputIterator>
+      void insert_batch(const InputIterator start, const InputIterator end) {
+	this->population +=
+	  detail::bitset_insert_batch<apply_hash_type>(start, end, bits);
+      }
+
+      //? tests every key in [start, end). Bit i % 64 of out[i / 64] is
+      //? set if the i-th key is probably contained, so out must have
+      //? room for (std::distance(start, end) + 63) / 64 words. Returns
+      //? the number of keys that are probably contained.
+      template <typename InputIterator>
+      size_t probably_contains_batch(const InputIterator start,
+				     const InputIterator end,
+				     boost::uint64_t *const out) const {
+	return detail::bitset_contains_batch<apply_hash_type>(start, end,
+							      bits, out);
+      }
+
       //* auxilliary operations
       void clear() {
         this->bits.reset();
+	this->population = 0;
+      }
+
+      //? with Allocator = mapped_file: writes the bits changed so far
+      //? back to the file; waits for the disk unless async is true
+      void flush(const bool async = false) {
+	this->bits.flush(async);
+      }
+
+      dynamic_bloom_filter& operator=(const dynamic_bloom_filter& rhs) {
+	this->bits = rhs.bits;
+	this->population = rhs.population;
+	return *this;
+      }
+
+#ifndef BOOST_NO_CXX11_RVALUE_REFERENCES
+      //? takes the bits of rhs, leaving it with none
+      dynamic_bloom_filter& operator=(dynamic_bloom_filter&& rhs)
+	BOOST_NOEXCEPT
+      {
+	bitset_type released;
+	released.swap(this->bits);
+	this->bits.swap(rhs.bits);
+	this->population = rhs.population;
+	rhs.population = 0;
+	return *this;
       }
+#endif
 
-      void swap(dynamic_bloom_filter& other) {
-	dynamic_bloom_filter tmp = other;
-	other = *this;
-	*this = tmp;
+      //? exchanges the bits of the two filters; no bits are copied
+      void swap(dynamic_bloom_filter& other) BOOST_NOEXCEPT {
+	this->bits.swap(other.bits);
+	std::swap(this->population, other.population);
       }
 
       void resize(const size_t new_capacity) {
+	detail::checked_range<Reduction>(new_capacity);
 	bits.clear();
 	bits.resize(new_capacity);
+	this->population = 0;
+      }
+
+      //? divides the capacity by factor, which must divide it, keeping
+      //? every key: bit i is or-ed into bit i % (bit_capacity() /
+      //? factor). Reduction must be modulo_reduction, or mask_reduction
+      //? with a power of two factor. The result is the filter the
+      //? same keys would have made at the smaller size. With
+      //? Allocator = mapped_file the filter stays on its file, which
+      //? is rewritten at the smaller size as resize() does.
+      void fold(const size_t factor) {
+	BOOST_STATIC_ASSERT(detail::foldable<Reduction>::value);
+	if (factor == 0 || this->bit_capacity() % factor != 0) {
+	  throw detail::incompatible_size_exception();
+	}
+
+	bitset_type folded(this->bit_capacity() / factor);
+	detail::fold_bits(folded, this->bits);
+	this->resize(folded.size());
+	this->population = detail::combine_bits(this->bits, folded,
+						detail::combine_or);
+      }
+
+      //? the union of this filter and rhs at the smaller of their
+      //? capacities, the larger folded down first; throws
+      //? incompatible_size_exception unless one capacity divides the
+      //? other
+      dynamic_bloom_filter& fold_union(const dynamic_bloom_filter& rhs) {
+	BOOST_STATIC_ASSERT(detail::foldable<Reduction>::value);
+	const size_t size = this->bit_capacity();
+	const size_t rhs_size = rhs.bit_capacity();
+	if (size != 0 && rhs_size % size == 0) {
+	  this->population = detail::fold_bits(this->bits, rhs.bits);
+	}
+	else if (rhs_size != 0 && size % rhs_size == 0) {
+	  this->fold(size / rhs_size);
+	  *this |= rhs;
+	}
+	else {
+	  throw detail::incompatible_size_exception();
+	}
+	return *this;
       }
 
       template <typename _T, typename _HashFunctions, 
-		typename _Block, typename _Allocator>
+		typename _Block, typename _Allocator, typename _Reduction>
       friend bool operator==(const dynamic_bloom_filter<_T, _HashFunctions, 
-							_Block, _Allocator>&, 
+							_Block, _Allocator, _Reduction>&, 
 			     const dynamic_bloom_filter<_T, _HashFunctions, 
-							_Block, _Allocator>&);
+							_Block, _Allocator, _Reduction>&);
 
       template <typename _T, typename _HashFunctions, 
-		typename _Block, typename _Allocator>
+		typename _Block, typename _Allocator, typename _Reduction>
       friend bool operator!=(const dynamic_bloom_filter<_T, 
 							_HashFunctions, 
 							_Block, 
-							_Allocator>&, 
+							_Allocator,
+							_Reduction>&, 
 			     const dynamic_bloom_filter<_T, 
 							_HashFunctions, 
 							_Block, 
-							_Allocator>&);
+							_Allocator,
+							_Reduction>&);
 
       dynamic_bloom_filter& operator|=(const dynamic_bloom_filter& rhs) {
 	if(this->bit_capacity() != rhs.bit_capacity()) {
 	  throw detail::incompatible_size_exception();
 	}
 
-        this->bits |= rhs.bits;
+	this->population = detail::combine_bits(this->bits, rhs.bits,
+						detail::combine_or);
         return *this;
       }
 
@@ -158,62 +332,130 @@ namespace boost {
 	  throw detail::incompatible_size_exception();
 	}
 
-        this->bits &= rhs.bits;
+	this->population = detail::combine_bits(this->bits, rhs.bits,
+						detail::combine_and);
         return *this;
       }
 
     private:
+      friend struct detail::filter_access;
+
+      static detail::filter_header header_for(const size_t bit_capacity) {
+	return detail::make_header<HashFunctions, Reduction, mpl::vector<> >(
+	  detail::hashed_bits, sizeof(Block), 0, num_hash_functions(),
+	  bit_capacity);
+      }
+
+      detail::filter_header header() const {
+	return header_for(this->bit_capacity());
+      }
+
+      void reshape(const detail::filter_header& saved, const bool allocate) {
+	const size_t capacity = static_cast<size_t>(saved.capacity);
+	detail::check_header(saved, header_for(capacity));
+	detail::checked_range<Reduction>(capacity);
+
+	if (!allocate) {
+	  bitset_type none;
+	  this->bits.swap(none);
+	  this->population = 0;
+	}
+	else if (this->bit_capacity() != capacity)
+	  this->resize(capacity);
+      }
+
+      bitset_type& block_storage() { return this->bits; }
+
+      void recount() {
+	this->population = detail::count_bits(this->bits);
+      }
+
       bitset_type bits;
+      size_t population;
     };
 
     template<class T, class HashFunctions,
-	     class Block, class Allocator>
-    dynamic_bloom_filter<T, HashFunctions, Block, Allocator>
+	     class Block, class Allocator, class Reduction>
+    dynamic_bloom_filter<T, HashFunctions, Block, Allocator, Reduction>
     operator|(const dynamic_bloom_filter<T, 
 					 HashFunctions, 
-					 Block, Allocator>& lhs,
+					 Block, Allocator, Reduction>& lhs,
 	      const dynamic_bloom_filter<T, 
 					 HashFunctions, 
-					 Block, Allocator>& rhs)
+					 Block, Allocator, Reduction>& rhs)
     {
       if(lhs.bit_capacity() != rhs.bit_capacity()) {
 	throw detail::incompatible_size_exception();
       }
 
-      dynamic_bloom_filter<T, HashFunctions, Block, Allocator> ret(lhs);
+      dynamic_bloom_filter<T, HashFunctions,
+			   Block, Allocator, Reduction> ret(lhs);
       ret |= rhs;
       return ret;
     }
 
     template<class T, class HashFunctions,
-	     class Block, class Allocator>
-    dynamic_bloom_filter<T, HashFunctions, Block, Allocator>
+	     class Block, class Allocator, class Reduction>
+    dynamic_bloom_filter<T, HashFunctions, Block, Allocator, Reduction>
     operator&(const dynamic_bloom_filter<T, 
 					 HashFunctions, 
-					 Block, Allocator>& lhs,
+					 Block, Allocator, Reduction>& lhs,
 	      const dynamic_bloom_filter<T, 
 					 HashFunctions, 
-					 Block, Allocator>& rhs)
+					 Block, Allocator, Reduction>& rhs)
     {
       if(lhs.bit_capacity() != rhs.bit_capacity()) {
 	throw detail::incompatible_size_exception();
       }
 
-      dynamic_bloom_filter<T, HashFunctions, Block, Allocator> ret(lhs);
+      dynamic_bloom_filter<T, HashFunctions,
+			   Block, Allocator, Reduction> ret(lhs);
       ret &= rhs;
       return ret;
     }
 
+#ifndef BOOST_NO_CXX11_RVALUE_REFERENCES
+    //? the result takes the bits of lhs instead of copying them, so
+    //? a | b | c copies only once
+    template<class T, class HashFunctions,
+	     class Block, class Allocator, class Reduction>
+    dynamic_bloom_filter<T, HashFunctions, Block, Allocator, Reduction>
+    operator|(dynamic_bloom_filter<T, 
+				   HashFunctions, 
+				   Block, Allocator, Reduction>&& lhs,
+	      const dynamic_bloom_filter<T, 
+					 HashFunctions, 
+					 Block, Allocator, Reduction>& rhs)
+    {
+      lhs |= rhs;
+      return std::move(lhs);
+    }
+
+    template<class T, class HashFunctions,
+	     class Block, class Allocator, class Reduction>
+    dynamic_bloom_filter<T, HashFunctions, Block, Allocator, Reduction>
+    operator&(dynamic_bloom_filter<T, 
+				   HashFunctions, 
+				   Block, Allocator, Reduction>&& lhs,
+	      const dynamic_bloom_filter<T, 
+					 HashFunctions, 
+					 Block, Allocator, Reduction>& rhs)
+    {
+      lhs &= rhs;
+      return std::move(lhs);
+    }
+#endif
+
 
     template<class T, class HashFunctions,
-	     class Block, class Allocator>
+	     class Block, class Allocator, class Reduction>
     bool
     operator==(const dynamic_bloom_filter<T, 
 					  HashFunctions, 
-					  Block, Allocator>& lhs,
+					  Block, Allocator, Reduction>& lhs,
 	       const dynamic_bloom_filter<T, 
 					  HashFunctions, 
-					  Block, Allocator>& rhs)
+					  Block, Allocator, Reduction>& rhs)
     {
       if(lhs.bit_capacity() != rhs.bit_capacity()) {
 	throw detail::incompatible_size_exception();
@@ -223,30 +465,50 @@ namespace boost {
     }
 
     template<class T, class HashFunctions,
-	     class Block, class Allocator>
+	     class Block, class Allocator, class Reduction>
     bool
     operator!=(const dynamic_bloom_filter<T, 
 					  HashFunctions, 
-					  Block, Allocator>& lhs,
+					  Block, Allocator, Reduction>& lhs,
 	       const dynamic_bloom_filter<T, 
 					  HashFunctions, 
-					  Block, Allocator>& rhs)
+					  Block, Allocator, Reduction>& rhs)
     {
       return !(lhs == rhs);
     }
 
     template<class T, class HashFunctions,
-	     class Block, class Allocator>
+	     class Block, class Allocator, class Reduction>
     void
     swap(dynamic_bloom_filter<T, 
 			      HashFunctions, 
-			      Block, Allocator>& lhs,
+			      Block, Allocator, Reduction>& lhs,
 	 dynamic_bloom_filter<T, 
 			      HashFunctions, 
-			      Block, Allocator>& rhs)
+			      Block, Allocator, Reduction>& rhs) BOOST_NOEXCEPT
     {
       lhs.swap(rhs);
     }
+
+    //? the union of lhs and rhs at the smaller of their capacities;
+    //? only the smaller one is copied
+    template<class T, class HashFunctions,
+	     class Block, class Allocator, class Reduction>
+    dynamic_bloom_filter<T, HashFunctions, Block, Allocator, Reduction>
+    fold_union(const dynamic_bloom_filter<T, 
+					  HashFunctions, 
+					  Block, Allocator, Reduction>& lhs,
+	       const dynamic_bloom_filter<T, 
+					  HashFunctions, 
+					  Block, Allocator, Reduction>& rhs)
+    {
+      const bool lhs_smaller = lhs.bit_capacity() <= rhs.bit_capacity();
+      dynamic_bloom_filter<T, HashFunctions,
+			   Block, Allocator, Reduction> ret(lhs_smaller ?
+							    lhs : rhs);
+      ret.fold_union(lhs_smaller ? rhs : lhs);
+      return ret;
+    }
   } // namespace bloom_filter
 } // namespace boost
 #endif
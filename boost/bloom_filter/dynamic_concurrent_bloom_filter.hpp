@@ -0,0 +1,299 @@
+//////////////////////////////////////////////////////////////////////////////
+//
+// (C) Copyright Alejandro Cabrera 2011.
+// Distributed under the Boost
+// Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or
+// copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// See http://www.boost.org/libs/bloom_filter for documentation.
+//
+//////////////////////////////////////////////////////////////////////////////
+
+#ifndef BOOST_BLOOM_FILTER_DYNAMIC_CONCURRENT_BLOOM_FILTER_HPP
+#define BOOST_BLOOM_FILTER_DYNAMIC_CONCURRENT_BLOOM_FILTER_HPP 1
+
+#include <iterator>
+#include <memory>
+
+#include <boost/config.hpp>
+#include <boost/cstdint.hpp>
+#include <boost/mpl/vector.hpp>
+
+#include <boost/bloom_filter/detail/apply_hash.hpp>
+#include <boost/bloom_filter/detail/atomic_bits.hpp>
+#include <boost/bloom_filter/detail/batch.hpp>
+#include <boost/bloom_filter/detail/exceptions.hpp>
+#include <boost/bloom_filter/detail/hash_digest.hpp>
+#include <boost/bloom_filter/detail/optimal_size.hpp>
+#include <boost/bloom_filter/detail/population.hpp>
+#include <boost/bloom_filter/hash/default.hpp>
+#include <boost/bloom_filter/reduction.hpp>
+
+/**
+ * dynamic_bloom_filter for many threads at once; see
+ * concurrent_bloom_filter.hpp. Inserts and probes are lock free and
+ * set the bits a dynamic_bloom_filter with the same parameters would.
+ * Allocator allocates the atomic words, so page_allocator can place
+ * them on huge pages.
+ *
+ * Changing the capacity -- resize(), assignment from a filter of
+ * another size, swap() and moves -- is not safe while other threads
+ * use either filter.
+ */
+namespace boost {
+  namespace bloom_filters {
+    template <typename T,
+	      class HashFunctions = mpl::vector<boost_hash<T> >,
+	      class Block = size_t,
+	      class Allocator = std::allocator<Block>,
+	      class Reduction = modulo_reduction>
+    class dynamic_concurrent_bloom_filter {
+    public:
+      typedef T value_type;
+      typedef T key_type;
+      typedef HashFunctions hash_function_type;
+      typedef Block block_type;
+      typedef Allocator allocator_type;
+      typedef Reduction reduction_type;
+      typedef detail::atomic_bit_array<Block, Allocator> bitset_type;
+      typedef dynamic_concurrent_bloom_filter<T, HashFunctions,
+					      Block, Allocator,
+					      Reduction> this_type;
+
+    private:
+      typedef typename detail::select_apply_hash<
+	HashFunctions, this_type>::type apply_hash_type;
+
+    public:
+      //* constructors
+      dynamic_concurrent_bloom_filter() {}
+
+      explicit dynamic_concurrent_bloom_filter(const size_t bit_capacity)
+	: bits(detail::checked_range<Reduction>(bit_capacity)) {}
+
+      //? as dynamic_bloom_filter's
+      dynamic_concurrent_bloom_filter(const size_t expected_insertions,
+				      const double false_positive_rate)
+	: bits(detail::bit_count_for<Reduction>(expected_insertions,
+						false_positive_rate,
+						num_hash_functions())) {}
+
+      template <typename InputIterator>
+      dynamic_concurrent_bloom_filter(const InputIterator start,
+				      const InputIterator end)
+	: bits(detail::range_for<Reduction>(std::distance(start, end) * 4))
+      {
+	this->insert(start, end);
+      }
+
+      dynamic_concurrent_bloom_filter(
+	const dynamic_concurrent_bloom_filter& other)
+	: bits(other.bits) {}
+
+#ifndef BOOST_NO_CXX11_RVALUE_REFERENCES
+      //? takes the bits of other, leaving it with none
+      dynamic_concurrent_bloom_filter(
+	dynamic_concurrent_bloom_filter&& other) BOOST_NOEXCEPT
+      {
+	this->bits.swap(other.bits);
+      }
+
+      dynamic_concurrent_bloom_filter&
+      operator=(dynamic_concurrent_bloom_filter&& rhs) BOOST_NOEXCEPT
+      {
+	bitset_type released;
+	released.swap(this->bits);
+	this->bits.swap(rhs.bits);
+	return *this;
+      }
+#endif
+
+      dynamic_concurrent_bloom_filter&
+      operator=(const dynamic_concurrent_bloom_filter& rhs)
+      {
+	this->bits = rhs.bits;
+	return *this;
+      }
+
+      //* query functions
+      static BOOST_CONSTEXPR size_t num_hash_functions() {
+        return detail::num_hashes<HashFunctions>::value;
+      }
+
+      //? estimated from count()
+      double false_positive_rate() const {
+	return detail::estimated_fpr(this->count(), this->bit_capacity(),
+				     num_hash_functions());
+      }
+
+      //? the number of bits set, counted now
+      size_t count() const {
+        return this->bits.count();
+      }
+
+      size_t bit_capacity() const {
+	return this->bits.size();
+      }
+
+      bool empty() const {
+	return this->count() == 0;
+      }
+
+      const bitset_type&
+      data() const
+      {
+	return this->bits;
+      }
+
+      //* core operations; safe from any number of threads
+      void insert(const T& t) {
+	apply_hash_type::insert(t, bits);
+      }
+
+      template <typename InputIterator>
+      void insert(const InputIterator start, const InputIterator end) {
+	for (InputIterator i = start; i != end; ++i) {
+	  this->insert(*i);
+	}
+      }
+
+      bool probably_contains(const T& t) const {
+	return apply_hash_type::contains(t, bits);
+      }
+
+      //* pre-hashed ops
+      //? digests are those of dynamic_bloom_filter
+      typedef detail::hash_digest<apply_hash_type::num_positions> digest_type;
+
+      static digest_type hash_key(const T& t) {
+	digest_type digest;
+	apply_hash_type::hashes(t, digest.values);
+	return digest;
+      }
+
+      void insert_hash(const digest_type& digest) {
+	detail::bitset_insert_digest<reduction_type>(digest, bits);
+      }
+
+      bool probably_contains_hash(const digest_type& digest) const {
+	return detail::bitset_contains_digest<reduction_type>(digest, bits);
+      }
+
+      //? as dynamic_bloom_filter::insert_batch
+      template <typename InputIterator>
+      void insert_batch(const InputIterator start, const InputIterator end) {
+	detail::bitset_insert_batch<apply_hash_type>(start, end, bits);
+      }
+
+      //? as dynamic_bloom_filter::probably_contains_batch
+      template <typename InputIterator>
+      size_t probably_contains_batch(const InputIterator start,
+				     const InputIterator end,
+				     boost::uint64_t *const out) const {
+	return detail::bitset_contains_batch<apply_hash_type>(start, end,
+							      bits, out);
+      }
+
+      //* auxilliary operations
+      void clear() {
+        this->bits.reset();
+      }
+
+      //? exchanges the bits of the two filters; no bits are copied
+      void swap(dynamic_concurrent_bloom_filter& other) BOOST_NOEXCEPT {
+	this->bits.swap(other.bits);
+      }
+
+      void resize(const size_t new_capacity) {
+	bitset_type resized(detail::checked_range<Reduction>(new_capacity));
+	this->bits.swap(resized);
+      }
+
+      //? safe while either filter is inserted into
+      dynamic_concurrent_bloom_filter&
+      operator|=(const dynamic_concurrent_bloom_filter& rhs) {
+	if(this->bit_capacity() != rhs.bit_capacity()) {
+	  throw detail::incompatible_size_exception();
+	}
+
+	detail::or_words(this->bits.data(), rhs.bits.data(),
+			 this->bits.num_blocks());
+        return *this;
+      }
+
+      dynamic_concurrent_bloom_filter&
+      operator&=(const dynamic_concurrent_bloom_filter& rhs) {
+	if(this->bit_capacity() != rhs.bit_capacity()) {
+	  throw detail::incompatible_size_exception();
+	}
+
+	detail::and_words(this->bits.data(), rhs.bits.data(),
+			  this->bits.num_blocks());
+        return *this;
+      }
+
+      bool operator==(const dynamic_concurrent_bloom_filter& rhs) const {
+	if(this->bit_capacity() != rhs.bit_capacity()) {
+	  throw detail::incompatible_size_exception();
+	}
+
+	return detail::equal_words(this->bits.data(), rhs.bits.data(),
+				   this->bits.num_blocks());
+      }
+
+      bool operator!=(const dynamic_concurrent_bloom_filter& rhs) const {
+	return !(*this == rhs);
+      }
+
+    private:
+      bitset_type bits;
+    };
+
+    template<class T, class HashFunctions,
+	     class Block, class Allocator, class Reduction>
+    dynamic_concurrent_bloom_filter<T, HashFunctions,
+				    Block, Allocator, Reduction>
+    operator|(const dynamic_concurrent_bloom_filter<T, HashFunctions,
+						    Block, Allocator,
+						    Reduction>& lhs,
+	      const dynamic_concurrent_bloom_filter<T, HashFunctions,
+						    Block, Allocator,
+						    Reduction>& rhs)
+    {
+      dynamic_concurrent_bloom_filter<T, HashFunctions,
+				      Block, Allocator, Reduction> ret(lhs);
+      ret |= rhs;
+      return ret;
+    }
+
+    template<class T, class HashFunctions,
+	     class Block, class Allocator, class Reduction>
+    dynamic_concurrent_bloom_filter<T, HashFunctions,
+				    Block, Allocator, Reduction>
+    operator&(const dynamic_concurrent_bloom_filter<T, HashFunctions,
+						    Block, Allocator,
+						    Reduction>& lhs,
+	      const dynamic_concurrent_bloom_filter<T, HashFunctions,
+						    Block, Allocator,
+						    Reduction>& rhs)
+    {
+      dynamic_concurrent_bloom_filter<T, HashFunctions,
+				      Block, Allocator, Reduction> ret(lhs);
+      ret &= rhs;
+      return ret;
+    }
+
+    template<class T, class HashFunctions,
+	     class Block, class Allocator, class Reduction>
+    void
+    swap(dynamic_concurrent_bloom_filter<T, HashFunctions,
+					 Block, Allocator, Reduction>& lhs,
+	 dynamic_concurrent_bloom_filter<T, HashFunctions,
+					 Block, Allocator, Reduction>& rhs)
+    {
+      lhs.swap(rhs);
+    }
+  } // namespace bloom_filters
+} // namespace boost
+#endif
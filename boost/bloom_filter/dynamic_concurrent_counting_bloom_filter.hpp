@@ -0,0 +1,370 @@
+//////////////////////////////////////////////////////////////////////////////
+//
+// (C) Copyright Alejandro Cabrera 2011.
+// Distributed under the Boost
+// Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or
+// copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// See http://www.boost.org/libs/bloom_filter for documentation.
+//
+//////////////////////////////////////////////////////////////////////////////
+
+#ifndef BOOST_BLOOM_FILTER_DYNAMIC_CONCURRENT_COUNTING_BLOOM_FILTER_HPP
+#define BOOST_BLOOM_FILTER_DYNAMIC_CONCURRENT_COUNTING_BLOOM_FILTER_HPP 1
+
+#include <algorithm>
+#include <iterator>
+#include <memory>
+
+#include <boost/config.hpp>
+#include <boost/cstdint.hpp>
+#include <boost/mpl/vector.hpp>
+#include <boost/static_assert.hpp>
+#include <boost/type_traits/is_integral.hpp>
+#include <boost/type_traits/is_unsigned.hpp>
+
+#include <boost/bloom_filter/detail/atomic_bits.hpp>
+#include <boost/bloom_filter/detail/counting_apply_hash.hpp>
+#include <boost/bloom_filter/detail/counting_ops.hpp>
+#include <boost/bloom_filter/detail/exceptions.hpp>
+#include <boost/bloom_filter/detail/hash_digest.hpp>
+#include <boost/bloom_filter/detail/optimal_size.hpp>
+#include <boost/bloom_filter/detail/population.hpp>
+#include <boost/bloom_filter/hash/default.hpp>
+#include <boost/bloom_filter/reduction.hpp>
+
+/**
+ * dynamic_counting_bloom_filter for many threads at once; see
+ * concurrent_counting_bloom_filter.hpp. insert() and remove() are lock
+ * free and return false on a full (or empty) bin instead of throwing,
+ * and full bins are sticky.
+ *
+ * Changing the number of bins -- assignment from a filter of another
+ * size, swap() and moves -- is not safe while other threads use either
+ * filter.
+ */
+namespace boost {
+  namespace bloom_filters {
+    template <typename T,
+	      size_t BitsPerBin = 4,
+	      class HashFunctions = mpl::vector<boost_hash<T> >,
+	      typename Block = size_t,
+	      typename Allocator = std::allocator<Block>,
+	      class Reduction = modulo_reduction>
+    class dynamic_concurrent_counting_bloom_filter {
+
+      // as for dynamic_counting_bloom_filter
+      BOOST_STATIC_ASSERT( boost::is_integral<Block>::value == true);
+      BOOST_STATIC_ASSERT( boost::is_unsigned<Block>::value == true);
+      BOOST_STATIC_ASSERT( BitsPerBin > 0);
+      BOOST_STATIC_ASSERT( (BitsPerBin < (sizeof(Block) * 8) ) );
+      BOOST_STATIC_ASSERT( ((sizeof(Block) * 8) % BitsPerBin) == 0);
+
+    public:
+      typedef T value_type;
+      typedef T key_type;
+      typedef HashFunctions hash_function_type;
+      typedef Block block_type;
+      typedef Allocator allocator_type;
+      typedef Reduction reduction_type;
+      typedef dynamic_concurrent_counting_bloom_filter<T, BitsPerBin,
+						       HashFunctions, Block,
+						       Allocator,
+						       Reduction> this_type;
+
+      typedef detail::atomic_block_array<Block, Allocator> bucket_type;
+
+      static const size_t slot_bits = sizeof(block_type) * 8;
+      static const size_t default_num_bins = 32;
+
+    private:
+      static size_t bucket_size(const size_t requested_bins) {
+	const size_t bin_bits = requested_bins * BitsPerBin;
+	return bin_bits / slot_bits + 1;
+      }
+
+      typedef typename detail::select_counting_apply_hash<
+	HashFunctions, this_type>::type apply_hash_type;
+
+    public:
+      //* constructors
+      dynamic_concurrent_counting_bloom_filter()
+	: bits(bucket_size(default_num_bins)),
+	  _num_bins(default_num_bins)
+      {
+      }
+
+      explicit
+      dynamic_concurrent_counting_bloom_filter(const size_t requested_bins)
+	: bits(bucket_size(detail::checked_range<Reduction>(requested_bins))),
+	  _num_bins(requested_bins)
+      {
+      }
+
+      //? as dynamic_counting_bloom_filter's
+      dynamic_concurrent_counting_bloom_filter(
+	const size_t expected_insertions,
+	const double false_positive_rate)
+	: bits(bucket_size(detail::bit_count_for<Reduction>(
+			     expected_insertions, false_positive_rate,
+			     num_hash_functions()))),
+	  _num_bins(detail::bit_count_for<Reduction>(expected_insertions,
+						     false_positive_rate,
+						     num_hash_functions()))
+      {
+      }
+
+      template <typename InputIterator>
+      dynamic_concurrent_counting_bloom_filter(const InputIterator start,
+					       const InputIterator end)
+	: bits(bucket_size(
+	    detail::range_for<Reduction>(std::distance(start, end) * 4))),
+	  _num_bins(detail::range_for<Reduction>(std::distance(start, end) * 4))
+      {
+	this->insert(start, end);
+      }
+
+      dynamic_concurrent_counting_bloom_filter(
+	const dynamic_concurrent_counting_bloom_filter& other)
+	: bits(other.bits),
+	  _num_bins(other._num_bins)
+      {
+      }
+
+#ifndef BOOST_NO_CXX11_RVALUE_REFERENCES
+      //? takes the bins of other, leaving it with none
+      dynamic_concurrent_counting_bloom_filter(
+	dynamic_concurrent_counting_bloom_filter&& other) BOOST_NOEXCEPT
+	: _num_bins(0)
+      {
+	this->swap(other);
+      }
+
+      dynamic_concurrent_counting_bloom_filter&
+      operator=(dynamic_concurrent_counting_bloom_filter&& rhs) BOOST_NOEXCEPT
+      {
+	dynamic_concurrent_counting_bloom_filter released;
+	released.swap(*this);
+	this->swap(rhs);
+	return *this;
+      }
+#endif
+
+      dynamic_concurrent_counting_bloom_filter&
+      operator=(const dynamic_concurrent_counting_bloom_filter& rhs)
+      {
+	this->bits = rhs.bits;
+	this->_num_bins = rhs._num_bins;
+	return *this;
+      }
+
+      //* meta functions
+      size_t num_bins() const
+      {
+	return this->_num_bins;
+      }
+
+      static BOOST_CONSTEXPR size_t bits_per_bin()
+      {
+	return BitsPerBin;
+      }
+
+      static BOOST_CONSTEXPR size_t bins_per_slot()
+      {
+	return sizeof(block_type) * 8 / BitsPerBin;
+      }
+
+      static BOOST_CONSTEXPR size_t mask()
+      {
+	return static_cast<Block>(0 - 1) >> (slot_bits - BitsPerBin);
+      }
+
+      size_t bit_capacity() const
+      {
+	return this->_num_bins * BitsPerBin;
+      }
+
+      static BOOST_CONSTEXPR size_t num_hash_functions()
+      {
+	return detail::num_hashes<HashFunctions>::value;
+      }
+
+      //? estimated from count()
+      double false_positive_rate() const
+      {
+	return detail::estimated_fpr(this->count(), this->_num_bins,
+				     num_hash_functions());
+      }
+
+      //? the number of bins in use, counted now
+      size_t count() const
+      {
+	return detail::count_nonzero_bins<this_type>(this->bits,
+						     this->_num_bins);
+      }
+
+      bool empty() const
+      {
+	return this->count() == 0;
+      }
+
+      const bucket_type&
+      data() const
+      {
+	return this->bits;
+      }
+
+      //* core operations; safe from any number of threads
+      //? false if a bin of t was full, and so left as it was
+      bool insert(const T& t)
+      {
+	size_t bins[apply_hash_type::num_positions];
+	apply_hash_type::positions(t, this->_num_bins, bins);
+	return this->step(bins, true);
+      }
+
+      //? returns the number of keys with a full bin
+      template <typename InputIterator>
+      size_t insert(const InputIterator start, const InputIterator end)
+      {
+	size_t overflows = 0;
+	for (InputIterator i = start; i != end; ++i)
+	  if (!this->insert(*i))
+	    ++overflows;
+	return overflows;
+      }
+
+      //? false if a bin of t was empty, and so left as it was; full
+      //? bins stay full
+      bool remove(const T& t)
+      {
+	size_t bins[apply_hash_type::num_positions];
+	apply_hash_type::positions(t, this->_num_bins, bins);
+	return this->step(bins, false);
+      }
+
+      //? returns the number of keys with an empty bin
+      template <typename InputIterator>
+      size_t remove(const InputIterator start, const InputIterator end)
+      {
+	size_t underflows = 0;
+	for (InputIterator i = start; i != end; ++i)
+	  if (!this->remove(*i))
+	    ++underflows;
+	return underflows;
+      }
+
+      bool probably_contains(const T& t) const
+      {
+	size_t bins[apply_hash_type::num_positions];
+	apply_hash_type::positions(t, this->_num_bins, bins);
+	return this->all_in_use(bins);
+      }
+
+      //* pre-hashed ops
+      //? digests are those of dynamic_counting_bloom_filter
+      typedef detail::hash_digest<apply_hash_type::num_positions> digest_type;
+
+      static digest_type hash_key(const T& t)
+      {
+	digest_type digest;
+	apply_hash_type::hashes(t, digest.values);
+	return digest;
+      }
+
+      bool insert_hash(const digest_type& digest)
+      {
+	size_t bins[apply_hash_type::num_positions];
+	this->reduce(digest, bins);
+	return this->step(bins, true);
+      }
+
+      bool remove_hash(const digest_type& digest)
+      {
+	size_t bins[apply_hash_type::num_positions];
+	this->reduce(digest, bins);
+	return this->step(bins, false);
+      }
+
+      bool probably_contains_hash(const digest_type& digest) const
+      {
+	size_t bins[apply_hash_type::num_positions];
+	this->reduce(digest, bins);
+	return this->all_in_use(bins);
+      }
+
+      //* auxiliary operations
+      void clear()
+      {
+	this->bits.reset();
+      }
+
+      //? exchanges the bins of the two filters; no bins are copied
+      void swap(dynamic_concurrent_counting_bloom_filter& other)
+	BOOST_NOEXCEPT
+      {
+	this->bits.swap(other.bits);
+	std::swap(this->_num_bins, other._num_bins);
+      }
+
+      bool
+      operator==(const dynamic_concurrent_counting_bloom_filter& rhs) const
+      {
+	if (this->_num_bins != rhs._num_bins)
+	  throw detail::incompatible_size_exception();
+
+	return detail::equal_words(this->bits.data(), rhs.bits.data(),
+				   this->bits.size());
+      }
+
+      bool
+      operator!=(const dynamic_concurrent_counting_bloom_filter& rhs) const
+      {
+	return !(*this == rhs);
+      }
+
+    private:
+      void reduce(const digest_type& digest, size_t *const bins) const
+      {
+	for (size_t i = 0; i < apply_hash_type::num_positions; ++i)
+	  bins[i] = reduction_type::reduce(digest.values[i], this->_num_bins);
+      }
+
+      bool step(const size_t *const bins, const bool up)
+      {
+	bool stepped = true;
+	for (size_t i = 0; i < apply_hash_type::num_positions; ++i)
+	  if (!detail::atomic_step_bin<this_type>(this->bits.data(),
+						  bins[i], up))
+	    stepped = false;
+	return stepped;
+      }
+
+      bool all_in_use(const size_t *const bins) const
+      {
+	for (size_t i = 0; i < apply_hash_type::num_positions; ++i)
+	  if (detail::read_bin<this_type>(this->bits, bins[i]) == 0)
+	    return false;
+	return true;
+      }
+
+      bucket_type bits;
+      size_t _num_bins;
+    };
+
+    template<class T, size_t BitsPerBin, class HashFunctions,
+	     class Block, class Allocator, class Reduction>
+    void
+    swap(dynamic_concurrent_counting_bloom_filter<T, BitsPerBin,
+						  HashFunctions, Block,
+						  Allocator, Reduction>& lhs,
+	 dynamic_concurrent_counting_bloom_filter<T, BitsPerBin,
+						  HashFunctions, Block,
+						  Allocator, Reduction>& rhs)
+    {
+      lhs.swap(rhs);
+    }
+  } // namespace bloom_filters
+} // namespace boost
+#endif
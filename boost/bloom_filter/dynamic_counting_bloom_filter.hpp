@@ -13,10 +13,12 @@
 #ifndef BOOST_BLOOM_FILTER_DYNAMIC_COUNTING_BLOOM_FILTER_HPP
 #define BOOST_BLOOM_FILTER_DYNAMIC_COUNTING_BLOOM_FILTER_HPP 1
 
-#include <cmath>
+#include <algorithm>
+#include <utility>
 #include <vector>
 
 #include <boost/config.hpp>
+#include <boost/cstdint.hpp>
 
 #include <boost/mpl/vector.hpp>
 #include <boost/mpl/size.hpp>
@@ -26,7 +28,15 @@
 #include <boost/type_traits/is_unsigned.hpp>
 
 #include <boost/bloom_filter/detail/counting_apply_hash.hpp>
+#include <boost/bloom_filter/detail/batch.hpp>
+#include <boost/bloom_filter/detail/dynamic_storage.hpp>
+#include <boost/bloom_filter/detail/exceptions.hpp>
+#include <boost/bloom_filter/detail/filter_header.hpp>
+#include <boost/bloom_filter/detail/hash_digest.hpp>
+#include <boost/bloom_filter/detail/optimal_size.hpp>
+#include <boost/bloom_filter/detail/population.hpp>
 #include <boost/bloom_filter/hash/default.hpp>
+#include <boost/bloom_filter/reduction.hpp>
 
 namespace boost {
   namespace bloom_filters {
@@ -34,7 +44,8 @@ namespace boost {
 	      size_t BitsPerBin = 4,
 	      class HashFunctions = mpl::vector<boost_hash<T> >,
 	      typename Block = size_t,
-	      typename Allocator = std::allocator<Block> >
+	      typename Allocator = std::allocator<Block>,
+	      class Reduction = modulo_reduction>
     class dynamic_counting_bloom_filter {
 
       // Block needs to be an integral type
@@ -66,11 +77,14 @@ namespace boost {
       typedef HashFunctions hash_function_type;
       typedef Block block_type;
       typedef Allocator allocator_type;
+      typedef Reduction reduction_type;
       typedef dynamic_counting_bloom_filter<T, BitsPerBin, 
 					    HashFunctions, 
-					    Block, Allocator> this_type;
+					    Block, Allocator,
+					    Reduction> this_type;
 
-      typedef std::vector<Block, Allocator> bucket_type;
+      typedef typename detail::dynamic_buckets<Block,
+					       Allocator>::type bucket_type;
       typedef typename bucket_type::iterator bucket_iterator;
       typedef typename bucket_type::const_iterator bucket_const_iterator;
 
@@ -83,33 +97,96 @@ namespace boost {
 	return bin_bits / slot_bits + 1;
       }
 
-      typedef detail::counting_apply_hash<mpl::size<HashFunctions>::value - 1,
-					  this_type> apply_hash_type;
+      typedef typename detail::select_counting_apply_hash<
+	HashFunctions, this_type>::type apply_hash_type;
 
     public:
       //* constructors
       dynamic_counting_bloom_filter() 
 	: bits(bucket_size(default_num_bins)),
-	  _num_bins(default_num_bins)
+	  _num_bins(default_num_bins),
+	  population(0)
       {
       }
 
       explicit dynamic_counting_bloom_filter(const size_t requested_bins)
-	: bits(bucket_size(requested_bins)),
-	  _num_bins(requested_bins)
+	: bits(bucket_size(detail::checked_range<Reduction>(requested_bins))),
+	  _num_bins(requested_bins),
+	  population(0)
       {
       }
 
+      //? sized to hold expected_insertions keys at no more than
+      //? false_positive_rate, one bin per bit of the equivalent
+      //? dynamic_bloom_filter
+      dynamic_counting_bloom_filter(const size_t expected_insertions,
+				    const double false_positive_rate)
+	: bits(bucket_size(detail::bit_count_for<Reduction>(
+			     expected_insertions, false_positive_rate,
+			     num_hash_functions()))),
+	  _num_bins(detail::bit_count_for<Reduction>(expected_insertions,
+						     false_positive_rate,
+						     num_hash_functions())),
+	  population(0)
+      {
+      }
+
+      //? with Allocator = mapped_file: creates file.path, replacing any
+      //? file there, for a filter of requested_bins bins
+      dynamic_counting_bloom_filter(const mapped_file_params& file,
+				    const size_t requested_bins)
+	: bits(file,
+	       bucket_size(detail::checked_range<Reduction>(requested_bins)),
+	       header_for(requested_bins)),
+	  _num_bins(requested_bins),
+	  population(0)
+      {
+      }
+
+      //? with Allocator = mapped_file: maps the filter in file.path
+      explicit dynamic_counting_bloom_filter(const mapped_file_params& file)
+	: bits(file, header_for(0)),
+	  _num_bins(static_cast<size_t>(bits.layout().capacity)),
+	  population(0)
+      {
+	if (bits.size() != bucket_size(this->_num_bins))
+	  throw detail::mapped_file_exception();
+	detail::checked_range<Reduction>(this->_num_bins);
+	this->recount();
+      }
+
       template <typename InputIterator>
       dynamic_counting_bloom_filter(const InputIterator start, 
 				    const InputIterator end) 
-	: bits(bucket_size(std::distance(start, end) * 4)),
-	  _num_bins(std::distance(start, end) * 4)
+	: bits(bucket_size(
+	    detail::range_for<Reduction>(std::distance(start, end) * 4))),
+	  _num_bins(detail::range_for<Reduction>(std::distance(start, end) * 4)),
+	  population(0)
       {
 	for (InputIterator i = start; i != end; ++i)
 	  this->insert(*i);
       }
 
+      dynamic_counting_bloom_filter(const dynamic_counting_bloom_filter& other)
+	: bits(other.bits),
+	  _num_bins(other._num_bins),
+	  population(other.population)
+      {
+      }
+
+#ifndef BOOST_NO_CXX11_RVALUE_REFERENCES
+      //? takes the bins of other, leaving it with none
+      dynamic_counting_bloom_filter(dynamic_counting_bloom_filter&& other)
+	BOOST_NOEXCEPT
+	: _num_bins(other._num_bins),
+	  population(other.population)
+      {
+	this->bits.swap(other.bits);
+	other._num_bins = 0;
+	other.population = 0;
+      }
+#endif
+
       //* meta functions
       size_t num_bins() const
       {
@@ -138,37 +215,25 @@ namespace boost {
 
       static BOOST_CONSTEXPR size_t num_hash_functions() 
       {
-        return mpl::size<HashFunctions>::value;
+        return detail::num_hashes<HashFunctions>::value;
       }
 
+      //? estimated from count(), so as cheap to ask
       double false_positive_rate() const 
       {
-        const double n = static_cast<double>(this->count());
-        static const double k = static_cast<double>(num_hash_functions());
-        static const double m = static_cast<double>(this->num_bins());
-        static const double e =
-	  2.718281828459045235360287471352662497757247093699959574966;
-        return std::pow(1 - std::pow(e, -k * n / m), k);
+	return detail::estimated_fpr(this->count(), this->num_bins(),
+				     num_hash_functions());
       }
 
-      //? returns the number of bins that have at least 1 bit set
+      //? returns the number of bins that have at least 1 bit set. It
+      //? is kept as keys go in and out, except with Allocator =
+      //? mapped_file, where it is counted afresh each time.
       size_t count() const 
       {
-	size_t ret = 0;
-
-	for (bucket_const_iterator i = this->bits.begin(), 
-	       end = this->bits.end(); 
-	     i != end; ++i) {
-	  for (size_t bin = 0; bin < this->bins_per_slot(); ++bin) {
-	    const size_t offset_bits = bin * BitsPerBin;
-	    const size_t target_bits = (*i >> offset_bits) & this->mask();
-
-	    if (target_bits > 0)
-	      ++ret;
-	  }
-	}
-
-        return ret;
+	if (detail::shared_storage<bucket_type>::value)
+	  return detail::count_nonzero_bins<this_type>(this->bits,
+						       this->num_bins());
+        return this->population;
       }
 
       bool empty() const
@@ -187,7 +252,8 @@ namespace boost {
       {
 	apply_hash_type::insert(t, 
 				this->bits,
-				this->num_bins());
+				this->num_bins(),
+				this->population);
       }
 
       template <typename InputIterator>
@@ -202,7 +268,8 @@ namespace boost {
       {
 	apply_hash_type::remove(t, 
 				this->bits,
-				this->num_bins());
+				this->num_bins(),
+				this->population);
       }
 
       template <typename InputIterator>
@@ -220,73 +287,220 @@ namespace boost {
 					 this->num_bins());
       }
 
+      //* pre-hashed ops
+      //? the unreduced hash values of a key. A digest can be passed to
+      //? insert_hash() and probably_contains_hash() of any filter with
+      //? the same key type and hashing, whatever its size, so a key
+      //? probed against many filters is hashed only once.
+      typedef detail::hash_digest<apply_hash_type::num_positions> digest_type;
+
+      static digest_type hash_key(const T& t)
+      {
+	digest_type digest;
+	apply_hash_type::hashes(t, digest.values);
+	return digest;
+      }
+
+      void insert_hash(const digest_type& digest)
+      {
+	detail::counting_update_digest<this_type>(
+	  digest, this->bits, this->num_bins(),
+	  detail::increment(this->population),
+	  (static_cast<size_t>(1) << BitsPerBin) - 1);
+      }
+
+      void remove_hash(const digest_type& digest)
+      {
+	detail::counting_update_digest<this_type>(
+	  digest, this->bits, this->num_bins(),
+	  detail::decrement(this->population), 0);
+      }
+
+      bool probably_contains_hash(const digest_type& digest) const
+      {
+	return detail::counting_contains_digest<this_type>(
+	  digest, this->bits, this->num_bins());
+      }
+
+      //? inserts every key in [start, end). Same result as
+      //? insert(start, end), but the bins of a group of keys are
+      //? prefetched together so their cache misses overlap.
+      template <typename InputIterator>
+      void insert_batch(const InputIterator start, const InputIterator end)
+      {
+	detail::counting_update_batch<apply_hash_type, this_type>(
+	  start, end, this->bits, this->num_bins(),
+	  detail::increment(this->population),
+	  (static_cast<size_t>(1) << BitsPerBin) - 1);
+      }
+
+      //? tests every key in [start, end). Bit i % 64 of out[i / 64] is
+      //? set if the i-th key is probably contained, so out must have
+      //? room for (std::distance(start, end) + 63) / 64 words. Returns
+      //? the number of keys that are probably contained.
+      template <typename InputIterator>
+      size_t probably_contains_batch(const InputIterator start,
+				     const InputIterator end,
+				     boost::uint64_t *const out) const
+      {
+	return detail::counting_contains_batch<apply_hash_type, this_type>(
+	  start, end, this->bits, this->num_bins(), out);
+      }
+
       //* auxiliary ops
       void clear()
       {
 	for (bucket_iterator i = bits.begin(), end = bits.end();
 	     i != end; ++i)
 	  *i = 0;
+	this->population = 0;
       }
 
-      void swap(dynamic_counting_bloom_filter& other)
+      //? with Allocator = mapped_file: writes the bins changed so far
+      //? back to the file; waits for the disk unless async is true
+      void flush(const bool async = false)
+      {
+	this->bits.flush(async);
+      }
+
+      dynamic_counting_bloom_filter&
+      operator=(const dynamic_counting_bloom_filter& rhs)
+      {
+	this->bits = rhs.bits;
+	this->_num_bins = rhs._num_bins;
+	this->population = rhs.population;
+	return *this;
+      }
+
+#ifndef BOOST_NO_CXX11_RVALUE_REFERENCES
+      //? takes the bins of rhs, leaving it with none
+      dynamic_counting_bloom_filter&
+      operator=(dynamic_counting_bloom_filter&& rhs) BOOST_NOEXCEPT
+      {
+	bucket_type released;
+	released.swap(this->bits);
+	this->bits.swap(rhs.bits);
+	this->_num_bins = rhs._num_bins;
+	this->population = rhs.population;
+	rhs._num_bins = 0;
+	rhs.population = 0;
+	return *this;
+      }
+#endif
+
+      //? exchanges the bins of the two filters; no bins are copied
+      void swap(dynamic_counting_bloom_filter& other) BOOST_NOEXCEPT
       {
-	dynamic_counting_bloom_filter tmp = other;
-	other = *this;
-	*this = tmp;
+	this->bits.swap(other.bits);
+	std::swap(this->_num_bins, other._num_bins);
+	std::swap(this->population, other.population);
       }
 
       //* equality comparison operators
       template <typename _T, size_t _BitsPerBin,
-		typename _HashFns, typename _Block, typename _Allocator>
+		typename _HashFns, typename _Block, typename _Allocator,
+		typename _Reduction>
       friend bool
       operator==(const dynamic_counting_bloom_filter<_T, _BitsPerBin,
 						     _HashFns, _Block,
-						     _Allocator>& lhs,
+						     _Allocator,
+						     _Reduction>& lhs,
 		 const dynamic_counting_bloom_filter<_T, _BitsPerBin,
 						     _HashFns, _Block,
-						     _Allocator>& rhs);
+						     _Allocator,
+						     _Reduction>& rhs);
 
       template <typename _T, size_t _BitsPerBin,
-		typename _HashFns, typename _Block, typename _Allocator>
+		typename _HashFns, typename _Block, typename _Allocator,
+		typename _Reduction>
       friend bool
       operator!=(const dynamic_counting_bloom_filter<_T, _BitsPerBin,
 						     _HashFns, _Block,
-						     _Allocator>& lhs,
+						     _Allocator,
+						     _Reduction>& lhs,
 		 const dynamic_counting_bloom_filter<_T, _BitsPerBin,
 						     _HashFns, _Block,
-						     _Allocator>& rhs);
+						     _Allocator,
+						     _Reduction>& rhs);
 
 
     private:
+      friend struct detail::filter_access;
+
+      static detail::filter_header header_for(const size_t bins)
+      {
+	return detail::make_header<HashFunctions, Reduction, mpl::vector<> >(
+	  detail::hashed_bins, sizeof(Block), BitsPerBin,
+	  num_hash_functions(), bins);
+      }
+
+      detail::filter_header header() const
+      {
+	return header_for(this->num_bins());
+      }
+
+      void reshape(const detail::filter_header& saved, const bool allocate)
+      {
+	const size_t bins = static_cast<size_t>(saved.capacity);
+	detail::check_header(saved, header_for(bins));
+	detail::checked_range<Reduction>(bins);
+
+	if (!allocate) {
+	  bucket_type none;
+	  this->bits.swap(none);
+	  this->population = 0;
+	}
+	else if (this->num_bins() != bins) {
+	  bucket_type fresh(bucket_size(bins));
+	  this->bits.swap(fresh);
+	  this->population = 0;
+	}
+	this->_num_bins = bins;
+      }
+
+      bucket_type& block_storage() { return this->bits; }
+
+      void recount()
+      {
+	this->population =
+	  detail::count_nonzero_bins<this_type>(this->bits, this->num_bins());
+      }
+
       bucket_type bits;
       size_t _num_bins;
+      size_t population;
     };
 
     template<class T, size_t BitsPerBin, class HashFunctions,
-	     typename Block, typename Allocator>
+	     typename Block, typename Allocator,
+	     typename Reduction>
     void
     swap(dynamic_counting_bloom_filter<T, BitsPerBin, 
 				       HashFunctions, Block,
-				       Allocator>& lhs,
+				       Allocator,
+				       Reduction>& lhs,
 	 dynamic_counting_bloom_filter<T, BitsPerBin,
 				       HashFunctions, Block,
-				       Allocator>& rhs)
-
+				       Allocator,
+				       Reduction>& rhs) BOOST_NOEXCEPT
     {
       lhs.swap(rhs);
     }
 
     template<class T, size_t BitsPerBin, class HashFunctions,
-	     typename Block, typename Allocator>
+	     typename Block, typename Allocator,
+	     typename Reduction>
     bool
     operator==(const dynamic_counting_bloom_filter<T, BitsPerBin, 
 						   HashFunctions, 
 						   Block,
-						   Allocator>& lhs,
+						   Allocator,
+						   Reduction>& lhs,
 	       const dynamic_counting_bloom_filter<T, BitsPerBin,
 						   HashFunctions, 
 						   Block,
-						   Allocator>& rhs)
+						   Allocator,
+						   Reduction>& rhs)
     {
       if (lhs.bit_capacity() != rhs.bit_capacity())
 	throw detail::incompatible_size_exception();
@@ -295,16 +509,19 @@ namespace boost {
     }
 
     template<class T, size_t BitsPerBin, class HashFunctions,
-	     typename Block, typename Allocator>
+	     typename Block, typename Allocator,
+	     typename Reduction>
     bool
     operator!=(const dynamic_counting_bloom_filter<T, BitsPerBin, 
 						   HashFunctions, 
 						   Block,
-						   Allocator>& lhs,
+						   Allocator,
+						   Reduction>& lhs,
 	       const dynamic_counting_bloom_filter<T, BitsPerBin,
 						   HashFunctions, 
 						   Block,
-						   Allocator>& rhs)
+						   Allocator,
+						   Reduction>& rhs)
     {
       if (lhs.bit_capacity() != rhs.bit_capacity())
 	throw detail::incompatible_size_exception();
@@ -0,0 +1,145 @@
+//////////////////////////////////////////////////////////////////////////////
+//
+// (C) Copyright Alejandro Cabrera 2011.
+// Distributed under the Boost
+// Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or
+// copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// See http://www.boost.org/libs/bloom_filter for documentation.
+//
+//////////////////////////////////////////////////////////////////////////////
+
+#ifndef BOOST_BLOOM_FILTER_BYTE_VIEW_HPP
+#define BOOST_BLOOM_FILTER_BYTE_VIEW_HPP 1
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include <boost/config.hpp>
+#include <boost/static_assert.hpp>
+#include <boost/type_traits/is_pod.hpp>
+#include <boost/type_traits/is_same.hpp>
+#include <boost/utility/enable_if.hpp>
+#include <boost/utility/string_view.hpp>
+
+#ifndef BOOST_NO_CXX17_HDR_STRING_VIEW
+#include <string_view>
+#endif
+
+/**
+ * byte_view<T> tells the byte hashers (murmurhash3, murmurhash3_128)
+ * which bytes make up the value of a T:
+ *   static const void *data(const T&);
+ *   static size_t size(const T&);
+ * The hashers read those bytes in place; nothing is copied.
+ *
+ * The primary template uses the object representation, &t and
+ * sizeof(T). That's only right for types without padding or pointers.
+ * Strings, string views and vectors of PODs are specialized below to
+ * use their contents; vector<bool> doesn't compile. Specialize byte_view for your own types that own
+ * a buffer, or whose equal values can differ in padding:
+ *
+ *   namespace boost { namespace bloom_filters {
+ *     template <> struct byte_view<url> {
+ *       static const void *data(const url& u) { return u.text(); }
+ *       static size_t size(const url& u) { return u.length(); }
+ *     };
+ *   }}
+ *
+ * The second parameter exists only so that specializations can be
+ * selected with enable_if.
+ */
+namespace boost {
+  namespace bloom_filters {
+
+    template <typename T, typename Enable = void>
+    struct byte_view {
+      static const void *data(const T& t)
+      {
+	return &t;
+      }
+
+      static size_t size(const T&)
+      {
+	return sizeof(T);
+      }
+    };
+
+    //* strings hash their characters, not their pointer and length
+    template <typename Char, typename Traits, typename Allocator>
+    struct byte_view<std::basic_string<Char, Traits, Allocator> > {
+      static const void *
+      data(const std::basic_string<Char, Traits, Allocator>& s)
+      {
+	return s.data();
+      }
+
+      static size_t
+      size(const std::basic_string<Char, Traits, Allocator>& s)
+      {
+	return s.size() * sizeof(Char);
+      }
+    };
+
+    template <typename Char, typename Traits>
+    struct byte_view<boost::basic_string_view<Char, Traits> > {
+      static const void *
+      data(const boost::basic_string_view<Char, Traits>& s)
+      {
+	return s.data();
+      }
+
+      static size_t
+      size(const boost::basic_string_view<Char, Traits>& s)
+      {
+	return s.size() * sizeof(Char);
+      }
+    };
+
+#ifndef BOOST_NO_CXX17_HDR_STRING_VIEW
+    template <typename Char, typename Traits>
+    struct byte_view<std::basic_string_view<Char, Traits> > {
+      static const void *
+      data(const std::basic_string_view<Char, Traits>& s)
+      {
+	return s.data();
+      }
+
+      static size_t
+      size(const std::basic_string_view<Char, Traits>& s)
+      {
+	return s.size() * sizeof(Char);
+      }
+    };
+#endif
+
+    //* vectors of PODs hash their elements
+    template <typename T, typename Allocator>
+    struct byte_view<std::vector<T, Allocator>,
+		     typename enable_if_c<is_pod<T>::value &&
+					  !is_same<T, bool>::value>::type> {
+      static const void *data(const std::vector<T, Allocator>& v)
+      {
+	return v.empty() ? 0 : &v[0];
+      }
+
+      static size_t size(const std::vector<T, Allocator>& v)
+      {
+	return v.size() * sizeof(T);
+      }
+    };
+
+    //* vector<bool> is packed, so its elements aren't bytes to read,
+    //* and its object representation is only pointers
+    template <typename Allocator>
+    struct byte_view<std::vector<bool, Allocator> > {
+      BOOST_STATIC_ASSERT_MSG(sizeof(Allocator) == 0,
+			      "vector<bool> has no bytes to hash: "
+			      "specialize byte_view for it");
+    };
+
+  } // namespace bloom_filters
+} // namespace boost
+#endif
@@ -0,0 +1,72 @@
+//////////////////////////////////////////////////////////////////////////////
+//
+// (C) Copyright Alejandro Cabrera 2011.
+// Distributed under the Boost
+// Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or
+// copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// See http://www.boost.org/libs/bloom_filter for documentation.
+//
+//////////////////////////////////////////////////////////////////////////////
+
+#ifndef BOOST_BLOOM_FILTER_DOUBLE_HASHING_HPP
+#define BOOST_BLOOM_FILTER_DOUBLE_HASHING_HPP 1
+
+#include <cstddef>
+
+#include <boost/cstdint.hpp>
+#include <boost/static_assert.hpp>
+
+#include <boost/bloom_filter/detail/hash_engine.hpp>
+#include <boost/bloom_filter/hash/murmurhash3.hpp>
+
+namespace boost {
+  namespace bloom_filters {
+
+    /**
+     * A hashing engine: pass it instead of an mpl::vector of hash
+     * functions to basic_bloom_filter, dynamic_bloom_filter,
+     * counting_bloom_filter or dynamic_counting_bloom_filter.
+     *
+     * Each key is hashed once with WideHash, whose result is a pair of
+     * 64 bit halves (x, y). The HashValues hash values are derived
+     * with enhanced double hashing (Dillinger & Manolios):
+     *   h(i) = x + i * y + (i^3 - i) / 6
+     * The cubic term keeps the probes of two keys from coinciding just
+     * because their x and y coincide modulo the filter size, and the
+     * probes of one key from collapsing when y does.
+     */
+    template <typename T,
+	      size_t HashValues = 4,
+	      class WideHash = murmurhash3_128<T> >
+    struct enhanced_double_hashing {
+      // there has to be at least one probe per key
+      BOOST_STATIC_ASSERT(HashValues > 0);
+
+      typedef detail::hash_engine_tag engine_category;
+      typedef T value_type;
+      typedef WideHash wide_hash_type;
+
+      static const size_t num_hashes = HashValues;
+
+      //? writes the HashValues hash values of t to out
+      void operator()(const T& t, size_t *const out) {
+	const typename wide_hash_type::result_type wide = hasher(t);
+	boost::uint64_t x = wide.first;
+	boost::uint64_t y = wide.second;
+
+	out[0] = static_cast<size_t>(x);
+	for (size_t i = 1; i < HashValues; ++i) {
+	  x += y;
+	  y += i;
+	  out[i] = static_cast<size_t>(x);
+	}
+      }
+
+      wide_hash_type hasher;
+    };
+
+  } // namespace bloom_filters
+} // namespace boost
+#endif
@@ -0,0 +1,118 @@
+//////////////////////////////////////////////////////////////////////////////
+//
+// (C) Copyright Alejandro Cabrera 2011.
+// Distributed under the Boost
+// Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or
+// copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// See http://www.boost.org/libs/bloom_filter for documentation.
+//
+//////////////////////////////////////////////////////////////////////////////
+
+#ifndef BOOST_BLOOM_FILTER_FIXED_WIDTH_HASHING_HPP
+#define BOOST_BLOOM_FILTER_FIXED_WIDTH_HASHING_HPP 1
+
+#include <cstddef>
+#include <cstring>
+
+#include <boost/cstdint.hpp>
+#include <boost/static_assert.hpp>
+#include <boost/type_traits/is_pod.hpp>
+
+#include <boost/bloom_filter/detail/fixed_width_simd.hpp>
+#include <boost/bloom_filter/detail/hash_engine.hpp>
+
+namespace boost {
+  namespace bloom_filters {
+
+    /**
+     * A hashing engine for keys of 4, 8 or 16 bytes: 32 and 64 bit
+     * integers, 128 bit ids. Pass it instead of an mpl::vector of hash
+     * functions to basic_bloom_filter, dynamic_bloom_filter,
+     * counting_bloom_filter or dynamic_counting_bloom_filter.
+     *
+     * A key is one or two 64 bit words, with no length or tail to
+     * handle, so hashing it is a couple of murmurhash3 finalizers. The
+     * batch operations (insert_batch, probably_contains_batch) hash a
+     * group of keys at a time, 4 per AVX2 instruction stream or 8 per
+     * AVX-512 one where the host has them. Single key operations give
+     * the same hash values through the scalar code.
+     *
+     * The two halves (x, y) of the hash are expanded to HashValues
+     * values by enhanced double hashing, as in enhanced_double_hashing.
+     */
+    template <typename T,
+	      size_t HashValues = 4,
+	      size_t Seed = 0>
+    struct fixed_width_hashing {
+      BOOST_STATIC_ASSERT(HashValues > 0);
+      BOOST_STATIC_ASSERT(is_pod<T>::value);
+      BOOST_STATIC_ASSERT(sizeof(T) == 4 || sizeof(T) == 8 ||
+			  sizeof(T) == 16);
+
+      typedef detail::multi_key_engine_tag engine_category;
+      typedef T value_type;
+
+      static const size_t num_hashes = HashValues;
+
+      //? writes the HashValues hash values of t to out
+      void operator()(const T& t, size_t *const out) {
+	boost::uint64_t w[words] = {0};
+	const boost::uint64_t *const columns[2] = {&w[0], &w[words - 1]};
+	boost::uint64_t x, y;
+
+	std::memcpy(w, &t, sizeof(T));
+	detail::fixed_width_hash_scalar<words>(columns, 1, seed_x, seed_y,
+					       &x, &y);
+	expand(x, y, out);
+      }
+
+      //? writes the HashValues hash values of each of the n keys to
+      //? out, key after key
+      void operator()(const T *const keys, const size_t n,
+		      size_t *const out) {
+	static const detail::fixed_width_kernel kernel =
+	  detail::select_fixed_width_kernel<words>();
+	static const size_t chunk = 64;
+	boost::uint64_t w[words][chunk];
+	boost::uint64_t x[chunk], y[chunk];
+	const boost::uint64_t *const columns[2] = {w[0], w[words - 1]};
+
+	for (size_t done = 0; done < n; done += chunk) {
+	  const size_t m = n - done < chunk ? n - done : chunk;
+
+	  for (size_t i = 0; i < m; ++i) {
+	    boost::uint64_t key[words] = {0};
+	    std::memcpy(key, keys + done + i, sizeof(T));
+	    for (size_t j = 0; j < words; ++j)
+	      w[j][i] = key[j];
+	  }
+
+	  kernel(columns, m, seed_x, seed_y, x, y);
+
+	  for (size_t i = 0; i < m; ++i)
+	    expand(x[i], y[i], out + (done + i) * HashValues);
+	}
+      }
+
+    private:
+      static const size_t words = sizeof(T) > 8 ? 2 : 1;
+      static const boost::uint64_t seed_x = Seed + 0x9e3779b97f4a7c15ull;
+      static const boost::uint64_t seed_y = Seed + 0xc2b2ae3d27d4eb4full;
+
+      static void expand(boost::uint64_t x, boost::uint64_t y,
+			 size_t *const out)
+      {
+	out[0] = static_cast<size_t>(x);
+	for (size_t i = 1; i < HashValues; ++i) {
+	  x += y;
+	  y += i;
+	  out[i] = static_cast<size_t>(x);
+	}
+      }
+    };
+
+  } // namespace bloom_filters
+} // namespace boost
+#endif
@@ -42,18 +42,25 @@
  * murmurhash function based on the template parameters and whether
  * the compilation target is 64-bit or not.
  */
+#ifndef BOOST_BLOOM_FILTER_MURMURHASH3_HPP
+#define BOOST_BLOOM_FILTER_MURMURHASH3_HPP 1
+
+#include <utility>
+
 #include <boost/cstdint.hpp>
 
+#include <boost/bloom_filter/hash/byte_view.hpp>
+
 namespace boost {
   namespace bloom_filters {
 
     // forward declarations
     namespace detail {
-      void murmurhash3_x86_32 ( const void *const key, const size_t len,
+      inline void murmurhash3_x86_32 ( const void *const key, const size_t len,
 				const size_t seed, const void * out );
-      void murmurhash3_x86_128 ( const void *const key, const size_t len,
+      inline void murmurhash3_x86_128 ( const void *const key, const size_t len,
 				 const size_t seed, const void * out );
-      void murmurhash3_x64_128 ( const void *const key, const size_t len,
+      inline void murmurhash3_x64_128 ( const void *const key, const size_t len,
 				 const size_t seed, const void * out );
       template <bool, bool> 
       struct murmurhash3_dispatch;
@@ -63,6 +70,9 @@ namespace boost {
       };
     }
 
+    //! Hashes the bytes byte_view<T> exposes: the contents of strings,
+    //! string views and vectors of PODs, the object representation of
+    //! anything else.
     template <typename T, size_t Seed = 0, bool Use128Mode = true>
     struct murmurhash3 {
       typedef detail::murmurhash3_dispatch<detail::Is64Bit::value,
@@ -71,12 +81,28 @@ namespace boost {
 	static dispatch_type dispatcher;
 	size_t out[2] = {0,0};
 
-	dispatcher(&t, sizeof(T), Seed, &out);
+	dispatcher(byte_view<T>::data(t), byte_view<T>::size(t), Seed, &out);
 	
 	return out[0];
       }
     };
 
+    //! The whole 128 bit x64 digest of t as two 64 bit halves, for
+    //! hashing engines that derive several hash values from one hash.
+    template <typename T, size_t Seed = 0>
+    struct murmurhash3_128 {
+      typedef std::pair<boost::uint64_t, boost::uint64_t> result_type;
+
+      result_type operator()(const T& t) {
+	boost::uint64_t out[2] = {0, 0};
+
+	detail::murmurhash3_x64_128(byte_view<T>::data(t),
+				    byte_view<T>::size(t), Seed, out);
+
+	return result_type(out[0], out[1]);
+      }
+    };
+
     namespace detail {
 
       template <bool _64Bit = true, bool Use128Mode = true>
@@ -125,12 +151,12 @@ namespace boost {
       // Block read - if your platform needs to do endian-swapping or can only
       // handle aligned reads, do the conversion here
       
-      uint32_t getblock(const uint32_t *const p, const size_t i)
+      inline uint32_t getblock(const uint32_t *const p, const size_t i)
       {
 	return p[i];
       }
       
-      uint64_t getblock(const uint64_t *const p, const size_t i)
+      inline uint64_t getblock(const uint64_t *const p, const size_t i)
       {
 	return p[i];
       }
@@ -138,7 +164,7 @@ namespace boost {
       //-----------------------------------------------------------------------------
       // Finalization mix - force all bits of a hash block to avalanche
       
-      uint32_t fmix(const uint32_t val)
+      inline uint32_t fmix(const uint32_t val)
       {
 	uint32_t h = val;
 
@@ -153,7 +179,7 @@ namespace boost {
 
       //----------
       
-      uint64_t fmix(const uint64_t val)
+      inline uint64_t fmix(const uint64_t val)
       {
 	uint64_t k = val;
 
@@ -168,7 +194,7 @@ namespace boost {
 
       //-----------------------------------------------------------------------------
 
-      void murmurhash3_x86_32 ( const void *const key, const size_t len,
+      inline void murmurhash3_x86_32 ( const void *const key, const size_t len,
 				const size_t seed, const void * out )
       {
 	const uint8_t *const data = static_cast<const uint8_t*>(key);
@@ -224,7 +250,7 @@ namespace boost {
 
       //-----------------------------------------------------------------------------
 
-      void murmurhash3_x86_128(const void *const key, const size_t len,
+      inline void murmurhash3_x86_128(const void *const key, const size_t len,
 				 const size_t seed, const void *out )
       {
 	const uint8_t *const data = static_cast<const uint8_t*>(key);
@@ -329,7 +355,7 @@ namespace boost {
 
       //-----------------------------------------------------------------------------
 
-      void murmurhash3_x64_128(const void *const __restrict__ key, const size_t len,
+      inline void murmurhash3_x64_128(const void *const __restrict__ key, const size_t len,
 			       const size_t seed, const void *__restrict__ out )
       {
 	const uint8_t *const __restrict__ data = static_cast<const uint8_t*>(key);
@@ -410,3 +436,4 @@ namespace boost {
     }// detail
   }// hash
 }// boost
+#endif
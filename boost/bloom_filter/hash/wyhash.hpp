@@ -0,0 +1,201 @@
+//////////////////////////////////////////////////////////////////////////////
+//
+// (C) Copyright Alejandro Cabrera 2011.
+// Distributed under the Boost
+// Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or
+// copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// See http://www.boost.org/libs/bloom_filter for documentation.
+//
+//////////////////////////////////////////////////////////////////////////////
+
+// wyhash was written by Wang Yi and is released into the public domain.
+// This is the "final 4" version of the algorithm.
+
+/**
+ * wyhash is a non-cryptographic 64 bit hash built on one operation,
+ * the 64x64 -> 128 bit multiplication folded back to 64 bits. Keys of
+ * up to 16 bytes are read with a few overlapping loads and mixed once,
+ * with no loop and no branch per byte. Longer keys are consumed 48
+ * bytes per iteration by three independent lanes. On the short keys
+ * a Bloom filter usually sees it is several times faster than
+ * murmurhash3_x64_128.
+ *
+ * Blocks are read in native byte order, so like murmurhash3 the
+ * values differ between little and big endian targets.
+ *
+ * Hashers:
+ * - wyhash<T, Seed=0>: a drop-in for murmurhash3<T, Seed>
+ * - wyhash_128<T, Seed=0>: two 64 bit halves, for
+ *   enhanced_double_hashing
+ * Both hash the bytes byte_view<T> exposes.
+ */
+#ifndef BOOST_BLOOM_FILTER_WYHASH_HPP
+#define BOOST_BLOOM_FILTER_WYHASH_HPP 1
+
+#include <cstddef>
+#include <cstring>
+#include <utility>
+
+#include <boost/config.hpp>
+#include <boost/cstdint.hpp>
+
+#include <boost/bloom_filter/hash/byte_view.hpp>
+
+namespace boost {
+  namespace bloom_filters {
+    namespace detail {
+
+      struct wyhash_secret {
+	static const boost::uint64_t s0 = 0xa0761d6478bd642full;
+	static const boost::uint64_t s1 = 0xe7037ed1a0b428dbull;
+	static const boost::uint64_t s2 = 0x8ebc6af09c88c6e3ull;
+	static const boost::uint64_t s3 = 0x589965cc75374cc3ull;
+      };
+
+      //? a * b as 128 bits; the low half goes to a, the high half to b
+      inline void wymum(boost::uint64_t& a, boost::uint64_t& b)
+      {
+#if defined(BOOST_HAS_INT128)
+	const boost::uint128_type r =
+	  static_cast<boost::uint128_type>(a) * b;
+	a = static_cast<boost::uint64_t>(r);
+	b = static_cast<boost::uint64_t>(r >> 64);
+#else
+	const boost::uint64_t a_hi = a >> 32, a_lo = a & 0xffffffffull;
+	const boost::uint64_t b_hi = b >> 32, b_lo = b & 0xffffffffull;
+	const boost::uint64_t hh = a_hi * b_hi, hl = a_hi * b_lo;
+	const boost::uint64_t lh = a_lo * b_hi, ll = a_lo * b_lo;
+	const boost::uint64_t t = ll + (hl << 32);
+	const boost::uint64_t lo = t + (lh << 32);
+	const boost::uint64_t carry = (t < ll) + (lo < t);
+	a = lo;
+	b = hh + (hl >> 32) + (lh >> 32) + carry;
+#endif
+      }
+
+      inline boost::uint64_t wymix(boost::uint64_t a, boost::uint64_t b)
+      {
+	wymum(a, b);
+	return a ^ b;
+      }
+
+      inline boost::uint64_t wyr8(const boost::uint8_t *const p)
+      {
+	boost::uint64_t v;
+	std::memcpy(&v, p, 8);
+	return v;
+      }
+
+      inline boost::uint64_t wyr4(const boost::uint8_t *const p)
+      {
+	boost::uint32_t v;
+	std::memcpy(&v, p, 4);
+	return v;
+      }
+
+      //? 1 to 3 bytes: the first, the middle and the last
+      inline boost::uint64_t wyr3(const boost::uint8_t *const p,
+				  const size_t k)
+      {
+	return (static_cast<boost::uint64_t>(p[0]) << 16) |
+	  (static_cast<boost::uint64_t>(p[k >> 1]) << 8) | p[k - 1];
+      }
+
+      //? consumes the key and leaves the two words of the final mix in
+      //? a and b; the hash is wymix(a ^ s0 ^ len, b ^ s1)
+      inline void wyhash_state(const void *const key, const size_t len,
+			       boost::uint64_t seed,
+			       boost::uint64_t& a, boost::uint64_t& b)
+      {
+	typedef wyhash_secret s;
+	const boost::uint8_t *p = static_cast<const boost::uint8_t *>(key);
+
+	seed ^= wymix(seed ^ s::s0, s::s1);
+
+	if (len <= 16) {
+	  if (len >= 4) {
+	    const size_t mid = (len >> 3) << 2;
+	    a = (wyr4(p) << 32) | wyr4(p + mid);
+	    b = (wyr4(p + len - 4) << 32) | wyr4(p + len - 4 - mid);
+	  }
+	  else if (len > 0) {
+	    a = wyr3(p, len);
+	    b = 0;
+	  }
+	  else
+	    a = b = 0;
+	}
+	else {
+	  size_t i = len;
+
+	  if (i > 48) {
+	    boost::uint64_t see1 = seed, see2 = seed;
+	    do {
+	      seed = wymix(wyr8(p) ^ s::s1, wyr8(p + 8) ^ seed);
+	      see1 = wymix(wyr8(p + 16) ^ s::s2, wyr8(p + 24) ^ see1);
+	      see2 = wymix(wyr8(p + 32) ^ s::s3, wyr8(p + 40) ^ see2);
+	      p += 48;
+	      i -= 48;
+	    } while (i > 48);
+	    seed ^= see1 ^ see2;
+	  }
+
+	  while (i > 16) {
+	    seed = wymix(wyr8(p) ^ s::s1, wyr8(p + 8) ^ seed);
+	    i -= 16;
+	    p += 16;
+	  }
+
+	  a = wyr8(p + i - 16);
+	  b = wyr8(p + i - 8);
+	}
+
+	a ^= s::s1;
+	b ^= seed;
+	wymum(a, b);
+      }
+
+      inline boost::uint64_t wyhash64(const void *const key,
+				      const size_t len,
+				      const boost::uint64_t seed)
+      {
+	boost::uint64_t a, b;
+	wyhash_state(key, len, seed, a, b);
+	return wymix(a ^ wyhash_secret::s0 ^ len, b ^ wyhash_secret::s1);
+      }
+
+    } // namespace detail
+
+    template <typename T, size_t Seed = 0>
+    struct wyhash {
+      size_t operator()(const T& t) {
+	return static_cast<size_t>(
+	  detail::wyhash64(byte_view<T>::data(t), byte_view<T>::size(t),
+			   Seed));
+      }
+    };
+
+    //! The first half is wyhash<T, Seed>. The second runs the final mix
+    //! of the same state again with the other two secrets, so a wide
+    //! hash costs one extra multiplication rather than a second pass.
+    template <typename T, size_t Seed = 0>
+    struct wyhash_128 {
+      typedef std::pair<boost::uint64_t, boost::uint64_t> result_type;
+
+      result_type operator()(const T& t) {
+	typedef detail::wyhash_secret s;
+	const size_t len = byte_view<T>::size(t);
+	boost::uint64_t a, b;
+
+	detail::wyhash_state(byte_view<T>::data(t), len, Seed, a, b);
+
+	return result_type(detail::wymix(a ^ s::s0 ^ len, b ^ s::s1),
+			   detail::wymix(a ^ s::s2 ^ len, b ^ s::s3));
+      }
+    };
+
+  } // namespace bloom_filters
+} // namespace boost
+#endif
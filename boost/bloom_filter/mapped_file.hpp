@@ -0,0 +1,69 @@
+//////////////////////////////////////////////////////////////////////////////
+//
+// (C) Copyright Alejandro Cabrera 2011.
+// Distributed under the Boost
+// Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or
+// copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// See http://www.boost.org/libs/bloom_filter for documentation.
+//
+//////////////////////////////////////////////////////////////////////////////
+
+#ifndef BOOST_BLOOM_FILTER_MAPPED_FILE_HPP
+#define BOOST_BLOOM_FILTER_MAPPED_FILE_HPP 1
+
+#include <boost/bloom_filter/detail/dynamic_storage.hpp>
+#include <boost/bloom_filter/detail/mapped_blocks.hpp>
+
+namespace boost {
+  namespace bloom_filters {
+
+    /**
+     * Given as the Allocator of a dynamic_bloom_filter or a
+     * dynamic_counting_bloom_filter, keeps the filter's blocks in a
+     * memory-mapped file:
+     *
+     *   typedef dynamic_bloom_filter<T, HashFunctions, size_t,
+     *                                mapped_file> mapped_bloom;
+     *
+     *   // creates the file, all bits clear
+     *   mapped_bloom writer(mapped_file_params("keys.bloom"), bits);
+     *   writer.insert(key);
+     *   writer.flush();
+     *
+     *   // maps it again at the size it was created with
+     *   mapped_bloom reader(mapped_file_params("keys.bloom",
+     *                                          mapped_read_only));
+     *
+     * Opening maps the file without reading it. Pages are read in as
+     * probes touch them, and processes that map the same file share
+     * them through the page cache. The file is laid out as save() in
+     * serialization.hpp writes a filter: a 64 byte header, then the
+     * blocks. Opening throws mapped_file_exception if the filter type
+     * or its Block type does not match the header, and on big-endian
+     * machines, where the blocks in a file aren't those in memory.
+     *
+     * Writes to a read-write mapping reach the file when the kernel
+     * writes the pages back, or when flush() asks for it. A filter
+     * built with a size and no file, and every copy of a mapped filter,
+     * uses anonymous memory.
+     */
+    struct mapped_file {};
+
+    namespace detail {
+
+      template <typename Block>
+      struct dynamic_bits<Block, mapped_file> {
+	typedef mapped_bitset<Block> type;
+      };
+
+      template <typename Block>
+      struct dynamic_buckets<Block, mapped_file> {
+	typedef mapped_blocks<Block> type;
+      };
+
+    } // namespace detail
+  } // namespace bloom_filters
+} // namespace boost
+#endif
@@ -0,0 +1,204 @@
+//////////////////////////////////////////////////////////////////////////////
+//
+// (C) Copyright Alejandro Cabrera 2011.
+// Distributed under the Boost
+// Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or
+// copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// See http://www.boost.org/libs/bloom_filter for documentation.
+//
+//////////////////////////////////////////////////////////////////////////////
+
+#ifndef BOOST_BLOOM_FILTER_OPTIMAL_PARAMETERS_HPP
+#define BOOST_BLOOM_FILTER_OPTIMAL_PARAMETERS_HPP 1
+
+#include <cstddef>
+
+#include <boost/cstdint.hpp>
+#include <boost/ratio.hpp>
+#include <boost/static_assert.hpp>
+
+#include <boost/bloom_filter/basic_bloom_filter.hpp>
+#include <boost/bloom_filter/counting_bloom_filter.hpp>
+#include <boost/bloom_filter/hash/double_hashing.hpp>
+#include <boost/bloom_filter/storage.hpp>
+
+namespace boost {
+  namespace bloom_filters {
+
+    //! A false positive rate in parts per million: ppm<100> is 0.0001.
+    //! Any boost::ratio is accepted where a rate is expected.
+    template <boost::intmax_t PartsPerMillion>
+    struct ppm : boost::ratio<PartsPerMillion, 1000000> {};
+
+    namespace detail {
+
+      // Everything below is integer arithmetic on 64 bit constants, so
+      // the sizing works without constexpr. Logarithms are fixed point
+      // with log2_fraction_bits fractional bits.
+      static const size_t log2_fraction_bits = 28;
+      static const size_t log2_mantissa_bits = 30;
+
+      // largest e with Num * 2^e <= Den
+      template <boost::uint64_t Num, boost::uint64_t Den,
+		bool Done = (Num * 2 > Den)>
+      struct floor_log2_ratio {
+	static const boost::uint64_t value =
+	  1 + floor_log2_ratio<Num * 2, Den>::value;
+      };
+
+      template <boost::uint64_t Num, boost::uint64_t Den>
+      struct floor_log2_ratio<Num, Den, true> {
+	static const boost::uint64_t value = 0;
+      };
+
+      // the first Bits fractional bits of log2(z), z in [1, 2) with
+      // log2_mantissa_bits fractional bits: squaring z doubles its
+      // logarithm, which shifts the next bit into the integer part
+      template <boost::uint64_t Z, size_t Bits>
+      struct log2_fraction {
+	static const boost::uint64_t square = (Z * Z) >> log2_mantissa_bits;
+	static const bool high = square >= (2ull << log2_mantissa_bits);
+	static const boost::uint64_t value =
+	  (static_cast<boost::uint64_t>(high) << (Bits - 1)) |
+	  log2_fraction<(high ? square >> 1 : square), Bits - 1>::value;
+      };
+
+      template <boost::uint64_t Z>
+      struct log2_fraction<Z, 0> {
+	static const boost::uint64_t value = 0;
+      };
+
+      // log2(1 / Rate) with log2_fraction_bits fractional bits
+      template <class Rate>
+      struct log2_inverse_rate {
+	static const boost::uint64_t num = Rate::num;
+	static const boost::uint64_t den = Rate::den;
+
+	// the rate has to be a probability strictly between 0 and 1, and
+	// den shifted by log2_mantissa_bits has to fit in 64 bits
+	BOOST_STATIC_ASSERT(Rate::num > 0 && Rate::num < Rate::den);
+	BOOST_STATIC_ASSERT(Rate::den < (1ll << 32));
+
+	static const boost::uint64_t exponent =
+	  floor_log2_ratio<num, den>::value;
+	static const boost::uint64_t mantissa =
+	  (den << log2_mantissa_bits) / (num << exponent);
+
+	static const boost::uint64_t value =
+	  (exponent << log2_fraction_bits) |
+	  log2_fraction<mantissa, log2_fraction_bits>::value;
+      };
+
+    } // namespace detail
+
+    /**
+     * The optimal shape of a Bloom filter that holds ExpectedInsertions
+     * elements with a false positive rate of at most Rate, a
+     * boost::ratio such as ppm<100>:
+     *   bits           = ceil(-n * ln(p) / ln(2)^2)
+     *   hash_functions = round(-log2(p)), at least 1
+     * Computed with integer arithmetic at compile time; bits is within
+     * one part in a billion of the exact formula.
+     */
+    template <size_t ExpectedInsertions, class Rate>
+    struct optimal_parameters {
+      BOOST_STATIC_ASSERT(ExpectedInsertions > 0);
+
+    private:
+      static const size_t one = static_cast<size_t>(1);
+      static const boost::uint64_t log2_rate =
+	detail::log2_inverse_rate<Rate>::value;
+
+      // 1 / ln(2) = 1.442695040..., split so the product fits
+      static const boost::uint64_t bits_per_element =
+	log2_rate + log2_rate * 442695041ull / 1000000000ull;
+      static const boost::uint64_t fraction_mask =
+	(one << detail::log2_fraction_bits) - 1;
+
+      static const boost::uint64_t rounded_hashes =
+	(log2_rate + (one << (detail::log2_fraction_bits - 1))) >>
+	detail::log2_fraction_bits;
+
+      // n times the fractional part of bits_per_element must fit
+      BOOST_STATIC_ASSERT(ExpectedInsertions <=
+			  (~0ull >> detail::log2_fraction_bits));
+
+    public:
+      static const size_t expected_insertions = ExpectedInsertions;
+      static const size_t bits = static_cast<size_t>(
+	ExpectedInsertions *
+	  (bits_per_element >> detail::log2_fraction_bits) +
+	((ExpectedInsertions * (bits_per_element & fraction_mask) +
+	  fraction_mask) >> detail::log2_fraction_bits));
+      static const size_t hash_functions =
+	rounded_hashes > 0 ? static_cast<size_t>(rounded_hashes) : 1;
+    };
+
+    template <size_t ExpectedInsertions, class Rate>
+    const size_t
+    optimal_parameters<ExpectedInsertions, Rate>::expected_insertions;
+
+    template <size_t ExpectedInsertions, class Rate>
+    const size_t optimal_parameters<ExpectedInsertions, Rate>::bits;
+
+    template <size_t ExpectedInsertions, class Rate>
+    const size_t optimal_parameters<ExpectedInsertions, Rate>::hash_functions;
+
+    /**
+     * A basic_bloom_filter sized by optimal_parameters. Its keys are
+     * hashed once by enhanced_double_hashing and expanded to the
+     * optimal number of probes, which, like the size, is a constant
+     * the compiler can unroll the probe loops over.
+     *
+     *   optimal_bloom_filter<std::string, 1000000, ppm<100> >::type
+     *
+     * With the default inline_storage the bits live inside the filter
+     * object, so large filters should not be put on the stack; pass
+     * heap_storage<> as Storage for those.
+     */
+    template <typename T,
+	      size_t ExpectedInsertions,
+	      class Rate,
+	      class WideHash = murmurhash3_128<T>,
+	      class Storage = inline_storage>
+    struct optimal_bloom_filter {
+      typedef optimal_parameters<ExpectedInsertions, Rate> parameters;
+      typedef basic_bloom_filter<T,
+				 parameters::bits,
+				 enhanced_double_hashing<T,
+					    parameters::hash_functions,
+					    WideHash>,
+				 typename default_reduction<
+				   parameters::bits>::type,
+				 Storage> type;
+    };
+
+    /**
+     * A counting_bloom_filter sized by optimal_parameters: one bin
+     * per bit of the equivalent basic filter, BitsPerBin bits each.
+     */
+    template <typename T,
+	      size_t ExpectedInsertions,
+	      class Rate,
+	      size_t BitsPerBin = 4,
+	      class WideHash = murmurhash3_128<T>,
+	      class Storage = inline_storage>
+    struct optimal_counting_bloom_filter {
+      typedef optimal_parameters<ExpectedInsertions, Rate> parameters;
+      typedef counting_bloom_filter<T,
+				    parameters::bits,
+				    BitsPerBin,
+				    enhanced_double_hashing<T,
+					       parameters::hash_functions,
+					       WideHash>,
+				    size_t,
+				    typename default_reduction<
+				      parameters::bits>::type,
+				    Storage> type;
+    };
+
+  } // namespace bloom_filters
+} // namespace boost
+#endif
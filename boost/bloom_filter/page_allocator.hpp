@@ -0,0 +1,139 @@
+//////////////////////////////////////////////////////////////////////////////
+//
+// (C) Copyright Alejandro Cabrera 2011.
+// Distributed under the Boost
+// Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or
+// copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// See http://www.boost.org/libs/bloom_filter for documentation.
+//
+//////////////////////////////////////////////////////////////////////////////
+
+#ifndef BOOST_BLOOM_FILTER_PAGE_ALLOCATOR_HPP
+#define BOOST_BLOOM_FILTER_PAGE_ALLOCATOR_HPP 1
+
+#include <cstddef>
+#include <new>
+
+#include <boost/config.hpp>
+#include <boost/static_assert.hpp>
+#include <boost/type_traits/alignment_of.hpp>
+
+#include <boost/bloom_filter/detail/page_memory.hpp>
+
+namespace boost {
+  namespace bloom_filters {
+
+    /**
+     * An allocator that controls where the bits of a large filter
+     * land in memory. Pass it as the Allocator of dynamic_bloom_filter,
+     * dynamic_counting_bloom_filter, the twohash dynamic filters or
+     * blocked_bloom_filter, or to allocated_storage for a fixed size
+     * filter:
+     *
+     *   dynamic_bloom_filter<T, HashFunctions, size_t,
+     *                        page_allocator<size_t> > bloom(bits);
+     *
+     * Every allocation is aligned to Alignment bytes; the default is a
+     * cache line. Allocations of 2 MiB or more are mapped straight
+     * from the operating system and aligned to at least 2 MiB. Placement
+     * then chooses the page size behind them, or-ing together
+     * transparent_huge_pages, explicit_huge_pages, no_huge_pages and
+     * prefault_pages. With huge pages, random probes across a
+     * multi-gigabyte filter need 512 times fewer TLB entries.
+     *
+     * prefault_pages faults the whole allocation in before the filter
+     * is built on it, one huge page at a time where possible. Clearing
+     * a new filter writes every page anyway, so this mostly moves the
+     * page faults into a single batch.
+     *
+     * Where mmap is not available the allocator only aligns.
+     */
+    template <typename T,
+	      size_t Alignment = 64,
+	      unsigned Placement = transparent_huge_pages>
+    class page_allocator {
+      // Alignment has to be a power of two, and enough for T
+      BOOST_STATIC_ASSERT( (Alignment & (Alignment - 1)) == 0);
+      BOOST_STATIC_ASSERT( Alignment >= boost::alignment_of<T>::value);
+
+    public:
+      typedef T value_type;
+      typedef T *pointer;
+      typedef const T *const_pointer;
+      typedef T &reference;
+      typedef const T &const_reference;
+      typedef size_t size_type;
+      typedef std::ptrdiff_t difference_type;
+
+      template <typename U>
+      struct rebind {
+	typedef page_allocator<U, Alignment, Placement> other;
+      };
+
+      static const size_t alignment = Alignment;
+      static const unsigned placement = Placement;
+
+      page_allocator() BOOST_NOEXCEPT {}
+
+      template <typename U>
+      page_allocator(const page_allocator<U, Alignment, Placement>&)
+	BOOST_NOEXCEPT {}
+
+      pointer address(reference x) const { return &x; }
+      const_pointer address(const_reference x) const { return &x; }
+
+      pointer allocate(const size_type n, const void * = 0)
+      {
+	if (n > this->max_size())
+	  throw std::bad_alloc();
+
+	return static_cast<pointer>(
+	  detail::allocate_pages(n * sizeof(T), Alignment, Placement));
+      }
+
+      void deallocate(const pointer p, const size_type n)
+      {
+	detail::deallocate_pages(p, n * sizeof(T));
+      }
+
+      size_type max_size() const BOOST_NOEXCEPT
+      {
+	return static_cast<size_type>(-1) / sizeof(T);
+      }
+
+      void construct(const pointer p, const_reference value)
+      {
+	::new (static_cast<void *>(p)) T(value);
+      }
+
+      void destroy(const pointer p)
+      {
+	p->~T();
+      }
+    };
+
+    template <typename T, size_t Alignment, unsigned Placement>
+    const size_t page_allocator<T, Alignment, Placement>::alignment;
+
+    template <typename T, size_t Alignment, unsigned Placement>
+    const unsigned page_allocator<T, Alignment, Placement>::placement;
+
+    template <typename T, typename U, size_t Alignment, unsigned Placement>
+    bool operator==(const page_allocator<T, Alignment, Placement>&,
+		    const page_allocator<U, Alignment, Placement>&)
+    {
+      return true;
+    }
+
+    template <typename T, typename U, size_t Alignment, unsigned Placement>
+    bool operator!=(const page_allocator<T, Alignment, Placement>&,
+		    const page_allocator<U, Alignment, Placement>&)
+    {
+      return false;
+    }
+
+  } // namespace bloom_filters
+} // namespace boost
+#endif
@@ -0,0 +1,268 @@
+//////////////////////////////////////////////////////////////////////////////
+//
+// (C) Copyright Alejandro Cabrera 2011.
+// Distributed under the Boost
+// Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or
+// copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// See http://www.boost.org/libs/bloom_filter for documentation.
+//
+//////////////////////////////////////////////////////////////////////////////
+
+#ifndef BOOST_BLOOM_FILTER_PARALLEL_BUILD_HPP
+#define BOOST_BLOOM_FILTER_PARALLEL_BUILD_HPP 1
+
+#include <algorithm>
+#include <iterator>
+#include <vector>
+
+#include <boost/exception_ptr.hpp>
+#include <boost/thread/barrier.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/locks.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
+
+#include <boost/bloom_filter/detail/population.hpp>
+#include <boost/bloom_filter/serialization.hpp>
+
+/**
+ * Inserting a large range of keys into one of the bit filters --
+ * basic_bloom_filter, dynamic_bloom_filter and their twohash
+ * counterparts -- with a pool of threads.
+ *
+ * The filter's bits are split into one contiguous part per thread,
+ * each a whole number of cache lines, and only the thread that owns a
+ * part ever writes to it. The keys are taken a round at a time: every
+ * thread hashes its share of the round and sorts the bit positions by
+ * the part they fall in, then, once all have, sets the positions of
+ * its own part that every thread found. No bit is written by two
+ * threads and no atomics are needed, so the pool scales with the
+ * number of cores for as long as memory bandwidth lasts, with no extra
+ * copies of the filter. The bits set are those insert() would set.
+ *
+ * Needs Boost.Thread. The filter must not be used by other threads
+ * until parallel_insert() returns. If hashing a key throws, the first
+ * exception is rethrown once every thread has stopped, with the keys
+ * of the earlier rounds inserted. If not all the threads can be
+ * started, the keys are inserted by the calling thread alone.
+ */
+namespace boost {
+  namespace bloom_filters {
+    namespace detail {
+
+      // bits of a part are a multiple of this: a cache line, and so a
+      // whole number of blocks of any filter
+      static const size_t part_alignment = 512;
+
+      //! the shared state of one parallel_insert()
+      template <typename Filter, typename RandomAccessIterator>
+      class parallel_inserter {
+      public:
+	parallel_inserter(const Filter& filter,
+			  const RandomAccessIterator start,
+			  const RandomAccessIterator end,
+			  const size_t num_threads)
+	  : start(start),
+	    num_keys(static_cast<size_t>(std::distance(start, end))),
+	    num_threads(num_threads),
+	    num_hashes(filter.num_hash_functions()),
+	    bit_capacity(filter.bit_capacity()),
+	    part_bits(part_size(filter.bit_capacity(), num_threads)),
+	    found(num_threads * num_threads),
+	    sync(static_cast<unsigned>(num_threads)),
+	    state(starting)
+	{
+	  for (size_t i = 0; i < this->found.size(); ++i)
+	    this->found[i].reserve(round_keys * this->num_hashes /
+				   num_threads + 64);
+	}
+
+	//? called by filter_access with the filter's blocks
+	template <typename Bits>
+	void operator()(Bits& bits)
+	{
+	  // the workers wait for all of them to exist: each round's
+	  // barrier needs every one
+	  boost::thread_group threads;
+	  try {
+	    for (size_t t = 0; t < this->num_threads; ++t)
+	      threads.create_thread(worker<Bits>(*this, bits, t));
+	  }
+	  catch (...) {
+	    this->release(abandoned);
+	    threads.join_all();
+	    this->insert_serially(bits);
+	    return;
+	  }
+
+	  this->release(running);
+	  threads.join_all();
+	  if (this->error)
+	    boost::rethrow_exception(this->error);
+	}
+
+      private:
+	enum start_state { starting, running, abandoned };
+	// keys each thread hashes in a round
+	static const size_t round_keys = 1 << 14;
+
+	static size_t part_size(const size_t bits, const size_t parts)
+	{
+	  const size_t even = (bits + parts - 1) / parts;
+	  return std::max<size_t>(
+	    (even + part_alignment - 1) / part_alignment * part_alignment,
+	    part_alignment);
+	}
+
+	// positions found by thread from in part
+	std::vector<size_t>& positions(const size_t from, const size_t part)
+	{
+	  return this->found[from * this->num_threads + part];
+	}
+
+	void release(const start_state how)
+	{
+	  {
+	    boost::lock_guard<boost::mutex> lock(this->guard);
+	    this->state = how;
+	  }
+	  this->started.notify_all();
+	}
+
+	//? waits for release(); whether to run
+	bool wait_to_run()
+	{
+	  boost::unique_lock<boost::mutex> lock(this->guard);
+	  while (this->state == starting)
+	    this->started.wait(lock);
+	  return this->state == running;
+	}
+
+	//? keeps the first exception a worker caught
+	void fail(const boost::exception_ptr& caught)
+	{
+	  boost::lock_guard<boost::mutex> lock(this->guard);
+	  if (!this->error)
+	    this->error = caught;
+	}
+
+	bool failed()
+	{
+	  boost::lock_guard<boost::mutex> lock(this->guard);
+	  return this->error ? true : false;
+	}
+
+	template <typename Bits>
+	void insert_serially(Bits& bits) const
+	{
+	  for (size_t i = 0; i < this->num_keys; ++i) {
+	    const typename Filter::digest_type digest =
+	      Filter::hash_key(*(this->start + i));
+	    for (size_t j = 0; j < this->num_hashes; ++j)
+	      set_bit(bits, Filter::reduction_type::reduce(digest.values[j],
+							    this->bit_capacity));
+	  }
+	}
+
+	template <typename Bits>
+	struct worker {
+	  worker(parallel_inserter& shared, Bits& bits, const size_t thread)
+	    : shared(&shared), bits(&bits), thread(thread) {}
+
+	  void operator()() const
+	  {
+	    parallel_inserter& s = *this->shared;
+	    const size_t per_round = round_keys * s.num_threads;
+	    if (!s.wait_to_run())
+	      return;
+
+	    for (size_t round = 0; round < s.num_keys; round += per_round) {
+	      const size_t first = std::min(s.num_keys,
+					    round + this->thread * round_keys);
+	      const size_t last = std::min(s.num_keys, first + round_keys);
+
+	      try {
+		for (size_t i = first; i < last; ++i) {
+		  const typename Filter::digest_type digest =
+		    Filter::hash_key(*(s.start + i));
+		  for (size_t j = 0; j < s.num_hashes; ++j) {
+		    const size_t pos = Filter::reduction_type::reduce(
+		      digest.values[j], s.bit_capacity);
+		    s.positions(this->thread, pos / s.part_bits).push_back(pos);
+		  }
+		}
+	      }
+	      catch (...) {
+		s.fail(boost::current_exception());
+	      }
+
+	      // every thread sees the same failures past the barrier, so
+	      // they all leave together
+	      s.sync.wait();
+	      if (s.failed())
+		return;
+
+	      for (size_t from = 0; from < s.num_threads; ++from) {
+		std::vector<size_t>& mine = s.positions(from, this->thread);
+		for (size_t i = 0; i < mine.size(); ++i)
+		  set_bit(*this->bits, mine[i]);
+		mine.clear();
+	      }
+	      s.sync.wait();
+	    }
+	  }
+
+	  parallel_inserter *shared;
+	  Bits *bits;
+	  size_t thread;
+	};
+
+	const RandomAccessIterator start;
+	const size_t num_keys;
+	const size_t num_threads;
+	const size_t num_hashes;
+	const size_t bit_capacity;
+	const size_t part_bits;
+	std::vector<std::vector<size_t> > found;
+	boost::barrier sync;
+	boost::mutex guard;
+	boost::condition_variable started;
+	start_state state;
+	boost::exception_ptr error;
+      };
+
+    } // namespace detail
+
+    //? inserts every key in [start, end) into filter with num_threads
+    //? threads; the same bits as filter.insert(start, end)
+    template <typename Filter, typename RandomAccessIterator>
+    void parallel_insert(Filter& filter,
+			 const RandomAccessIterator start,
+			 const RandomAccessIterator end,
+			 const size_t num_threads)
+    {
+      if (num_threads <= 1 || filter.bit_capacity() == 0) {
+	filter.insert(start, end);
+	return;
+      }
+
+      detail::parallel_inserter<Filter, RandomAccessIterator>
+	inserter(filter, start, end, num_threads);
+      detail::filter_access::update_blocks(filter, inserter);
+    }
+
+    //? with a thread per hardware thread
+    template <typename Filter, typename RandomAccessIterator>
+    void parallel_insert(Filter& filter,
+			 const RandomAccessIterator start,
+			 const RandomAccessIterator end)
+    {
+      parallel_insert(filter, start, end,
+		      std::max<size_t>(boost::thread::hardware_concurrency(),
+				       1));
+    }
+  } // namespace bloom_filters
+} // namespace boost
+#endif
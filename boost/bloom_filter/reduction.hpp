@@ -0,0 +1,140 @@
+//////////////////////////////////////////////////////////////////////////////
+//
+// (C) Copyright Alejandro Cabrera 2011.
+// Distributed under the Boost
+// Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or
+// copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// See http://www.boost.org/libs/bloom_filter for documentation.
+//
+//////////////////////////////////////////////////////////////////////////////
+
+#ifndef BOOST_BLOOM_FILTER_REDUCTION_HPP
+#define BOOST_BLOOM_FILTER_REDUCTION_HPP 1
+
+#include <cstddef>
+
+#include <boost/assert.hpp>
+#include <boost/config.hpp>
+#include <boost/cstdint.hpp>
+#include <boost/mpl/bool.hpp>
+#include <boost/mpl/if.hpp>
+
+#include <boost/bloom_filter/detail/exceptions.hpp>
+
+/**
+ * Reduction policies map a hash value onto [0, range), the index of a
+ * bit or bin. Every probe of every operation goes through one, so
+ * they are the hottest line of the library.
+ *
+ * A reduction policy is a class with the static member function
+ *   size_t reduce(size_t hash, size_t range);
+ */
+namespace boost {
+  namespace bloom_filters {
+
+    //! hash % range. Works for any range, but costs an integer
+    //! division per probe. This is what every filter used originally.
+    struct modulo_reduction {
+      static size_t reduce(const size_t hash, const size_t range)
+      {
+	return hash % range;
+      }
+    };
+
+    //! hash & (range - 1). range must be a power of two.
+    struct mask_reduction {
+      static size_t reduce(const size_t hash, const size_t range)
+      {
+	BOOST_ASSERT(range != 0 && (range & (range - 1)) == 0);
+	return hash & (range - 1);
+      }
+    };
+
+    //! (hash * range) / 2^bits, Lemire's multiply-shift. Works for any
+    //! range with a multiplication instead of a division. It uses the
+    //! high bits of the hash, so the hash function has to mix them
+    //! well: boost_hash of an integer doesn't.
+    struct fastrange_reduction {
+      static size_t reduce(const size_t hash, const size_t range)
+      {
+#if defined(BOOST_HAS_INT128) && !defined(BOOST_NO_INT64_T)
+	if (sizeof(size_t) == 8) {
+	  return static_cast<size_t>(
+	    (static_cast<boost::uint128_type>(hash) * range) >> 64);
+	}
+#endif
+	if (sizeof(size_t) <= 4) {
+	  return static_cast<size_t>(
+	    (static_cast<boost::uint64_t>(hash) * range) >> 32);
+	}
+
+	// 64x64 -> high 64 bits without a 128-bit type
+	const boost::uint64_t a = hash, b = range;
+	const boost::uint64_t a_lo = a & 0xffffffffull, a_hi = a >> 32;
+	const boost::uint64_t b_lo = b & 0xffffffffull, b_hi = b >> 32;
+	const boost::uint64_t lo_lo = a_lo * b_lo;
+	const boost::uint64_t hi_lo = a_hi * b_lo;
+	const boost::uint64_t lo_hi = a_lo * b_hi;
+	const boost::uint64_t cross =
+	  (lo_lo >> 32) + (hi_lo & 0xffffffffull) + lo_hi;
+	return static_cast<size_t>(a_hi * b_hi + (hi_lo >> 32) +
+				   (cross >> 32));
+      }
+    };
+
+    //! mask_reduction if Range is a power of two, modulo_reduction
+    //! otherwise. The default for filters sized at compile time.
+    template <size_t Range>
+    struct default_reduction {
+      typedef typename mpl::if_c<Range != 0 && (Range & (Range - 1)) == 0,
+				 mask_reduction,
+				 modulo_reduction>::type type;
+    };
+
+    namespace detail {
+
+      //! whether Reduction only reduces onto power of two ranges
+      template <typename Reduction>
+      struct needs_power_of_two : mpl::false_ {};
+
+      template <>
+      struct needs_power_of_two<mask_reduction> : mpl::true_ {};
+
+      //? the smallest power of two >= range, or 0 if there is none
+      inline size_t next_power_of_two(const size_t range)
+      {
+	size_t power = 1;
+	while (power != 0 && power < range)
+	  power <<= 1;
+	return power;
+      }
+
+      //? range, rounded up to a power of two if Reduction needs one:
+      //? for the sizes filters choose themselves
+      template <typename Reduction>
+      size_t range_for(const size_t range)
+      {
+	if (!needs_power_of_two<Reduction>::value || range == 0)
+	  return range;
+	return next_power_of_two(range);
+      }
+
+      //? range, if Reduction can reduce onto it, for the sizes filters
+      //? are given; throws invalid_parameter_exception otherwise. 0,
+      //? an empty filter, is fine.
+      template <typename Reduction>
+      size_t checked_range(const size_t range)
+      {
+	if (needs_power_of_two<Reduction>::value &&
+	    (range & (range - 1)) != 0)
+	  throw invalid_parameter_exception();
+	return range;
+      }
+
+    } // namespace detail
+
+  } // namespace bloom_filters
+} // namespace boost
+#endif
@@ -0,0 +1,575 @@
+//////////////////////////////////////////////////////////////////////////////
+//
+// (C) Copyright Alejandro Cabrera 2011.
+// Distributed under the Boost
+// Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or
+// copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// See http://www.boost.org/libs/bloom_filter for documentation.
+//
+//////////////////////////////////////////////////////////////////////////////
+
+#ifndef BOOST_BLOOM_FILTER_SERIALIZATION_HPP
+#define BOOST_BLOOM_FILTER_SERIALIZATION_HPP 1
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+#include <istream>
+#include <ostream>
+#include <vector>
+
+#include <boost/bloom_filter/detail/exceptions.hpp>
+#include <boost/bloom_filter/detail/filter_header.hpp>
+#include <boost/bloom_filter/detail/golomb.hpp>
+#include <boost/bloom_filter/detail/mapped_blocks.hpp>
+#include <boost/bloom_filter/detail/payload.hpp>
+
+/**
+ * save() and load() for every filter in the library.
+ *
+ * A saved filter is a 64 byte header followed by its blocks:
+ *
+ *   std::ofstream out("keys.bloom", std::ios::binary);
+ *   save(filter, out);
+ *
+ *   std::ifstream in("keys.bloom", std::ios::binary);
+ *   load(other, in);
+ *
+ * The header records what the filter is: how it lays out and probes
+ * its bits, its capacity, number of hash functions, bits per bin,
+ * reduction and hash functions with their seeds. Everything in it is
+ * little-endian, as are the blocks, so any machine can read what any
+ * other wrote. On a little-endian machine the blocks are written and
+ * read straight from and to the filter's memory.
+ *
+ * A fixed-size filter and the dynamic filter of the same design load
+ * each other's bits, so long as the hash functions and size agree.
+ * Dynamic filters take on the saved size, and twohash filters with
+ * runtime_hash_values the saved number of hash values. Hash functions
+ * other than the library's can't be told apart by the header; it is
+ * up to the caller to load with the ones the filter was saved with.
+ *
+ * load_in_place() is the zero-copy load: a filter whose Allocator is
+ * mapped_file uses the blocks where they are in the caller's buffer.
+ * That buffer is laid out as a file written by save(), so a filter
+ * file can equally be mapped with mapped_file_params.
+ *
+ * save_compressed() is for sending filters where bytes are dear. It
+ * writes the same header, followed by the gaps between set bits,
+ * Golomb-Rice coded (detail/golomb.hpp), unless that would come out
+ * no smaller than the blocks. load() reads either. A sparse filter
+ * codes to about its entropy, so for the same bytes sent a bigger
+ * filter with fewer hash functions gives fewer false positives than
+ * the filter that is optimal uncompressed (Mitzenmacher, "Compressed
+ * Bloom Filters"); compressed_bit_capacity() sizes one. Compressed
+ * filters can't be used in place.
+ */
+namespace boost {
+  namespace bloom_filters {
+    namespace detail {
+
+      // The way in from save(), load(), parallel_insert() and
+      // combine.hpp. Every filter befriends it and has, privately:
+      //   filter_header header() const
+      //     what it saves, but for block_bytes and payload_bytes
+      //   void reshape(const filter_header& saved, bool allocate)
+      //     takes on the capacity and number of hash functions saved,
+      //     or throws serialization_exception if it can't. Without
+      //     allocate it is left without blocks, for the caller to
+      //     give it some.
+      //   Blocks& block_storage()
+      //     its blocks, for the payload functions
+      //   void recount()
+      //     counts its population again once they have filled them
+      // and the dynamic bit filters, for combine.hpp:
+      //   size_t population
+      //     the bits set in its blocks
+      struct filter_access {
+	template <typename Filter>
+	static filter_header header(const Filter& filter)
+	{
+	  filter_header header = filter.header();
+	  header.block_bytes = static_cast<boost::uint8_t>(
+	    detail::payload_block_bytes(writable(filter).block_storage()));
+	  header.payload_bytes =
+	    detail::payload_size(writable(filter).block_storage());
+	  return header;
+	}
+
+	//? the bits are the same whatever the payload's encoding
+	template <typename Filter>
+	static void reshape(Filter& filter, filter_header saved,
+			    const bool allocate)
+	{
+	  saved.encoding = raw_blocks;
+	  filter.reshape(saved, allocate);
+	}
+
+	template <typename Filter>
+	static const unsigned char *native_bytes(const Filter& filter)
+	{
+	  return detail::native_bytes(writable(filter).block_storage());
+	}
+
+	template <typename Filter>
+	static unsigned char *native_bytes(Filter& filter)
+	{
+	  return detail::native_bytes(filter.block_storage());
+	}
+
+	template <typename Filter>
+	static size_t payload_size(Filter& filter)
+	{
+	  return detail::payload_size(filter.block_storage());
+	}
+
+	template <typename Filter>
+	static void write_payload(const Filter& filter,
+				  unsigned char *const out)
+	{
+	  detail::write_payload(writable(filter).block_storage(), out);
+	}
+
+	template <typename Filter>
+	static void read_payload(Filter& filter,
+				 const unsigned char *const in,
+				 const size_t bytes, const size_t used_bits)
+	{
+	  detail::read_payload(filter.block_storage(), in, bytes, used_bits);
+	  filter.recount();
+	}
+
+	template <typename Filter>
+	static void finish_payload(Filter& filter, const size_t have,
+				   const size_t used_bits)
+	{
+	  detail::finish_payload(filter.block_storage(), have, used_bits);
+	  filter.recount();
+	}
+
+	template <typename Filter>
+	static void borrow_payload(Filter& filter, unsigned char *const image,
+				   const filter_header& saved)
+	{
+	  detail::borrow_payload(filter.block_storage(), image, saved);
+	  filter.recount();
+	}
+
+	//? the blocks of filter as bytes; for combine.hpp
+	template <typename Filter>
+	static const unsigned char *block_bytes(const Filter& filter)
+	{
+	  return detail::block_bytes(writable(filter).block_storage());
+	}
+
+	//? op(blocks) on the blocks of filter, then recounts, also if op
+	//? throws; for parallel_insert() and combine.hpp, which set bits
+	//? in them directly
+	template <typename Filter, typename Op>
+	static void update_blocks(Filter& filter, Op& op)
+	{
+	  try {
+	    op(filter.block_storage());
+	  }
+	  catch (...) {
+	    filter.recount();
+	    throw;
+	  }
+	  filter.recount();
+	}
+
+	//? as update_blocks(), for an op that returns the bits it left
+	//? set, so they aren't read again to count them
+	template <typename Filter, typename Op>
+	static void update_counted_blocks(Filter& filter, Op& op)
+	{
+	  filter.population = op(filter.block_storage());
+	}
+
+      private:
+	// save() only reads through this
+	template <typename Filter>
+	static Filter& writable(const Filter& filter)
+	{
+	  return const_cast<Filter&>(filter);
+	}
+      };
+
+      //? bits of the payload that hold bits of the filter; for the
+      //? counting filters, 0
+      inline size_t used_bits(const filter_header& saved)
+      {
+	return saved.kind == hashed_bins || saved.kind == twohash_bins ? 0 :
+	  static_cast<size_t>(saved.capacity);
+      }
+
+      //? throws serialization_exception if saved is too short for
+      //? its capacity. Only raw blocks can be checked without decoding.
+      inline void check_saved(const filter_header& saved)
+      {
+	const boost::uint64_t bits_per_bin =
+	  saved.bits_per_bin == 0 ? 1 : saved.bits_per_bin;
+	if (saved.encoding == raw_blocks &&
+	    saved.payload_bytes * 8 / bits_per_bin < saved.capacity)
+	  throw serialization_exception();
+      }
+
+      //? the header of the image of size bytes at image
+      inline filter_header read_header(const unsigned char *const image,
+				       const size_t size)
+      {
+	filter_header saved;
+	if (size < encoded_header_size || !decode_header(image, saved))
+	  throw serialization_exception();
+	check_saved(saved);
+	if (size - encoded_header_size < padded_payload(saved.payload_bytes))
+	  throw serialization_exception();
+	return saved;
+      }
+
+      //? the payload of filter: its own memory where that is the
+      //? payload, else written to staged
+      template <typename Filter>
+      const unsigned char *payload_of(const Filter& filter,
+				      std::vector<unsigned char>& staged)
+      {
+	const unsigned char *const native =
+	  filter_access::native_bytes(filter);
+	if (native != 0)
+	  return native;
+
+	staged.resize(static_cast<size_t>(
+	  filter_access::header(filter).payload_bytes));
+	if (staged.empty())
+	  return 0;
+
+	filter_access::write_payload(filter, &staged[0]);
+	return &staged[0];
+      }
+
+      //? the header save_compressed() writes for filter, and the coded
+      //? payload in coded; encoding is raw_blocks, and coded empty, if
+      //? coding wouldn't make it smaller
+      template <typename Filter>
+      filter_header compress(const Filter& filter,
+			     std::vector<unsigned char>& coded)
+      {
+	filter_header header = filter_access::header(filter);
+	const size_t bytes = static_cast<size_t>(header.payload_bytes);
+	std::vector<unsigned char> staged;
+	const unsigned char *const payload = payload_of(filter, staged);
+
+	const size_t size = golomb_size(payload, bytes);
+	coded.clear();
+	if (size >= bytes)
+	  return header;
+
+	coded.resize(size);
+	golomb_encode(payload, bytes, &coded[0]);
+	header.encoding = golomb_gaps;
+	header.payload_bytes = coded.size();
+	return header;
+      }
+
+      //? fills filter, already reshaped, from the coded payload at in.
+      //? Throws serialization_exception, leaving filter empty, if in
+      //? isn't one.
+      template <typename Filter>
+      void decompress(Filter& filter, const unsigned char *const in,
+		      const size_t bytes, const size_t used_bits)
+      {
+	const size_t size = filter_access::payload_size(filter);
+	unsigned char *const native = filter_access::native_bytes(filter);
+
+	try {
+	  if (native != 0) {
+	    golomb_decode(in, bytes, native, size);
+	    filter_access::finish_payload(filter, size, used_bits);
+	    return;
+	  }
+
+	  std::vector<unsigned char> staged(size);
+	  golomb_decode(in, bytes, staged.empty() ? 0 : &staged[0], size);
+	  filter_access::read_payload(filter, staged.empty() ? 0 : &staged[0],
+				      size, used_bits);
+	}
+	catch (...) {
+	  filter_access::finish_payload(filter, 0, used_bits);
+	  throw;
+	}
+      }
+
+    } // namespace detail
+
+    //? the number of bytes save() writes for filter
+    template <typename Filter>
+    size_t serialized_size(const Filter& filter)
+    {
+      return detail::encoded_header_size + static_cast<size_t>(
+	detail::padded_payload(
+	  detail::filter_access::header(filter).payload_bytes));
+    }
+
+    //? writes filter to out: its header, then its blocks in one write
+    //? where the machine is little-endian. Failures are left in the
+    //? state of out.
+    template <typename Filter>
+    void save(const Filter& filter, std::ostream& out)
+    {
+      const detail::filter_header header =
+	detail::filter_access::header(filter);
+      unsigned char encoded[detail::encoded_header_size];
+      detail::encode_header(header, encoded);
+      out.write(reinterpret_cast<const char *>(encoded), sizeof(encoded));
+
+      const size_t bytes = static_cast<size_t>(header.payload_bytes);
+      const unsigned char *const native =
+	detail::filter_access::native_bytes(filter);
+      if (native != 0) {
+	out.write(reinterpret_cast<const char *>(native), bytes);
+      }
+      else if (bytes != 0) {
+	std::vector<unsigned char> staged(bytes);
+	detail::filter_access::write_payload(filter, &staged[0]);
+	out.write(reinterpret_cast<const char *>(&staged[0]), bytes);
+      }
+
+      static const char padding[8] = {0};
+      out.write(padding, static_cast<std::streamsize>(
+		  detail::padded_payload(bytes) - bytes));
+    }
+
+    //? writes filter to the size bytes at buffer, which have to hold
+    //? serialized_size(filter) of them, else throws
+    //? serialization_exception. Returns the number written.
+    template <typename Filter>
+    size_t save(const Filter& filter, void *const buffer, const size_t size)
+    {
+      const detail::filter_header header =
+	detail::filter_access::header(filter);
+      const size_t bytes = static_cast<size_t>(header.payload_bytes);
+      const size_t total = detail::encoded_header_size +
+	static_cast<size_t>(detail::padded_payload(bytes));
+      if (size < total)
+	throw detail::serialization_exception();
+
+      unsigned char *const image = static_cast<unsigned char *>(buffer);
+      detail::encode_header(header, image);
+      detail::filter_access::write_payload(
+	filter, image + detail::encoded_header_size);
+      std::memset(image + detail::encoded_header_size + bytes, 0,
+		  total - detail::encoded_header_size - bytes);
+      return total;
+    }
+
+    //? replaces filter with the one save() or save_compressed() wrote
+    //? to in. Throws
+    //? serialization_exception if in holds no saved filter, one filter
+    //? can't become, or ends early; filter is then left empty or as
+    //? it was. The blocks are read straight into the filter where the
+    //? machine is little-endian.
+    template <typename Filter>
+    void load(Filter& filter, std::istream& in)
+    {
+      unsigned char encoded[detail::encoded_header_size];
+      detail::filter_header saved;
+      if (!in.read(reinterpret_cast<char *>(encoded), sizeof(encoded)) ||
+	  !detail::decode_header(encoded, saved))
+	throw detail::serialization_exception();
+      detail::check_saved(saved);
+
+      detail::filter_access::reshape(filter, saved, true);
+
+      const size_t bytes = static_cast<size_t>(saved.payload_bytes);
+      const size_t used = detail::used_bits(saved);
+      if (saved.encoding == detail::golomb_gaps) {
+	const size_t padded =
+	  static_cast<size_t>(detail::padded_payload(bytes));
+	std::vector<unsigned char> coded(padded);
+	if (padded != 0 &&
+	    !in.read(reinterpret_cast<char *>(&coded[0]),
+		     static_cast<std::streamsize>(padded))) {
+	  detail::filter_access::finish_payload(filter, 0, used);
+	  throw detail::serialization_exception();
+	}
+	detail::decompress(filter, coded.empty() ? 0 : &coded[0], bytes, used);
+	return;
+      }
+
+      unsigned char *const native =
+	detail::filter_access::native_bytes(filter);
+      size_t read = 0;
+      if (native != 0) {
+	read = std::min(bytes,
+			detail::filter_access::payload_size(filter));
+	in.read(reinterpret_cast<char *>(native),
+		static_cast<std::streamsize>(read));
+	detail::filter_access::finish_payload(
+	  filter, static_cast<size_t>(in.gcount()), used);
+      }
+      else if (bytes != 0) {
+	std::vector<unsigned char> staged(bytes);
+	read = bytes;
+	in.read(reinterpret_cast<char *>(&staged[0]),
+		static_cast<std::streamsize>(bytes));
+	detail::filter_access::read_payload(
+	  filter, &staged[0], static_cast<size_t>(in.gcount()), used);
+      }
+
+      const std::streamsize rest = static_cast<std::streamsize>(
+	detail::padded_payload(bytes) - read);
+      if (!in || in.ignore(rest).gcount() != rest) {
+	detail::filter_access::finish_payload(filter, 0, used);
+	throw detail::serialization_exception();
+      }
+    }
+
+    //? replaces filter with the one save() or save_compressed() wrote
+    //? to the size bytes at buffer, copying its blocks. Throws as load from a stream does.
+    //? Returns the number of bytes used.
+    template <typename Filter>
+    size_t load(Filter& filter, const void *const buffer, const size_t size)
+    {
+      const unsigned char *const image =
+	static_cast<const unsigned char *>(buffer);
+      const detail::filter_header saved = detail::read_header(image, size);
+
+      detail::filter_access::reshape(filter, saved, true);
+      if (saved.encoding == detail::golomb_gaps)
+	detail::decompress(filter, image + detail::encoded_header_size,
+			   static_cast<size_t>(saved.payload_bytes),
+			   detail::used_bits(saved));
+      else
+	detail::filter_access::read_payload(
+	  filter, image + detail::encoded_header_size,
+	  static_cast<size_t>(saved.payload_bytes), detail::used_bits(saved));
+      return detail::encoded_header_size +
+	static_cast<size_t>(detail::padded_payload(saved.payload_bytes));
+    }
+
+    //? as load, but without copying: filter, whose Allocator has to
+    //? be mapped_file, uses the blocks where they are in buffer, which
+    //? has to outlive it and stay put. Inserting writes to buffer.
+    //? Needs a little-endian machine, the Block type the filter was
+    //? saved with, and blocks aligned for it, as they are when buffer
+    //? is; otherwise throws serialization_exception and leaves filter
+    //? empty.
+    template <typename Filter>
+    size_t load_in_place(Filter& filter, void *const buffer,
+			 const size_t size)
+    {
+      unsigned char *const image = static_cast<unsigned char *>(buffer);
+      const detail::filter_header saved = detail::read_header(image, size);
+
+      detail::filter_access::reshape(filter, saved, false);
+      detail::filter_access::borrow_payload(filter, image, saved);
+      return detail::encoded_header_size +
+	static_cast<size_t>(detail::padded_payload(saved.payload_bytes));
+    }
+
+    //* compressed
+    //? the number of bytes save_compressed() writes for filter; never
+    //? more than serialized_size(filter)
+    template <typename Filter>
+    size_t compressed_size(const Filter& filter)
+    {
+      std::vector<unsigned char> staged;
+      const size_t bytes = static_cast<size_t>(
+	detail::filter_access::header(filter).payload_bytes);
+      const size_t coded = std::min(
+	bytes, detail::golomb_size(detail::payload_of(filter, staged), bytes));
+      return detail::encoded_header_size +
+	static_cast<size_t>(detail::padded_payload(coded));
+    }
+
+    //? as save, but with the set bits Golomb-Rice coded where that
+    //? takes fewer bytes. load() reads it back.
+    template <typename Filter>
+    void save_compressed(const Filter& filter, std::ostream& out)
+    {
+      std::vector<unsigned char> coded;
+      const detail::filter_header header = detail::compress(filter, coded);
+      if (header.encoding == detail::raw_blocks) {
+	save(filter, out);
+	return;
+      }
+
+      unsigned char encoded[detail::encoded_header_size];
+      detail::encode_header(header, encoded);
+      out.write(reinterpret_cast<const char *>(encoded), sizeof(encoded));
+      out.write(reinterpret_cast<const char *>(&coded[0]),
+		static_cast<std::streamsize>(coded.size()));
+
+      static const char padding[8] = {0};
+      out.write(padding, static_cast<std::streamsize>(
+		  detail::padded_payload(coded.size()) - coded.size()));
+    }
+
+    //? writes filter as save_compressed to the size bytes at buffer,
+    //? which have to hold compressed_size(filter) of them, else throws
+    //? serialization_exception. Returns the number written.
+    template <typename Filter>
+    size_t save_compressed(const Filter& filter, void *const buffer,
+			   const size_t size)
+    {
+      std::vector<unsigned char> coded;
+      const detail::filter_header header = detail::compress(filter, coded);
+      if (header.encoding == detail::raw_blocks)
+	return save(filter, buffer, size);
+
+      const size_t total = detail::encoded_header_size +
+	static_cast<size_t>(detail::padded_payload(coded.size()));
+      if (size < total)
+	throw detail::serialization_exception();
+
+      unsigned char *const image = static_cast<unsigned char *>(buffer);
+      detail::encode_header(header, image);
+      std::memcpy(image + detail::encoded_header_size, &coded[0],
+		  coded.size());
+      std::memset(image + detail::encoded_header_size + coded.size(), 0,
+		  total - detail::encoded_header_size - coded.size());
+      return total;
+    }
+
+    //? the largest bit capacity for which a filter holding
+    //? expected_insertions keys, each setting hash_functions bits, is
+    //? expected to save_compressed() to no more than bytes after the
+    //? header. Throws invalid_parameter_exception if any is 0.
+    inline size_t compressed_bit_capacity(const size_t expected_insertions,
+					  const size_t hash_functions,
+					  const size_t bytes)
+    {
+      if (expected_insertions == 0 || hash_functions == 0 || bytes == 0)
+	throw detail::invalid_parameter_exception();
+
+      const double kn = static_cast<double>(expected_insertions) *
+	static_cast<double>(hash_functions);
+      const double budget = static_cast<double>(bytes);
+
+      // bytes * 8 bits always fit, uncoded if need be; the coded size
+      // only grows with the capacity
+      size_t low = bytes * 8;
+      size_t high = low * 2;
+      while (high < (static_cast<size_t>(1) << 48) &&
+	     detail::golomb_estimate_for(high, kn) <= budget) {
+	low = high;
+	high *= 2;
+      }
+
+      while (high - low > 1) {
+	const size_t mid = low + (high - low) / 2;
+	if (detail::golomb_estimate_for(mid, kn) <= budget)
+	  low = mid;
+	else
+	  high = mid;
+      }
+
+      return low;
+    }
+
+  } // namespace bloom_filters
+} // namespace boost
+#endif
@@ -0,0 +1,213 @@
+//////////////////////////////////////////////////////////////////////////////
+//
+// (C) Copyright Alejandro Cabrera 2011.
+// Distributed under the Boost
+// Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or
+// copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// See http://www.boost.org/libs/bloom_filter for documentation.
+//
+//////////////////////////////////////////////////////////////////////////////
+
+#ifndef BOOST_BLOOM_FILTER_SHARDED_BLOOM_FILTER_HPP
+#define BOOST_BLOOM_FILTER_SHARDED_BLOOM_FILTER_HPP 1
+
+#include <memory>
+#include <vector>
+
+#include <boost/config.hpp>
+#include <boost/mpl/vector.hpp>
+
+#include <boost/bloom_filter/dynamic_bloom_filter.hpp>
+#include <boost/bloom_filter/hash/default.hpp>
+#include <boost/bloom_filter/reduction.hpp>
+
+/**
+ * dynamic_bloom_filter split into per-thread shards for write-heavy
+ * loads.
+ *
+ * Each writer is given a shard index and inserts only into that
+ * shard, a dynamic_bloom_filter of its own with the same capacity and
+ * hashes as all the others. Writers share nothing -- not even the
+ * cache lines concurrent_bloom_filter's atomic words bounce between
+ * cores -- so they need no synchronization at all.
+ *
+ * A key is found by probing every shard, or by probing the merged
+ * filter: the union of the shards, built by merge() with operator|=.
+ * merged() is a separate filter, so it may be probed while the
+ * writers carry on inserting into their shards; it only knows the
+ * keys inserted before the last merge().
+ *
+ * probably_contains(), merge() and clear() read or write every shard,
+ * and must not run while any thread is inserting. Neither may merge()
+ * run while merged() is probed.
+ */
+namespace boost {
+  namespace bloom_filters {
+    namespace detail {
+      // keeps the population each shard updates on insert off the
+      // cache line of the next shard's
+      template <typename Filter>
+      struct padded_shard {
+	// pad is zeroed so that copying a shard reads nothing
+	// uninitialized
+	padded_shard() : pad() {}
+	explicit padded_shard(const Filter& filter)
+	  : filter(filter), pad() {}
+
+	Filter filter;
+	char pad[64];
+      };
+    } // namespace detail
+
+    template <typename T,
+	      class HashFunctions = mpl::vector<boost_hash<T> >,
+	      class Block = size_t,
+	      class Allocator = std::allocator<Block>,
+	      class Reduction = modulo_reduction>
+    class sharded_bloom_filter {
+    public:
+      typedef T value_type;
+      typedef T key_type;
+      typedef HashFunctions hash_function_type;
+      typedef Block block_type;
+      typedef Allocator allocator_type;
+      typedef Reduction reduction_type;
+      typedef dynamic_bloom_filter<T, HashFunctions,
+				   Block, Allocator, Reduction> shard_type;
+      typedef typename shard_type::digest_type digest_type;
+
+    private:
+      typedef detail::padded_shard<shard_type> padded_type;
+
+    public:
+      //* constructors
+      sharded_bloom_filter(const size_t num_shards,
+			   const size_t bit_capacity)
+	: shards(num_shards, padded_type(shard_type(bit_capacity))),
+	  snapshot(bit_capacity) {}
+
+      //? each shard -- and so the merged filter -- is sized to hold all
+      //? expected_insertions keys at no more than false_positive_rate
+      sharded_bloom_filter(const size_t num_shards,
+			   const size_t expected_insertions,
+			   const double false_positive_rate)
+	: shards(num_shards,
+		 padded_type(shard_type(expected_insertions,
+					false_positive_rate))),
+	  snapshot(expected_insertions, false_positive_rate) {}
+
+      //* query functions
+      size_t num_shards() const {
+	return this->shards.size();
+      }
+
+      size_t bit_capacity() const {
+	return this->snapshot.bit_capacity();
+      }
+
+      static BOOST_CONSTEXPR size_t num_hash_functions() {
+	return shard_type::num_hash_functions();
+      }
+
+      //? that of probably_contains(): the chance any one shard gives a
+      //? false positive
+      double false_positive_rate() const {
+	double none = 1.0;
+	for (size_t i = 0; i < this->shards.size(); ++i)
+	  none *= 1.0 - this->shards[i].filter.false_positive_rate();
+	return 1.0 - none;
+      }
+
+      bool empty() const {
+	for (size_t i = 0; i < this->shards.size(); ++i)
+	  if (!this->shards[i].filter.empty())
+	    return false;
+	return true;
+      }
+
+      shard_type& shard(const size_t i) {
+	return this->shards[i].filter;
+      }
+
+      const shard_type& shard(const size_t i) const {
+	return this->shards[i].filter;
+      }
+
+      //? the union of the shards as of the last merge()
+      const shard_type& merged() const {
+	return this->snapshot;
+      }
+
+      //* core operations
+      //? only one thread may insert into a given shard at a time
+      void insert(const size_t shard, const T& t) {
+	this->shards[shard].filter.insert(t);
+      }
+
+      template <typename InputIterator>
+      void insert(const size_t shard,
+		  const InputIterator start, const InputIterator end) {
+	this->shards[shard].filter.insert_batch(start, end);
+      }
+
+      //? hashes t once for all the shards
+      bool probably_contains(const T& t) const {
+	return this->probably_contains_hash(hash_key(t));
+      }
+
+      //* pre-hashed ops
+      static digest_type hash_key(const T& t) {
+	return shard_type::hash_key(t);
+      }
+
+      void insert_hash(const size_t shard, const digest_type& digest) {
+	this->shards[shard].filter.insert_hash(digest);
+      }
+
+      bool probably_contains_hash(const digest_type& digest) const {
+	for (size_t i = 0; i < this->shards.size(); ++i)
+	  if (this->shards[i].filter.probably_contains_hash(digest))
+	    return true;
+	return false;
+      }
+
+      //* whole filter operations
+      //? rebuilds merged() from the shards
+      const shard_type& merge() {
+	this->snapshot.clear();
+	for (size_t i = 0; i < this->shards.size(); ++i)
+	  this->snapshot |= this->shards[i].filter;
+	return this->snapshot;
+      }
+
+      void clear() {
+	for (size_t i = 0; i < this->shards.size(); ++i)
+	  this->shards[i].filter.clear();
+	this->snapshot.clear();
+      }
+
+      void swap(sharded_bloom_filter& other) {
+	this->shards.swap(other.shards);
+	this->snapshot.swap(other.snapshot);
+      }
+
+    private:
+      std::vector<padded_type> shards;
+      shard_type snapshot;
+    };
+
+    template<class T, class HashFunctions,
+	     class Block, class Allocator, class Reduction>
+    void
+    swap(sharded_bloom_filter<T, HashFunctions,
+			      Block, Allocator, Reduction>& lhs,
+	 sharded_bloom_filter<T, HashFunctions,
+			      Block, Allocator, Reduction>& rhs)
+    {
+      lhs.swap(rhs);
+    }
+  } // namespace bloom_filters
+} // namespace boost
+#endif
@@ -0,0 +1,157 @@
+//////////////////////////////////////////////////////////////////////////////
+//
+// (C) Copyright Alejandro Cabrera 2011.
+// Distributed under the Boost
+// Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or
+// copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// See http://www.boost.org/libs/bloom_filter for documentation.
+//
+//////////////////////////////////////////////////////////////////////////////
+
+#ifndef BOOST_BLOOM_FILTER_STORAGE_HPP
+#define BOOST_BLOOM_FILTER_STORAGE_HPP 1
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <new>
+
+#include <boost/config.hpp>
+#include <boost/align/aligned_allocator.hpp>
+#include <boost/core/allocator_access.hpp>
+
+namespace boost {
+  namespace bloom_filters {
+    namespace detail {
+
+      // A storage policy's apply<Object>::type holds the bits (or bins)
+      // of a fixed size filter: get() returns them, swap() exchanges
+      // them with another holder of the same type, and copies are
+      // deep.
+
+      template <typename Object>
+      class inline_holder {
+      public:
+	Object& get() { return this->object; }
+	const Object& get() const { return this->object; }
+
+	void swap(inline_holder& other)
+	{
+	  std::swap(this->object, other.object);
+	}
+
+      private:
+	Object object;
+      };
+
+      template <typename Object, typename Allocator>
+      class allocated_holder {
+	typedef typename boost::allocator_rebind<Allocator, Object>::type
+	  allocator_type;
+
+      public:
+	// value-initialized in place: a large Object never passes
+	// through the stack
+	allocated_holder()
+	  : object(allocate())
+	{
+	  ::new (static_cast<void *>(this->object)) Object();
+	}
+
+	allocated_holder(const allocated_holder& other)
+	  : object(allocate())
+	{
+	  ::new (static_cast<void *>(this->object)) Object(other.get());
+	}
+
+#ifndef BOOST_NO_CXX11_RVALUE_REFERENCES
+	//? takes the allocation of other, leaving it with none
+	allocated_holder(allocated_holder&& other) BOOST_NOEXCEPT
+	  : object(other.object)
+	{
+	  other.object = 0;
+	}
+
+	allocated_holder& operator=(allocated_holder&& rhs) BOOST_NOEXCEPT
+	{
+	  allocated_holder released(static_cast<allocated_holder&&>(rhs));
+	  this->swap(released);
+	  return *this;
+	}
+#endif
+
+	~allocated_holder()
+	{
+	  if (this->object == 0)
+	    return;
+
+	  this->object->~Object();
+	  allocator_type().deallocate(this->object, 1);
+	}
+
+	//? copies into the existing allocation, or into a new one if
+	//? this holder was moved from
+	allocated_holder& operator=(const allocated_holder& rhs)
+	{
+	  if (this->object == 0) {
+	    allocated_holder copy(rhs);
+	    this->swap(copy);
+	  }
+	  else
+	    this->get() = rhs.get();
+	  return *this;
+	}
+
+	Object& get() { return *this->object; }
+	const Object& get() const { return *this->object; }
+
+	void swap(allocated_holder& other) BOOST_NOEXCEPT
+	{
+	  std::swap(this->object, other.object);
+	}
+
+      private:
+	static Object *allocate()
+	{
+	  return &*allocator_type().allocate(1);
+	}
+
+	Object *object;
+      };
+
+    } // namespace detail
+
+    //! Keeps the bits of a fixed size filter inside the filter object.
+    //! The default; best for small filters.
+    struct inline_storage {
+      template <typename Object>
+      struct apply {
+	typedef detail::inline_holder<Object> type;
+      };
+    };
+
+    //! Keeps the bits of a fixed size filter in one allocation made
+    //! with a default constructed Allocator, rebound to the bit
+    //! container. The filter object is then a pointer wide, swapping
+    //! or moving it does not touch the bits, and a large filter can be
+    //! a local variable. An arena allocator plugs in here.
+    template <typename Allocator = std::allocator<char> >
+    struct allocated_storage {
+      template <typename Object>
+      struct apply {
+	typedef detail::allocated_holder<Object, Allocator> type;
+      };
+    };
+
+    //! allocated_storage on the heap, aligned to Alignment bytes: 64
+    //! puts the first bits at the start of a cache line.
+    template <size_t Alignment = 64>
+    struct heap_storage
+      : allocated_storage<alignment::aligned_allocator<char, Alignment> >
+    {};
+
+  } // namespace bloom_filters
+} // namespace boost
+#endif
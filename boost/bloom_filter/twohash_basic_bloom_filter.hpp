@@ -13,15 +13,20 @@
 #ifndef BOOST_BLOOM_FILTER_TWOHASH_BASIC_BLOOM_FILTER_HPP
 #define BOOST_BLOOM_FILTER_TWOHASH_BASIC_BLOOM_FILTER_HPP 1
 
-#include <cmath>
 #include <bitset>
 
 #include <boost/config.hpp>
+#include <boost/cstdint.hpp>
 
 #include <boost/bloom_filter/hash/default.hpp>
 #include <boost/bloom_filter/hash/murmurhash3.hpp>
+#include <boost/bloom_filter/reduction.hpp>
 #include <boost/bloom_filter/detail/extenders.hpp>
 #include <boost/bloom_filter/detail/twohash_apply_hash.hpp>
+#include <boost/bloom_filter/detail/batch.hpp>
+#include <boost/bloom_filter/detail/filter_header.hpp>
+#include <boost/bloom_filter/detail/hash_digest.hpp>
+#include <boost/bloom_filter/detail/population.hpp>
 
 #ifndef BOOST_NO_0X_HDR_INITIALIZER_LIST
 #include <initializer_list>
@@ -35,7 +40,8 @@ namespace boost {
 	      size_t ExpectedInsertionCount = 0,
 	      class HashFunction1 = boost_hash<T>,
 	      class HashFunction2 = murmurhash3<T>, 
-	      typename ExtensionFunction = detail::square>// = ???
+	      typename ExtensionFunction = detail::square,
+	      class Reduction = typename default_reduction<Size>::type>
     class twohash_basic_bloom_filter {
     public:
       typedef T value_type;
@@ -44,13 +50,15 @@ namespace boost {
       typedef HashFunction1 hash_function1_type;
       typedef HashFunction2 hash_function2_type;
       typedef ExtensionFunction extension_function_type;
+      typedef Reduction reduction_type;
       typedef twohash_basic_bloom_filter<T, 
 					 Size,
 					 HashValues,
 					 ExpectedInsertionCount,
 					 HashFunction1,
 					 HashFunction2,
-					 ExtensionFunction> this_type;
+					 ExtensionFunction,
+					 Reduction> this_type;
 
     private:
       typedef detail::twohash_apply_hash<HashValues,
@@ -59,12 +67,14 @@ namespace boost {
     public:
       //* constructors
       twohash_basic_bloom_filter()
+	: population(0)
       {
       }
 
       template <typename InputIterator>
       twohash_basic_bloom_filter(const InputIterator start, 
 				 const InputIterator end)
+	: population(0)
       {
 	for (InputIterator i = start; i != end; ++i)
 	  this->insert(*i);
@@ -72,6 +82,7 @@ namespace boost {
 
 #ifndef BOOST_NO_0X_HDR_INITIALIZER_LIST
       twohash_basic_bloom_filter(const std::initializer_list<T>& ilist)
+	: population(0)
       {
 	typedef typename std::initializer_list<T>::const_iterator citer;
 	for (citer i = ilist.begin(), end = ilist.end(); i != end; ++i)
@@ -95,19 +106,16 @@ namespace boost {
 	return ExpectedInsertionCount;
       }
 
+      //? estimated from count(), so as cheap to ask
       double false_positive_rate() const
       {
-        const double n = static_cast<double>(this->bits.count());
-        static const double k = static_cast<double>(HashValues);
-        static const double m = static_cast<double>(Size);
-        static const double e =
-	  2.718281828459045235360287471352662497757247093699959574966;
-        return std::pow(1 - std::pow(e, -k * n / m), k);
+	return detail::estimated_fpr(this->count(), Size, HashValues);
       }
 
+      //? the number of bits set; kept as keys go in, so free to ask
       size_t count() const
       {
-	return this->bits.count();
+	return this->population;
       }
 
       bool empty() const
@@ -124,7 +132,7 @@ namespace boost {
       //* core ops
       void insert(const T& t)
       {
-	apply_hash_type::insert(t, bits);
+	this->population += apply_hash_type::insert(t, bits);
       }
 
       template <typename InputIterator>
@@ -140,9 +148,58 @@ namespace boost {
 	return apply_hash_type::contains(t, bits);
       }
 
+      //* pre-hashed ops
+      //? the unreduced hash values of a key. A digest can be passed to
+      //? insert_hash() and probably_contains_hash() of any filter with
+      //? the same key type and hashing, whatever its size, so a key
+      //? probed against many filters is hashed only once.
+      typedef detail::hash_digest<apply_hash_type::num_positions> digest_type;
+
+      static digest_type hash_key(const T& t)
+      {
+	digest_type digest;
+	apply_hash_type::hashes(t, digest.values);
+	return digest;
+      }
+
+      void insert_hash(const digest_type& digest)
+      {
+	this->population +=
+	  detail::bitset_insert_digest<reduction_type>(digest, bits);
+      }
+
+      bool probably_contains_hash(const digest_type& digest) const
+      {
+	return detail::bitset_contains_digest<reduction_type>(digest, bits);
+      }
+
+      //? inserts every key in [start, end). Same result as
+      //? insert(start, end), but the probes of a group of keys are
+      //? prefetched together so their cache misses overlap.
+      template <typename InputIterator>
+      void insert_batch(const InputIterator start, const InputIterator end)
+      {
+	this->population +=
+	  detail::bitset_insert_batch<apply_hash_type>(start, end, bits);
+      }
+
+      //? tests every key in [start, end). Bit i % 64 of out[i / 64] is
+      //? set if the i-th key is probably contained, so out must have
+      //? room for (std::distance(start, end) + 63) / 64 words. Returns
+      //? the number of keys that are probably contained.
+      template <typename InputIterator>
+      size_t probably_contains_batch(const InputIterator start,
+				     const InputIterator end,
+				     boost::uint64_t *const out) const
+      {
+	return detail::bitset_contains_batch<apply_hash_type>(start, end,
+							      bits, out);
+      }
+
       void clear()
       {
 	this->bits.reset();
+	this->population = 0;
       }
 
       void swap(twohash_basic_bloom_filter& other)
@@ -157,6 +214,7 @@ namespace boost {
       operator|=(const twohash_basic_bloom_filter& rhs)
       {
 	this->bits |= rhs.bits;
+	this->recount();
 	return *this;
       }
 
@@ -164,6 +222,7 @@ namespace boost {
       operator&=(const twohash_basic_bloom_filter& rhs)
       {
 	this->bits &= rhs.bits;
+	this->recount();
 	return *this;
       }
 
@@ -171,7 +230,8 @@ namespace boost {
 	       size_t _ExpectedInsertionCount,
 	       class _HashFunction1,
 	       class _HashFunction2,
-	       class _ExtensionFunction>
+	       class _ExtensionFunction,
+	       class _Reduction>
       friend bool
       operator==(const twohash_basic_bloom_filter<_T, 
 						  _Size,
@@ -179,24 +239,51 @@ namespace boost {
 						  _ExpectedInsertionCount,
 						  _HashFunction1,
 						  _HashFunction2,
-						  _ExtensionFunction>&,
+						  _ExtensionFunction,
+						  _Reduction>&,
 		 const twohash_basic_bloom_filter<_T, 
 						  _Size,
 		                                  _HashValues,
 						  _ExpectedInsertionCount,
 						  _HashFunction1,
 						  _HashFunction2,
-						  _ExtensionFunction>&);
+						  _ExtensionFunction,
+						  _Reduction>&);
       
     private:
+      //* serialization
+      friend struct detail::filter_access;
+
+      detail::filter_header header() const
+      {
+	return detail::make_header<HashFunction1, Reduction,
+				   mpl::vector<HashFunction2,
+					       ExtensionFunction> >(
+	  detail::twohash_bits, 1, 0, num_hash_functions(), Size);
+      }
+
+      void reshape(const detail::filter_header& saved, bool)
+      {
+	detail::check_header(saved, this->header());
+      }
+
+      bitset_type& block_storage() { return this->bits; }
+
+      void recount()
+      {
+	this->population = detail::count_bits(this->bits);
+      }
+
       bitset_type bits;
+      size_t population;
     };
 
     //* global ops
     template<class T, size_t Size, size_t HashValues, 
 	     size_t ExpectedInsertionCount,
 	     class HashFunction1,
-	     class HashFunction2, class ExtensionFunction>
+	     class HashFunction2, class ExtensionFunction,
+	     class Reduction>
     bool
     operator==(const twohash_basic_bloom_filter<T, 
 						Size, 
@@ -204,14 +291,16 @@ namespace boost {
 						ExpectedInsertionCount,
 						HashFunction1,
 						HashFunction2,
-						ExtensionFunction>& lhs,
+						ExtensionFunction,
+						Reduction>& lhs,
 	       const twohash_basic_bloom_filter<T, 
 						Size, 
 	                                        HashValues,
 						ExpectedInsertionCount,
 						HashFunction1,
 						HashFunction2,
-						ExtensionFunction>& rhs)
+						ExtensionFunction,
+						Reduction>& rhs)
     {
       return lhs.bits == rhs.bits;
     }
@@ -219,7 +308,8 @@ namespace boost {
     template<class T, size_t Size, size_t HashValues, 
 	     size_t ExpectedInsertionCount,
 	     class HashFunction1,
-	     class HashFunction2, class ExtensionFunction>
+	     class HashFunction2, class ExtensionFunction,
+	     class Reduction>
     bool
     operator!=(const twohash_basic_bloom_filter<T, 
 						Size, 
@@ -227,14 +317,16 @@ namespace boost {
 						ExpectedInsertionCount,
 						HashFunction1,
 						HashFunction2,
-						ExtensionFunction>& lhs,
+						ExtensionFunction,
+						Reduction>& lhs,
 	       const twohash_basic_bloom_filter<T, 
 						Size, 
 	                                        HashValues,
 						ExpectedInsertionCount,
 						HashFunction1,
 						HashFunction2,
-						ExtensionFunction>& rhs)
+						ExtensionFunction,
+						Reduction>& rhs)
     {
       return !(lhs == rhs);
     }
@@ -242,31 +334,35 @@ namespace boost {
     template<class T, size_t Size, size_t HashValues,
 	     size_t ExpectedInsertionCount,
 	     class HashFunction1,
-	     class HashFunction2, class ExtensionFunction>
+	     class HashFunction2, class ExtensionFunction,
+	     class Reduction>
     twohash_basic_bloom_filter<T, Size, 
 			       HashValues,
 			       ExpectedInsertionCount,
 			       HashFunction1, 
-			       HashFunction2, ExtensionFunction>
+			       HashFunction2, ExtensionFunction, Reduction>
     operator|(const twohash_basic_bloom_filter<T, 
 	                                       Size, 
 	                                       HashValues,
 	                                       ExpectedInsertionCount,
 					       HashFunction1,
 					       HashFunction2,
-					       ExtensionFunction>& lhs,
+					       ExtensionFunction,
+					       Reduction>& lhs,
 	      const twohash_basic_bloom_filter<T, 
 					       Size, 
 	                                       HashValues,
 	                                       ExpectedInsertionCount,
 					       HashFunction1,
 					       HashFunction2,
-					       ExtensionFunction>& rhs)
+					       ExtensionFunction,
+					       Reduction>& rhs)
     {
       twohash_basic_bloom_filter<T, Size, HashValues,
 				 ExpectedInsertionCount,
 				 HashFunction1, HashFunction2,
-				 ExtensionFunction> result(lhs);
+				 ExtensionFunction,
+				 Reduction> result(lhs);
       
       result |= rhs;
       return result;
@@ -275,30 +371,34 @@ namespace boost {
     template<class T, size_t Size, size_t HashValues, 
 	     size_t ExpectedInsertionCount, 
 	     class HashFunction1,
-	     class HashFunction2, class ExtensionFunction>
+	     class HashFunction2, class ExtensionFunction,
+	     class Reduction>
     twohash_basic_bloom_filter<T, Size, HashValues, 
 			       ExpectedInsertionCount,
 			       HashFunction1, 
-			       HashFunction2, ExtensionFunction>
+			       HashFunction2, ExtensionFunction, Reduction>
     operator&(const twohash_basic_bloom_filter<T, 
 					       Size, 
 	                                       HashValues,
 					       ExpectedInsertionCount,
 					       HashFunction1,
 					       HashFunction2,
-					       ExtensionFunction>& lhs,
+					       ExtensionFunction,
+					       Reduction>& lhs,
 	      const twohash_basic_bloom_filter<T, 
 					       Size, 
 	                                       HashValues,
 					       ExpectedInsertionCount,
 					       HashFunction1,
 					       HashFunction2,
-					       ExtensionFunction>& rhs)
+					       ExtensionFunction,
+					       Reduction>& rhs)
     {
       twohash_basic_bloom_filter<T, Size, HashValues,
 				 ExpectedInsertionCount,
 				 HashFunction1, HashFunction2,
-				 ExtensionFunction> result(lhs);
+				 ExtensionFunction,
+				 Reduction> result(lhs);
       
       result &= rhs;
       return result;
@@ -307,21 +407,24 @@ namespace boost {
     template<class T, size_t Size, size_t HashValues, 
 	     size_t ExpectedInsertionCount, 
 	     class HashFunction1,
-	     class HashFunction2, class ExtensionFunction>
+	     class HashFunction2, class ExtensionFunction,
+	     class Reduction>
     void swap(twohash_basic_bloom_filter<T, 
 					 Size,
 					 HashValues,
 					 ExpectedInsertionCount,
 					 HashFunction1,
 					 HashFunction2,
-					 ExtensionFunction>& lhs,
+					 ExtensionFunction,
+					 Reduction>& lhs,
 	      twohash_basic_bloom_filter<T, 
 					 Size, 
 					 HashValues,
 					 ExpectedInsertionCount,
 					 HashFunction1,
 					 HashFunction2,
-					 ExtensionFunction>& rhs)
+					 ExtensionFunction,
+					 Reduction>& rhs)
     {
       lhs.swap(rhs);
     }
@@ -13,9 +13,8 @@
 #ifndef BOOST_BLOOM_FILTER_TWOHASH_COUNTING_BLOOM_FILTER_HPP
 #define BOOST_BLOOM_FILTER_TWOHASH_COUNTING_BLOOM_FILTER_HPP 1
 
-#include <cmath>
-
 #include <boost/config.hpp>
+#include <boost/cstdint.hpp>
 #include <boost/array.hpp>
 
 #include <boost/static_assert.hpp>
@@ -23,9 +22,14 @@
 #include <boost/type_traits/is_unsigned.hpp>
 
 #include <boost/bloom_filter/detail/twohash_counting_apply_hash.hpp>
+#include <boost/bloom_filter/detail/batch.hpp>
+#include <boost/bloom_filter/detail/filter_header.hpp>
+#include <boost/bloom_filter/detail/hash_digest.hpp>
+#include <boost/bloom_filter/detail/population.hpp>
 #include <boost/bloom_filter/detail/extenders.hpp>
 #include <boost/bloom_filter/hash/default.hpp>
 #include <boost/bloom_filter/hash/murmurhash3.hpp>
+#include <boost/bloom_filter/reduction.hpp>
 
 #ifndef BOOST_NO_0X_HDR_INITIALIZER_LIST
 #include <initializer_list>
@@ -41,7 +45,8 @@ namespace boost {
 	      class HashFunction1 = boost_hash<T>,
 	      class HashFunction2 = murmurhash3<T>,
 	      class ExtensionFunction = detail::square,
-	      typename Block = size_t>
+	      typename Block = size_t,
+	      class Reduction = typename default_reduction<NumBins>::type>
     class twohash_counting_bloom_filter {
 
       // Block needs to be an integral type
@@ -81,10 +86,12 @@ namespace boost {
       typedef HashFunction2 hash_function2_type;
       typedef ExtensionFunction extension_function_type;
       typedef Block block_type;
+      typedef Reduction reduction_type;
       typedef twohash_counting_bloom_filter<T, NumBins, BitsPerBin, HashValues,
 					    ExpectedInsertionCount,
 					    HashFunction1, HashFunction2, 
-					    ExtensionFunction, Block> this_type;
+					    ExtensionFunction, Block,
+					    Reduction> this_type;
 
       typedef boost::array<Block, array_size> bucket_type;
       typedef typename bucket_type::iterator bucket_iterator;
@@ -159,34 +166,17 @@ namespace boost {
         return HashValues;
       }
 
+      //? estimated from count(), so as cheap to ask
       double false_positive_rate() const 
       {
-        const double n = static_cast<double>(this->count());
-        static const double k = static_cast<double>(HashValues);
-        static const double m = static_cast<double>(NumBins);
-        static const double e =
-	  2.718281828459045235360287471352662497757247093699959574966;
-        return std::pow(1 - std::pow(e, -k * n / m), k);
+	return detail::estimated_fpr(this->count(), NumBins, HashValues);
       }
 
-      //? returns the number of bins that have at least 1 bit set
+      //? returns the number of bins that have at least 1 bit set; kept
+      //? as keys go in and out, so free to ask
       size_t count() const 
       {
-	size_t ret = 0;
-
-	for (bucket_const_iterator i = this->bits.begin(), 
-	       end = this->bits.end(); 
-	     i != end; ++i) {
-	  for (size_t bin = 0; bin < this->bins_per_slot(); ++bin) {
-	    const size_t offset_bits = bin * BitsPerBin;
-	    const size_t target_bits = (*i >> offset_bits) & this->mask();
-
-	    if (target_bits > 0)
-	      ++ret;
-	  }
-	}
-
-        return ret;
+        return this->population;
       }
 
       bool empty() const
@@ -205,7 +195,8 @@ namespace boost {
       {
 	apply_hash_type::insert(t, 
 				this->bits,
-				this->num_bins());
+				this->num_bins(),
+				this->population);
       }
 
       template <typename InputIterator>
@@ -220,7 +211,8 @@ namespace boost {
       {
 	apply_hash_type::remove(t, 
 				this->bits,
-				this->num_bins());
+				this->num_bins(),
+				this->population);
       }
 
       template <typename InputIterator>
@@ -238,6 +230,66 @@ namespace boost {
 					 this->num_bins());
       }
 
+      //* pre-hashed ops
+      //? the unreduced hash values of a key. A digest can be passed to
+      //? insert_hash() and probably_contains_hash() of any filter with
+      //? the same key type and hashing, whatever its size, so a key
+      //? probed against many filters is hashed only once.
+      typedef detail::hash_digest<apply_hash_type::num_positions> digest_type;
+
+      static digest_type hash_key(const T& t)
+      {
+	digest_type digest;
+	apply_hash_type::hashes(t, digest.values);
+	return digest;
+      }
+
+      void insert_hash(const digest_type& digest)
+      {
+	detail::counting_update_digest<this_type>(
+	  digest, this->bits, this->num_bins(),
+	  detail::increment(this->population),
+	  (static_cast<size_t>(1) << BitsPerBin) - 1);
+      }
+
+      void remove_hash(const digest_type& digest)
+      {
+	detail::counting_update_digest<this_type>(
+	  digest, this->bits, this->num_bins(),
+	  detail::decrement(this->population), 0);
+      }
+
+      bool probably_contains_hash(const digest_type& digest) const
+      {
+	return detail::counting_contains_digest<this_type>(
+	  digest, this->bits, this->num_bins());
+      }
+
+      //? inserts every key in [start, end). Same result as
+      //? insert(start, end), but the bins of a group of keys are
+      //? prefetched together so their cache misses overlap.
+      template <typename InputIterator>
+      void insert_batch(const InputIterator start, const InputIterator end)
+      {
+	detail::counting_update_batch<apply_hash_type, this_type>(
+	  start, end, this->bits, this->num_bins(),
+	  detail::increment(this->population),
+	  (static_cast<size_t>(1) << BitsPerBin) - 1);
+      }
+
+      //? tests every key in [start, end). Bit i % 64 of out[i / 64] is
+      //? set if the i-th key is probably contained, so out must have
+      //? room for (std::distance(start, end) + 63) / 64 words. Returns
+      //? the number of keys that are probably contained.
+      template <typename InputIterator>
+      size_t probably_contains_batch(const InputIterator start,
+				     const InputIterator end,
+				     boost::uint64_t *const out) const
+      {
+	return detail::counting_contains_batch<apply_hash_type, this_type>(
+	  start, end, this->bits, this->num_bins(), out);
+      }
+
       //! auxiliary ops
       void clear()
       {
@@ -245,6 +297,7 @@ namespace boost {
 	     i != end; ++i) {
 	  *i = 0;
 	}
+	this->population = 0;
       }
 
       void swap(twohash_counting_bloom_filter& other)
@@ -258,27 +311,57 @@ namespace boost {
       template <typename _T, size_t _Bins, size_t _BitsPerBin,
 		size_t _HashValues, size_t _ExpectedInsertionCount,
 		class _HashFn1, class _HashFn2, class _ExtFn,
-		typename _Block>
+		typename _Block,
+		typename _Reduction>
       friend bool      
       operator==(const twohash_counting_bloom_filter<_T, _Bins, _BitsPerBin,
 						     _HashValues, 
 						     _ExpectedInsertionCount,
 						     _HashFn1, _HashFn2, _ExtFn, 
-						     _Block>& lhs,
+						     _Block,
+						     _Reduction>& lhs,
 		 const twohash_counting_bloom_filter<_T, _Bins, _BitsPerBin,
 						     _HashValues, 
 						     _ExpectedInsertionCount,
 						     _HashFn1, _HashFn2, _ExtFn, 
-						     _Block>& rhs);
+						     _Block,
+						     _Reduction>& rhs);
 
     private:
+      //* serialization
+      friend struct detail::filter_access;
+
+      detail::filter_header header() const
+      {
+	return detail::make_header<HashFunction1, Reduction,
+				   mpl::vector<HashFunction2,
+					       ExtensionFunction> >(
+	  detail::twohash_bins, sizeof(Block), BitsPerBin,
+	  num_hash_functions(), NumBins);
+      }
+
+      void reshape(const detail::filter_header& saved, bool)
+      {
+	detail::check_header(saved, this->header());
+      }
+
+      bucket_type& block_storage() { return this->bits; }
+
+      void recount()
+      {
+	this->population =
+	  detail::count_nonzero_bins<this_type>(this->bits, NumBins);
+      }
+
       bucket_type bits;
+      size_t population;
     };
 
     template <typename T, size_t NumBins, size_t BitsPerBin,
 	      size_t HashValues, size_t ExpectedInsertionCount,
 	      class HashFunction1, class HashFunction2,
-	      class ExtensionFunction, typename Block>
+	      class ExtensionFunction, typename Block,
+	      typename Reduction>
     void
     swap(twohash_counting_bloom_filter<T, NumBins, 
 				       BitsPerBin, 
@@ -287,7 +370,8 @@ namespace boost {
 				       HashFunction1, 
 				       HashFunction2,
 				       ExtensionFunction, 
-				       Block>& lhs,
+				       Block,
+				       Reduction>& lhs,
 	 twohash_counting_bloom_filter<T, NumBins, 
 				       BitsPerBin, 
 				       HashValues,
@@ -295,7 +379,8 @@ namespace boost {
 				       HashFunction1, 
 				       HashFunction2,
 				       ExtensionFunction, 
-				       Block>& rhs)
+				       Block,
+				       Reduction>& rhs)
     {
       lhs.swap(rhs);
     }
@@ -303,7 +388,8 @@ namespace boost {
     template <typename T, size_t NumBins, size_t BitsPerBin,
 	      size_t HashValues, size_t ExpectedInsertionCount,
 	      class HashFunction1, class HashFunction2,
-	      class ExtensionFunction, typename Block>
+	      class ExtensionFunction, typename Block,
+	      typename Reduction>
     bool
     operator==(const twohash_counting_bloom_filter<T, NumBins, 
 						   BitsPerBin, 
@@ -312,7 +398,8 @@ namespace boost {
 						   HashFunction1, 
 						   HashFunction2,
 						   ExtensionFunction, 
-						   Block>& lhs,
+						   Block,
+						   Reduction>& lhs,
 	       const twohash_counting_bloom_filter<T, NumBins, 
 						   BitsPerBin, 
 						   HashValues,
@@ -320,7 +407,8 @@ namespace boost {
 						   HashFunction1, 
 						   HashFunction2,
 						   ExtensionFunction, 
-						   Block>& rhs)
+						   Block,
+						   Reduction>& rhs)
     {
       return (lhs.bits == rhs.bits);
     }
@@ -328,7 +416,8 @@ namespace boost {
     template <typename T, size_t NumBins, size_t BitsPerBin,
 	      size_t HashValues, size_t ExpectedInsertionCount,
 	      class HashFunction1, class HashFunction2,
-	      class ExtensionFunction, typename Block>
+	      class ExtensionFunction, typename Block,
+	      typename Reduction>
     bool
     operator!=(const twohash_counting_bloom_filter<T, NumBins, 
 						   BitsPerBin, 
@@ -337,7 +426,8 @@ namespace boost {
 						   HashFunction1, 
 						   HashFunction2,
 						   ExtensionFunction, 
-						   Block>& lhs,
+						   Block,
+						   Reduction>& lhs,
 	       const twohash_counting_bloom_filter<T, NumBins, 
 						   BitsPerBin, 
 						   HashValues,
@@ -345,7 +435,8 @@ namespace boost {
 						   HashFunction1, 
 						   HashFunction2,
 						   ExtensionFunction, 
-						   Block>& rhs)
+						   Block,
+						   Reduction>& rhs)
     {
       return !(lhs == rhs);
     }
@@ -13,15 +13,25 @@
 #ifndef BOOST_BLOOM_FILTER_TWOHASH_DYNAMIC_BASIC_BLOOM_FILTER_HPP
 #define BOOST_BLOOM_FILTER_TWOHASH_DYNAMIC_BASIC_BLOOM_FILTER_HPP 1
 
-#include <cmath>
+#include <algorithm>
+#include <utility>
 
 #include <boost/config.hpp>
+#include <boost/cstdint.hpp>
 #include <boost/dynamic_bitset.hpp>
+#include <boost/static_assert.hpp>
 
 #include <boost/bloom_filter/hash/default.hpp>
 #include <boost/bloom_filter/hash/murmurhash3.hpp>
+#include <boost/bloom_filter/reduction.hpp>
 #include <boost/bloom_filter/detail/extenders.hpp>
 #include <boost/bloom_filter/detail/twohash_apply_hash.hpp>
+#include <boost/bloom_filter/detail/batch.hpp>
+#include <boost/bloom_filter/detail/combine.hpp>
+#include <boost/bloom_filter/detail/filter_header.hpp>
+#include <boost/bloom_filter/detail/fold.hpp>
+#include <boost/bloom_filter/detail/population.hpp>
+#include <boost/bloom_filter/detail/hash_digest.hpp>
 #include <boost/bloom_filter/detail/exceptions.hpp>
 
 namespace boost {
@@ -33,8 +43,12 @@ namespace boost {
 	      class HashFunction2 = murmurhash3<T>, 
 	      typename ExtensionFunction = detail::square,
 	      typename Block = size_t,
-	      typename Allocator = std::allocator<Block> >// = ???
-    class twohash_dynamic_basic_bloom_filter {
+	      typename Allocator = std::allocator<Block>,
+	      class Reduction = modulo_reduction>
+    class twohash_dynamic_basic_bloom_filter
+      : public detail::twohash_hash_values<HashValues> {
+      typedef detail::twohash_hash_values<HashValues> hash_values_type;
+
     public:
       typedef T value_type;
       typedef T key_type;
@@ -44,6 +58,7 @@ namespace boost {
       typedef HashFunction1 hash_function1_type;
       typedef HashFunction2 hash_function2_type;
       typedef ExtensionFunction extension_function_type;
+      typedef Reduction reduction_type;
       typedef twohash_dynamic_basic_bloom_filter<T, 
 						 HashValues,
 						 ExpectedInsertionCount,
@@ -51,7 +66,8 @@ namespace boost {
 						 HashFunction2,
 						 ExtensionFunction,
 						 Block,
-						 Allocator> this_type;
+						 Allocator,
+						 Reduction> this_type;
 
       static const size_t default_size = 32;
 
@@ -59,56 +75,100 @@ namespace boost {
       typedef detail::twohash_apply_hash<HashValues,
 					 this_type> apply_hash_type;
 
+      static size_t hash_values_for_size(const size_t size)
+      {
+	return detail::twohash_hash_count_for_size<
+	  HashValues, ExpectedInsertionCount>(size);
+      }
+
     public:
       //* constructors
       twohash_dynamic_basic_bloom_filter()
-	: bits(default_size)
+	: hash_values_type(hash_values_for_size(default_size)),
+	  bits(default_size),
+	  population(0)
       {
       }
 
       explicit twohash_dynamic_basic_bloom_filter(const size_t size)
-	: bits(size)
+	: hash_values_type(hash_values_for_size(size)),
+	  bits(detail::checked_range<Reduction>(size)),
+	  population(0)
+      {
+      }
+
+      //? sized to hold expected_insertions keys at no more than
+      //? false_positive_rate. With HashValues = runtime_hash_values
+      //? the number of hash values is chosen too, otherwise only the
+      //? size is.
+      twohash_dynamic_basic_bloom_filter(const size_t expected_insertions,
+					 const double false_positive_rate)
+	: hash_values_type(
+	    detail::twohash_hash_count<HashValues>(false_positive_rate)),
+	  bits(detail::bit_count_for<Reduction>(expected_insertions,
+						false_positive_rate,
+						this->num_hash_functions())),
+	  population(0)
       {
       }
 
       template <typename InputIterator>
       twohash_dynamic_basic_bloom_filter(const InputIterator start, 
 				 const InputIterator end)
-	: bits(std::distance(start, end) * 4)
+	: hash_values_type(hash_values_for_size(
+	    detail::range_for<Reduction>(std::distance(start, end) * 4))),
+	  bits(detail::range_for<Reduction>(std::distance(start, end) * 4)),
+	  population(0)
       {
 	for (InputIterator i = start; i != end; ++i)
 	  this->insert(*i);
       }
 
+      twohash_dynamic_basic_bloom_filter(
+	const twohash_dynamic_basic_bloom_filter& other)
+	: hash_values_type(other),
+	  bits(other.bits),
+	  population(other.population)
+      {
+      }
+
+#ifndef BOOST_NO_CXX11_RVALUE_REFERENCES
+      //? takes the bits of other, leaving it with none
+      twohash_dynamic_basic_bloom_filter(
+	twohash_dynamic_basic_bloom_filter&& other) BOOST_NOEXCEPT
+	: hash_values_type(other),
+	  population(other.population)
+      {
+	this->bits.swap(other.bits);
+	other.population = 0;
+      }
+#endif
+
       //* meta-ops
       size_t bit_capacity() const
       {
 	return bits.size();
       }
 
-      static BOOST_CONSTEXPR size_t num_hash_functions()
-      {
-	return HashValues;
-      }
+      //? num_hash_functions() is static for a fixed HashValues, and a
+      //? const member function with runtime_hash_values
 
       static BOOST_CONSTEXPR size_t expected_insertion_count()
       {
 	return ExpectedInsertionCount;
       }
 
+      //? estimated from count(), so as cheap to ask
       double false_positive_rate() const
       {
-        const double n = static_cast<double>(this->bits.count());
-        static const double k = static_cast<double>(HashValues);
-        static const double m = static_cast<double>(this->bit_capacity());
-        static const double e =
-	  2.718281828459045235360287471352662497757247093699959574966;
-        return std::pow(1 - std::pow(e, -k * n / m), k);
+	return detail::estimated_fpr(this->count(), this->bit_capacity(),
+				     this->num_hash_functions());
       }
 
+      //? the number of bits set; kept as keys go in, so free to ask
       size_t count() const
       {
-	return this->bits.count();
+	return this->population;
       }
 
       bool empty() const
@@ -125,7 +185,8 @@ namespace boost {
       //* core ops
       void insert(const T& t)
       {
-	apply_hash_type::insert(t, bits);
+	this->population +=
+	  apply_hash_type::insert(t, this->num_hash_functions(), bits);
       }
 
       template <typename InputIterator>
@@ -138,39 +199,156 @@ namespace boost {
 
       bool probably_contains(const T& t) const
       {
-	return apply_hash_type::contains(t, bits);
+	return apply_hash_type::contains(t, this->num_hash_functions(), bits);
+      }
+
+      //* pre-hashed ops
+      //? the unreduced hash values of a key. A digest can be passed to
+      //? insert_hash() and probably_contains_hash() of any filter with
+      //? the same key type and hashing, whatever its size, so a key
+      //? probed against many filters is hashed only once. With
+      //? runtime_hash_values a digest holds max_runtime_hash_values
+      //? values, of which a filter uses the first num_hash_functions().
+      typedef detail::hash_digest<apply_hash_type::num_positions> digest_type;
+
+      static digest_type hash_key(const T& t)
+      {
+	digest_type digest;
+	apply_hash_type::hashes(t, digest.values);
+	return digest;
+      }
+
+      void insert_hash(const digest_type& digest)
+      {
+	this->population += detail::bitset_insert_digest<reduction_type>(
+	  digest, bits, this->num_hash_functions());
+      }
+
+      bool probably_contains_hash(const digest_type& digest) const
+      {
+	return detail::bitset_contains_digest<reduction_type>(
+	  digest, bits, this->num_hash_functions());
+      }
+
+      //? inserts every key in [start, end). Same result as
+      //? insert(start, end), but the probes of a group of keys are
+      //? prefetched together so their cache misses overlap.
+      template <typename InputIterator>
+      void insert_batch(const InputIterator start, const InputIterator end)
+      {
+	this->population += detail::bitset_insert_batch<apply_hash_type>(
+	  start, end, bits, this->num_hash_functions());
+      }
+
+      //? tests every key in [start, end). Bit i % 64 of out[i / 64] is
+      //? set if the i-th key is probably contained, so out must have
+      //? room for (std::distance(start, end) + 63) / 64 words. Returns
+      //? the number of keys that are probably contained.
+      template <typename InputIterator>
+      size_t probably_contains_batch(const InputIterator start,
+				     const InputIterator end,
+				     boost::uint64_t *const out) const
+      {
+	return detail::bitset_contains_batch<apply_hash_type>(
+	  start, end, bits, out, this->num_hash_functions());
       }
 
       void clear()
       {
 	this->bits.reset();
+	this->population = 0;
       }
 
-      void swap(twohash_dynamic_basic_bloom_filter& other)
+      twohash_dynamic_basic_bloom_filter&
+      operator=(const twohash_dynamic_basic_bloom_filter& rhs)
       {
-	twohash_dynamic_basic_bloom_filter tmp = other;
-	other = *this;
-	*this = tmp;
+	this->bits = rhs.bits;
+	this->set_num_hash_functions(rhs.num_hash_functions());
+	this->population = rhs.population;
+	return *this;
+      }
+
+#ifndef BOOST_NO_CXX11_RVALUE_REFERENCES
+      //? takes the bits of rhs, leaving it with none
+      twohash_dynamic_basic_bloom_filter&
+      operator=(twohash_dynamic_basic_bloom_filter&& rhs) BOOST_NOEXCEPT
+      {
+	bitset_type released;
+	released.swap(this->bits);
+	this->bits.swap(rhs.bits);
+	this->set_num_hash_functions(rhs.num_hash_functions());
+	this->population = rhs.population;
+	rhs.population = 0;
+	return *this;
+      }
+#endif
+
+      //? exchanges the bits of the two filters; no bits are copied
+      void swap(twohash_dynamic_basic_bloom_filter& other) BOOST_NOEXCEPT
+      {
+	this->bits.swap(other.bits);
+	const size_t hash_values = this->num_hash_functions();
+	this->set_num_hash_functions(other.num_hash_functions());
+	other.set_num_hash_functions(hash_values);
+	std::swap(this->population, other.population);
       }
 
       //* pairwise ops
       twohash_dynamic_basic_bloom_filter& 
       operator|=(const twohash_dynamic_basic_bloom_filter& rhs)
       {
-	if (this->bit_capacity() != rhs.bit_capacity())
+	if (this->bit_capacity() != rhs.bit_capacity() ||
+	    this->num_hash_functions() != rhs.num_hash_functions())
 	  throw detail::incompatible_size_exception();
 
-	this->bits |= rhs.bits;
+	this->population = detail::combine_bits(this->bits, rhs.bits,
+						detail::combine_or);
 	return *this;
       }
 
       twohash_dynamic_basic_bloom_filter& 
       operator&=(const twohash_dynamic_basic_bloom_filter& rhs)
       {
-	if (this->bit_capacity() != rhs.bit_capacity())
+	if (this->bit_capacity() != rhs.bit_capacity() ||
+	    this->num_hash_functions() != rhs.num_hash_functions())
+	  throw detail::incompatible_size_exception();
+
+	this->population = detail::combine_bits(this->bits, rhs.bits,
+						detail::combine_and);
+	return *this;
+      }
+
+      //? as dynamic_bloom_filter::fold(); the number of hash values
+      //? stays what it was
+      void fold(const size_t factor)
+      {
+	BOOST_STATIC_ASSERT(detail::foldable<Reduction>::value);
+	if (factor == 0 || this->bit_capacity() % factor != 0)
 	  throw detail::incompatible_size_exception();
 
-	this->bits &= rhs.bits;
+	bitset_type folded(this->bit_capacity() / factor);
+	this->population = detail::fold_bits(folded, this->bits);
+	this->bits.swap(folded);
+      }
+
+      //? as dynamic_bloom_filter::fold_union()
+      twohash_dynamic_basic_bloom_filter&
+      fold_union(const twohash_dynamic_basic_bloom_filter& rhs)
+      {
+	BOOST_STATIC_ASSERT(detail::foldable<Reduction>::value);
+	if (this->num_hash_functions() != rhs.num_hash_functions())
+	  throw detail::incompatible_size_exception();
+
+	const size_t size = this->bit_capacity();
+	const size_t rhs_size = rhs.bit_capacity();
+	if (size != 0 && rhs_size % size == 0)
+	  this->population = detail::fold_bits(this->bits, rhs.bits);
+	else if (rhs_size != 0 && size % rhs_size == 0) {
+	  this->fold(size / rhs_size);
+	  *this |= rhs;
+	}
+	else
+	  throw detail::incompatible_size_exception();
 	return *this;
       }
 
@@ -179,7 +357,8 @@ namespace boost {
 	       class _HashFunction1,
 	       class _HashFunction2,
 	       class _ExtensionFunction,
-	       typename _Block, class _Allocator>
+	       typename _Block, class _Allocator,
+	       class _Reduction>
       friend bool
       operator==(const twohash_dynamic_basic_bloom_filter<_T, 
 		                                          _HashValues, 
@@ -188,7 +367,8 @@ namespace boost {
 						          _HashFunction2,
 		                                          _ExtensionFunction,
 		                                          _Block,
-		                                          _Allocator>&,
+		                                          _Allocator,
+		                                          _Reduction>&,
 		 const twohash_dynamic_basic_bloom_filter<_T, 
 		                                          _HashValues,
 						          _ExpectedInsertionCount,
@@ -196,10 +376,57 @@ namespace boost {
 						          _HashFunction2,
 		                                          _ExtensionFunction,
 		                                          _Block,
-		                                          _Allocator>&);
+		                                          _Allocator,
+		                                          _Reduction>&);
       
     private:
+      //* serialization
+      friend struct detail::filter_access;
+
+      static detail::filter_header header_for(const size_t bit_capacity,
+					      const size_t hash_values)
+      {
+	return detail::make_header<HashFunction1, Reduction,
+				   mpl::vector<HashFunction2,
+					       ExtensionFunction> >(
+	  detail::twohash_bits, sizeof(Block), 0, hash_values,
+	  bit_capacity);
+      }
+
+      detail::filter_header header() const
+      {
+	return header_for(this->bit_capacity(), this->num_hash_functions());
+      }
+
+      //? with runtime_hash_values the saved number of hash values
+      //? is taken on too
+      void reshape(const detail::filter_header& saved, bool)
+      {
+	const size_t capacity = static_cast<size_t>(saved.capacity);
+	const size_t k = HashValues == runtime_hash_values ?
+	  static_cast<size_t>(saved.hash_functions) : HashValues;
+	if (k == 0 || k > detail::max_runtime_hash_values)
+	  throw detail::serialization_exception();
+	detail::check_header(saved, header_for(capacity, k));
+	detail::checked_range<Reduction>(capacity);
+
+	if (this->bit_capacity() != capacity) {
+	  this->bits.clear();
+	  this->bits.resize(capacity);
+	  this->population = 0;
+	}
+	this->set_num_hash_functions(k);
+      }
+
+      bitset_type& block_storage() { return this->bits; }
+
+      void recount()
+      {
+	this->population = detail::count_bits(this->bits);
+      }
+
       bitset_type bits;
+      size_t population;
     };
 
     //* global ops
@@ -207,7 +434,8 @@ namespace boost {
 	     size_t ExpectedInsertionCount,
 	     class HashFunction1,
 	     class HashFunction2, class ExtensionFunction,
-	     typename Block, class Allocator>
+	     typename Block, class Allocator,
+	     class Reduction>
     bool
     operator==(const twohash_dynamic_basic_bloom_filter<T, 
 	       	       	       	       	       	        HashValues,
@@ -216,7 +444,8 @@ namespace boost {
 	                                                HashFunction2,
 	                                                ExtensionFunction,
 	                                                Block, 
-	                                                Allocator>& lhs,
+	                                                Allocator,
+	                                                Reduction>& lhs,
 	       const twohash_dynamic_basic_bloom_filter<T, 
 	                                        HashValues,
 						ExpectedInsertionCount,
@@ -224,9 +453,11 @@ namespace boost {
 						HashFunction2,
 	                                        ExtensionFunction,
 	                                        Block,
-	                                        Allocator>& rhs)
+	                                        Allocator,
+	                                        Reduction>& rhs)
     {
-	if (lhs.bit_capacity() != rhs.bit_capacity())
+	if (lhs.bit_capacity() != rhs.bit_capacity() ||
+	    lhs.num_hash_functions() != rhs.num_hash_functions())
 	  throw detail::incompatible_size_exception();
 
       return lhs.bits == rhs.bits;
@@ -236,7 +467,8 @@ namespace boost {
 	     size_t ExpectedInsertionCount,
 	     class HashFunction1,
 	     class HashFunction2, class ExtensionFunction,
-	     typename Block, class Allocator>
+	     typename Block, class Allocator,
+	     class Reduction>
     bool
     operator!=(const twohash_dynamic_basic_bloom_filter<T, 
 	       	       	       	       	       	        HashValues,
@@ -245,7 +477,8 @@ namespace boost {
 	                                                HashFunction2,
 	                                                ExtensionFunction,
 	                                                Block, 
-	                                                Allocator>& lhs,
+	                                                Allocator,
+	                                                Reduction>& lhs,
 	       const twohash_dynamic_basic_bloom_filter<T, 
 	                                                HashValues,
 						        ExpectedInsertionCount,
@@ -253,7 +486,8 @@ namespace boost {
 						        HashFunction2,
 	                                                ExtensionFunction,
 	                                                Block,
-	                                                Allocator>& rhs)
+	                                                Allocator,
+	                                                Reduction>& rhs)
     {
       return !(lhs == rhs);
     }
@@ -262,13 +496,14 @@ namespace boost {
 	     size_t ExpectedInsertionCount,
 	     class HashFunction1,
 	     class HashFunction2, class ExtensionFunction,
-	     typename Block, class Allocator>
+	     typename Block, class Allocator,
+	     class Reduction>
     twohash_dynamic_basic_bloom_filter<T, 
 				       HashValues,
 				       ExpectedInsertionCount,
 				       HashFunction1, 
 				       HashFunction2, ExtensionFunction,
-				       Block, Allocator>
+				       Block, Allocator, Reduction>
     operator|(const twohash_dynamic_basic_bloom_filter<T, 
 	                                               HashValues,
 	                                               ExpectedInsertionCount,
@@ -276,7 +511,8 @@ namespace boost {
 	                                               HashFunction2,
 	                                               ExtensionFunction,
 	                                               Block,
-	                                               Allocator>& lhs,
+	                                               Allocator,
+	                                               Reduction>& lhs,
 	      const twohash_dynamic_basic_bloom_filter<T, 
 	                                               HashValues,
 	                                               ExpectedInsertionCount,
@@ -284,14 +520,16 @@ namespace boost {
 	                                               HashFunction2,
 	                                               ExtensionFunction,
 	                                               Block,
-	                                               Allocator>& rhs)
+	                                               Allocator,
+	                                               Reduction>& rhs)
     {
       twohash_dynamic_basic_bloom_filter<T, HashValues,
 					 ExpectedInsertionCount,
 					 HashFunction1, HashFunction2,
 					 ExtensionFunction,
 					 Block,
-					 Allocator> result(lhs);
+					 Allocator,
+					 Reduction> result(lhs);
       
       result |= rhs;
       return result;
@@ -301,13 +539,14 @@ namespace boost {
 	     size_t ExpectedInsertionCount,
 	     class HashFunction1,
 	     class HashFunction2, class ExtensionFunction,
-	     typename Block, class Allocator>
+	     typename Block, class Allocator,
+	     class Reduction>
     twohash_dynamic_basic_bloom_filter<T, 
 				       HashValues,
 				       ExpectedInsertionCount,
 				       HashFunction1, 
 				       HashFunction2, ExtensionFunction,
-				       Block, Allocator>
+				       Block, Allocator, Reduction>
     operator&(const twohash_dynamic_basic_bloom_filter<T, 
 	                                               HashValues,
 	                                               ExpectedInsertionCount,
@@ -315,7 +554,8 @@ namespace boost {
 	                                               HashFunction2,
 	                                               ExtensionFunction,
 	                                               Block,
-	                                               Allocator>& lhs,
+	                                               Allocator,
+	                                               Reduction>& lhs,
 	      const twohash_dynamic_basic_bloom_filter<T, 
 	                                               HashValues,
 	                                               ExpectedInsertionCount,
@@ -323,24 +563,101 @@ namespace boost {
 	                                               HashFunction2,
 	                                               ExtensionFunction,
 	                                               Block,
-	                                               Allocator>& rhs)
+	                                               Allocator,
+	                                               Reduction>& rhs)
     {
       twohash_dynamic_basic_bloom_filter<T, HashValues,
 					 ExpectedInsertionCount,
 					 HashFunction1, HashFunction2,
 					 ExtensionFunction,
 					 Block,
-					 Allocator> result(lhs);
+					 Allocator,
+					 Reduction> result(lhs);
       
       result &= rhs;
       return result;
     }
 
+#ifndef BOOST_NO_CXX11_RVALUE_REFERENCES
+    //? the result takes the bits of lhs instead of copying them, so
+    //? a | b | c copies only once
+    template<class T, size_t HashValues, 
+	     size_t ExpectedInsertionCount,
+	     class HashFunction1,
+	     class HashFunction2, class ExtensionFunction,
+	     typename Block, class Allocator,
+	     class Reduction>
+    twohash_dynamic_basic_bloom_filter<T, 
+				       HashValues,
+				       ExpectedInsertionCount,
+				       HashFunction1, 
+				       HashFunction2, ExtensionFunction,
+				       Block, Allocator, Reduction>
+    operator|(twohash_dynamic_basic_bloom_filter<T, 
+	                                         HashValues,
+	                                         ExpectedInsertionCount,
+	                                         HashFunction1,
+	                                         HashFunction2,
+	                                         ExtensionFunction,
+	                                         Block,
+	                                         Allocator,
+	                                         Reduction>&& lhs,
+	      const twohash_dynamic_basic_bloom_filter<T, 
+	                                               HashValues,
+	                                               ExpectedInsertionCount,
+	                                               HashFunction1,
+	                                               HashFunction2,
+	                                               ExtensionFunction,
+	                                               Block,
+	                                               Allocator,
+	                                               Reduction>& rhs)
+    {
+      lhs |= rhs;
+      return std::move(lhs);
+    }
+
+    template<class T, size_t HashValues, 
+	     size_t ExpectedInsertionCount,
+	     class HashFunction1,
+	     class HashFunction2, class ExtensionFunction,
+	     typename Block, class Allocator,
+	     class Reduction>
+    twohash_dynamic_basic_bloom_filter<T, 
+				       HashValues,
+				       ExpectedInsertionCount,
+				       HashFunction1, 
+				       HashFunction2, ExtensionFunction,
+				       Block, Allocator, Reduction>
+    operator&(twohash_dynamic_basic_bloom_filter<T, 
+	                                         HashValues,
+	                                         ExpectedInsertionCount,
+	                                         HashFunction1,
+	                                         HashFunction2,
+	                                         ExtensionFunction,
+	                                         Block,
+	                                         Allocator,
+	                                         Reduction>&& lhs,
+	      const twohash_dynamic_basic_bloom_filter<T, 
+	                                               HashValues,
+	                                               ExpectedInsertionCount,
+	                                               HashFunction1,
+	                                               HashFunction2,
+	                                               ExtensionFunction,
+	                                               Block,
+	                                               Allocator,
+	                                               Reduction>& rhs)
+    {
+      lhs &= rhs;
+      return std::move(lhs);
+    }
+#endif
+
     template<class T, size_t Size, size_t HashValues, 
 	     size_t ExpectedInsertionCount, 
 	     class HashFunction1,
 	     class HashFunction2, class ExtensionFunction,
-	     typename Block, class Allocator>
+	     typename Block, class Allocator,
+	     class Reduction>
     void swap(twohash_dynamic_basic_bloom_filter<T, 
 	                                         HashValues,
 	                                         ExpectedInsertionCount,
@@ -348,7 +665,8 @@ namespace boost {
 	                                         HashFunction2,
 	                                         ExtensionFunction,
 	                                         Block,
-	                                         Allocator>& lhs,
+	                                         Allocator,
+	                                         Reduction>& lhs,
 	      twohash_dynamic_basic_bloom_filter<T, 
 	                                         HashValues,
 	                                         ExpectedInsertionCount,
@@ -356,9 +674,10 @@ namespace boost {
 	                                         HashFunction2,
 	                                         ExtensionFunction,
 	                                         Block,
-	                                         Allocator>& rhs)
+	                                         Allocator,
+	                                         Reduction>& rhs) BOOST_NOEXCEPT
     {
-      return lhs.swap(rhs);
+      lhs.swap(rhs);
     }
   } // namespace bloom_filters
 } // namespace boost
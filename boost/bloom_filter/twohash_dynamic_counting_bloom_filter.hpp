@@ -10,22 +10,29 @@
 //
 //////////////////////////////////////////////////////////////////////////////
 
-#ifndef BOOST_BLOOM_FILTER_DYNAMIC_COUNTING_BLOOM_FILTER_HPP
-#define BOOST_BLOOM_FILTER_DYNAMIC_COUNTING_BLOOM_FILTER_HPP 1
+#ifndef BOOST_BLOOM_FILTER_TWOHASH_DYNAMIC_COUNTING_BLOOM_FILTER_HPP
+#define BOOST_BLOOM_FILTER_TWOHASH_DYNAMIC_COUNTING_BLOOM_FILTER_HPP 1
 
-#include <cmath>
+#include <algorithm>
+#include <utility>
 #include <vector>
 
 #include <boost/config.hpp>
+#include <boost/cstdint.hpp>
 
 #include <boost/static_assert.hpp>
 #include <boost/type_traits/is_integral.hpp>
 #include <boost/type_traits/is_unsigned.hpp>
 
 #include <boost/bloom_filter/detail/twohash_counting_apply_hash.hpp>
+#include <boost/bloom_filter/detail/batch.hpp>
+#include <boost/bloom_filter/detail/filter_header.hpp>
+#include <boost/bloom_filter/detail/hash_digest.hpp>
+#include <boost/bloom_filter/detail/population.hpp>
 #include <boost/bloom_filter/detail/extenders.hpp>
 #include <boost/bloom_filter/hash/default.hpp>
 #include <boost/bloom_filter/hash/murmurhash3.hpp>
+#include <boost/bloom_filter/reduction.hpp>
 
 namespace boost {
   namespace bloom_filters {
@@ -37,8 +44,11 @@ namespace boost {
 	      class HashFunction2 = murmurhash3<T>,
 	      class ExtensionFunction = detail::square,
 	      typename Block = size_t,
-	      typename Allocator = std::allocator<Block> >
-    class twohash_dynamic_counting_bloom_filter {
+	      typename Allocator = std::allocator<Block>,
+	      class Reduction = modulo_reduction>
+    class twohash_dynamic_counting_bloom_filter
+      : public detail::twohash_hash_values<HashValues> {
+      typedef detail::twohash_hash_values<HashValues> hash_values_type;
 
       // Block needs to be an integral type
       BOOST_STATIC_ASSERT( boost::is_integral<Block>::value == true);
@@ -71,13 +81,15 @@ namespace boost {
       typedef ExtensionFunction extension_function_type;
       typedef Block block_type;
       typedef Allocator allocator_type;
+      typedef Reduction reduction_type;
       typedef twohash_dynamic_counting_bloom_filter<T, BitsPerBin,
 						    HashValues,
 						    ExpectedInsertionCount,
 						    HashFunction1,
 						    HashFunction2,
 						    ExtensionFunction,
-						    Block, Allocator> this_type;
+						    Block, Allocator,
+						    Reduction> this_type;
 
       typedef std::vector<Block, Allocator> bucket_type;
       typedef typename bucket_type::iterator bucket_iterator;
@@ -96,30 +108,83 @@ namespace boost {
       typedef detail::twohash_counting_apply_hash<HashValues,
 						  this_type> apply_hash_type;
 
+      static size_t hash_values_for_size(const size_t num_bins)
+      {
+	return detail::twohash_hash_count_for_size<
+	  HashValues, ExpectedInsertionCount>(num_bins);
+      }
+
     public:
       //! constructors
       twohash_dynamic_counting_bloom_filter() 
-	: bits(bucket_size(default_num_bins)),
-	  _num_bins(default_num_bins)
+	: hash_values_type(hash_values_for_size(default_num_bins)),
+	  bits(bucket_size(default_num_bins)),
+	  _num_bins(default_num_bins),
+	  population(0)
       {
       }
 
       explicit twohash_dynamic_counting_bloom_filter(const size_t requested_bins)
-	: bits(bucket_size(requested_bins)),
-	  _num_bins(requested_bins)
+	: hash_values_type(hash_values_for_size(requested_bins)),
+	  bits(bucket_size(detail::checked_range<Reduction>(requested_bins))),
+	  _num_bins(requested_bins),
+	  population(0)
+      {
+      }
+
+      //? sized to hold expected_insertions keys at no more than
+      //? false_positive_rate, one bin per bit of the equivalent
+      //? twohash_dynamic_basic_bloom_filter. With HashValues =
+      //? runtime_hash_values the number of hash values is chosen too.
+      twohash_dynamic_counting_bloom_filter(const size_t expected_insertions,
+					    const double false_positive_rate)
+	: hash_values_type(
+	    detail::twohash_hash_count<HashValues>(false_positive_rate)),
+	  population(0)
       {
+	this->_num_bins = detail::bit_count_for<Reduction>(
+	  expected_insertions, false_positive_rate,
+	  this->num_hash_functions());
+	this->bits.resize(bucket_size(this->_num_bins));
       }
 
       template <typename InputIterator>
       twohash_dynamic_counting_bloom_filter(const InputIterator start, 
 					    const InputIterator end) 
-	: bits(bucket_size(std::distance(start, end) * 4)),
-	  _num_bins(std::distance(start, end) * 4)
+	: hash_values_type(hash_values_for_size(
+	    detail::range_for<Reduction>(std::distance(start, end) * 4))),
+	  bits(bucket_size(
+	    detail::range_for<Reduction>(std::distance(start, end) * 4))),
+	  _num_bins(detail::range_for<Reduction>(std::distance(start, end) * 4)),
+	  population(0)
       {
 	for (InputIterator i = start; i != end; ++i)
 	  this->insert(*i);
       }
 
+      twohash_dynamic_counting_bloom_filter(
+	const twohash_dynamic_counting_bloom_filter& other)
+	: hash_values_type(other),
+	  bits(other.bits),
+	  _num_bins(other._num_bins),
+	  population(other.population)
+      {
+      }
+
+#ifndef BOOST_NO_CXX11_RVALUE_REFERENCES
+      //? takes the bins of other, leaving it with none
+      twohash_dynamic_counting_bloom_filter(
+	twohash_dynamic_counting_bloom_filter&& other) BOOST_NOEXCEPT
+	: hash_values_type(other),
+	  _num_bins(other._num_bins),
+	  population(other.population)
+      {
+	this->bits.swap(other.bits);
+	other._num_bins = 0;
+	other.population = 0;
+      }
+#endif
+
       //! meta functions
       size_t num_bins() const
       {
@@ -151,39 +216,21 @@ namespace boost {
         return this->num_bins() * BitsPerBin;
       }
 
-      static BOOST_CONSTEXPR size_t num_hash_functions() 
-      {
-        return HashValues;
-      }
+      //? num_hash_functions() is static for a fixed HashValues, and a
+      //? const member function with runtime_hash_values
 
+      //? estimated from count(), so as cheap to ask
       double false_positive_rate() const 
       {
-        const double n = static_cast<double>(this->count());
-        static const double k = static_cast<double>(num_hash_functions());
-        static const double m = static_cast<double>(this->num_bins());
-        static const double e =
-	  2.718281828459045235360287471352662497757247093699959574966;
-        return std::pow(1 - std::pow(e, -k * n / m), k);
+	return detail::estimated_fpr(this->count(), this->num_bins(),
+				     this->num_hash_functions());
       }
 
-      //? returns the number of bins that have at least 1 bit set
+      //? returns the number of bins that have at least 1 bit set; kept
+      //? as keys go in and out, so free to ask
       size_t count() const 
       {
-	size_t ret = 0;
-
-	for (bucket_const_iterator i = this->bits.begin(), 
-	       end = this->bits.end(); 
-	     i != end; ++i) {
-	  for (size_t bin = 0; bin < this->bins_per_slot(); ++bin) {
-	    const size_t offset_bits = bin * BitsPerBin;
-	    const size_t target_bits = (*i >> offset_bits) & this->mask();
-
-	    if (target_bits > 0)
-	      ++ret;
-	  }
-	}
-
-        return ret;
+        return this->population;
       }
 
       bool empty() const
@@ -202,7 +249,9 @@ namespace boost {
       {
 	apply_hash_type::insert(t, 
 				this->bits,
-				this->num_bins());
+				this->num_bins(),
+				this->population,
+				this->num_hash_functions());
       }
 
       template <typename InputIterator>
@@ -217,7 +266,9 @@ namespace boost {
       {
 	apply_hash_type::remove(t, 
 				this->bits,
-				this->num_bins());
+				this->num_bins(),
+				this->population,
+				this->num_hash_functions());
       }
 
       template <typename InputIterator>
@@ -232,7 +283,75 @@ namespace boost {
       {
 	return apply_hash_type::contains(t,
 					 this->bits,
-					 this->num_bins());
+					 this->num_bins(),
+					 this->num_hash_functions());
+      }
+
+      //* pre-hashed ops
+      //? the unreduced hash values of a key. A digest can be passed to
+      //? insert_hash() and probably_contains_hash() of any filter with
+      //? the same key type and hashing, whatever its size, so a key
+      //? probed against many filters is hashed only once. With
+      //? runtime_hash_values a digest holds max_runtime_hash_values
+      //? values, of which a filter uses the first num_hash_functions().
+      typedef detail::hash_digest<apply_hash_type::num_positions> digest_type;
+
+      static digest_type hash_key(const T& t)
+      {
+	digest_type digest;
+	apply_hash_type::hashes(t, digest.values);
+	return digest;
+      }
+
+      void insert_hash(const digest_type& digest)
+      {
+	detail::counting_update_digest<this_type>(
+	  digest, this->bits, this->num_bins(),
+	  detail::increment(this->population),
+	  (static_cast<size_t>(1) << BitsPerBin) - 1,
+	  this->num_hash_functions());
+      }
+
+      void remove_hash(const digest_type& digest)
+      {
+	detail::counting_update_digest<this_type>(
+	  digest, this->bits, this->num_bins(),
+	  detail::decrement(this->population), 0,
+	  this->num_hash_functions());
+      }
+
+      bool probably_contains_hash(const digest_type& digest) const
+      {
+	return detail::counting_contains_digest<this_type>(
+	  digest, this->bits, this->num_bins(),
+	  this->num_hash_functions());
+      }
+
+      //? inserts every key in [start, end). Same result as
+      //? insert(start, end), but the bins of a group of keys are
+      //? prefetched together so their cache misses overlap.
+      template <typename InputIterator>
+      void insert_batch(const InputIterator start, const InputIterator end)
+      {
+	detail::counting_update_batch<apply_hash_type, this_type>(
+	  start, end, this->bits, this->num_bins(),
+	  detail::increment(this->population),
+	  (static_cast<size_t>(1) << BitsPerBin) - 1,
+	  this->num_hash_functions());
+      }
+
+      //? tests every key in [start, end). Bit i % 64 of out[i / 64] is
+      //? set if the i-th key is probably contained, so out must have
+      //? room for (std::distance(start, end) + 63) / 64 words. Returns
+      //? the number of keys that are probably contained.
+      template <typename InputIterator>
+      size_t probably_contains_batch(const InputIterator start,
+				     const InputIterator end,
+				     boost::uint64_t *const out) const
+      {
+	return detail::counting_contains_batch<apply_hash_type, this_type>(
+	  start, end, this->bits, this->num_bins(), out,
+	  this->num_hash_functions());
       }
 
       //! auxiliary ops
@@ -241,20 +360,53 @@ namespace boost {
 	for (bucket_iterator i = bits.begin(), end = bits.end();
 	     i != end; ++i)
 	  *i = 0;
+	this->population = 0;
       }
 
-      void swap(twohash_dynamic_counting_bloom_filter& other)
+      twohash_dynamic_counting_bloom_filter&
+      operator=(const twohash_dynamic_counting_bloom_filter& rhs)
       {
-	twohash_dynamic_counting_bloom_filter tmp = other;
-	other = *this;
-	*this = tmp;
+	this->bits = rhs.bits;
+	this->_num_bins = rhs._num_bins;
+	this->set_num_hash_functions(rhs.num_hash_functions());
+	this->population = rhs.population;
+	return *this;
+      }
+
+#ifndef BOOST_NO_CXX11_RVALUE_REFERENCES
+      //? takes the bins of rhs, leaving it with none
+      twohash_dynamic_counting_bloom_filter&
+      operator=(twohash_dynamic_counting_bloom_filter&& rhs) BOOST_NOEXCEPT
+      {
+	bucket_type released;
+	released.swap(this->bits);
+	this->bits.swap(rhs.bits);
+	this->_num_bins = rhs._num_bins;
+	this->set_num_hash_functions(rhs.num_hash_functions());
+	this->population = rhs.population;
+	rhs._num_bins = 0;
+	rhs.population = 0;
+	return *this;
+      }
+#endif
+
+      //? exchanges the bins of the two filters; no bins are copied
+      void swap(twohash_dynamic_counting_bloom_filter& other) BOOST_NOEXCEPT
+      {
+	this->bits.swap(other.bits);
+	std::swap(this->_num_bins, other._num_bins);
+	const size_t hash_values = this->num_hash_functions();
+	this->set_num_hash_functions(other.num_hash_functions());
+	other.set_num_hash_functions(hash_values);
+	std::swap(this->population, other.population);
       }
 
       // equality comparison operators
       template <typename _T, size_t _BitsPerBin,
 		size_t _HashValues, size_t _ExpectedInsertionCount,
 		class _HashFn1, class _HashFn2, class _Extender,
-		typename _Block, class _Allocator>
+		typename _Block, class _Allocator,
+		class _Reduction>
       friend bool
       operator==(const twohash_dynamic_counting_bloom_filter<_T, _BitsPerBin,
 							     _HashValues,
@@ -263,7 +415,8 @@ namespace boost {
 							     _HashFn2,
 							     _Extender,
 							     _Block,
-							     _Allocator>& lhs,
+							     _Allocator,
+							     _Reduction>& lhs,
 		 const twohash_dynamic_counting_bloom_filter<_T, _BitsPerBin,
 							     _HashValues,
 							     _ExpectedInsertionCount,
@@ -271,12 +424,14 @@ namespace boost {
 							     _HashFn2,
 							     _Extender,
 							     _Block,
-							     _Allocator>& rhs);
+							     _Allocator,
+							     _Reduction>& rhs);
 
       template <typename _T, size_t _BitsPerBin,
 		size_t _HashValues, size_t _ExpectedInsertionCount,
 		class _HashFn1, class _HashFn2, class _Extender,
-		typename _Block, class _Allocator>
+		typename _Block, class _Allocator,
+		class _Reduction>
       friend bool
       operator!=(const twohash_dynamic_counting_bloom_filter<_T, _BitsPerBin,
 							     _HashValues,
@@ -285,7 +440,8 @@ namespace boost {
 							     _HashFn2,
 							     _Extender,
 							     _Block,
-							     _Allocator>& lhs,
+							     _Allocator,
+							     _Reduction>& lhs,
 		 const twohash_dynamic_counting_bloom_filter<_T, _BitsPerBin,
 							     _HashValues,
 							     _ExpectedInsertionCount,
@@ -293,18 +449,68 @@ namespace boost {
 							     _HashFn2,
 							     _Extender,
 							     _Block,
-							     _Allocator>& rhs);
+							     _Allocator,
+							     _Reduction>& rhs);
 
     private:
+      //* serialization
+      friend struct detail::filter_access;
+
+      static detail::filter_header header_for(const size_t bins,
+					      const size_t hash_values)
+      {
+	return detail::make_header<HashFunction1, Reduction,
+				   mpl::vector<HashFunction2,
+					       ExtensionFunction> >(
+	  detail::twohash_bins, sizeof(Block), BitsPerBin, hash_values,
+	  bins);
+      }
+
+      detail::filter_header header() const
+      {
+	return header_for(this->num_bins(), this->num_hash_functions());
+      }
+
+      //? with runtime_hash_values the saved number of hash values
+      //? is taken on too
+      void reshape(const detail::filter_header& saved, bool)
+      {
+	const size_t bins = static_cast<size_t>(saved.capacity);
+	const size_t k = HashValues == runtime_hash_values ?
+	  static_cast<size_t>(saved.hash_functions) : HashValues;
+	if (k == 0 || k > detail::max_runtime_hash_values)
+	  throw detail::serialization_exception();
+	detail::check_header(saved, header_for(bins, k));
+	detail::checked_range<Reduction>(bins);
+
+	if (this->num_bins() != bins) {
+	  bucket_type fresh(bucket_size(bins));
+	  this->bits.swap(fresh);
+	  this->population = 0;
+	}
+	this->_num_bins = bins;
+	this->set_num_hash_functions(k);
+      }
+
+      bucket_type& block_storage() { return this->bits; }
+
+      void recount()
+      {
+	this->population =
+	  detail::count_nonzero_bins<this_type>(this->bits, this->num_bins());
+      }
+
       bucket_type bits;
       size_t _num_bins;
+      size_t population;
     };
 
     template<class T, size_t BitsPerBin, size_t HashValues,
 	     size_t ExpectedInsertionCount,
 	     class HashFunction1, class HashFunction2,
 	     class ExtensionFunction, typename Block,
-	     class Allocator>
+	     class Allocator,
+	     class Reduction>
     void
     swap(twohash_dynamic_counting_bloom_filter<T, BitsPerBin,
 					       HashValues,
@@ -313,7 +519,8 @@ namespace boost {
 					       HashFunction2,
 					       ExtensionFunction,
 					       Block,
-					       Allocator>& lhs,
+					       Allocator,
+					       Reduction>& lhs,
 	 twohash_dynamic_counting_bloom_filter<T, BitsPerBin,
 					       HashValues,
 					       ExpectedInsertionCount,
@@ -321,8 +528,8 @@ namespace boost {
 					       HashFunction2,
 					       ExtensionFunction,
 					       Block,
-					       Allocator>& rhs)
-
+					       Allocator,
+					       Reduction>& rhs) BOOST_NOEXCEPT
     {
       lhs.swap(rhs);
     }
@@ -331,7 +538,8 @@ namespace boost {
 	     size_t ExpectedInsertionCount,
 	     class HashFunction1, class HashFunction2,
 	     class ExtensionFunction, typename Block,
-	     class Allocator>
+	     class Allocator,
+	     class Reduction>
     bool
     operator==(const twohash_dynamic_counting_bloom_filter<T, BitsPerBin,
 							   HashValues,
@@ -340,7 +548,8 @@ namespace boost {
 							   HashFunction2,
 							   ExtensionFunction,
 							   Block,
-							   Allocator>& lhs,
+							   Allocator,
+							   Reduction>& lhs,
 	       const twohash_dynamic_counting_bloom_filter<T, BitsPerBin,
 							   HashValues,
 							   ExpectedInsertionCount,
@@ -348,9 +557,11 @@ namespace boost {
 							   HashFunction2,
 							   ExtensionFunction,
 							   Block,
-							   Allocator>& rhs)
+							   Allocator,
+							   Reduction>& rhs)
     {
-      if (lhs.bit_capacity() != rhs.bit_capacity())
+      if (lhs.bit_capacity() != rhs.bit_capacity() ||
+	  lhs.num_hash_functions() != rhs.num_hash_functions())
 	throw detail::incompatible_size_exception();
 
       return (lhs.bits == rhs.bits);
@@ -360,7 +571,8 @@ namespace boost {
 	     size_t ExpectedInsertionCount,
 	     class HashFunction1, class HashFunction2,
 	     class ExtensionFunction, typename Block,
-	     class Allocator>
+	     class Allocator,
+	     class Reduction>
     bool
     operator!=(const twohash_dynamic_counting_bloom_filter<T, BitsPerBin,
 							   HashValues,
@@ -369,7 +581,8 @@ namespace boost {
 							   HashFunction2,
 							   ExtensionFunction,
 							   Block,
-							   Allocator>& lhs,
+							   Allocator,
+							   Reduction>& lhs,
 	       const twohash_dynamic_counting_bloom_filter<T, BitsPerBin,
 							   HashValues,
 							   ExpectedInsertionCount,
@@ -377,7 +590,8 @@ namespace boost {
 							   HashFunction2,
 							   ExtensionFunction,
 							   Block,
-							   Allocator>& rhs)
+							   Allocator,
+							   Reduction>& rhs)
     {
       if (lhs.bit_capacity() != rhs.bit_capacity())
 	throw detail::incompatible_size_exception();
@@ -0,0 +1,121 @@
+//////////////////////////////////////////////////////////////////////////////
+//
+// (C) Copyright Alejandro Cabrera 2011.
+// Distributed under the Boost
+// Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or
+// copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// See http://www.boost.org/libs/bloom_filter for documentation.
+//
+//////////////////////////////////////////////////////////////////////////////
+
+// Compares false positive rate against insert/lookup throughput for
+// the dynamic, twohash and blocked filters at the same bit budget. The
+// filter is made larger than a typical last level cache so that lookups
+// are bound by cache misses. Each filter is run once key by key and
+// once through the batched interface.
+
+#include "detail/pow.hpp"
+
+#include <boost/bloom_filter/dynamic_bloom_filter.hpp>
+#include <boost/bloom_filter/twohash_dynamic_basic_bloom_filter.hpp>
+#include <boost/bloom_filter/blocked_bloom_filter.hpp>
+#include <boost/bloom_filter/hash/murmurhash3.hpp>
+#include <boost/timer.hpp>
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+using namespace std;
+using boost::detail::Pow;
+using boost::bloom_filters::dynamic_bloom_filter;
+using boost::bloom_filters::twohash_dynamic_basic_bloom_filter;
+using boost::bloom_filters::blocked_bloom_filter;
+using boost::bloom_filters::murmurhash3;
+
+static const size_t BITS = Pow<2, 28>::val; // 32MB
+static const size_t INSERTS = BITS / 10; // 10 bits per key
+static const size_t LOOKUPS = Pow<10, 7>::val;
+
+typedef boost::mpl::vector<
+  murmurhash3<size_t, 1>, murmurhash3<size_t, 2>,
+  murmurhash3<size_t, 3>, murmurhash3<size_t, 4>,
+  murmurhash3<size_t, 5>, murmurhash3<size_t, 6>,
+  murmurhash3<size_t, 7> > SevenHashes;
+
+typedef dynamic_bloom_filter<size_t, SevenHashes> dynamic_bloom;
+typedef twohash_dynamic_basic_bloom_filter<size_t, 7, 0,
+					   murmurhash3<size_t, 1>,
+					   murmurhash3<size_t, 2> > twohash_bloom;
+typedef blocked_bloom_filter<size_t, 7> blocked_bloom;
+
+template <typename Filter>
+void run(const string& name)
+{
+  Filter bloom(BITS);
+  size_t hits = 0;
+
+  boost::timer insert_timer;
+  for (size_t i = 0; i < INSERTS; ++i)
+    bloom.insert(i);
+  const double insert_time = insert_timer.elapsed();
+
+  boost::timer lookup_timer;
+  for (size_t i = INSERTS; i < INSERTS + LOOKUPS; ++i)
+    hits += bloom.probably_contains(i);
+  const double lookup_time = lookup_timer.elapsed();
+
+  cout << setw(10) << name
+       << setw(14) << insert_time * 1e9 / INSERTS
+       << setw(14) << lookup_time * 1e9 / LOOKUPS
+       << setw(14) << static_cast<double>(hits) / LOOKUPS
+       << endl;
+}
+
+// same workload through insert_batch and probably_contains_batch
+template <typename Filter>
+void run_batch(const string& name)
+{
+  Filter bloom(BITS);
+  std::vector<size_t> keys(INSERTS + LOOKUPS);
+  std::vector<boost::uint64_t> found((LOOKUPS + 63) / 64);
+
+  for (size_t i = 0; i < keys.size(); ++i)
+    keys[i] = i;
+
+  boost::timer insert_timer;
+  bloom.insert_batch(keys.begin(), keys.begin() + INSERTS);
+  const double insert_time = insert_timer.elapsed();
+
+  boost::timer lookup_timer;
+  const size_t hits =
+    bloom.probably_contains_batch(keys.begin() + INSERTS, keys.end(),
+				  &found[0]);
+  const double lookup_time = lookup_timer.elapsed();
+
+  cout << setw(10) << name
+       << setw(14) << insert_time * 1e9 / INSERTS
+       << setw(14) << lookup_time * 1e9 / LOOKUPS
+       << setw(14) << static_cast<double>(hits) / LOOKUPS
+       << endl;
+}
+
+int main()
+{
+  cout << BITS << " bits, " << INSERTS << " keys, 7 probes per key\n"
+       << setw(10) << "filter"
+       << setw(14) << "insert ns"
+       << setw(14) << "lookup ns"
+       << setw(14) << "measured fpr" << endl;
+
+  run<dynamic_bloom>("dynamic");
+  run<twohash_bloom>("twohash");
+  run<blocked_bloom>("blocked");
+  run_batch<dynamic_bloom>("dynamic*");
+  run_batch<twohash_bloom>("twohash*");
+  run_batch<blocked_bloom>("blocked*");
+  cout << "* batched" << endl;
+
+  return 0;
+}
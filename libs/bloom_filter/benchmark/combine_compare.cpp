@@ -0,0 +1,107 @@
+//////////////////////////////////////////////////////////////////////////////
+//
+// (C) Copyright Alejandro Cabrera 2011.
+// Distributed under the Boost
+// Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or
+// copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// See http://www.boost.org/libs/bloom_filter for documentation.
+//
+//////////////////////////////////////////////////////////////////////////////
+
+// Throughput of or-ing dynamic_bloom_filters together: dynamic_bitset's
+// operator|= and a recount, as operator|=() used to be; operator|=()
+// now; unite() with more threads; and union_all() over many inputs
+// against folding them in with operator|=() one at a time. Build with
+// -pthread -lboost_thread -lboost_system.
+
+#include "detail/pow.hpp"
+
+#include <boost/bloom_filter/combine.hpp>
+#include <boost/bloom_filter/dynamic_bloom_filter.hpp>
+#include <boost/date_time/posix_time/posix_time_types.hpp>
+#include <boost/lexical_cast.hpp>
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+using namespace std;
+using boost::detail::Pow;
+using boost::bloom_filters::dynamic_bloom_filter;
+
+static const size_t BITS = Pow<2, 30>::val; // 128MB
+static const size_t INPUTS = 8;
+
+typedef dynamic_bloom_filter<size_t> bloom;
+
+static double now()
+{
+  using namespace boost::posix_time;
+  static const ptime start = microsec_clock::universal_time();
+  return static_cast<double>(
+    (microsec_clock::universal_time() - start).total_microseconds()) / 1e6;
+}
+
+// GB of input or-ed in per second
+static void report(const string& name, const size_t inputs,
+		   const double seconds)
+{
+  cout << setw(20) << name
+       << setw(16) << inputs * (BITS / 8) / seconds / 1e9
+       << endl;
+}
+
+int main()
+{
+  vector<bloom> filters(INPUTS, bloom(BITS));
+  for (size_t i = 0; i < INPUTS; ++i)
+    for (size_t k = 0; k < 100000; ++k)
+      filters[i].insert(i * 100000 + k);
+
+  cout << "hardware threads: " << boost::thread::hardware_concurrency()
+       << "\n"
+       << setw(20) << "union"
+       << setw(16) << "GB/s" << endl;
+
+  {
+    boost::dynamic_bitset<size_t> bits(filters[0].data());
+    const double start = now();
+    bits |= filters[1].data();
+    volatile size_t count = bits.count();
+    (void)count;
+    report("dynamic_bitset |=", 1, now() - start);
+  }
+
+  {
+    bloom lhs(filters[0]);
+    const double start = now();
+    lhs |= filters[1];
+    report("operator|=", 1, now() - start);
+  }
+
+  for (size_t threads = 2; threads <= 8; threads *= 2) {
+    bloom lhs(filters[0]);
+    const double start = now();
+    boost::bloom_filters::unite(lhs, filters[1], threads);
+    report("unite x" + boost::lexical_cast<string>(threads), 1,
+	   now() - start);
+  }
+
+  {
+    const double start = now();
+    bloom all(filters[0]);
+    for (size_t i = 1; i < INPUTS; ++i)
+      all |= filters[i];
+    report("chained operator|=", INPUTS, now() - start);
+  }
+
+  {
+    const double start = now();
+    const bloom all =
+      boost::bloom_filters::union_all(filters.begin(), filters.end());
+    report("union_all", INPUTS, now() - start);
+  }
+
+  return 0;
+}
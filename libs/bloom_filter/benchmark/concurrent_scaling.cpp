@@ -0,0 +1,150 @@
+//////////////////////////////////////////////////////////////////////////////
+//
+// (C) Copyright Alejandro Cabrera 2011.
+// Distributed under the Boost
+// Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or
+// copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// See http://www.boost.org/libs/bloom_filter for documentation.
+//
+//////////////////////////////////////////////////////////////////////////////
+
+// Insert and lookup throughput from 1 to 64 threads, for a
+// dynamic_bloom_filter behind a mutex and for the lock-free
+// dynamic_concurrent_bloom_filter. Every run does the same total
+// work, split evenly between the threads; times are wall clock.
+// Build with -pthread -lboost_thread -lboost_system.
+
+#include "detail/pow.hpp"
+
+#include <boost/bloom_filter/dynamic_bloom_filter.hpp>
+#include <boost/bloom_filter/dynamic_concurrent_bloom_filter.hpp>
+#include <boost/bloom_filter/hash/murmurhash3.hpp>
+#include <boost/date_time/posix_time/posix_time_types.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
+#include <iostream>
+#include <iomanip>
+#include <string>
+using namespace std;
+using boost::detail::Pow;
+using boost::bloom_filters::dynamic_bloom_filter;
+using boost::bloom_filters::dynamic_concurrent_bloom_filter;
+using boost::bloom_filters::murmurhash3;
+
+static const size_t BITS = Pow<2, 28>::val; // 32MB
+static const size_t INSERTS = BITS / 10; // 10 bits per key
+static const size_t LOOKUPS = Pow<10, 7>::val * 2;
+
+typedef boost::mpl::vector<
+  murmurhash3<size_t, 1>, murmurhash3<size_t, 2>,
+  murmurhash3<size_t, 3>, murmurhash3<size_t, 4>,
+  murmurhash3<size_t, 5>, murmurhash3<size_t, 6>,
+  murmurhash3<size_t, 7> > SevenHashes;
+
+typedef dynamic_bloom_filter<size_t, SevenHashes> serial_bloom;
+typedef dynamic_concurrent_bloom_filter<size_t, SevenHashes> concurrent_bloom;
+
+// what callers do today: one lock around the whole filter
+class locked_bloom {
+public:
+  explicit locked_bloom(const size_t bits) : filter(bits) {}
+
+  void insert(const size_t key) {
+    boost::mutex::scoped_lock lock(this->mutex);
+    this->filter.insert(key);
+  }
+
+  bool probably_contains(const size_t key) {
+    boost::mutex::scoped_lock lock(this->mutex);
+    return this->filter.probably_contains(key);
+  }
+
+private:
+  serial_bloom filter;
+  boost::mutex mutex;
+};
+
+static double now()
+{
+  using namespace boost::posix_time;
+  static const ptime start = microsec_clock::universal_time();
+  return static_cast<double>(
+    (microsec_clock::universal_time() - start).total_microseconds()) / 1e6;
+}
+
+// the keys [first, last) into the filter, or probed against it
+template <typename Filter>
+struct worker {
+  worker(Filter& filter, const size_t first, const size_t last,
+	 const bool lookup, size_t& hits)
+    : filter(filter), first(first), last(last), lookup(lookup), hits(hits) {}
+
+  void operator()() const {
+    size_t found = 0;
+    if (lookup)
+      for (size_t i = first; i < last; ++i)
+	found += filter.probably_contains(i);
+    else
+      for (size_t i = first; i < last; ++i)
+	filter.insert(i);
+    hits = found;
+  }
+
+  Filter& filter;
+  size_t first;
+  size_t last;
+  bool lookup;
+  size_t& hits;
+};
+
+// seconds for num_threads threads to share out [first, first + n)
+template <typename Filter>
+double timed(Filter& filter, const size_t num_threads,
+	     const size_t first, const size_t n, const bool lookup)
+{
+  size_t hits[64] = {0};
+  boost::thread_group threads;
+
+  const double start = now();
+  for (size_t t = 0; t < num_threads; ++t)
+    threads.create_thread(worker<Filter>(filter,
+					 first + n * t / num_threads,
+					 first + n * (t + 1) / num_threads,
+					 lookup, hits[t]));
+  threads.join_all();
+  return now() - start;
+}
+
+template <typename Filter>
+void run(const string& name, const size_t num_threads)
+{
+  Filter bloom(BITS);
+  const double insert_time = timed(bloom, num_threads, 0, INSERTS, false);
+  const double lookup_time =
+    timed(bloom, num_threads, INSERTS, LOOKUPS, true);
+
+  cout << setw(12) << name
+       << setw(8) << num_threads
+       << setw(16) << INSERTS / insert_time / 1e6
+       << setw(16) << LOOKUPS / lookup_time / 1e6
+       << endl;
+}
+
+int main()
+{
+  cout << "hardware threads: " << boost::thread::hardware_concurrency()
+       << "\n"
+       << setw(12) << "filter"
+       << setw(8) << "threads"
+       << setw(16) << "insert Mops/s"
+       << setw(16) << "lookup Mops/s" << endl;
+
+  for (size_t threads = 1; threads <= 64; threads *= 2) {
+    run<locked_bloom>("mutex", threads);
+    run<concurrent_bloom>("lock-free", threads);
+  }
+
+  return 0;
+}
@@ -0,0 +1,216 @@
+//////////////////////////////////////////////////////////////////////////////
+//
+// (C) Copyright Alejandro Cabrera 2011.
+// Distributed under the Boost
+// Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or
+// copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// See http://www.boost.org/libs/bloom_filter for documentation.
+//
+//////////////////////////////////////////////////////////////////////////////
+
+// Compares ways of producing the k hash values of a key: k seeded
+// boost_hash, murmurhash3 or wyhash functions, and one 128 bit hash
+// expanded by enhanced double hashing. The filter fits in cache so
+// that hashing dominates. The measured false positive rate is printed
+// next to the textbook one for independent hashes. A second table
+// times the batch operations, where fixed_width_hashing hashes several
+// keys per SIMD instruction stream, and a third the hash functions
+// alone on string keys of several lengths.
+
+#include "detail/pow.hpp"
+
+#include <boost/bloom_filter/dynamic_bloom_filter.hpp>
+#include <boost/bloom_filter/hash/double_hashing.hpp>
+#include <boost/bloom_filter/hash/fixed_width_hashing.hpp>
+#include <boost/bloom_filter/hash/murmurhash3.hpp>
+#include <boost/bloom_filter/hash/wyhash.hpp>
+#include <boost/timer.hpp>
+#include <cmath>
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+using namespace std;
+using boost::detail::Pow;
+using boost::bloom_filters::dynamic_bloom_filter;
+using boost::bloom_filters::boost_hash;
+using boost::bloom_filters::murmurhash3;
+using boost::bloom_filters::wyhash;
+using boost::bloom_filters::wyhash_128;
+using boost::bloom_filters::enhanced_double_hashing;
+using boost::bloom_filters::fixed_width_hashing;
+using boost::bloom_filters::modulo_reduction;
+using boost::bloom_filters::fastrange_reduction;
+
+static const size_t BITS = Pow<2, 20>::val;
+static const size_t INSERTS = BITS / 10; // 10 bits per key
+static const size_t LOOKUPS = Pow<10, 7>::val;
+
+typedef boost::mpl::vector<
+  boost_hash<size_t, 13>, boost_hash<size_t, 17>,
+  boost_hash<size_t, 19>, boost_hash<size_t, 23>,
+  boost_hash<size_t, 29>, boost_hash<size_t, 31>,
+  boost_hash<size_t, 37> > SevenBoostHashes;
+
+typedef boost::mpl::vector<
+  murmurhash3<size_t, 1>, murmurhash3<size_t, 2>,
+  murmurhash3<size_t, 3>, murmurhash3<size_t, 4>,
+  murmurhash3<size_t, 5>, murmurhash3<size_t, 6>,
+  murmurhash3<size_t, 7> > SevenMurmurHashes;
+
+typedef boost::mpl::vector<
+  wyhash<size_t, 1>, wyhash<size_t, 2>,
+  wyhash<size_t, 3>, wyhash<size_t, 4>,
+  wyhash<size_t, 5>, wyhash<size_t, 6>,
+  wyhash<size_t, 7> > SevenWyhashes;
+
+typedef enhanced_double_hashing<size_t, 7> DoubleHashing;
+typedef enhanced_double_hashing<size_t, 7,
+				wyhash_128<size_t> > WyDoubleHashing;
+typedef fixed_width_hashing<size_t, 7> FixedWidthHashing;
+
+static const size_t HASHES = Pow<10, 7>::val;
+
+// spreads the keys over the whole key space
+static size_t key(const size_t i)
+{
+  return i * static_cast<size_t>(0x9e3779b97f4a7c15ull);
+}
+
+template <typename HashFunctions, typename Reduction>
+void run(const string& name)
+{
+  dynamic_bloom_filter<size_t, HashFunctions, size_t,
+		       std::allocator<size_t>, Reduction> bloom(BITS);
+  size_t hits = 0;
+
+  boost::timer insert_timer;
+  for (size_t i = 0; i < INSERTS; ++i)
+    bloom.insert(key(i));
+  const double insert_time = insert_timer.elapsed();
+
+  boost::timer lookup_timer;
+  for (size_t i = INSERTS; i < INSERTS + LOOKUPS; ++i)
+    hits += bloom.probably_contains(key(i));
+  const double lookup_time = lookup_timer.elapsed();
+
+  const double k = static_cast<double>(bloom.num_hash_functions());
+  const double predicted =
+    std::pow(1 - std::exp(-k * INSERTS / BITS), k);
+
+  cout << setw(18) << name
+       << setw(12) << insert_time * 1e9 / INSERTS
+       << setw(12) << lookup_time * 1e9 / LOOKUPS
+       << setw(14) << static_cast<double>(hits) / LOOKUPS
+       << setw(14) << predicted
+       << endl;
+}
+
+template <typename HashFunctions>
+void run_batch(const string& name)
+{
+  dynamic_bloom_filter<size_t, HashFunctions, size_t,
+		       std::allocator<size_t>, fastrange_reduction> bloom(BITS);
+  vector<size_t> keys(LOOKUPS);
+  vector<boost::uint64_t> out((LOOKUPS + 63) / 64);
+
+  for (size_t i = 0; i < LOOKUPS; ++i)
+    keys[i] = key(i);
+
+  boost::timer insert_timer;
+  bloom.insert_batch(keys.begin(), keys.begin() + INSERTS);
+  const double insert_time = insert_timer.elapsed();
+
+  boost::timer lookup_timer;
+  const size_t hits =
+    bloom.probably_contains_batch(keys.begin() + INSERTS, keys.end(),
+				  &out[0]);
+  const double lookup_time = lookup_timer.elapsed();
+
+  cout << setw(18) << name
+       << setw(12) << insert_time * 1e9 / INSERTS
+       << setw(12) << lookup_time * 1e9 / (LOOKUPS - INSERTS)
+       << setw(14) << static_cast<double>(hits) / (LOOKUPS - INSERTS)
+       << endl;
+}
+
+template <typename Hasher>
+double time_hash(const vector<string>& keys)
+{
+  Hasher hasher;
+  size_t sink = 0;
+
+  boost::timer timer;
+  for (size_t i = 0; i < HASHES; ++i)
+    sink += hasher(keys[i % keys.size()]);
+  const double elapsed = timer.elapsed();
+
+  // keeps the loop from being optimized away
+  if (sink == 42)
+    cout << "";
+
+  return elapsed * 1e9 / HASHES;
+}
+
+void run_lengths()
+{
+  static const size_t lengths[] = {4, 8, 16, 24, 32, 64, 256};
+
+  cout << "\n" << setw(18) << "key bytes"
+       << setw(14) << "murmurhash3"
+       << setw(14) << "wyhash" << endl;
+
+  for (size_t l = 0; l < sizeof(lengths) / sizeof(lengths[0]); ++l) {
+    vector<string> keys;
+    for (size_t i = 0; i < 1024; ++i) {
+      string k(lengths[l], 'x');
+      for (size_t j = 0; j < k.size(); ++j)
+	k[j] = static_cast<char>(key(i * 131 + j) >> 56);
+      keys.push_back(k);
+    }
+
+    cout << setw(18) << lengths[l]
+	 << setw(14) << time_hash<murmurhash3<string> >(keys)
+	 << setw(14) << time_hash<wyhash<string> >(keys)
+	 << endl;
+  }
+  cout << "ns per hash" << endl;
+}
+
+int main()
+{
+  cout << BITS << " bits, " << INSERTS << " keys, 7 probes per key\n"
+       << setw(18) << "hashes"
+       << setw(12) << "insert ns"
+       << setw(12) << "lookup ns"
+       << setw(14) << "measured fpr"
+       << setw(14) << "predicted" << endl;
+
+  run<SevenBoostHashes, modulo_reduction>("7 x boost_hash");
+  run<SevenMurmurHashes, modulo_reduction>("7 x murmurhash3");
+  run<SevenWyhashes, modulo_reduction>("7 x wyhash");
+  run<DoubleHashing, modulo_reduction>("double hashing");
+  run<WyDoubleHashing, modulo_reduction>("wy double hashing");
+  run<SevenMurmurHashes, fastrange_reduction>("7 x murmurhash3*");
+  run<SevenWyhashes, fastrange_reduction>("7 x wyhash*");
+  run<DoubleHashing, fastrange_reduction>("double hashing*");
+  run<WyDoubleHashing, fastrange_reduction>("wy double hashing*");
+  run<FixedWidthHashing, fastrange_reduction>("fixed width*");
+  cout << "* fastrange_reduction" << endl;
+
+  cout << "\nbatch operations, fastrange_reduction\n"
+       << setw(18) << "hashes"
+       << setw(12) << "insert ns"
+       << setw(12) << "lookup ns"
+       << setw(14) << "measured fpr" << endl;
+  run_batch<SevenMurmurHashes>("7 x murmurhash3");
+  run_batch<DoubleHashing>("double hashing");
+  run_batch<WyDoubleHashing>("wy double hashing");
+  run_batch<FixedWidthHashing>("fixed width");
+
+  run_lengths();
+
+  return 0;
+}
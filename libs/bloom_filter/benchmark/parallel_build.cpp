@@ -0,0 +1,88 @@
+//////////////////////////////////////////////////////////////////////////////
+//
+// (C) Copyright Alejandro Cabrera 2011.
+// Distributed under the Boost
+// Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or
+// copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// See http://www.boost.org/libs/bloom_filter for documentation.
+//
+//////////////////////////////////////////////////////////////////////////////
+
+// Time to build a dynamic_bloom_filter from a range of keys with
+// insert() and with parallel_insert() from 1 to 64 threads; times are
+// wall clock. Build with -pthread -lboost_thread -lboost_system.
+
+#include "detail/pow.hpp"
+
+#include <boost/bloom_filter/dynamic_bloom_filter.hpp>
+#include <boost/bloom_filter/parallel_build.hpp>
+#include <boost/bloom_filter/hash/murmurhash3.hpp>
+#include <boost/date_time/posix_time/posix_time_types.hpp>
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+using namespace std;
+using boost::detail::Pow;
+using boost::bloom_filters::dynamic_bloom_filter;
+using boost::bloom_filters::murmurhash3;
+using boost::bloom_filters::parallel_insert;
+
+static const size_t BITS = Pow<2, 28>::val; // 32MB
+static const size_t INSERTS = BITS / 10; // 10 bits per key
+
+typedef boost::mpl::vector<
+  murmurhash3<size_t, 1>, murmurhash3<size_t, 2>,
+  murmurhash3<size_t, 3>, murmurhash3<size_t, 4>,
+  murmurhash3<size_t, 5>, murmurhash3<size_t, 6>,
+  murmurhash3<size_t, 7> > SevenHashes;
+
+typedef dynamic_bloom_filter<size_t, SevenHashes> bloom;
+
+static double now()
+{
+  using namespace boost::posix_time;
+  static const ptime start = microsec_clock::universal_time();
+  return static_cast<double>(
+    (microsec_clock::universal_time() - start).total_microseconds()) / 1e6;
+}
+
+static void report(const string& name, const size_t threads,
+		   const double seconds)
+{
+  cout << setw(12) << name
+       << setw(8) << threads
+       << setw(16) << INSERTS / seconds / 1e6
+       << endl;
+}
+
+int main()
+{
+  vector<size_t> keys(INSERTS);
+  for (size_t i = 0; i < INSERTS; ++i)
+    keys[i] = i;
+
+  cout << "hardware threads: " << boost::thread::hardware_concurrency()
+       << "\n"
+       << setw(12) << "build"
+       << setw(8) << "threads"
+       << setw(16) << "insert Mops/s" << endl;
+
+  {
+    bloom serial(BITS);
+    const double start = now();
+    serial.insert(keys.begin(), keys.end());
+    report("insert", 1, now() - start);
+  }
+
+  for (size_t threads = 1; threads <= 64; threads *= 2) {
+    bloom parallel(BITS);
+    const double start = now();
+    parallel_insert(parallel, keys.begin(), keys.end(), threads);
+    report("parallel", threads, now() - start);
+  }
+
+  return 0;
+}
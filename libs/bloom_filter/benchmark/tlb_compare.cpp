@@ -0,0 +1,151 @@
+//////////////////////////////////////////////////////////////////////////////
+//
+// (C) Copyright Alejandro Cabrera 2011.
+// Distributed under the Boost
+// Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or
+// copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// See http://www.boost.org/libs/bloom_filter for documentation.
+//
+//////////////////////////////////////////////////////////////////////////////
+
+// Compares data TLB misses and page faults of random probes into a
+// filter much larger than the TLB reach of 4 KiB pages, for each page
+// placement of page_allocator. Counters come from perf_event_open
+// (Linux); where it is unavailable only times are printed. Raise BITS
+// to 2^35 for a 4 GiB filter.
+
+#include <boost/bloom_filter/dynamic_bloom_filter.hpp>
+#include <boost/bloom_filter/page_allocator.hpp>
+#include <boost/bloom_filter/hash/murmurhash3.hpp>
+#include <boost/timer.hpp>
+#include <iostream>
+#include <iomanip>
+#include <cstring>
+#include <string>
+#include <memory>
+
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+using namespace std;
+using namespace boost::bloom_filters;
+
+static const size_t BITS = static_cast<size_t>(1) << 33; // 1 GiB
+static const size_t INSERTS = 4000000;
+static const size_t LOOKUPS = 20000000;
+
+typedef boost::mpl::vector<
+  murmurhash3<size_t, 1>, murmurhash3<size_t, 2>,
+  murmurhash3<size_t, 3>, murmurhash3<size_t, 4> > FourHashes;
+
+// one hardware or software counter of this thread, user space only
+class counter {
+public:
+  counter(const boost::uint32_t type, const boost::uint64_t config)
+  {
+    perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = type;
+    attr.config = config;
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    fd = static_cast<int>(syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0));
+  }
+
+  ~counter() { if (fd >= 0) close(fd); }
+
+  void start() {
+    if (fd < 0) return;
+    ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+    ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+  }
+
+  // the count since start(), or -1 if the counter is unavailable
+  double stop() {
+    boost::uint64_t value = 0;
+    if (fd < 0) return -1;
+    ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+    if (read(fd, &value, sizeof(value)) != sizeof(value)) return -1;
+    return static_cast<double>(value);
+  }
+
+private:
+  int fd;
+};
+
+static counter dtlb_misses(PERF_TYPE_HW_CACHE,
+			   PERF_COUNT_HW_CACHE_DTLB |
+			   (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+			   (PERF_COUNT_HW_CACHE_RESULT_MISS << 16));
+static counter page_faults(PERF_TYPE_SOFTWARE, PERF_COUNT_SW_PAGE_FAULTS);
+
+static void print_count(const double count, const double per)
+{
+  if (count < 0)
+    cout << setw(14) << "n/a";
+  else
+    cout << setw(14) << count / per;
+}
+
+template <typename Allocator>
+void run(const string& name)
+{
+  typedef dynamic_bloom_filter<size_t, FourHashes, size_t, Allocator> bloom;
+  size_t hits = 0;
+
+  page_faults.start();
+  boost::timer build_timer;
+  bloom filter(BITS);
+  const double build_time = build_timer.elapsed();
+  const double build_faults = page_faults.stop();
+
+  for (size_t i = 0; i < INSERTS; ++i)
+    filter.insert(i * 0x9e3779b97f4a7c15ull);
+
+  // the first lookups after start up, where late faults would show
+  page_faults.start();
+  dtlb_misses.start();
+  boost::timer lookup_timer;
+  for (size_t i = 0; i < LOOKUPS; ++i)
+    hits += filter.probably_contains(i);
+  const double lookup_time = lookup_timer.elapsed();
+  const double misses = dtlb_misses.stop();
+  const double lookup_faults = page_faults.stop();
+
+  cout << setw(12) << name
+       << setw(12) << build_time * 1e3;
+  print_count(build_faults, 1);
+  cout << setw(12) << lookup_time * 1e9 / LOOKUPS;
+  print_count(misses, LOOKUPS);
+  print_count(lookup_faults, 1);
+  cout << setw(8) << hits << endl;
+}
+
+int main()
+{
+  cout << BITS / 8 / (1 << 20) << " MiB filter, " << LOOKUPS
+       << " lookups, 4 probes per key\n"
+       << setw(12) << "placement"
+       << setw(12) << "build ms"
+       << setw(14) << "build faults"
+       << setw(12) << "lookup ns"
+       << setw(14) << "dTLB miss/op"
+       << setw(14) << "lookup faults"
+       << setw(8) << "hits" << endl;
+
+  run<std::allocator<size_t> >("std");
+  run<page_allocator<size_t, 64, no_huge_pages> >("4k");
+  run<page_allocator<size_t, 64, transparent_huge_pages> >("thp");
+  run<page_allocator<size_t, 64,
+		     transparent_huge_pages | prefault_pages> >("thp+pf");
+  run<page_allocator<size_t, 64,
+		     explicit_huge_pages | prefault_pages> >("hugetlb+pf");
+
+  return 0;
+}
@@ -13,6 +13,8 @@
 #define BOOST_TEST_DYN_LINK 1
 #define BOOST_TEST_MODULE "Boost Bloom Filter" 1
 #include <iostream>
+#include <memory>
+#include <utility>
 
 #include <boost/bloom_filter/basic_bloom_filter.hpp>
 #include <boost/test/unit_test.hpp>
@@ -20,6 +22,8 @@
 
 using boost::bloom_filters::basic_bloom_filter;
 using boost::bloom_filters::boost_hash;
+using boost::bloom_filters::heap_storage;
+using boost::bloom_filters::allocated_storage;
 
 BOOST_AUTO_TEST_CASE(defaultConstructor) {
   typedef boost::mpl::vector<
@@ -291,3 +295,152 @@ BOOST_AUTO_TEST_CASE(inequalityOperator) {
   bloom2.insert(1);
   BOOST_CHECK_EQUAL(bloom1 != bloom2, false);
 }
+
+BOOST_AUTO_TEST_CASE(batchOperations) {
+  typedef basic_bloom_filter<size_t, 4096, boost::mpl::vector<
+    boost_hash<size_t, 1>,
+    boost_hash<size_t, 2>,
+    boost_hash<size_t, 3> > > Bloom;
+  Bloom single;
+  Bloom batch;
+  size_t keys[300];
+  boost::uint64_t out[(300 + 63) / 64];
+
+  for (size_t i = 0; i < 300; ++i)
+    keys[i] = i * 7;
+
+  single.insert(keys, keys + 150);
+  batch.insert_batch(keys, keys + 150);
+  BOOST_CHECK(single == batch);
+
+  const size_t found = batch.probably_contains_batch(keys, keys + 300, out);
+
+  size_t expected = 0;
+  for (size_t i = 0; i < 300; ++i) {
+    const bool bit = ((out[i / 64] >> (i % 64)) & 1) != 0;
+    BOOST_CHECK_EQUAL(bit, single.probably_contains(keys[i]));
+    expected += bit;
+  }
+
+  BOOST_CHECK_EQUAL(found, expected);
+  BOOST_CHECK_GE(found, 150ul);
+}
+
+BOOST_AUTO_TEST_CASE(preHashed) {
+  typedef basic_bloom_filter<size_t, 4096, boost::mpl::vector<
+    boost_hash<size_t, 1>,
+    boost_hash<size_t, 2>,
+    boost_hash<size_t, 3> > > Bloom;
+  typedef basic_bloom_filter<size_t, 1000, boost::mpl::vector<
+    boost_hash<size_t, 1>,
+    boost_hash<size_t, 2>,
+    boost_hash<size_t, 3> > > Other;
+  Bloom plain;
+  Bloom hashed;
+  Other other;
+
+  // one digest per key serves filters of both sizes
+  for (size_t i = 0; i < 100; ++i) {
+    const Bloom::digest_type digest = Bloom::hash_key(i * 7);
+    BOOST_CHECK(digest == Other::hash_key(i * 7));
+
+    plain.insert(i * 7);
+    hashed.insert_hash(digest);
+    other.insert_hash(digest);
+  }
+
+  BOOST_CHECK(plain == hashed);
+
+  for (size_t i = 0; i < 100; ++i) {
+    BOOST_CHECK_EQUAL(hashed.probably_contains_hash(Bloom::hash_key(i * 7)),
+		      true);
+    BOOST_CHECK_EQUAL(other.probably_contains(i * 7), true);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(heapStorage) {
+  // 64 MiB of bits: too large for the stack, fine as a local here
+  typedef basic_bloom_filter<size_t, (static_cast<size_t>(1) << 29),
+			     boost::mpl::vector<boost_hash<size_t> >,
+			     boost::bloom_filters::mask_reduction,
+			     heap_storage<64> > Bloom;
+  BOOST_CHECK_EQUAL(sizeof(Bloom), sizeof(void *));
+
+  Bloom a;
+  BOOST_CHECK(a.empty());
+  BOOST_CHECK_EQUAL(reinterpret_cast<size_t>(&a.data()) % 64, 0ul);
+
+  for (size_t i = 0; i < 1000; ++i)
+    a.insert(i);
+
+  Bloom b(a);
+  BOOST_CHECK(a == b);
+  BOOST_CHECK(&a.data() != &b.data());
+  b.insert(5000);
+  BOOST_CHECK(a != b);
+
+  // swapping exchanges the allocations, not the bits
+  const void *const a_bits = &a.data();
+  const void *const b_bits = &b.data();
+  swap(a, b);
+  BOOST_CHECK_EQUAL(&a.data(), b_bits);
+  BOOST_CHECK_EQUAL(&b.data(), a_bits);
+  BOOST_CHECK(a.probably_contains(5000));
+
+  // assignment copies into the existing allocation
+  b = a;
+  BOOST_CHECK(a == b);
+  BOOST_CHECK_EQUAL(&b.data(), a_bits);
+
+  a.clear();
+  BOOST_CHECK(a.empty());
+  BOOST_CHECK_EQUAL(b.count(), 1001ul);
+
+#ifndef BOOST_NO_CXX11_RVALUE_REFERENCES
+  // a moved-from filter has no allocation until it is assigned to
+  Bloom c(std::move(a));
+  BOOST_CHECK(c.empty());
+  a = b;
+  BOOST_CHECK(a == b);
+  BOOST_CHECK(&a.data() != &b.data());
+  BOOST_CHECK_EQUAL(a.count(), 1001ul);
+
+  Bloom d(std::move(a));
+  a = std::move(c);
+  BOOST_CHECK(a.empty());
+  BOOST_CHECK(d == b);
+#endif
+}
+
+static size_t arena_allocations = 0;
+
+template <typename T>
+struct counted_allocator : std::allocator<T> {
+  template <typename U>
+  struct rebind {
+    typedef counted_allocator<U> other;
+  };
+
+  T *allocate(const size_t n) {
+    ++arena_allocations;
+    return std::allocator<T>::allocate(n);
+  }
+};
+
+BOOST_AUTO_TEST_CASE(allocatedStorage) {
+  typedef basic_bloom_filter<int, 8192,
+			     boost::mpl::vector<boost_hash<int> >,
+			     boost::bloom_filters::mask_reduction,
+			     allocated_storage<counted_allocator<char> > > Bloom;
+
+  Bloom a;
+  a.insert(1);
+  Bloom b = a | Bloom();
+  BOOST_CHECK(b.probably_contains(1));
+  BOOST_CHECK_GE(arena_allocations, 3ul);
+
+  const size_t before = arena_allocations;
+  a.swap(b);
+  a = b;
+  BOOST_CHECK_EQUAL(arena_allocations, before);
+}
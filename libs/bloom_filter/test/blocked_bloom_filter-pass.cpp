@@ -0,0 +1,546 @@
+//////////////////////////////////////////////////////////////////////////////
+//
+// (C) Copyright Alejandro Cabrera 2011.
+// Distributed under the Boost
+// Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or
+// copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// See http://www.boost.org/libs/bloom_filter for documentation.
+//
+//////////////////////////////////////////////////////////////////////////////
+
+#define BOOST_TEST_DYN_LINK 1
+#define BOOST_TEST_MODULE "Boost Blocked Bloom Filter" 1
+
+#include <vector>
+
+#include <boost/bloom_filter/blocked_bloom_filter.hpp>
+#include <boost/type_traits/is_nothrow_move_constructible.hpp>
+#include <boost/test/unit_test.hpp>
+#include <boost/test/floating_point_comparison.hpp>
+
+using boost::bloom_filters::blocked_bloom_filter;
+using boost::bloom_filters::murmurhash3;
+using boost::bloom_filters::detail::incompatible_size_exception;
+
+BOOST_AUTO_TEST_CASE(defaultConstructor) {
+  blocked_bloom_filter<int> bloom;
+  blocked_bloom_filter<int, 8> eight_hash_value_bloom;
+  blocked_bloom_filter<int, 8, murmurhash3<int, 7> > seeded_bloom;
+
+  BOOST_CHECK_EQUAL(bloom.num_blocks(), 1ul);
+  BOOST_CHECK_EQUAL(bloom.bit_capacity(), 512ul);
+}
+
+BOOST_AUTO_TEST_CASE(checkBlockTypes)
+{
+  blocked_bloom_filter<int, 4, murmurhash3<int>, unsigned char> uchar_bloom;
+  blocked_bloom_filter<int, 4, murmurhash3<int>, unsigned short> ushort_bloom;
+  blocked_bloom_filter<int, 4, murmurhash3<int>, unsigned int> uint_bloom;
+  blocked_bloom_filter<int, 4, murmurhash3<int>, unsigned long> ulong_bloom;
+
+  BOOST_CHECK_EQUAL(uchar_bloom.words_per_block(), 64ul);
+  BOOST_CHECK_EQUAL(ushort_bloom.words_per_block(), 32ul);
+  BOOST_CHECK_EQUAL(uint_bloom.words_per_block(), 16ul);
+
+  for (int i = 0; i < 100; ++i) {
+    uchar_bloom.insert(i);
+    ushort_bloom.insert(i);
+    uint_bloom.insert(i);
+    ulong_bloom.insert(i);
+  }
+
+  // the bit layout does not depend on the block type
+  BOOST_CHECK_EQUAL(uchar_bloom.count(), ulong_bloom.count());
+  BOOST_CHECK_EQUAL(ushort_bloom.count(), ulong_bloom.count());
+  BOOST_CHECK_EQUAL(uint_bloom.count(), ulong_bloom.count());
+}
+
+BOOST_AUTO_TEST_CASE(rangeConstructor) {
+  int elems[5] = {1,2,3,4,5};
+  blocked_bloom_filter<int> bloom(elems, elems+5);
+
+  for (size_t i = 0; i < 5; ++i)
+    BOOST_CHECK_EQUAL(bloom.probably_contains(elems[i]), true);
+}
+
+BOOST_AUTO_TEST_CASE(copyConstructor) {
+  int elems[5] = {1,2,3,4,5};
+  blocked_bloom_filter<int> bloom1(elems, elems+5);
+  blocked_bloom_filter<int> bloom2(bloom1);
+
+  BOOST_CHECK_EQUAL(bloom1.count(), bloom2.count());
+}
+
+BOOST_AUTO_TEST_CASE(assignment)
+{
+  blocked_bloom_filter<int> bloom1(2048);
+  blocked_bloom_filter<int> bloom2(2048);
+
+  for (int i = 0; i < 200; ++i) {
+    bloom1.insert(i);
+    BOOST_CHECK_EQUAL(bloom1.probably_contains(i), true);
+  }
+
+  bloom2 = bloom1;
+
+  for (int i = 0; i < 200; ++i) {
+    BOOST_CHECK_EQUAL(bloom2.probably_contains(i), true);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(bit_capacity) {
+  blocked_bloom_filter<size_t> bloom_1(1);
+  blocked_bloom_filter<size_t> bloom_512(512);
+  blocked_bloom_filter<size_t> bloom_513(513);
+  blocked_bloom_filter<size_t> bloom_8192(8192);
+
+  BOOST_CHECK_EQUAL(bloom_1.bit_capacity(), 512ul);
+  BOOST_CHECK_EQUAL(bloom_512.bit_capacity(), 512ul);
+  BOOST_CHECK_EQUAL(bloom_513.bit_capacity(), 1024ul);
+  BOOST_CHECK_EQUAL(bloom_8192.bit_capacity(), 8192ul);
+  BOOST_CHECK_EQUAL(bloom_8192.num_blocks(), 16ul);
+}
+
+BOOST_AUTO_TEST_CASE(cacheLineAligned) {
+  blocked_bloom_filter<size_t> bloom(8192);
+  const size_t addr = reinterpret_cast<size_t>(&bloom.data()[0]);
+
+  BOOST_CHECK_EQUAL(addr % 64, 0ul);
+}
+
+BOOST_AUTO_TEST_CASE(empty) {
+  blocked_bloom_filter<size_t> bloom;
+
+  BOOST_CHECK_EQUAL(bloom.empty(), true);
+  bloom.insert(1);
+  BOOST_CHECK_EQUAL(bloom.empty(), false);
+  bloom.clear();
+  BOOST_CHECK_EQUAL(bloom.empty(), true);
+}
+
+BOOST_AUTO_TEST_CASE(numHashFunctions) {
+  blocked_bloom_filter<size_t> bloom_4;
+  blocked_bloom_filter<size_t, 1> bloom_1;
+  blocked_bloom_filter<size_t, 7> bloom_7;
+
+  BOOST_CHECK_EQUAL(bloom_4.num_hash_functions(), 4ul);
+  BOOST_CHECK_EQUAL(bloom_1.num_hash_functions(), 1ul);
+  BOOST_CHECK_EQUAL(bloom_7.num_hash_functions(), 7ul);
+}
+
+BOOST_AUTO_TEST_CASE(falsePositiveRate) {
+  blocked_bloom_filter<size_t> bloom(512);
+
+  BOOST_CHECK_EQUAL(bloom.false_positive_rate(), 0.0);
+
+  // the probes of one key never collide, so each insert of a fresh key
+  // into an empty block sets exactly num_hash_functions() bits
+  bloom.insert(1);
+  BOOST_CHECK_EQUAL(bloom.count(), 4ul);
+  BOOST_CHECK_CLOSE(bloom.false_positive_rate(), 8.960399e-07, .01);
+
+  for (size_t i = 2; i < 5000; ++i)
+    bloom.insert(i);
+
+  BOOST_CHECK_GE(bloom.false_positive_rate(), 0.6);
+  BOOST_CHECK_LE(bloom.false_positive_rate(), 1.0);
+}
+
+BOOST_AUTO_TEST_CASE(probesStayInOneBlock) {
+  blocked_bloom_filter<size_t, 8> bloom(512 * 64);
+
+  for (size_t key = 0; key < 100; ++key) {
+    bloom.clear();
+    bloom.insert(key);
+
+    size_t touched_blocks = 0;
+    for (size_t b = 0; b < bloom.num_blocks(); ++b) {
+      bool touched = false;
+      for (size_t w = 0; w < bloom.words_per_block(); ++w)
+	touched |= bloom.data()[b * bloom.words_per_block() + w] != 0;
+      touched_blocks += touched;
+    }
+
+    BOOST_CHECK_EQUAL(touched_blocks, 1ul);
+    BOOST_CHECK_EQUAL(bloom.count(), 8ul);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(probably_contains) {
+  blocked_bloom_filter<size_t> bloom;
+
+  bloom.insert(1);
+  BOOST_CHECK_EQUAL(bloom.probably_contains(1), true);
+  BOOST_CHECK_EQUAL(bloom.count(), 4ul);
+}
+
+BOOST_AUTO_TEST_CASE(doesNotContain) {
+  blocked_bloom_filter<size_t> bloom;
+
+  BOOST_CHECK_EQUAL(bloom.probably_contains(1), false);
+}
+
+BOOST_AUTO_TEST_CASE(insertNoFalseNegatives) {
+  blocked_bloom_filter<size_t> bloom(2048);
+
+  for (size_t i = 0; i < 100; ++i) {
+    bloom.insert(i);
+    BOOST_CHECK_EQUAL(bloom.probably_contains(i), true);
+  }
+}
+
+template <typename Bloom>
+void checkBatchMatchesSingle(const size_t num_keys) {
+  Bloom bloom(512 * 32);
+  std::vector<size_t> keys(num_keys);
+  std::vector<boost::uint64_t> out((num_keys + 63) / 64, 0);
+
+  for (size_t i = 0; i < num_keys; ++i) {
+    keys[i] = i;
+    if (i % 2 == 0)
+      bloom.insert(i);
+  }
+
+  const size_t found =
+    bloom.probably_contains_batch(keys.begin(), keys.end(), &out[0]);
+
+  size_t expected = 0;
+  for (size_t i = 0; i < num_keys; ++i) {
+    const bool bit = ((out[i / 64] >> (i % 64)) & 1) != 0;
+    BOOST_CHECK_EQUAL(bit, bloom.probably_contains(keys[i]));
+    expected += bloom.probably_contains(keys[i]);
+  }
+
+  BOOST_CHECK_EQUAL(found, expected);
+  BOOST_CHECK_GE(found, (num_keys + 1) / 2);
+}
+
+BOOST_AUTO_TEST_CASE(batchContains) {
+  checkBatchMatchesSingle<blocked_bloom_filter<size_t> >(1000);
+  checkBatchMatchesSingle<blocked_bloom_filter<size_t, 1> >(3);
+  checkBatchMatchesSingle<blocked_bloom_filter<size_t, 7> >(129);
+  checkBatchMatchesSingle<blocked_bloom_filter<size_t, 4, murmurhash3<size_t>,
+					       unsigned char> >(77);
+  checkBatchMatchesSingle<blocked_bloom_filter<size_t, 4, murmurhash3<size_t>,
+					       unsigned int> >(64);
+}
+
+BOOST_AUTO_TEST_CASE(batchInsert) {
+  blocked_bloom_filter<size_t, 5> single(512 * 16);
+  blocked_bloom_filter<size_t, 5> batch(512 * 16);
+  std::vector<size_t> keys(1000);
+
+  for (size_t i = 0; i < keys.size(); ++i)
+    keys[i] = i * 3;
+
+  single.insert(keys.begin(), keys.end());
+  batch.insert_batch(keys.begin(), keys.end());
+  BOOST_CHECK(single == batch);
+}
+
+BOOST_AUTO_TEST_CASE(batchKernelsAgree) {
+  using namespace boost::bloom_filters::detail;
+
+  blocked_bloom_filter<size_t, 6> bloom(512 * 8);
+  boost::uint64_t blocks[64];
+  boost::uint64_t seeds[64];
+
+  for (size_t i = 0; i < 200; ++i)
+    bloom.insert(i);
+
+  // a mix of probably-contained and absent probe patterns
+  for (size_t i = 0; i < 64; ++i) {
+    blocks[i] = i % 8;
+    seeds[i] = (i * 0x9e3779b97f4a7c15ull) >> 32;
+  }
+
+  const void *const words = &bloom.data()[0];
+
+  // whole and partial groups of 16, 8 and 4 keys
+  const size_t sizes[] = {3, 8, 16, 24, 61, 64};
+  for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); ++s) {
+    const size_t n = sizes[s];
+    const boost::uint64_t expected =
+      blocked_contains_scalar<6, size_t>(words, blocks, seeds, n);
+
+#ifdef BOOST_BLOOM_FILTER_HAS_SIMD_DISPATCH
+    if (cpu_simd_level() >= simd_avx2) {
+      const boost::uint64_t avx2 =
+	blocked_contains_avx2<6, size_t>(words, blocks, seeds, n);
+      BOOST_CHECK_EQUAL(avx2, expected);
+    }
+
+    if (cpu_simd_level() >= simd_avx512) {
+      const boost::uint64_t avx512 =
+	blocked_contains_avx512<6, size_t>(words, blocks, seeds, n);
+      BOOST_CHECK_EQUAL(avx512, expected);
+    }
+#endif
+  }
+}
+
+BOOST_AUTO_TEST_CASE(rangeInsert) {
+  int elems[5] = {1,2,3,4,5};
+  blocked_bloom_filter<int> bloom(512 * 16);
+
+  bloom.insert(elems, elems+5);
+  BOOST_CHECK_LE(bloom.count(), 20ul);
+  BOOST_CHECK_GE(bloom.count(), 4ul);
+
+  for (size_t i = 0; i < 5; ++i)
+    BOOST_CHECK_EQUAL(bloom.probably_contains(elems[i]), true);
+}
+
+BOOST_AUTO_TEST_CASE(clear) {
+  blocked_bloom_filter<size_t> bloom;
+
+  for (size_t i = 0; i < 1000; ++i)
+    bloom.insert(i);
+
+  bloom.clear();
+  BOOST_CHECK_EQUAL(bloom.probably_contains(1), false);
+  BOOST_CHECK_EQUAL(bloom.count(), 0ul);
+}
+
+BOOST_AUTO_TEST_CASE(resize) {
+  blocked_bloom_filter<size_t> bloom;
+
+  bloom.insert(1);
+  bloom.resize(4096);
+
+  BOOST_CHECK_EQUAL(bloom.bit_capacity(), 4096ul);
+  BOOST_CHECK_EQUAL(bloom.count(), 0ul);
+}
+
+struct SwapFixture {
+  SwapFixture()
+    : bloom1(512), bloom2(1024)
+  {
+    for (size_t i = 0; i < 5; ++i)
+      elems[i] = i+1;
+
+    bloom1.insert(elems, elems+2);
+    bloom2.insert(elems+2, elems+5);
+  }
+
+  blocked_bloom_filter<size_t> bloom1;
+  blocked_bloom_filter<size_t> bloom2;
+  size_t elems[5];
+};
+
+BOOST_FIXTURE_TEST_CASE(memberSwap, SwapFixture) {
+  const size_t count1 = bloom1.count();
+  const size_t count2 = bloom2.count();
+
+  bloom1.swap(bloom2);
+
+  BOOST_CHECK_EQUAL(bloom1.count(), count2);
+  BOOST_CHECK_EQUAL(bloom1.bit_capacity(), 1024ul);
+  BOOST_CHECK_EQUAL(bloom2.count(), count1);
+  BOOST_CHECK_EQUAL(bloom2.bit_capacity(), 512ul);
+}
+
+BOOST_FIXTURE_TEST_CASE(globalSwap, SwapFixture) {
+  const size_t count1 = bloom1.count();
+  const size_t count2 = bloom2.count();
+
+  swap(bloom1, bloom2);
+
+  BOOST_CHECK_EQUAL(bloom1.count(), count2);
+  BOOST_CHECK_EQUAL(bloom2.count(), count1);
+}
+
+struct PairwiseOpsFixture {
+  PairwiseOpsFixture() :
+    bloom1(4096), bloom2(4096), bloom_result(4096)
+  {
+  }
+
+  blocked_bloom_filter<size_t> bloom1;
+  blocked_bloom_filter<size_t> bloom2;
+  blocked_bloom_filter<size_t> bloom_result;
+};
+
+BOOST_FIXTURE_TEST_CASE(testUnion, PairwiseOpsFixture) {
+  for (size_t i = 0; i < 50; ++i)
+    bloom1.insert(i);
+
+  for (size_t i = 50; i < 100; ++i)
+    bloom2.insert(i);
+
+  bloom_result = bloom1 | bloom2;
+
+  for (size_t i = 0; i < 100; ++i)
+    BOOST_CHECK_EQUAL(bloom_result.probably_contains(i), true);
+
+  BOOST_CHECK_GE(bloom_result.count(), bloom1.count());
+  BOOST_CHECK_GE(bloom_result.count(), bloom2.count());
+}
+
+BOOST_FIXTURE_TEST_CASE(testUnionAssign, PairwiseOpsFixture) {
+  for (size_t i = 0; i < 100; ++i)
+    bloom1.insert(i);
+
+  bloom_result |= bloom1;
+
+  for (size_t i = 0; i < 100; ++i)
+    BOOST_CHECK_EQUAL(bloom_result.probably_contains(i), true);
+
+  BOOST_CHECK_EQUAL(bloom_result.count(), bloom1.count());
+}
+
+BOOST_FIXTURE_TEST_CASE(testIntersect, PairwiseOpsFixture) {
+  // overlap at 50
+  for (size_t i = 0; i < 51; ++i)
+    bloom1.insert(i);
+
+  for (size_t i = 50; i < 100; ++i)
+    bloom2.insert(i);
+
+  bloom_result = bloom1 & bloom2;
+
+  BOOST_CHECK_LE(bloom_result.count(), bloom1.count());
+  BOOST_CHECK_LE(bloom_result.count(), bloom2.count());
+  BOOST_CHECK_EQUAL(bloom_result.probably_contains(50), true);
+}
+
+BOOST_FIXTURE_TEST_CASE(testIntersectAssign, PairwiseOpsFixture) {
+  for (size_t i = 0; i < 100; ++i)
+    bloom1.insert(i);
+
+  bloom_result &= bloom1;
+
+  for (size_t i = 0; i < 100; ++i)
+    BOOST_CHECK_EQUAL(bloom_result.probably_contains(i), false);
+}
+
+BOOST_FIXTURE_TEST_CASE(equalityOperator, PairwiseOpsFixture) {
+  BOOST_CHECK_EQUAL(bloom1 == bloom2, true);
+  bloom1.insert(1);
+  BOOST_CHECK_EQUAL(bloom1 == bloom2, false);
+  bloom2.insert(1);
+  BOOST_CHECK_EQUAL(bloom1 == bloom2, true);
+}
+
+BOOST_FIXTURE_TEST_CASE(inequalityOperator, PairwiseOpsFixture) {
+  BOOST_CHECK_EQUAL(bloom1 != bloom2, false);
+  bloom1.insert(1);
+  BOOST_CHECK_EQUAL(bloom1 != bloom2, true);
+  bloom2.insert(1);
+  BOOST_CHECK_EQUAL(bloom1 != bloom2, false);
+}
+
+struct IncompatibleSizeFixture {
+  IncompatibleSizeFixture() :
+    bloom1(512), bloom2(1024), exception_thrown(false)
+  {}
+
+  blocked_bloom_filter<size_t> bloom1;
+  blocked_bloom_filter<size_t> bloom2;
+  blocked_bloom_filter<size_t> bloom3;
+  bool exception_thrown;
+};
+
+BOOST_FIXTURE_TEST_CASE(_intersectException, IncompatibleSizeFixture) {
+  try {
+    bloom3 = bloom1 & bloom2;
+  }
+  catch (incompatible_size_exception e) {
+    exception_thrown = true;
+  }
+
+  BOOST_CHECK_EQUAL(exception_thrown, true);
+}
+
+BOOST_FIXTURE_TEST_CASE(_unionException, IncompatibleSizeFixture) {
+  try {
+    bloom3 = bloom1 | bloom2;
+  }
+  catch (incompatible_size_exception e) {
+    exception_thrown = true;
+  }
+
+  BOOST_CHECK_EQUAL(exception_thrown, true);
+}
+
+BOOST_FIXTURE_TEST_CASE(_equalityException, IncompatibleSizeFixture) {
+  try {
+    if (bloom1 == bloom2)
+      exception_thrown = false;
+  }
+  catch (incompatible_size_exception e) {
+    exception_thrown = true;
+  }
+
+  BOOST_CHECK_EQUAL(exception_thrown, true);
+}
+
+BOOST_AUTO_TEST_CASE(preHashed) {
+  typedef blocked_bloom_filter<size_t, 5> Bloom;
+  Bloom plain(512 * 16);
+  Bloom hashed(512 * 16);
+  Bloom other(512 * 3);
+
+  // one digest per key serves filters of both sizes
+  for (size_t i = 0; i < 100; ++i) {
+    const Bloom::digest_type digest = Bloom::hash_key(i * 7);
+
+    plain.insert(i * 7);
+    hashed.insert_hash(digest);
+    other.insert_hash(digest);
+  }
+
+  BOOST_CHECK(plain == hashed);
+
+  for (size_t i = 0; i < 100; ++i) {
+    BOOST_CHECK_EQUAL(hashed.probably_contains_hash(Bloom::hash_key(i * 7)),
+		      true);
+    BOOST_CHECK_EQUAL(other.probably_contains(i * 7), true);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(moveAndSwap) {
+  typedef blocked_bloom_filter<size_t> Bloom;
+  Bloom a(1024);
+  Bloom b(2048);
+  const size_t *const a_storage = &a.data()[0];
+  const size_t *const b_storage = &b.data()[0];
+
+  a.insert(1);
+  b.insert(2);
+
+  // swapping exchanges storage instead of copying it
+  a.swap(b);
+  BOOST_CHECK_EQUAL(a.bit_capacity(), 2048ul);
+  BOOST_CHECK_EQUAL(b.bit_capacity(), 1024ul);
+  BOOST_CHECK_EQUAL(a.probably_contains(2), true);
+  BOOST_CHECK_EQUAL(b.probably_contains(1), true);
+  BOOST_CHECK(&a.data()[0] == b_storage);
+  BOOST_CHECK(&b.data()[0] == a_storage);
+
+#ifndef BOOST_NO_CXX11_RVALUE_REFERENCES
+  BOOST_CHECK(boost::is_nothrow_move_constructible<Bloom>::value);
+
+  Bloom c(std::move(a));
+  BOOST_CHECK_EQUAL(c.bit_capacity(), 2048ul);
+  BOOST_CHECK_EQUAL(c.probably_contains(2), true);
+  BOOST_CHECK_EQUAL(a.bit_capacity(), 0ul);
+  BOOST_CHECK(&c.data()[0] == b_storage);
+
+  // a moved-from filter can be assigned to again
+  a = std::move(c);
+  BOOST_CHECK_EQUAL(a.bit_capacity(), 2048ul);
+  BOOST_CHECK_EQUAL(a.probably_contains(2), true);
+  BOOST_CHECK_EQUAL(c.bit_capacity(), 0ul);
+
+  // an rvalue left operand lends its storage to the result
+  Bloom d(2048);
+  d.insert(3);
+  Bloom u = Bloom(a) | d;
+  Bloom i = std::move(u) & a;
+  BOOST_CHECK_EQUAL(u.bit_capacity(), 0ul);
+  BOOST_CHECK(i == a);
+#endif
+}
@@ -0,0 +1,211 @@
+//////////////////////////////////////////////////////////////////////////////
+//
+// (C) Copyright Alejandro Cabrera 2011.
+// Distributed under the Boost
+// Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or
+// copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// See http://www.boost.org/libs/bloom_filter for documentation.
+//
+//////////////////////////////////////////////////////////////////////////////
+
+#define BOOST_TEST_DYN_LINK 1
+#define BOOST_TEST_MODULE "Boost Bloom Filter" 1
+#include <cstring>
+#include <vector>
+
+#include <boost/bloom_filter/basic_bloom_filter.hpp>
+#include <boost/bloom_filter/bloom_filter_view.hpp>
+#include <boost/bloom_filter/dynamic_bloom_filter.hpp>
+#include <boost/bloom_filter/serialization.hpp>
+#include <boost/bloom_filter/twohash_dynamic_basic_bloom_filter.hpp>
+#include <boost/test/unit_test.hpp>
+
+using namespace boost::bloom_filters;
+using boost::bloom_filters::detail::invalid_parameter_exception;
+using boost::bloom_filters::detail::serialization_exception;
+
+typedef boost::mpl::vector<boost_hash<size_t, 1>,
+			   boost_hash<size_t, 2>,
+			   boost_hash<size_t, 3> > ThreeHashes;
+
+// the saved image of filter, in 8 byte aligned memory
+template <typename Filter>
+std::vector<boost::uint64_t> image_of(const Filter& filter)
+{
+  std::vector<boost::uint64_t> image((serialized_size(filter) + 7) / 8);
+  save(filter, &image[0], image.size() * 8);
+  return image;
+}
+
+// the view answers every probe as filter does
+template <typename View, typename Filter>
+void check_same(const View& view, const Filter& filter)
+{
+  BOOST_CHECK_EQUAL(view.bit_capacity(), filter.bit_capacity());
+  BOOST_CHECK_EQUAL(view.num_hash_functions(), filter.num_hash_functions());
+  BOOST_CHECK_EQUAL(view.count(), filter.count());
+
+  for (size_t i = 0; i < 2000; ++i) {
+    BOOST_CHECK_EQUAL(view.probably_contains(i), filter.probably_contains(i));
+    BOOST_CHECK_EQUAL(view.probably_contains_hash(View::hash_key(i)),
+		      filter.probably_contains(i));
+  }
+}
+
+BOOST_AUTO_TEST_CASE(viewOfFilter) {
+  dynamic_bloom_filter<size_t, ThreeHashes> filter(10007);
+  for (size_t i = 0; i < 300; ++i)
+    filter.insert(i * 3);
+
+  bloom_filter_view<size_t, ThreeHashes> view(filter);
+  check_same(view, filter);
+
+  // the view sees later inserts: it reads the filter's own bits
+  BOOST_CHECK(!view.probably_contains(5000 * 3 + 1) ||
+	      filter.probably_contains(5000 * 3 + 1));
+  filter.insert(5000 * 3 + 1);
+  BOOST_CHECK(view.probably_contains(5000 * 3 + 1));
+}
+
+BOOST_AUTO_TEST_CASE(viewOfBlocks) {
+  dynamic_bloom_filter<size_t, ThreeHashes> filter(1000);
+  for (size_t i = 0; i < 100; ++i)
+    filter.insert(i);
+
+  std::vector<size_t> blocks((1000 + 63) / 64 + 1, 0);
+  for (size_t i = 0; i < 1000; ++i)
+    if (filter.data()[i])
+      blocks[i / 64] |= static_cast<size_t>(1) << (i % 64);
+  // bits past the capacity are never read or counted
+  blocks.back() = ~static_cast<size_t>(0);
+  blocks[1000 / 64] |= ~static_cast<size_t>(0) << (1000 % 64);
+
+  bloom_filter_view<size_t, ThreeHashes> view(&blocks[0], 1000);
+  check_same(view, filter);
+}
+
+BOOST_AUTO_TEST_CASE(viewOfImage) {
+  dynamic_bloom_filter<size_t, ThreeHashes> filter(4099);
+  for (size_t i = 0; i < 200; ++i)
+    filter.insert(i * 11);
+
+  const std::vector<boost::uint64_t> image = image_of(filter);
+  bloom_filter_view<size_t, ThreeHashes> view(
+    filter_image(&image[0], image.size() * 8));
+  check_same(view, filter);
+
+  // the view reads the image where it is
+  BOOST_CHECK(reinterpret_cast<const char *>(view.data().data()) ==
+	      reinterpret_cast<const char *>(&image[0]) + 64);
+}
+
+BOOST_AUTO_TEST_CASE(viewOfFixedSizeImage) {
+  basic_bloom_filter<size_t, 4096, ThreeHashes> filter;
+  for (size_t i = 0; i < 200; ++i)
+    filter.insert(i * 13);
+
+  const std::vector<boost::uint64_t> image = image_of(filter);
+  bloom_filter_view<size_t, ThreeHashes, unsigned char> view(
+    filter_image(&image[0], image.size() * 8));
+  check_same(view, filter);
+}
+
+BOOST_AUTO_TEST_CASE(imageMustMatch) {
+  dynamic_bloom_filter<size_t, ThreeHashes> filter(4099);
+  std::vector<boost::uint64_t> image = image_of(filter);
+  const filter_image whole(&image[0], image.size() * 8);
+
+  typedef boost::mpl::vector<boost_hash<size_t, 1>,
+			     boost_hash<size_t, 2> > TwoHashes;
+  BOOST_CHECK_THROW(
+    (bloom_filter_view<size_t, TwoHashes>(whole).bit_capacity()),
+    serialization_exception);
+  BOOST_CHECK_THROW(
+    (bloom_filter_view<size_t, ThreeHashes, size_t, fastrange_reduction>(
+      whole).bit_capacity()),
+    serialization_exception);
+  BOOST_CHECK_THROW(twohash_bloom_filter_view<size_t>(whole).bit_capacity(),
+		    serialization_exception);
+  BOOST_CHECK_THROW(
+    (bloom_filter_view<size_t, ThreeHashes>(
+      filter_image(&image[0], image.size() * 8 - 8))),
+    serialization_exception);
+
+  // blocks not aligned for the view's Block
+  std::vector<boost::uint64_t> shifted(image.size() + 1);
+  char *const moved = reinterpret_cast<char *>(&shifted[0]) + 4;
+  std::memcpy(moved, &image[0], image.size() * 8);
+  BOOST_CHECK_THROW(
+    (bloom_filter_view<size_t, ThreeHashes>(
+      filter_image(moved, image.size() * 8))),
+    serialization_exception);
+  bloom_filter_view<size_t, ThreeHashes, boost::uint32_t> narrow(
+    filter_image(moved, image.size() * 8));
+  check_same(narrow, filter);
+}
+
+BOOST_AUTO_TEST_CASE(twohashViewOfFilter) {
+  twohash_dynamic_basic_bloom_filter<size_t, 4> filter(8191);
+  for (size_t i = 0; i < 300; ++i)
+    filter.insert(i * 5);
+
+  twohash_bloom_filter_view<size_t, 4> view(filter);
+  check_same(view, filter);
+
+  twohash_bloom_filter_view<size_t, 4> raw(
+    &boost::bloom_filters::detail::blocks_of(filter.data())[0],
+    filter.bit_capacity());
+  check_same(raw, filter);
+}
+
+BOOST_AUTO_TEST_CASE(twohashViewOfImage) {
+  twohash_dynamic_basic_bloom_filter<size_t, runtime_hash_values>
+    filter(1000, 0.001);
+  for (size_t i = 0; i < 300; ++i)
+    filter.insert(i * 5);
+
+  const std::vector<boost::uint64_t> image = image_of(filter);
+  twohash_bloom_filter_view<size_t, runtime_hash_values> view(
+    filter_image(&image[0], image.size() * 8));
+  check_same(view, filter);
+
+  BOOST_CHECK_THROW(
+    (twohash_bloom_filter_view<size_t, 3>(
+      filter_image(&image[0], image.size() * 8))),
+    serialization_exception);
+}
+
+BOOST_AUTO_TEST_CASE(runtimeHashValuesChecked) {
+  const size_t blocks[2] = {0, 0};
+
+  BOOST_CHECK_THROW(
+    (twohash_bloom_filter_view<size_t, runtime_hash_values>(blocks, 128, 0)),
+    invalid_parameter_exception);
+  BOOST_CHECK_THROW(
+    (twohash_bloom_filter_view<size_t, runtime_hash_values>(blocks, 128, 33)),
+    invalid_parameter_exception);
+
+  twohash_bloom_filter_view<size_t, runtime_hash_values> view(blocks, 128, 7);
+  BOOST_CHECK_EQUAL(view.num_hash_functions(), 7ul);
+  BOOST_CHECK(view.empty());
+}
+
+BOOST_AUTO_TEST_CASE(batchProbes) {
+  dynamic_bloom_filter<size_t, ThreeHashes> filter(10007);
+  std::vector<size_t> keys;
+  for (size_t i = 0; i < 500; ++i) {
+    keys.push_back(i * 2);
+    if (i % 3 == 0)
+      filter.insert(i * 2);
+  }
+
+  bloom_filter_view<size_t, ThreeHashes> view(filter);
+  std::vector<boost::uint64_t> ours((keys.size() + 63) / 64);
+  std::vector<boost::uint64_t> theirs((keys.size() + 63) / 64);
+  BOOST_CHECK_EQUAL(
+    view.probably_contains_batch(keys.begin(), keys.end(), &ours[0]),
+    filter.probably_contains_batch(keys.begin(), keys.end(), &theirs[0]));
+  BOOST_CHECK(ours == theirs);
+}
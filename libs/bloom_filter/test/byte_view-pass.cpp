@@ -0,0 +1,156 @@
+//////////////////////////////////////////////////////////////////////////////
+//
+// (C) Copyright Alejandro Cabrera 2011.
+// Distributed under the Boost
+// Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or
+// copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// See http://www.boost.org/libs/bloom_filter for documentation.
+//
+//////////////////////////////////////////////////////////////////////////////
+
+#define BOOST_TEST_DYN_LINK 1
+#define BOOST_TEST_MODULE "Boost Bloom Filter" 1
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <boost/bloom_filter/hash/byte_view.hpp>
+#include <boost/bloom_filter/hash/murmurhash3.hpp>
+#include <boost/bloom_filter/hash/double_hashing.hpp>
+#include <boost/bloom_filter/basic_bloom_filter.hpp>
+#include <boost/bloom_filter/twohash_basic_bloom_filter.hpp>
+#include <boost/lexical_cast.hpp>
+#include <boost/test/unit_test.hpp>
+
+using boost::bloom_filters::byte_view;
+using boost::bloom_filters::murmurhash3;
+using boost::bloom_filters::murmurhash3_128;
+
+// owns its text, like the strings it wraps
+struct url {
+  explicit url(const std::string& text) : text(text) {}
+  std::string text;
+};
+
+namespace boost {
+  namespace bloom_filters {
+    template <>
+    struct byte_view<url> {
+      static const void *data(const url& u) { return u.text.data(); }
+      static size_t size(const url& u) { return u.text.size(); }
+    };
+  }
+}
+
+BOOST_AUTO_TEST_CASE(stringsHashTheirContents) {
+  const std::string a("http://www.boost.org/libs/bloom_filter");
+  const std::string b(a.begin(), a.end());
+  murmurhash3<std::string> hasher;
+
+  BOOST_CHECK(a.data() != b.data());
+  BOOST_CHECK_EQUAL(hasher(a), hasher(b));
+  BOOST_CHECK(hasher(a) != hasher(a + "/"));
+
+  BOOST_CHECK_EQUAL(byte_view<std::string>::data(a),
+		    static_cast<const void *>(a.data()));
+  BOOST_CHECK_EQUAL(byte_view<std::string>::size(a), a.size());
+  BOOST_CHECK_EQUAL(byte_view<std::wstring>::size(std::wstring(L"abc")),
+		    3 * sizeof(wchar_t));
+}
+
+BOOST_AUTO_TEST_CASE(viewsHashLikeStrings) {
+  const std::string s("http://www.boost.org/");
+  const boost::string_view view(s);
+  murmurhash3<std::string> string_hasher;
+  murmurhash3<boost::string_view> view_hasher;
+
+  BOOST_CHECK_EQUAL(string_hasher(s), view_hasher(view));
+  BOOST_CHECK_EQUAL(view_hasher(view.substr(0, 4)),
+		    string_hasher(std::string("http")));
+
+#ifndef BOOST_NO_CXX17_HDR_STRING_VIEW
+  murmurhash3<std::string_view> std_view_hasher;
+  BOOST_CHECK_EQUAL(std_view_hasher(std::string_view(s)), string_hasher(s));
+#endif
+}
+
+BOOST_AUTO_TEST_CASE(podVectorsHashTheirElements) {
+  std::vector<int> a;
+  for (int i = 0; i < 100; ++i)
+    a.push_back(i * i);
+  const std::vector<int> b(a);
+  murmurhash3<std::vector<int> > hasher;
+
+  BOOST_CHECK_EQUAL(hasher(a), hasher(b));
+  BOOST_CHECK_EQUAL(byte_view<std::vector<int> >::size(a),
+		    a.size() * sizeof(int));
+
+  // same bytes, same hash, whatever holds them
+  const char bytes[] = "abcd";
+  const std::vector<char> chars(bytes, bytes + 4);
+  BOOST_CHECK_EQUAL(murmurhash3<std::vector<char> >()(chars),
+		    murmurhash3<std::string>()(std::string("abcd")));
+
+  const std::vector<int> empty;
+  BOOST_CHECK_EQUAL(byte_view<std::vector<int> >::size(empty), 0ul);
+  BOOST_CHECK_EQUAL(hasher(empty), hasher(std::vector<int>()));
+}
+
+BOOST_AUTO_TEST_CASE(otherTypesHashTheirRepresentation) {
+  const size_t x = 12345;
+
+  BOOST_CHECK_EQUAL(byte_view<size_t>::data(x),
+		    static_cast<const void *>(&x));
+  BOOST_CHECK_EQUAL(byte_view<size_t>::size(x), sizeof(size_t));
+  // vector<bool> doesn't compile: byte_view_vector_bool-fail.cpp
+}
+
+BOOST_AUTO_TEST_CASE(userSpecialization) {
+  murmurhash3<url> url_hasher;
+  murmurhash3<std::string> string_hasher;
+  const url u("http://www.boost.org/");
+
+  BOOST_CHECK_EQUAL(url_hasher(u), url_hasher(url(u.text)));
+  BOOST_CHECK_EQUAL(url_hasher(u), string_hasher(u.text));
+
+  murmurhash3_128<url> wide_url_hasher;
+  murmurhash3_128<std::string> wide_string_hasher;
+  BOOST_CHECK(wide_url_hasher(u) == wide_string_hasher(u.text));
+}
+
+BOOST_AUTO_TEST_CASE(stringFilters) {
+  using namespace boost::bloom_filters;
+  typedef boost::mpl::vector<murmurhash3<std::string, 1>,
+			     murmurhash3<std::string, 2>,
+			     murmurhash3<std::string, 3> > hashes;
+
+  basic_bloom_filter<std::string, 8192, hashes> bloom;
+  basic_bloom_filter<std::string, 8192,
+		     enhanced_double_hashing<std::string, 3> > engine_bloom;
+  twohash_basic_bloom_filter<std::string, 8192, 3> twohash_bloom;
+  std::vector<std::string> keys;
+
+  for (size_t i = 0; i < 200; ++i)
+    keys.push_back("http://www.boost.org/" +
+		   boost::lexical_cast<std::string>(i));
+
+  bloom.insert(keys.begin(), keys.end());
+  engine_bloom.insert(keys.begin(), keys.end());
+  twohash_bloom.insert(keys.begin(), keys.end());
+
+  // probe with copies, so a hash of the string object itself would miss
+  size_t false_positives = 0;
+  for (size_t i = 0; i < 200; ++i) {
+    const std::string copy(keys[i].begin(), keys[i].end());
+    BOOST_CHECK_EQUAL(bloom.probably_contains(copy), true);
+    BOOST_CHECK_EQUAL(engine_bloom.probably_contains(copy), true);
+    BOOST_CHECK_EQUAL(twohash_bloom.probably_contains(copy), true);
+
+    false_positives +=
+      bloom.probably_contains(copy + "#");
+  }
+
+  BOOST_CHECK_LT(false_positives, 20ul);
+}
@@ -0,0 +1,23 @@
+//////////////////////////////////////////////////////////////////////////////
+//
+// (C) Copyright Alejandro Cabrera 2011.
+// Distributed under the Boost
+// Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or
+// copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// See http://www.boost.org/libs/bloom_filter for documentation.
+//
+//////////////////////////////////////////////////////////////////////////////
+
+// vector<bool> has no contiguous bytes, so hashing it mustn't compile
+#include <vector>
+
+#include <boost/bloom_filter/hash/murmurhash3.hpp>
+
+int main()
+{
+  const std::vector<bool> bits(10, true);
+  return static_cast<int>(
+    boost::bloom_filters::murmurhash3<std::vector<bool> >()(bits));
+}
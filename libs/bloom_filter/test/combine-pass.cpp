@@ -0,0 +1,136 @@
+//////////////////////////////////////////////////////////////////////////////
+//
+// (C) Copyright Alejandro Cabrera 2011.
+// Distributed under the Boost
+// Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or
+// copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// See http://www.boost.org/libs/bloom_filter for documentation.
+//
+//////////////////////////////////////////////////////////////////////////////
+
+#define BOOST_TEST_DYN_LINK 1
+#define BOOST_TEST_MODULE "Boost Bloom Filter" 1
+#include <cstdlib>
+#include <vector>
+
+#include <boost/bloom_filter/combine.hpp>
+#include <boost/bloom_filter/dynamic_bloom_filter.hpp>
+#include <boost/bloom_filter/twohash_dynamic_basic_bloom_filter.hpp>
+#include <boost/bloom_filter/hash/murmurhash3.hpp>
+#include <boost/test/unit_test.hpp>
+
+using namespace boost::bloom_filters;
+using boost::bloom_filters::detail::incompatible_size_exception;
+
+typedef boost::mpl::vector<murmurhash3<size_t, 1>,
+			   murmurhash3<size_t, 2>,
+			   murmurhash3<size_t, 3> > ThreeHashes;
+typedef dynamic_bloom_filter<size_t, ThreeHashes> Bloom;
+
+static Bloom filled(const size_t bits, const size_t first, const size_t n)
+{
+  Bloom ret(bits);
+  for (size_t i = first; i < first + n; ++i)
+    ret.insert(i);
+  return ret;
+}
+
+BOOST_AUTO_TEST_CASE(kernelsMatchScalar) {
+  using namespace boost::bloom_filters::detail;
+
+  std::srand(7);
+  for (size_t n = 0; n < 300; n += 37) {
+    std::vector<unsigned char> a(n + 1), b(n + 1);
+    for (size_t i = 0; i < a.size(); ++i) {
+      a[i] = static_cast<unsigned char>(std::rand());
+      b[i] = static_cast<unsigned char>(std::rand());
+    }
+
+    for (int op = combine_or; op <= combine_and; ++op) {
+      std::vector<unsigned char> expect(a), got(a);
+      if (op == combine_or)
+	or_bytes_scalar(&expect[0], &b[0], n);
+      else
+	and_bytes_scalar(&expect[0], &b[0], n);
+      combine_kernel_for(combine_op(op))(&got[0], &b[0], n);
+      BOOST_CHECK(got == expect);
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(operatorsKeepCount) {
+  const Bloom a = filled(100003, 0, 5000);
+  const Bloom b = filled(100003, 2500, 5000);
+
+  boost::dynamic_bitset<size_t> ored = a.data() | b.data();
+  boost::dynamic_bitset<size_t> anded = a.data() & b.data();
+
+  Bloom u(a);
+  u |= b;
+  BOOST_CHECK(u.data() == ored);
+  BOOST_CHECK_EQUAL(u.count(), ored.count());
+
+  Bloom n(a);
+  n &= b;
+  BOOST_CHECK(n.data() == anded);
+  BOOST_CHECK_EQUAL(n.count(), anded.count());
+
+  typedef twohash_dynamic_basic_bloom_filter<size_t, 4> Twohash;
+  Twohash c(3001), d(3001);
+  for (size_t i = 0; i < 200; ++i) {
+    c.insert(i);
+    d.insert(i + 100);
+  }
+  boost::dynamic_bitset<size_t> twohash_ored = c.data() | d.data();
+  c |= d;
+  BOOST_CHECK(c.data() == twohash_ored);
+  BOOST_CHECK_EQUAL(c.count(), twohash_ored.count());
+}
+
+BOOST_AUTO_TEST_CASE(threadedMatchesOperators) {
+  // more than one tile, and not a whole number of cache lines
+  const Bloom a = filled(1000003, 0, 50000);
+  const Bloom b = filled(1000003, 25000, 50000);
+
+  for (size_t threads = 1; threads <= 5; ++threads) {
+    Bloom u(a);
+    unite(u, b, threads);
+    BOOST_CHECK(u == (a | b));
+    BOOST_CHECK_EQUAL(u.count(), (a | b).count());
+
+    Bloom n(a);
+    intersect(n, b, threads);
+    BOOST_CHECK(n == (a & b));
+    BOOST_CHECK_EQUAL(n.count(), (a & b).count());
+  }
+
+  Bloom other(1000);
+  BOOST_CHECK_THROW(unite(other, a, 2), incompatible_size_exception);
+}
+
+BOOST_AUTO_TEST_CASE(unionOfMany) {
+  std::vector<Bloom> filters;
+  Bloom expect(70001);
+  for (size_t i = 0; i < 12; ++i) {
+    filters.push_back(filled(70001, i * 1000, 1500));
+    expect |= filters.back();
+  }
+
+  for (size_t threads = 1; threads <= 4; threads += 3) {
+    const Bloom all = union_all(filters.begin(), filters.end(), threads);
+    BOOST_CHECK(all == expect);
+    BOOST_CHECK_EQUAL(all.count(), expect.count());
+  }
+
+  BOOST_CHECK(union_all(filters.begin(), filters.begin() + 1) ==
+	      filters[0]);
+  BOOST_CHECK_EQUAL(union_all(filters.begin(),
+			      filters.begin()).bit_capacity(),
+		    Bloom().bit_capacity());
+
+  filters.push_back(Bloom(100));
+  BOOST_CHECK_THROW(union_all(filters.begin(), filters.end()),
+		    incompatible_size_exception);
+}
@@ -0,0 +1,218 @@
+//////////////////////////////////////////////////////////////////////////////
+//
+// (C) Copyright Alejandro Cabrera 2011.
+// Distributed under the Boost
+// Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or
+// copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// See http://www.boost.org/libs/bloom_filter for documentation.
+//
+//////////////////////////////////////////////////////////////////////////////
+
+#define BOOST_TEST_DYN_LINK 1
+#define BOOST_TEST_MODULE "Boost Bloom Filter" 1
+#include <vector>
+
+#include <boost/bloom_filter/basic_bloom_filter.hpp>
+#include <boost/bloom_filter/concurrent_bloom_filter.hpp>
+#include <boost/bloom_filter/dynamic_bloom_filter.hpp>
+#include <boost/bloom_filter/dynamic_concurrent_bloom_filter.hpp>
+#include <boost/bloom_filter/hash/murmurhash3.hpp>
+#include <boost/thread/thread.hpp>
+#include <boost/test/unit_test.hpp>
+
+using namespace boost::bloom_filters;
+using boost::bloom_filters::detail::incompatible_size_exception;
+
+typedef boost::mpl::vector<murmurhash3<size_t, 1>,
+			   murmurhash3<size_t, 2>,
+			   murmurhash3<size_t, 3> > ThreeHashes;
+
+static const size_t num_threads = 8;
+static const size_t keys_per_thread = 5000;
+
+// the filters have the same bits set
+template <typename Concurrent, typename Serial>
+void check_same_bits(const Concurrent& concurrent, const Serial& serial)
+{
+  BOOST_REQUIRE_EQUAL(concurrent.bit_capacity(), serial.bit_capacity());
+  BOOST_CHECK_EQUAL(concurrent.count(), serial.count());
+
+  size_t differ = 0;
+  for (size_t i = 0; i < serial.bit_capacity(); ++i)
+    if (concurrent.data()[i] != serial.data()[i])
+      ++differ;
+  BOOST_CHECK_EQUAL(differ, 0ul);
+}
+
+// inserts the keys of thread, one at a time or in batches, and probes
+// for each as soon as it is in
+template <typename Bloom>
+struct inserter {
+  inserter(Bloom& filter, const size_t thread, size_t& misses)
+    : filter(filter), thread(thread), misses(misses) {}
+
+  void operator()() const
+  {
+    std::vector<size_t> keys;
+    for (size_t i = 0; i < keys_per_thread; ++i)
+      keys.push_back(i * num_threads + thread);
+
+    if (thread % 2 == 0)
+      filter.insert_batch(keys.begin(), keys.end());
+    else
+      for (size_t i = 0; i < keys.size(); ++i)
+	filter.insert(keys[i]);
+
+    for (size_t i = 0; i < keys.size(); ++i)
+      if (!filter.probably_contains(keys[i]))
+	++misses;
+  }
+
+  Bloom& filter;
+  size_t thread;
+  size_t& misses;
+};
+
+template <typename Bloom>
+void insert_from_threads(Bloom& filter)
+{
+  size_t misses[num_threads] = {0};
+  boost::thread_group threads;
+  for (size_t t = 0; t < num_threads; ++t)
+    threads.create_thread(inserter<Bloom>(filter, t, misses[t]));
+  threads.join_all();
+
+  for (size_t t = 0; t < num_threads; ++t)
+    BOOST_CHECK_EQUAL(misses[t], 0ul);
+}
+
+BOOST_AUTO_TEST_CASE(fixedSizeSetsTheBitsOfBasic) {
+  concurrent_bloom_filter<size_t, 8191, ThreeHashes> concurrent;
+  basic_bloom_filter<size_t, 8191, ThreeHashes> serial;
+  BOOST_CHECK(concurrent.empty());
+
+  for (size_t i = 0; i < 1000; ++i) {
+    concurrent.insert(i * 3);
+    serial.insert(i * 3);
+  }
+  check_same_bits(concurrent, serial);
+  BOOST_CHECK_EQUAL(concurrent.false_positive_rate(),
+		    serial.false_positive_rate());
+
+  for (size_t i = 0; i < 3000; ++i)
+    BOOST_CHECK_EQUAL(concurrent.probably_contains(i),
+		      serial.probably_contains(i));
+}
+
+BOOST_AUTO_TEST_CASE(dynamicSetsTheBitsOfDynamic) {
+  dynamic_concurrent_bloom_filter<size_t, ThreeHashes> concurrent(10007);
+  dynamic_bloom_filter<size_t, ThreeHashes> serial(10007);
+
+  for (size_t i = 0; i < 1000; ++i) {
+    concurrent.insert_hash(concurrent.hash_key(i * 5));
+    serial.insert(i * 5);
+  }
+  check_same_bits(concurrent, serial);
+
+  for (size_t i = 0; i < 5000; ++i)
+    BOOST_CHECK_EQUAL(concurrent.probably_contains_hash(
+			concurrent.hash_key(i)),
+		      serial.probably_contains(i));
+}
+
+BOOST_AUTO_TEST_CASE(sizedForRate) {
+  dynamic_concurrent_bloom_filter<size_t, ThreeHashes> concurrent(1000, 0.01);
+  dynamic_bloom_filter<size_t, ThreeHashes> serial(1000, 0.01);
+  BOOST_CHECK_EQUAL(concurrent.bit_capacity(), serial.bit_capacity());
+}
+
+BOOST_AUTO_TEST_CASE(insertsFromManyThreads) {
+  std::vector<size_t> keys;
+  for (size_t i = 0; i < num_threads * keys_per_thread; ++i)
+    keys.push_back(i);
+
+  dynamic_concurrent_bloom_filter<size_t, ThreeHashes> concurrent(400009);
+  dynamic_bloom_filter<size_t, ThreeHashes> serial(400009);
+  insert_from_threads(concurrent);
+  serial.insert(keys.begin(), keys.end());
+  check_same_bits(concurrent, serial);
+
+  // small blocks put more keys' bits in each word
+  typedef concurrent_bloom_filter<size_t, 65536, ThreeHashes,
+				  unsigned char> Narrow;
+  Narrow narrow;
+  basic_bloom_filter<size_t, 65536, ThreeHashes> narrow_serial;
+  insert_from_threads(narrow);
+  narrow_serial.insert(keys.begin(), keys.end());
+  check_same_bits(narrow, narrow_serial);
+}
+
+BOOST_AUTO_TEST_CASE(batchProbes) {
+  dynamic_concurrent_bloom_filter<size_t, ThreeHashes> concurrent(10007);
+  dynamic_bloom_filter<size_t, ThreeHashes> serial(10007);
+  std::vector<size_t> keys;
+  for (size_t i = 0; i < 500; ++i) {
+    keys.push_back(i * 2);
+    if (i % 3 == 0) {
+      concurrent.insert(i * 2);
+      serial.insert(i * 2);
+    }
+  }
+
+  std::vector<boost::uint64_t> ours((keys.size() + 63) / 64);
+  std::vector<boost::uint64_t> theirs((keys.size() + 63) / 64);
+  BOOST_CHECK_EQUAL(
+    concurrent.probably_contains_batch(keys.begin(), keys.end(), &ours[0]),
+    serial.probably_contains_batch(keys.begin(), keys.end(), &theirs[0]));
+  BOOST_CHECK(ours == theirs);
+}
+
+BOOST_AUTO_TEST_CASE(wholeFilterOps) {
+  typedef dynamic_concurrent_bloom_filter<size_t, ThreeHashes> Bloom;
+  Bloom a(4096);
+  Bloom b(4096);
+  for (size_t i = 0; i < 100; ++i) {
+    a.insert(i);
+    b.insert(i + 50);
+  }
+
+  Bloom copy(a);
+  BOOST_CHECK(copy == a);
+  copy.insert(1000);
+  BOOST_CHECK(copy != a);
+
+  const Bloom u = a | b;
+  const Bloom n = a & b;
+  for (size_t i = 0; i < 150; ++i)
+    BOOST_CHECK(u.probably_contains(i));
+  for (size_t i = 50; i < 100; ++i)
+    BOOST_CHECK(n.probably_contains(i));
+
+  Bloom other(1024);
+  BOOST_CHECK_THROW(a |= other, incompatible_size_exception);
+  BOOST_CHECK_THROW(a == other, incompatible_size_exception);
+
+  other = a;
+  BOOST_CHECK_EQUAL(other.bit_capacity(), 4096ul);
+  BOOST_CHECK(other == a);
+
+  swap(a, copy);
+  BOOST_CHECK(a.probably_contains(1000));
+  a.resize(128);
+  BOOST_CHECK_EQUAL(a.bit_capacity(), 128ul);
+  BOOST_CHECK(a.empty());
+
+  b.clear();
+  BOOST_CHECK(b.empty());
+
+  concurrent_bloom_filter<size_t, 1024> fixed;
+  fixed.insert(7);
+  concurrent_bloom_filter<size_t, 1024> fixed_copy(fixed);
+  BOOST_CHECK(fixed_copy == fixed);
+  fixed.clear();
+  swap(fixed, fixed_copy);
+  BOOST_CHECK(fixed.probably_contains(7));
+  BOOST_CHECK(fixed_copy.empty());
+}
@@ -0,0 +1,224 @@
+//////////////////////////////////////////////////////////////////////////////
+//
+// (C) Copyright Alejandro Cabrera 2011.
+// Distributed under the Boost
+// Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or
+// copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// See http://www.boost.org/libs/bloom_filter for documentation.
+//
+//////////////////////////////////////////////////////////////////////////////
+
+#define BOOST_TEST_DYN_LINK 1
+#define BOOST_TEST_MODULE "Boost Bloom Filter" 1
+#include <vector>
+
+#include <boost/bloom_filter/counting_bloom_filter.hpp>
+#include <boost/bloom_filter/concurrent_counting_bloom_filter.hpp>
+#include <boost/bloom_filter/dynamic_counting_bloom_filter.hpp>
+#include <boost/bloom_filter/dynamic_concurrent_counting_bloom_filter.hpp>
+#include <boost/bloom_filter/hash/murmurhash3.hpp>
+#include <boost/thread/thread.hpp>
+#include <boost/test/unit_test.hpp>
+
+using namespace boost::bloom_filters;
+using boost::bloom_filters::detail::incompatible_size_exception;
+using boost::bloom_filters::detail::read_bin;
+
+typedef boost::mpl::vector<murmurhash3<size_t, 1>,
+			   murmurhash3<size_t, 2>,
+			   murmurhash3<size_t, 3> > ThreeHashes;
+
+static const size_t num_threads = 8;
+static const size_t keys_per_thread = 2000;
+
+// the filters' bins hold the same counts
+template <typename Concurrent, typename Serial>
+void check_same_bins(const Concurrent& concurrent, const Serial& serial)
+{
+  BOOST_REQUIRE_EQUAL(concurrent.num_bins(), serial.num_bins());
+  BOOST_CHECK_EQUAL(concurrent.count(), serial.count());
+
+  size_t differ = 0;
+  for (size_t i = 0; i < serial.num_bins(); ++i)
+    if (read_bin<Concurrent>(concurrent.data(), i) !=
+	read_bin<Serial>(serial.data(), i))
+      ++differ;
+  BOOST_CHECK_EQUAL(differ, 0ul);
+}
+
+// inserts the keys of thread, probes for each, then removes them all
+template <typename Bloom>
+struct churner {
+  churner(Bloom& filter, const size_t thread, size_t& misses)
+    : filter(filter), thread(thread), misses(misses) {}
+
+  void operator()() const
+  {
+    std::vector<size_t> keys;
+    for (size_t i = 0; i < keys_per_thread; ++i)
+      keys.push_back(i * num_threads + thread);
+
+    misses += filter.insert(keys.begin(), keys.end());
+    for (size_t i = 0; i < keys.size(); ++i)
+      if (!filter.probably_contains(keys[i]))
+	++misses;
+    misses += filter.remove(keys.begin(), keys.end());
+  }
+
+  Bloom& filter;
+  size_t thread;
+  size_t& misses;
+};
+
+BOOST_AUTO_TEST_CASE(fixedSizeCountsAsCounting) {
+  concurrent_counting_bloom_filter<size_t, 4096, 4, ThreeHashes> concurrent;
+  counting_bloom_filter<size_t, 4096, 4, ThreeHashes> serial;
+  BOOST_CHECK(concurrent.empty());
+
+  for (size_t i = 0; i < 600; ++i) {
+    BOOST_CHECK(concurrent.insert(i % 400));
+    serial.insert(i % 400);
+  }
+  for (size_t i = 0; i < 100; ++i) {
+    BOOST_CHECK(concurrent.remove(i));
+    serial.remove(i);
+  }
+  check_same_bins(concurrent, serial);
+  BOOST_CHECK_EQUAL(concurrent.false_positive_rate(),
+		    serial.false_positive_rate());
+
+  for (size_t i = 0; i < 1000; ++i)
+    BOOST_CHECK_EQUAL(concurrent.probably_contains(i),
+		      serial.probably_contains(i));
+}
+
+BOOST_AUTO_TEST_CASE(dynamicCountsAsDynamicCounting) {
+  dynamic_concurrent_counting_bloom_filter<size_t, 8, ThreeHashes>
+    concurrent(5003);
+  dynamic_counting_bloom_filter<size_t, 8, ThreeHashes> serial(5003);
+
+  for (size_t i = 0; i < 800; ++i) {
+    BOOST_CHECK(concurrent.insert_hash(concurrent.hash_key(i * 7)));
+    serial.insert(i * 7);
+  }
+  for (size_t i = 0; i < 200; ++i) {
+    BOOST_CHECK(concurrent.remove_hash(concurrent.hash_key(i * 7)));
+    serial.remove(i * 7);
+  }
+  check_same_bins(concurrent, serial);
+
+  for (size_t i = 0; i < 5600; ++i)
+    BOOST_CHECK_EQUAL(concurrent.probably_contains_hash(
+			concurrent.hash_key(i)),
+		      serial.probably_contains(i));
+
+  dynamic_concurrent_counting_bloom_filter<size_t, 8, ThreeHashes>
+    sized(1000, 0.01);
+  dynamic_counting_bloom_filter<size_t, 8, ThreeHashes> serial_sized(1000,
+								      0.01);
+  BOOST_CHECK_EQUAL(sized.num_bins(), serial_sized.num_bins());
+}
+
+BOOST_AUTO_TEST_CASE(insertsAndRemovesFromManyThreads) {
+  // small blocks put several keys' bins in each word
+  typedef concurrent_counting_bloom_filter<size_t, 65536, 4, ThreeHashes,
+					   unsigned char> Narrow;
+  typedef dynamic_concurrent_counting_bloom_filter<size_t, 4,
+						   ThreeHashes> Dynamic;
+  Narrow narrow;
+  Dynamic dynamic(100003);
+
+  size_t narrow_misses[num_threads] = {0};
+  size_t dynamic_misses[num_threads] = {0};
+  boost::thread_group threads;
+  for (size_t t = 0; t < num_threads; ++t) {
+    threads.create_thread(churner<Narrow>(narrow, t, narrow_misses[t]));
+    threads.create_thread(churner<Dynamic>(dynamic, t, dynamic_misses[t]));
+  }
+  threads.join_all();
+
+  for (size_t t = 0; t < num_threads; ++t) {
+    BOOST_CHECK_EQUAL(narrow_misses[t], 0ul);
+    BOOST_CHECK_EQUAL(dynamic_misses[t], 0ul);
+  }
+  BOOST_CHECK(narrow.empty());
+  BOOST_CHECK(dynamic.empty());
+}
+
+BOOST_AUTO_TEST_CASE(overflowAndUnderflowAreReported) {
+  typedef concurrent_counting_bloom_filter<size_t, 64, 2> Bloom;
+  Bloom filter;
+
+  BOOST_CHECK(!filter.remove(1));
+  BOOST_CHECK(filter.empty());
+
+  for (size_t i = 0; i < Bloom::mask(); ++i)
+    BOOST_CHECK(filter.insert(1));
+  BOOST_CHECK(!filter.insert(1));
+  BOOST_CHECK(filter.probably_contains(1));
+
+  // a full bin is sticky: removes leave it full
+  for (size_t i = 0; i < Bloom::mask() + 1; ++i)
+    BOOST_CHECK(filter.remove(1));
+  BOOST_CHECK(filter.probably_contains(1));
+  BOOST_CHECK(!filter.empty());
+
+  filter.clear();
+  const std::vector<size_t> keys(Bloom::mask() + 2, 5);
+  BOOST_CHECK_EQUAL(filter.insert(keys.begin(), keys.end()), 2ul);
+  BOOST_CHECK_EQUAL(filter.remove(keys.begin(), keys.end()), 0ul);
+  BOOST_CHECK(filter.probably_contains(5));
+}
+
+BOOST_AUTO_TEST_CASE(overflowKeepsOtherKeys) {
+  // four 2-bit bins, so forty keys overflow every one of them
+  typedef concurrent_counting_bloom_filter<size_t, 4, 2> Bloom;
+  Bloom filter;
+
+  std::vector<size_t> keys;
+  for (size_t i = 0; i < 40; ++i)
+    keys.push_back(i);
+  BOOST_CHECK_GT(filter.insert(keys.begin(), keys.end()), 0ul);
+
+  // removing all but one key must not empty the bin of the last one
+  filter.remove(keys.begin(), keys.end() - 1);
+  BOOST_CHECK(filter.probably_contains(keys.back()));
+}
+
+BOOST_AUTO_TEST_CASE(wholeFilterOps) {
+  typedef dynamic_concurrent_counting_bloom_filter<size_t> Bloom;
+  Bloom a(1024);
+  for (size_t i = 0; i < 100; ++i)
+    a.insert(i);
+
+  Bloom copy(a);
+  BOOST_CHECK(copy == a);
+  copy.insert(1000);
+  BOOST_CHECK(copy != a);
+
+  Bloom other;
+  BOOST_CHECK_EQUAL(other.num_bins(), 32ul);
+  BOOST_CHECK_THROW(a == other, incompatible_size_exception);
+
+  other = a;
+  BOOST_CHECK_EQUAL(other.num_bins(), 1024ul);
+  BOOST_CHECK(other == a);
+
+  swap(a, copy);
+  BOOST_CHECK(a.probably_contains(1000));
+  BOOST_CHECK(copy == other);
+
+  a.clear();
+  BOOST_CHECK(a.empty());
+
+  concurrent_counting_bloom_filter<size_t, 1024> fixed;
+  fixed.insert(7);
+  concurrent_counting_bloom_filter<size_t, 1024> fixed_copy(fixed);
+  BOOST_CHECK(fixed_copy == fixed);
+  fixed.clear();
+  swap(fixed, fixed_copy);
+  BOOST_CHECK(fixed.probably_contains(7));
+  BOOST_CHECK(fixed_copy.empty());
+}
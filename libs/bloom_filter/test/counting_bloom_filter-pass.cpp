@@ -25,6 +25,7 @@ using boost::bloom_filters::counting_bloom_filter;
 using boost::bloom_filters::detail::bin_underflow_exception;
 using boost::bloom_filters::detail::bin_overflow_exception;
 using boost::bloom_filters::boost_hash;
+using boost::bloom_filters::heap_storage;
 
 BOOST_AUTO_TEST_CASE(allBitsPerBinCompile)
 {
@@ -434,3 +435,175 @@ BOOST_FIXTURE_TEST_CASE(inequalityOperator, PairwiseOpsFixture) {
   bloom2.insert(1);
   BOOST_CHECK_EQUAL(bloom1 != bloom2, false);
 }
+
+BOOST_AUTO_TEST_CASE(batchOperations) {
+  typedef counting_bloom_filter<size_t, 8192, 4, boost::mpl::vector<
+    boost_hash<size_t, 1>,
+    boost_hash<size_t, 2>,
+    boost_hash<size_t, 3> > > Bloom;
+  Bloom single;
+  Bloom batch;
+  size_t keys[300];
+  boost::uint64_t out[(300 + 63) / 64];
+
+  for (size_t i = 0; i < 300; ++i)
+    keys[i] = i * 7;
+
+  single.insert(keys, keys + 150);
+  batch.insert_batch(keys, keys + 150);
+  BOOST_CHECK(single == batch);
+
+  const size_t found = batch.probably_contains_batch(keys, keys + 300, out);
+
+  size_t expected = 0;
+  for (size_t i = 0; i < 300; ++i) {
+    const bool bit = ((out[i / 64] >> (i % 64)) & 1) != 0;
+    BOOST_CHECK_EQUAL(bit, single.probably_contains(keys[i]));
+    expected += bit;
+  }
+
+  BOOST_CHECK_EQUAL(found, expected);
+  BOOST_CHECK_GE(found, 150ul);
+}
+
+BOOST_AUTO_TEST_CASE(preHashed) {
+  typedef counting_bloom_filter<size_t, 8192, 4, boost::mpl::vector<
+    boost_hash<size_t, 1>,
+    boost_hash<size_t, 2>,
+    boost_hash<size_t, 3> > > Bloom;
+  typedef counting_bloom_filter<size_t, 1000, 4, boost::mpl::vector<
+    boost_hash<size_t, 1>,
+    boost_hash<size_t, 2>,
+    boost_hash<size_t, 3> > > Other;
+  Bloom plain;
+  Bloom hashed;
+  Other other;
+
+  // one digest per key serves filters of both sizes
+  for (size_t i = 0; i < 100; ++i) {
+    const Bloom::digest_type digest = Bloom::hash_key(i * 7);
+    BOOST_CHECK(digest == Other::hash_key(i * 7));
+
+    plain.insert(i * 7);
+    hashed.insert_hash(digest);
+    other.insert_hash(digest);
+  }
+
+  BOOST_CHECK(plain == hashed);
+
+  for (size_t i = 0; i < 100; ++i) {
+    BOOST_CHECK_EQUAL(hashed.probably_contains_hash(Bloom::hash_key(i * 7)),
+		      true);
+    BOOST_CHECK_EQUAL(other.probably_contains(i * 7), true);
+  }
+
+  for (size_t i = 0; i < 100; ++i)
+    hashed.remove_hash(Bloom::hash_key(i * 7));
+
+  BOOST_CHECK(hashed.empty());
+}
+
+BOOST_AUTO_TEST_CASE(heapStorage)
+{
+  // 16M four bit bins, 8 MiB
+  typedef counting_bloom_filter<size_t, (static_cast<size_t>(1) << 24), 4,
+				boost::mpl::vector<boost_hash<size_t> >,
+				size_t,
+				boost::bloom_filters::mask_reduction,
+				heap_storage<128> > Bloom;
+  BOOST_CHECK_EQUAL(sizeof(Bloom), sizeof(void *));
+
+  Bloom a;
+  BOOST_CHECK(a.empty());
+  BOOST_CHECK_EQUAL(reinterpret_cast<size_t>(&a.data()) % 128, 0ul);
+
+  for (size_t i = 0; i < 1000; ++i)
+    a.insert(i);
+
+  Bloom b(a);
+  BOOST_CHECK(a == b);
+  b.remove(0);
+  BOOST_CHECK(a != b);
+
+  const void *const a_bins = &a.data();
+  swap(a, b);
+  BOOST_CHECK_EQUAL(&b.data(), a_bins);
+  BOOST_CHECK(!a.probably_contains(0));
+  BOOST_CHECK(b.probably_contains(0));
+
+  for (size_t i = 0; i < 1000; ++i)
+    b.remove(i);
+
+  BOOST_CHECK(b.empty());
+}
+
+// the bins of bloom in use, counted one at a time
+template <typename Bloom>
+size_t bins_in_use(const Bloom& bloom)
+{
+  size_t ret = 0;
+  for (size_t bin = 0; bin < bloom.num_bins(); ++bin) {
+    const size_t slot = bloom.data()[bin / bloom.bins_per_slot()];
+    const size_t offset = (bin % bloom.bins_per_slot()) * bloom.bits_per_bin();
+    if (((slot >> offset) & bloom.mask()) != 0)
+      ++ret;
+  }
+  return ret;
+}
+
+BOOST_AUTO_TEST_CASE(countIsKept)
+{
+  typedef boost::mpl::vector<boost_hash<size_t, 1>,
+			     boost_hash<size_t, 2>,
+			     boost_hash<size_t, 3> > ThreeHashes;
+  typedef counting_bloom_filter<size_t, 301, 4, ThreeHashes> Bloom;
+  Bloom bloom;
+
+  for (size_t i = 0; i < 60; ++i) {
+    bloom.insert(i);
+    bloom.insert_hash(Bloom::hash_key(i));
+  }
+  BOOST_CHECK_EQUAL(bloom.count(), bins_in_use(bloom));
+
+  for (size_t i = 0; i < 60; i += 2) {
+    bloom.remove(i);
+    bloom.remove_hash(Bloom::hash_key(i));
+  }
+  BOOST_CHECK_EQUAL(bloom.count(), bins_in_use(bloom));
+
+  Bloom copy(bloom);
+  copy.clear();
+  swap(copy, bloom);
+  BOOST_CHECK(bloom.empty());
+  BOOST_CHECK_EQUAL(copy.count(), bins_in_use(copy));
+}
+
+BOOST_AUTO_TEST_CASE(countSurvivesOverflow)
+{
+  // one bit bins overflow as soon as two keys share one
+  typedef boost::mpl::vector<boost_hash<size_t, 1>,
+			     boost_hash<size_t, 2>,
+			     boost_hash<size_t, 3> > ThreeHashes;
+  counting_bloom_filter<size_t, 64, 1, ThreeHashes> bloom;
+
+  size_t overflows = 0;
+  for (size_t i = 0; i < 64; ++i) {
+    try {
+      bloom.insert(i);
+    }
+    catch (bin_overflow_exception&) {
+      ++overflows;
+    }
+    BOOST_CHECK_EQUAL(bloom.count(), bins_in_use(bloom));
+  }
+  BOOST_CHECK(overflows > 0);
+
+  for (size_t i = 0; i < 64; ++i) {
+    try {
+      bloom.remove(i);
+    }
+    catch (bin_underflow_exception&) {
+    }
+    BOOST_CHECK_EQUAL(bloom.count(), bins_in_use(bloom));
+  }
+}
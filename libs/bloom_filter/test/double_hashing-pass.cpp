@@ -0,0 +1,159 @@
+//////////////////////////////////////////////////////////////////////////////
+//
+// (C) Copyright Alejandro Cabrera 2011.
+// Distributed under the Boost
+// Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or
+// copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// See http://www.boost.org/libs/bloom_filter for documentation.
+//
+//////////////////////////////////////////////////////////////////////////////
+
+#define BOOST_TEST_DYN_LINK 1
+#define BOOST_TEST_MODULE "Boost Bloom Filter" 1
+#include <cmath>
+
+#include <boost/bloom_filter/hash/double_hashing.hpp>
+#include <boost/bloom_filter/basic_bloom_filter.hpp>
+#include <boost/bloom_filter/dynamic_bloom_filter.hpp>
+#include <boost/bloom_filter/counting_bloom_filter.hpp>
+#include <boost/bloom_filter/dynamic_counting_bloom_filter.hpp>
+#include <boost/test/unit_test.hpp>
+
+using boost::bloom_filters::enhanced_double_hashing;
+using boost::bloom_filters::murmurhash3_128;
+using boost::bloom_filters::basic_bloom_filter;
+using boost::bloom_filters::dynamic_bloom_filter;
+using boost::bloom_filters::counting_bloom_filter;
+using boost::bloom_filters::dynamic_counting_bloom_filter;
+
+// a wide hash with a known result
+struct fixed_wide_hash {
+  typedef std::pair<boost::uint64_t, boost::uint64_t> result_type;
+
+  result_type operator()(const size_t) {
+    return result_type(100, 7);
+  }
+};
+
+BOOST_AUTO_TEST_CASE(engineValues) {
+  enhanced_double_hashing<size_t, 5, fixed_wide_hash> engine;
+  size_t out[5];
+
+  engine(0, out);
+
+  // x + i * y + (i^3 - i) / 6
+  BOOST_CHECK_EQUAL(out[0], 100ul);
+  BOOST_CHECK_EQUAL(out[1], 107ul);
+  BOOST_CHECK_EQUAL(out[2], 115ul);
+  BOOST_CHECK_EQUAL(out[3], 125ul);
+  BOOST_CHECK_EQUAL(out[4], 138ul);
+}
+
+BOOST_AUTO_TEST_CASE(wideHashUsesBothHalves) {
+  murmurhash3_128<size_t> hasher;
+  const murmurhash3_128<size_t>::result_type h1 = hasher(1);
+  const murmurhash3_128<size_t>::result_type h2 = hasher(2);
+
+  BOOST_CHECK(h1.first != h1.second);
+  BOOST_CHECK(h1.first != h2.first);
+  BOOST_CHECK(h1.second != h2.second);
+}
+
+BOOST_AUTO_TEST_CASE(numHashFunctions) {
+  typedef enhanced_double_hashing<size_t, 7> engine;
+
+  BOOST_CHECK_EQUAL((basic_bloom_filter<size_t, 64, engine>::
+		     num_hash_functions()), 7ul);
+  BOOST_CHECK_EQUAL((dynamic_bloom_filter<size_t, engine>::
+		     num_hash_functions()), 7ul);
+  BOOST_CHECK_EQUAL((counting_bloom_filter<size_t, 64, 4, engine>::
+		     num_hash_functions()), 7ul);
+  BOOST_CHECK_EQUAL((dynamic_counting_bloom_filter<size_t, 4, engine>::
+		     num_hash_functions()), 7ul);
+}
+
+template <typename Bloom>
+void checkNoFalseNegatives(Bloom& bloom) {
+  for (size_t i = 0; i < 100; ++i)
+    bloom.insert(i);
+
+  for (size_t i = 0; i < 100; ++i)
+    BOOST_CHECK_EQUAL(bloom.probably_contains(i), true);
+}
+
+BOOST_AUTO_TEST_CASE(filtersAcceptEngine) {
+  typedef enhanced_double_hashing<size_t, 3> engine;
+
+  basic_bloom_filter<size_t, 2048, engine> b1;
+  dynamic_bloom_filter<size_t, engine> b2(2000);
+  counting_bloom_filter<size_t, 2048, 4, engine> b3;
+  dynamic_counting_bloom_filter<size_t, 4, engine> b4(2000);
+
+  checkNoFalseNegatives(b1);
+  checkNoFalseNegatives(b2);
+  checkNoFalseNegatives(b3);
+  checkNoFalseNegatives(b4);
+
+  BOOST_CHECK_LE(b1.count(), 300ul);
+  BOOST_CHECK_GT(b1.count(), 250ul);
+
+  for (size_t i = 0; i < 100; ++i) {
+    b3.remove(i);
+    b4.remove(i);
+  }
+
+  BOOST_CHECK_EQUAL(b3.empty(), true);
+  BOOST_CHECK_EQUAL(b4.empty(), true);
+}
+
+BOOST_AUTO_TEST_CASE(batchWithEngine) {
+  typedef dynamic_bloom_filter<size_t, enhanced_double_hashing<size_t, 5> >
+    Bloom;
+  Bloom single(4096);
+  Bloom batch(4096);
+  size_t keys[200];
+  boost::uint64_t out[(200 + 63) / 64];
+
+  for (size_t i = 0; i < 200; ++i)
+    keys[i] = i;
+
+  single.insert(keys, keys + 100);
+  batch.insert_batch(keys, keys + 100);
+  BOOST_CHECK(single == batch);
+
+  const size_t found = batch.probably_contains_batch(keys, keys + 200, out);
+  size_t expected = 0;
+
+  for (size_t i = 0; i < 200; ++i) {
+    const bool bit = ((out[i / 64] >> (i % 64)) & 1) != 0;
+    BOOST_CHECK_EQUAL(bit, single.probably_contains(keys[i]));
+    expected += bit;
+  }
+
+  BOOST_CHECK_EQUAL(found, expected);
+}
+
+BOOST_AUTO_TEST_CASE(measuredRateMatchesPrediction) {
+  // 10 bits per key, 7 probes: the textbook rate is about 0.0082
+  static const size_t bits = 1 << 16;
+  static const size_t inserts = bits / 10;
+  static const size_t lookups = 200000;
+  dynamic_bloom_filter<size_t, enhanced_double_hashing<size_t, 7> >
+    bloom(bits);
+
+  for (size_t i = 0; i < inserts; ++i)
+    bloom.insert(i);
+
+  size_t hits = 0;
+  for (size_t i = inserts; i < inserts + lookups; ++i)
+    hits += bloom.probably_contains(i);
+
+  const double k = 7, n = inserts, m = bits;
+  const double predicted = std::pow(1 - std::exp(-k * n / m), k);
+  const double measured = static_cast<double>(hits) / lookups;
+
+  BOOST_CHECK_LT(measured, predicted * 1.25);
+  BOOST_CHECK_GT(measured, predicted * 0.75);
+}
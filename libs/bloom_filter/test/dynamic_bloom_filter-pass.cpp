@@ -13,14 +13,18 @@
 #define BOOST_TEST_DYN_LINK 1
 #define BOOST_TEST_MODULE "Boost Dynamic Bloom Filter" 1
 #include <iostream>
+#include <vector>
 
 #include <boost/bloom_filter/dynamic_bloom_filter.hpp>
+#include <boost/bloom_filter/hash/murmurhash3.hpp>
+#include <boost/type_traits/is_nothrow_move_constructible.hpp>
 #include <boost/test/unit_test.hpp>
 #include <boost/test/floating_point_comparison.hpp>
 
 using boost::bloom_filters::dynamic_bloom_filter;
 using boost::bloom_filters::boost_hash;
 using boost::bloom_filters::detail::incompatible_size_exception;
+using boost::bloom_filters::detail::invalid_parameter_exception;
 
 BOOST_AUTO_TEST_CASE(defaultConstructor) {
   typedef boost::mpl::vector<
@@ -334,3 +338,284 @@ BOOST_FIXTURE_TEST_CASE(_equalityException, IncompatibleSizeFixture) {
 
   BOOST_CHECK_EQUAL(exception_thrown, true);
 }
+
+BOOST_AUTO_TEST_CASE(batchOperations) {
+  typedef dynamic_bloom_filter<size_t, boost::mpl::vector<
+    boost_hash<size_t, 1>,
+    boost_hash<size_t, 2>,
+    boost_hash<size_t, 3> > > Bloom;
+  Bloom single(4096);
+  Bloom batch(4096);
+  size_t keys[300];
+  boost::uint64_t out[(300 + 63) / 64];
+
+  for (size_t i = 0; i < 300; ++i)
+    keys[i] = i * 7;
+
+  single.insert(keys, keys + 150);
+  batch.insert_batch(keys, keys + 150);
+  BOOST_CHECK(single == batch);
+
+  const size_t found = batch.probably_contains_batch(keys, keys + 300, out);
+
+  size_t expected = 0;
+  for (size_t i = 0; i < 300; ++i) {
+    const bool bit = ((out[i / 64] >> (i % 64)) & 1) != 0;
+    BOOST_CHECK_EQUAL(bit, single.probably_contains(keys[i]));
+    expected += bit;
+  }
+
+  BOOST_CHECK_EQUAL(found, expected);
+  BOOST_CHECK_GE(found, 150ul);
+}
+
+BOOST_AUTO_TEST_CASE(preHashed) {
+  typedef dynamic_bloom_filter<size_t, boost::mpl::vector<
+    boost_hash<size_t, 1>,
+    boost_hash<size_t, 2>,
+    boost_hash<size_t, 3> > > Bloom;
+  typedef Bloom Other;
+  Bloom plain(4096);
+  Bloom hashed(4096);
+  Other other(1000);
+
+  // one digest per key serves filters of both sizes
+  for (size_t i = 0; i < 100; ++i) {
+    const Bloom::digest_type digest = Bloom::hash_key(i * 7);
+    BOOST_CHECK(digest == Other::hash_key(i * 7));
+
+    plain.insert(i * 7);
+    hashed.insert_hash(digest);
+    other.insert_hash(digest);
+  }
+
+  BOOST_CHECK(plain == hashed);
+
+  for (size_t i = 0; i < 100; ++i) {
+    BOOST_CHECK_EQUAL(hashed.probably_contains_hash(Bloom::hash_key(i * 7)),
+		      true);
+    BOOST_CHECK_EQUAL(other.probably_contains(i * 7), true);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(sizedForRate) {
+  using boost::bloom_filters::murmurhash3;
+  typedef dynamic_bloom_filter<size_t, boost::mpl::vector<
+    murmurhash3<size_t, 1>,
+    murmurhash3<size_t, 2>,
+    murmurhash3<size_t, 3> > > Bloom;
+
+  // three hash functions need 12.4 bits per key for 1%
+  Bloom bloom(1000, 0.01);
+  BOOST_CHECK_GE(bloom.bit_capacity(), 12300ul);
+  BOOST_CHECK_LE(bloom.bit_capacity(), 12400ul);
+
+  for (size_t i = 0; i < 1000; ++i)
+    bloom.insert(i);
+
+  size_t false_positives = 0;
+  for (size_t i = 1000; i < 21000; ++i)
+    false_positives += bloom.probably_contains(i);
+
+  BOOST_CHECK_LT(false_positives, 260ul);
+
+  BOOST_CHECK_THROW(Bloom(0, 0.01), invalid_parameter_exception);
+  BOOST_CHECK_THROW(Bloom(1000, 0.0), invalid_parameter_exception);
+  BOOST_CHECK_THROW(Bloom(1000, 1.0), invalid_parameter_exception);
+}
+
+BOOST_AUTO_TEST_CASE(sizedForRateMask) {
+  using boost::bloom_filters::murmurhash3;
+  typedef dynamic_bloom_filter<size_t, boost::mpl::vector<
+    murmurhash3<size_t, 1>,
+    murmurhash3<size_t, 2>,
+    murmurhash3<size_t, 3> >, size_t, std::allocator<size_t>,
+    boost::bloom_filters::mask_reduction> Bloom;
+
+  // 1236417 bits are needed; a mask can only reduce onto 2^21
+  Bloom bloom(100000, 0.01);
+  BOOST_CHECK_EQUAL(bloom.bit_capacity(), 2097152ul);
+
+  for (size_t i = 0; i < 100000; ++i)
+    bloom.insert(i);
+
+  size_t false_positives = 0;
+  for (size_t i = 100000; i < 200000; ++i)
+    false_positives += bloom.probably_contains(i);
+
+  BOOST_CHECK_LE(false_positives, 1000ul);
+}
+
+BOOST_AUTO_TEST_CASE(maskNeedsPowerOfTwo) {
+  typedef dynamic_bloom_filter<size_t, boost::mpl::vector<boost_hash<size_t> >,
+			       size_t, std::allocator<size_t>,
+			       boost::bloom_filters::mask_reduction> Bloom;
+
+  BOOST_CHECK_THROW(Bloom(1000), invalid_parameter_exception);
+  BOOST_CHECK_EQUAL(Bloom(1024).bit_capacity(), 1024ul);
+  BOOST_CHECK_EQUAL(Bloom().bit_capacity(), 0ul);
+
+  Bloom bloom(1024);
+  bloom.insert(1);
+  BOOST_CHECK_THROW(bloom.resize(1000), invalid_parameter_exception);
+  BOOST_CHECK_EQUAL(bloom.bit_capacity(), 1024ul);
+  BOOST_CHECK_EQUAL(bloom.probably_contains(1), true);
+
+  // sized from a range, the capacity is rounded up instead
+  std::vector<size_t> keys(250);
+  for (size_t i = 0; i < keys.size(); ++i)
+    keys[i] = i;
+  Bloom ranged(keys.begin(), keys.end());
+  BOOST_CHECK_EQUAL(ranged.bit_capacity(), 1024ul);
+  for (size_t i = 0; i < keys.size(); ++i)
+    BOOST_CHECK_EQUAL(ranged.probably_contains(i), true);
+}
+
+BOOST_AUTO_TEST_CASE(moveAndSwap) {
+  typedef dynamic_bloom_filter<size_t> Bloom;
+  Bloom a(1024);
+  Bloom b(2048);
+
+  a.insert(1);
+  b.insert(2);
+
+  // swapping exchanges storage instead of copying it
+  a.swap(b);
+  BOOST_CHECK_EQUAL(a.bit_capacity(), 2048ul);
+  BOOST_CHECK_EQUAL(b.bit_capacity(), 1024ul);
+  BOOST_CHECK_EQUAL(a.probably_contains(2), true);
+  BOOST_CHECK_EQUAL(b.probably_contains(1), true);
+
+#ifndef BOOST_NO_CXX11_RVALUE_REFERENCES
+  BOOST_CHECK(boost::is_nothrow_move_constructible<Bloom>::value);
+
+  Bloom c(std::move(a));
+  BOOST_CHECK_EQUAL(c.bit_capacity(), 2048ul);
+  BOOST_CHECK_EQUAL(c.probably_contains(2), true);
+  BOOST_CHECK_EQUAL(a.bit_capacity(), 0ul);
+
+  // a moved-from filter can be assigned to again
+  a = std::move(c);
+  BOOST_CHECK_EQUAL(a.bit_capacity(), 2048ul);
+  BOOST_CHECK_EQUAL(a.probably_contains(2), true);
+  BOOST_CHECK_EQUAL(c.bit_capacity(), 0ul);
+
+  // an rvalue left operand lends its storage to the result
+  Bloom d(2048);
+  d.insert(3);
+  Bloom u = Bloom(a) | d;
+  Bloom i = std::move(u) & a;
+  BOOST_CHECK_EQUAL(u.bit_capacity(), 0ul);
+  BOOST_CHECK(i == a);
+#endif
+}
+
+BOOST_AUTO_TEST_CASE(countIsKept) {
+  typedef dynamic_bloom_filter<size_t> Bloom;
+
+  // sizes that leave the last block partly used
+  for (size_t size = 1; size < 1000; size += 97) {
+    Bloom a(size);
+    Bloom b(size);
+    for (size_t i = 0; i < size / 3 + 1; ++i) {
+      a.insert(i);
+      b.insert_hash(Bloom::hash_key(i * 5));
+    }
+    BOOST_CHECK_EQUAL(a.count(), a.data().count());
+    BOOST_CHECK_EQUAL(b.count(), b.data().count());
+
+    // keys already in set no new bits
+    const size_t before = a.count();
+    const size_t again[] = {0, 0};
+    a.insert(0);
+    a.insert_batch(again, again + 2);
+    BOOST_CHECK_EQUAL(a.count(), before);
+
+    Bloom u = a | b;
+    BOOST_CHECK_EQUAL(u.count(), u.data().count());
+    Bloom n = a & b;
+    BOOST_CHECK_EQUAL(n.count(), n.data().count());
+
+    a.swap(b);
+    BOOST_CHECK_EQUAL(a.count(), a.data().count());
+    BOOST_CHECK_EQUAL(b.count(), before);
+
+    a.clear();
+    BOOST_CHECK_EQUAL(a.count(), 0ul);
+    BOOST_CHECK_EQUAL(a.false_positive_rate(), 0.0);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(fold) {
+  using boost::bloom_filters::murmurhash3;
+  typedef boost::mpl::vector<
+    murmurhash3<size_t, 1>,
+    murmurhash3<size_t, 2> > TwoHashes;
+  typedef dynamic_bloom_filter<size_t, TwoHashes> Bloom;
+  typedef dynamic_bloom_filter<size_t, TwoHashes, size_t,
+			       std::allocator<size_t>,
+			       boost::bloom_filters::mask_reduction> MaskBloom;
+
+  // bit by bit, and a whole number of blocks at a time
+  Bloom big(3000), small(1000);
+  MaskBloom mask_big(8192), mask_small(1024);
+  for (size_t i = 0; i < 300; ++i) {
+    big.insert(i);
+    small.insert(i);
+    mask_big.insert(i);
+    mask_small.insert(i);
+  }
+
+  big.fold(3);
+  mask_big.fold(8);
+  BOOST_CHECK_EQUAL(big.bit_capacity(), 1000ul);
+  BOOST_CHECK_EQUAL(mask_big.bit_capacity(), 1024ul);
+  BOOST_CHECK(big == small);
+  BOOST_CHECK(mask_big == mask_small);
+  BOOST_CHECK_EQUAL(big.count(), small.count());
+  BOOST_CHECK_EQUAL(mask_big.count(), mask_small.count());
+  for (size_t i = 0; i < 300; ++i) {
+    BOOST_CHECK_EQUAL(big.probably_contains(i), true);
+    BOOST_CHECK_EQUAL(mask_big.probably_contains(i), true);
+  }
+
+  BOOST_CHECK_THROW(big.fold(0), incompatible_size_exception);
+  BOOST_CHECK_THROW(big.fold(3), incompatible_size_exception);
+  BOOST_CHECK_EQUAL(big.bit_capacity(), 1000ul);
+}
+
+BOOST_AUTO_TEST_CASE(foldUnion) {
+  typedef dynamic_bloom_filter<size_t> Bloom;
+
+  Bloom a(4000), b(1000), expect(1000);
+  for (size_t i = 0; i < 200; ++i) {
+    a.insert(i);
+    b.insert(i + 100);
+    expect.insert(i);
+    expect.insert(i + 100);
+  }
+
+  // larger into smaller, smaller into larger, and the free function
+  Bloom lhs(b);
+  lhs.fold_union(a);
+  BOOST_CHECK(lhs == expect);
+  BOOST_CHECK_EQUAL(lhs.count(), expect.count());
+
+  Bloom rhs(a);
+  rhs.fold_union(b);
+  BOOST_CHECK(rhs == expect);
+  BOOST_CHECK_EQUAL(rhs.count(), expect.count());
+
+  BOOST_CHECK(fold_union(a, b) == expect);
+  BOOST_CHECK(fold_union(b, a) == expect);
+
+  // equal sizes are a plain union
+  Bloom same(b);
+  same.fold_union(b);
+  BOOST_CHECK(same == b);
+
+  Bloom odd(1500);
+  BOOST_CHECK_THROW(odd.fold_union(b), incompatible_size_exception);
+  BOOST_CHECK_THROW(b.fold_union(odd), incompatible_size_exception);
+  BOOST_CHECK_THROW(Bloom().fold_union(b), incompatible_size_exception);
+}
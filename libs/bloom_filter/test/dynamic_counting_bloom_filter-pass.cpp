@@ -12,8 +12,11 @@
 
 #define BOOST_TEST_DYN_LINK 1
 #define BOOST_TEST_MODULE "Boost Bloom Filter" 1
+#include <utility>
 
 #include <boost/bloom_filter/dynamic_counting_bloom_filter.hpp>
+#include <boost/bloom_filter/hash/murmurhash3.hpp>
+#include <boost/type_traits/is_nothrow_move_constructible.hpp>
 #include <boost/test/unit_test.hpp>
 #include <boost/test/floating_point_comparison.hpp>
 
@@ -25,6 +28,7 @@ using boost::bloom_filters::dynamic_counting_bloom_filter;
 using boost::bloom_filters::detail::bin_underflow_exception;
 using boost::bloom_filters::detail::bin_overflow_exception;
 using boost::bloom_filters::detail::incompatible_size_exception;
+using boost::bloom_filters::detail::invalid_parameter_exception;
 using boost::bloom_filters::boost_hash;
 
 BOOST_AUTO_TEST_CASE(allBitsPerBinCompile)
@@ -468,3 +472,140 @@ BOOST_FIXTURE_TEST_CASE(inequalityOperator, PairwiseOpsFixture) {
   bloom2.insert(1);
   BOOST_CHECK_EQUAL(bloom1 != bloom2, false);
 }
+
+BOOST_AUTO_TEST_CASE(batchOperations) {
+  typedef dynamic_counting_bloom_filter<size_t, 4, boost::mpl::vector<
+    boost_hash<size_t, 1>,
+    boost_hash<size_t, 2>,
+    boost_hash<size_t, 3> > > Bloom;
+  Bloom single(8192);
+  Bloom batch(8192);
+  size_t keys[300];
+  boost::uint64_t out[(300 + 63) / 64];
+
+  for (size_t i = 0; i < 300; ++i)
+    keys[i] = i * 7;
+
+  single.insert(keys, keys + 150);
+  batch.insert_batch(keys, keys + 150);
+  BOOST_CHECK(single == batch);
+
+  const size_t found = batch.probably_contains_batch(keys, keys + 300, out);
+
+  size_t expected = 0;
+  for (size_t i = 0; i < 300; ++i) {
+    const bool bit = ((out[i / 64] >> (i % 64)) & 1) != 0;
+    BOOST_CHECK_EQUAL(bit, single.probably_contains(keys[i]));
+    expected += bit;
+  }
+
+  BOOST_CHECK_EQUAL(found, expected);
+  BOOST_CHECK_GE(found, 150ul);
+}
+
+BOOST_AUTO_TEST_CASE(preHashed) {
+  typedef dynamic_counting_bloom_filter<size_t, 4, boost::mpl::vector<
+    boost_hash<size_t, 1>,
+    boost_hash<size_t, 2>,
+    boost_hash<size_t, 3> > > Bloom;
+  typedef Bloom Other;
+  Bloom plain(8192);
+  Bloom hashed(8192);
+  Other other(1000);
+
+  // one digest per key serves filters of both sizes
+  for (size_t i = 0; i < 100; ++i) {
+    const Bloom::digest_type digest = Bloom::hash_key(i * 7);
+    BOOST_CHECK(digest == Other::hash_key(i * 7));
+
+    plain.insert(i * 7);
+    hashed.insert_hash(digest);
+    other.insert_hash(digest);
+  }
+
+  BOOST_CHECK(plain == hashed);
+
+  for (size_t i = 0; i < 100; ++i) {
+    BOOST_CHECK_EQUAL(hashed.probably_contains_hash(Bloom::hash_key(i * 7)),
+		      true);
+    BOOST_CHECK_EQUAL(other.probably_contains(i * 7), true);
+  }
+
+  for (size_t i = 0; i < 100; ++i)
+    hashed.remove_hash(Bloom::hash_key(i * 7));
+
+  BOOST_CHECK(hashed.empty());
+}
+
+BOOST_AUTO_TEST_CASE(sizedForRate) {
+  using boost::bloom_filters::murmurhash3;
+  typedef dynamic_counting_bloom_filter<size_t, 4, boost::mpl::vector<
+    murmurhash3<size_t, 1>,
+    murmurhash3<size_t, 2>,
+    murmurhash3<size_t, 3> > > Bloom;
+
+  // one bin per bit of the equivalent dynamic_bloom_filter
+  Bloom bloom(1000, 0.01);
+  BOOST_CHECK_GE(bloom.num_bins(), 12300ul);
+  BOOST_CHECK_LE(bloom.num_bins(), 12400ul);
+
+  for (size_t i = 0; i < 1000; ++i)
+    bloom.insert(i);
+
+  size_t false_positives = 0;
+  for (size_t i = 1000; i < 21000; ++i)
+    false_positives += bloom.probably_contains(i);
+
+  BOOST_CHECK_LT(false_positives, 260ul);
+  BOOST_CHECK_THROW(Bloom(1000, 2.0), invalid_parameter_exception);
+}
+
+BOOST_AUTO_TEST_CASE(maskNeedsPowerOfTwo) {
+  typedef dynamic_counting_bloom_filter<size_t, 4,
+    boost::mpl::vector<boost_hash<size_t> >, size_t, std::allocator<size_t>,
+    boost::bloom_filters::mask_reduction> Bloom;
+
+  BOOST_CHECK_THROW(Bloom(1000), invalid_parameter_exception);
+  BOOST_CHECK_EQUAL(Bloom(1024).num_bins(), 1024ul);
+
+  // (n, p) sizing rounds the bins up to a power of two
+  const size_t bins = Bloom(1000, 0.01).num_bins();
+  BOOST_CHECK_EQUAL(bins & (bins - 1), 0ul);
+  BOOST_CHECK_GE(bins, 99500ul);
+}
+
+BOOST_AUTO_TEST_CASE(moveAndSwap) {
+  typedef dynamic_counting_bloom_filter<size_t> Bloom;
+  Bloom a(1024);
+  Bloom b(2048);
+  const size_t *const a_storage = &a.data()[0];
+  const size_t *const b_storage = &b.data()[0];
+
+  a.insert(1);
+  b.insert(2);
+
+  // swapping exchanges storage instead of copying it
+  a.swap(b);
+  BOOST_CHECK_EQUAL(a.num_bins(), 2048ul);
+  BOOST_CHECK_EQUAL(b.num_bins(), 1024ul);
+  BOOST_CHECK_EQUAL(a.probably_contains(2), true);
+  BOOST_CHECK_EQUAL(b.probably_contains(1), true);
+  BOOST_CHECK(&a.data()[0] == b_storage);
+  BOOST_CHECK(&b.data()[0] == a_storage);
+
+#ifndef BOOST_NO_CXX11_RVALUE_REFERENCES
+  BOOST_CHECK(boost::is_nothrow_move_constructible<Bloom>::value);
+
+  Bloom c(std::move(a));
+  BOOST_CHECK_EQUAL(c.num_bins(), 2048ul);
+  BOOST_CHECK_EQUAL(c.probably_contains(2), true);
+  BOOST_CHECK_EQUAL(a.num_bins(), 0ul);
+  BOOST_CHECK(&c.data()[0] == b_storage);
+
+  // a moved-from filter can be assigned to again
+  a = std::move(c);
+  BOOST_CHECK_EQUAL(a.num_bins(), 2048ul);
+  BOOST_CHECK_EQUAL(a.probably_contains(2), true);
+  BOOST_CHECK_EQUAL(c.num_bins(), 0ul);
+#endif
+}
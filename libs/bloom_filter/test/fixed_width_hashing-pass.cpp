@@ -0,0 +1,175 @@
+//////////////////////////////////////////////////////////////////////////////
+//
+// (C) Copyright Alejandro Cabrera 2011.
+// Distributed under the Boost
+// Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or
+// copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// See http://www.boost.org/libs/bloom_filter for documentation.
+//
+//////////////////////////////////////////////////////////////////////////////
+
+#define BOOST_TEST_DYN_LINK 1
+#define BOOST_TEST_MODULE "Boost Bloom Filter" 1
+#include <vector>
+
+#include <boost/bloom_filter/hash/fixed_width_hashing.hpp>
+#include <boost/bloom_filter/hash/double_hashing.hpp>
+#include <boost/bloom_filter/basic_bloom_filter.hpp>
+#include <boost/bloom_filter/dynamic_bloom_filter.hpp>
+#include <boost/bloom_filter/counting_bloom_filter.hpp>
+#include <boost/bloom_filter/dynamic_counting_bloom_filter.hpp>
+#include <boost/test/unit_test.hpp>
+
+using boost::bloom_filters::fixed_width_hashing;
+using boost::uint32_t;
+using boost::uint64_t;
+
+struct id128 {
+  uint64_t hi, lo;
+};
+
+static uint64_t mix(const size_t i)
+{
+  return (i + 1) * 0x9e3779b97f4a7c15ull;
+}
+
+template <typename Engine, typename Key>
+void checkMultiKeyMatchesSingle(const std::vector<Key>& keys)
+{
+  static const size_t k = Engine::num_hashes;
+  Engine engine;
+
+  // every group size, so each kernel's tail is covered too
+  for (size_t n = 0; n <= keys.size(); n += (n < 20 ? 1 : 37)) {
+    std::vector<size_t> many(n * k + 1), one(k);
+    engine(keys.empty() ? 0 : &keys[0], n, &many[0]);
+
+    for (size_t i = 0; i < n; ++i) {
+      engine(keys[i], &one[0]);
+      for (size_t j = 0; j < k; ++j)
+	BOOST_CHECK_EQUAL(many[i * k + j], one[j]);
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(multiKeyMatchesSingleKey) {
+  std::vector<uint32_t> k32;
+  std::vector<uint64_t> k64;
+  std::vector<id128> k128;
+
+  for (size_t i = 0; i < 200; ++i) {
+    const id128 id = {mix(i), mix(i + 1000)};
+    k32.push_back(static_cast<uint32_t>(mix(i)));
+    k64.push_back(mix(i));
+    k128.push_back(id);
+  }
+
+  checkMultiKeyMatchesSingle<fixed_width_hashing<uint32_t, 3> >(k32);
+  checkMultiKeyMatchesSingle<fixed_width_hashing<uint64_t, 7> >(k64);
+  checkMultiKeyMatchesSingle<fixed_width_hashing<uint64_t, 1, 42> >(k64);
+  checkMultiKeyMatchesSingle<fixed_width_hashing<id128, 4> >(k128);
+}
+
+// whichever kernel the host picks, each one must agree with the
+// scalar definition
+template <size_t Words>
+void checkKernels()
+{
+  using namespace boost::bloom_filters::detail;
+  static const size_t n = 67;
+  std::vector<uint64_t> w0(n), w1(n);
+  for (size_t i = 0; i < n; ++i) {
+    w0[i] = mix(i);
+    w1[i] = mix(i + n);
+  }
+  const uint64_t *const words[2] = {&w0[0], &w1[0]};
+
+  std::vector<uint64_t> x(n), y(n), sx(n), sy(n);
+  fixed_width_hash_scalar<Words>(words, n, 1, 2, &sx[0], &sy[0]);
+
+  std::vector<fixed_width_kernel> kernels;
+#ifdef BOOST_BLOOM_FILTER_HAS_SIMD_DISPATCH
+  if (cpu_simd_level() >= simd_avx2)
+    kernels.push_back(&fixed_width_hash_avx2<Words>);
+  if (cpu_simd_level() >= simd_avx512)
+    kernels.push_back(&fixed_width_hash_avx512<Words>);
+#endif
+  kernels.push_back(select_fixed_width_kernel<Words>());
+
+  for (size_t k = 0; k < kernels.size(); ++k) {
+    kernels[k](words, n, 1, 2, &x[0], &y[0]);
+    BOOST_CHECK(x == sx);
+    BOOST_CHECK(y == sy);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(kernelsAgree) {
+  checkKernels<1>();
+  checkKernels<2>();
+}
+
+BOOST_AUTO_TEST_CASE(distinctKeysDistinctHashes) {
+  fixed_width_hashing<uint32_t, 2> engine;
+  fixed_width_hashing<uint32_t, 2, 1> seeded;
+  size_t a[2], b[2];
+
+  for (uint32_t i = 0; i < 1000; ++i) {
+    engine(i, a);
+    engine(i + 1, b);
+    BOOST_CHECK(a[0] != b[0]);
+    BOOST_CHECK(a[1] != b[1]);
+
+    seeded(i, b);
+    BOOST_CHECK(a[0] != b[0]);
+  }
+}
+
+template <typename Bloom>
+void checkBatchMatchesSingle(Bloom& single, Bloom& batch)
+{
+  std::vector<uint64_t> keys;
+  for (size_t i = 0; i < 1000; ++i)
+    keys.push_back(mix(i));
+
+  single.insert(keys.begin(), keys.begin() + 500);
+  batch.insert_batch(keys.begin(), keys.begin() + 500);
+  BOOST_CHECK(single == batch);
+
+  std::vector<uint64_t> out(16, 0);
+  const size_t found =
+    batch.probably_contains_batch(keys.begin(), keys.end(), &out[0]);
+
+  size_t expected = 0;
+  for (size_t i = 0; i < keys.size(); ++i) {
+    const bool hit = single.probably_contains(keys[i]);
+    expected += hit;
+    BOOST_CHECK_EQUAL(((out[i / 64] >> (i % 64)) & 1) != 0, hit);
+  }
+
+  BOOST_CHECK_EQUAL(found, expected);
+  BOOST_CHECK_GE(found, 500ul);
+  BOOST_CHECK_LT(found, 550ul);
+}
+
+BOOST_AUTO_TEST_CASE(batchOperationsUseMultiKeyPath) {
+  using namespace boost::bloom_filters;
+  typedef fixed_width_hashing<uint64_t, 5> engine;
+
+  BOOST_CHECK(detail::is_multi_key_engine<engine>::value);
+  BOOST_CHECK(!detail::is_multi_key_engine<
+	        enhanced_double_hashing<uint64_t> >::value);
+
+  basic_bloom_filter<uint64_t, 8192, engine> b1, b2;
+  checkBatchMatchesSingle(b1, b2);
+
+  dynamic_bloom_filter<uint64_t, engine> d1(8000), d2(8000);
+  checkBatchMatchesSingle(d1, d2);
+
+  counting_bloom_filter<uint64_t, 8192, 4, engine> c1, c2;
+  checkBatchMatchesSingle(c1, c2);
+
+  dynamic_counting_bloom_filter<uint64_t, 4, engine> dc1(8000), dc2(8000);
+  checkBatchMatchesSingle(dc1, dc2);
+}
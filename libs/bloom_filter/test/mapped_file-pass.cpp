@@ -0,0 +1,231 @@
+//////////////////////////////////////////////////////////////////////////////
+//
+// (C) Copyright Alejandro Cabrera 2011.
+// Distributed under the Boost
+// Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or
+// copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// See http://www.boost.org/libs/bloom_filter for documentation.
+//
+//////////////////////////////////////////////////////////////////////////////
+
+#define BOOST_TEST_DYN_LINK 1
+#define BOOST_TEST_MODULE "Boost Bloom Filter" 1
+#include <cstdio>
+#include <fstream>
+#include <string>
+
+#include <boost/bloom_filter/mapped_file.hpp>
+#include <boost/bloom_filter/dynamic_bloom_filter.hpp>
+#include <boost/bloom_filter/dynamic_counting_bloom_filter.hpp>
+#include <boost/test/unit_test.hpp>
+
+using boost::bloom_filters::dynamic_bloom_filter;
+using boost::bloom_filters::dynamic_counting_bloom_filter;
+using boost::bloom_filters::boost_hash;
+using boost::bloom_filters::mapped_file;
+using boost::bloom_filters::mapped_file_params;
+using boost::bloom_filters::mapped_read_only;
+using boost::bloom_filters::mapped_read_write;
+using boost::bloom_filters::detail::mapped_file_exception;
+using boost::bloom_filters::detail::invalid_parameter_exception;
+
+typedef boost::mpl::vector<boost_hash<size_t, 1>,
+			   boost_hash<size_t, 2>,
+			   boost_hash<size_t, 3> > ThreeHashes;
+typedef dynamic_bloom_filter<size_t, ThreeHashes, size_t,
+			     mapped_file> MappedBloom;
+typedef dynamic_counting_bloom_filter<size_t, 4, ThreeHashes, size_t,
+				      mapped_file> MappedCounting;
+
+// removes its file at the end of the test
+struct scratch_file {
+  explicit scratch_file(const std::string& name) : name(name) {}
+  ~scratch_file() { std::remove(name.c_str()); }
+
+  const std::string name;
+};
+
+BOOST_AUTO_TEST_CASE(createAndReopen) {
+  scratch_file file("mapped_file-pass.bloom");
+  {
+    MappedBloom writer(mapped_file_params(file.name), 10007);
+    BOOST_CHECK_EQUAL(writer.bit_capacity(), 10007ul);
+    BOOST_CHECK(writer.empty());
+
+    for (size_t i = 0; i < 500; ++i)
+      writer.insert(i);
+    writer.flush();
+    writer.flush(true);
+  }
+
+  MappedBloom reader(mapped_file_params(file.name, mapped_read_only));
+  BOOST_CHECK_EQUAL(reader.bit_capacity(), 10007ul);
+  for (size_t i = 0; i < 500; ++i)
+    BOOST_CHECK(reader.probably_contains(i));
+
+  // the same keys in memory give the same bits
+  dynamic_bloom_filter<size_t, ThreeHashes> plain(10007);
+  for (size_t i = 0; i < 500; ++i)
+    plain.insert(i);
+  BOOST_CHECK_EQUAL(reader.count(), plain.count());
+
+  // batches work over the mapping too
+  std::vector<size_t> keys(500);
+  for (size_t i = 0; i < keys.size(); ++i)
+    keys[i] = i;
+  std::vector<boost::uint64_t> out(8);
+  BOOST_CHECK_EQUAL(reader.probably_contains_batch(keys.begin(), keys.end(),
+						   &out[0]), 500ul);
+}
+
+BOOST_AUTO_TEST_CASE(foldStaysOnTheFile) {
+  scratch_file file("mapped_file-pass.fold.bloom");
+  {
+    MappedBloom writer(mapped_file_params(file.name), 8000);
+    for (size_t i = 0; i < 300; ++i)
+      writer.insert(i);
+
+    writer.fold(4);
+    BOOST_CHECK_EQUAL(writer.bit_capacity(), 2000ul);
+
+    // later inserts reach the file too
+    writer.insert(1000);
+
+    MappedBloom other(mapped_file_params(file.name + ".other"), 4000);
+    other.insert(2000);
+    writer.fold_union(other);
+    std::remove((file.name + ".other").c_str());
+    writer.flush();
+  }
+
+  dynamic_bloom_filter<size_t, ThreeHashes> plain(2000);
+  for (size_t i = 0; i < 300; ++i)
+    plain.insert(i);
+  plain.insert(1000);
+  plain.insert(2000);
+
+  MappedBloom reader(mapped_file_params(file.name, mapped_read_only));
+  BOOST_CHECK_EQUAL(reader.bit_capacity(), 2000ul);
+  BOOST_CHECK(reader.probably_contains(1000));
+  BOOST_CHECK(reader.probably_contains(2000));
+  BOOST_CHECK_EQUAL(reader.count(), plain.count());
+}
+
+BOOST_AUTO_TEST_CASE(readOnlyNeverWritesTheFile) {
+  scratch_file file("mapped_file-pass-ro.bloom");
+  { MappedBloom writer(mapped_file_params(file.name), 4096); }
+
+  {
+    MappedBloom reader(mapped_file_params(file.name, mapped_read_only));
+    reader.insert(42);
+    BOOST_CHECK(reader.probably_contains(42));
+    reader.flush();
+  }
+
+  MappedBloom again(mapped_file_params(file.name, mapped_read_only));
+  BOOST_CHECK(again.empty());
+
+  // and cannot create one
+  BOOST_CHECK_THROW(MappedBloom(mapped_file_params(file.name,
+						   mapped_read_only), 64),
+		    invalid_parameter_exception);
+}
+
+BOOST_AUTO_TEST_CASE(readWriteSharesTheFile) {
+  scratch_file file("mapped_file-pass-rw.bloom");
+  MappedBloom a(mapped_file_params(file.name), 4096);
+  MappedBloom b(mapped_file_params(file.name, mapped_read_write));
+
+  // two mappings of one file see each other's writes
+  a.insert(7);
+  BOOST_CHECK(b.probably_contains(7));
+
+  // copies are private memory
+  MappedBloom copy(a);
+  copy.insert(8);
+  BOOST_CHECK(copy.probably_contains(8));
+  BOOST_CHECK(b != copy);
+  BOOST_CHECK(copy != a);
+
+  // assignment of the same size writes through to the file
+  a = copy;
+  BOOST_CHECK(b == copy);
+
+  // resizing recreates the file
+  a.resize(8192);
+  BOOST_CHECK_EQUAL(a.bit_capacity(), 8192ul);
+  BOOST_CHECK(a.empty());
+  a.insert(9);
+  a.flush();
+  MappedBloom c(mapped_file_params(file.name, mapped_read_only));
+  BOOST_CHECK_EQUAL(c.bit_capacity(), 8192ul);
+  BOOST_CHECK(c.probably_contains(9));
+}
+
+BOOST_AUTO_TEST_CASE(mismatchedFilesAreRejected) {
+  scratch_file file("mapped_file-pass-bad.bloom");
+  { MappedBloom writer(mapped_file_params(file.name), 4096); }
+
+  typedef dynamic_bloom_filter<size_t,
+			       boost::mpl::vector<boost_hash<size_t> >,
+			       size_t, mapped_file> OneHash;
+  typedef dynamic_bloom_filter<size_t, ThreeHashes, unsigned char,
+			       mapped_file> ByteBlocks;
+
+  BOOST_CHECK_THROW(OneHash(mapped_file_params(file.name)),
+		    mapped_file_exception);
+  BOOST_CHECK_THROW(ByteBlocks(mapped_file_params(file.name)),
+		    mapped_file_exception);
+  BOOST_CHECK_THROW(MappedCounting(mapped_file_params(file.name)),
+		    mapped_file_exception);
+
+  {
+    std::ofstream junk(file.name.c_str());
+    junk << "not a filter";
+  }
+  BOOST_CHECK_THROW(MappedBloom(mapped_file_params(file.name)),
+		    mapped_file_exception);
+}
+
+BOOST_AUTO_TEST_CASE(anonymousWithoutAFile) {
+  MappedBloom a(1000);
+  MappedBloom b;
+  BOOST_CHECK_EQUAL(a.bit_capacity(), 1000ul);
+  BOOST_CHECK_EQUAL(b.bit_capacity(), 0ul);
+
+  a.insert(1);
+  b = a;
+  BOOST_CHECK(b.probably_contains(1));
+  a.swap(b);
+  a.flush();
+}
+
+BOOST_AUTO_TEST_CASE(countingFile) {
+  scratch_file file("mapped_file-pass.cbf");
+  {
+    MappedCounting writer(mapped_file_params(file.name), 1000);
+    for (size_t i = 0; i < 100; ++i) {
+      writer.insert(i);
+      writer.insert(i);
+    }
+    writer.remove(0);
+    writer.flush();
+  }
+
+  MappedCounting reader(mapped_file_params(file.name));
+  BOOST_CHECK_EQUAL(reader.num_bins(), 1000ul);
+  for (size_t i = 0; i < 100; ++i)
+    BOOST_CHECK(reader.probably_contains(i));
+
+  reader.remove(0);
+  for (size_t i = 1; i < 100; ++i) {
+    reader.remove(i);
+    reader.remove(i);
+  }
+  BOOST_CHECK(reader.empty());
+
+  MappedCounting copy(reader);
+  BOOST_CHECK(copy == reader);
+}
@@ -0,0 +1,101 @@
+//////////////////////////////////////////////////////////////////////////////
+//
+// (C) Copyright Alejandro Cabrera 2011.
+// Distributed under the Boost
+// Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or
+// copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// See http://www.boost.org/libs/bloom_filter for documentation.
+//
+//////////////////////////////////////////////////////////////////////////////
+
+#define BOOST_TEST_DYN_LINK 1
+#define BOOST_TEST_MODULE "Boost Bloom Filter" 1
+#include <algorithm>
+#include <cmath>
+
+#include <boost/type_traits/is_same.hpp>
+#include <boost/bloom_filter/optimal_parameters.hpp>
+#include <boost/test/unit_test.hpp>
+
+using namespace boost::bloom_filters;
+
+template <size_t N, class Rate>
+void checkAgainstFormula()
+{
+  typedef optimal_parameters<N, Rate> params;
+  const double p = static_cast<double>(Rate::num) / Rate::den;
+  const double ln2 = std::log(2.0);
+  const double m = -(N * std::log(p)) / (ln2 * ln2);
+  const double k = -std::log(p) / ln2;
+
+  const double slack = 1 + m * 1e-9;
+
+  BOOST_CHECK_GE(static_cast<double>(params::bits), m - slack);
+  BOOST_CHECK_LE(static_cast<double>(params::bits), m + slack);
+  BOOST_CHECK_EQUAL(params::hash_functions,
+		    std::max(1.0, std::floor(k + 0.5)));
+}
+
+BOOST_AUTO_TEST_CASE(matchesFormula) {
+  checkAgainstFormula<1, ppm<100> >();
+  checkAgainstFormula<1000, ppm<1> >();
+  checkAgainstFormula<1000, ppm<999999> >();
+  checkAgainstFormula<1000000, ppm<100> >();
+  checkAgainstFormula<1000000, ppm<10000> >();
+  checkAgainstFormula<1000000, ppm<500000> >();
+  checkAgainstFormula<123456, boost::ratio<1, 3> >();
+  checkAgainstFormula<4000000000ul, boost::ratio<1, 1000000000> >();
+}
+
+BOOST_AUTO_TEST_CASE(knownValues) {
+  // 1% needs 9.59 bits per element and 7 probes
+  BOOST_CHECK_EQUAL((optimal_parameters<1000, ppm<10000> >::bits), 9586ul);
+  BOOST_CHECK_EQUAL((optimal_parameters<1000, ppm<10000> >::hash_functions),
+		    7ul);
+
+  // a rate of one half still needs one probe
+  BOOST_CHECK_EQUAL((optimal_parameters<10, ppm<600000> >::hash_functions),
+		    1ul);
+}
+
+BOOST_AUTO_TEST_CASE(filterTypes) {
+  typedef optimal_parameters<1000, ppm<100> > params;
+
+  BOOST_CHECK((boost::is_same<
+	       optimal_bloom_filter<int, 1000, ppm<100> >::type,
+	       basic_bloom_filter<int, params::bits,
+				  enhanced_double_hashing<int, 13> > >::value));
+  BOOST_CHECK((boost::is_same<
+	       optimal_counting_bloom_filter<int, 1000, ppm<100>, 8>::type,
+	       counting_bloom_filter<int, params::bits, 8,
+				     enhanced_double_hashing<int, 13> > >::value));
+  BOOST_CHECK_EQUAL((optimal_bloom_filter<int, 1000, ppm<100> >::type
+		     ::num_hash_functions()), 13ul);
+}
+
+template <typename Bloom>
+void checkRate(Bloom& bloom, const size_t n, const double p)
+{
+  for (size_t i = 0; i < n; ++i)
+    bloom.insert(i);
+
+  size_t false_positives = 0;
+  for (size_t i = 0; i < n; ++i) {
+    BOOST_CHECK_EQUAL(bloom.probably_contains(i), true);
+    for (size_t j = 1; j <= 10; ++j)
+      false_positives += bloom.probably_contains(j * n + i);
+  }
+
+  BOOST_CHECK_LT(false_positives, static_cast<size_t>(n * 10 * p * 1.3));
+}
+
+BOOST_AUTO_TEST_CASE(meetsTargetRate) {
+  static optimal_bloom_filter<size_t, 20000, ppm<10000> >::type bloom;
+  static optimal_counting_bloom_filter<size_t, 20000, ppm<10000> >::type
+    counting;
+
+  checkRate(bloom, 20000, 0.01);
+  checkRate(counting, 20000, 0.01);
+}
@@ -0,0 +1,117 @@
+//////////////////////////////////////////////////////////////////////////////
+//
+// (C) Copyright Alejandro Cabrera 2011.
+// Distributed under the Boost
+// Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or
+// copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// See http://www.boost.org/libs/bloom_filter for documentation.
+//
+//////////////////////////////////////////////////////////////////////////////
+
+#define BOOST_TEST_DYN_LINK 1
+#define BOOST_TEST_MODULE "Boost Bloom Filter" 1
+#include <vector>
+
+#include <boost/bloom_filter/page_allocator.hpp>
+#include <boost/bloom_filter/dynamic_bloom_filter.hpp>
+#include <boost/bloom_filter/dynamic_counting_bloom_filter.hpp>
+#include <boost/bloom_filter/basic_bloom_filter.hpp>
+#include <boost/test/unit_test.hpp>
+
+using boost::bloom_filters::page_allocator;
+using boost::bloom_filters::dynamic_bloom_filter;
+using boost::bloom_filters::dynamic_counting_bloom_filter;
+using boost::bloom_filters::boost_hash;
+using boost::bloom_filters::transparent_huge_pages;
+using boost::bloom_filters::explicit_huge_pages;
+using boost::bloom_filters::prefault_pages;
+using boost::bloom_filters::no_huge_pages;
+
+static const size_t MiB = static_cast<size_t>(1) << 20;
+
+template <typename Allocator>
+void checkAllocations(const size_t alignment)
+{
+  Allocator a;
+  const size_t sizes[] = {0, 1, 100, 4096, 2 * MiB - 8, 2 * MiB,
+			  3 * MiB + 8, 16 * MiB};
+
+  for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); ++i) {
+    const size_t n = sizes[i] / sizeof(size_t);
+    size_t *const p = a.allocate(n);
+    BOOST_CHECK_EQUAL(reinterpret_cast<size_t>(p) % alignment, 0ul);
+    if (sizes[i] >= 2 * MiB)
+      BOOST_CHECK_EQUAL(reinterpret_cast<size_t>(p) % (2 * MiB), 0ul);
+
+    for (size_t j = 0; j < n; ++j)
+      p[j] = j;
+    for (size_t j = 0; j < n; j += 4099)
+      BOOST_CHECK_EQUAL(p[j], j);
+
+    a.deallocate(p, n);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(alignedAllocations) {
+  checkAllocations<page_allocator<size_t> >(64);
+  checkAllocations<page_allocator<size_t, 4096> >(4096);
+  checkAllocations<page_allocator<size_t, 64, no_huge_pages> >(64);
+  checkAllocations<page_allocator<size_t, 64,
+				  explicit_huge_pages | prefault_pages> >(64);
+  checkAllocations<page_allocator<size_t, 4 * 1024 * 1024,
+				  transparent_huge_pages> >(4 * MiB);
+}
+
+BOOST_AUTO_TEST_CASE(rebindAndCompare) {
+  typedef page_allocator<char, 128, prefault_pages> chars;
+  typedef chars::rebind<size_t>::other blocks;
+
+  BOOST_CHECK_EQUAL(blocks::alignment, 128ul);
+  BOOST_CHECK_EQUAL(blocks::placement, prefault_pages);
+  BOOST_CHECK(chars() == blocks());
+  BOOST_CHECK(!(chars() != blocks(chars())));
+
+  std::vector<int, page_allocator<int> > v(1000, 7);
+  BOOST_CHECK_EQUAL(reinterpret_cast<size_t>(&v[0]) % 64, 0ul);
+  BOOST_CHECK_EQUAL(v[999], 7);
+}
+
+BOOST_AUTO_TEST_CASE(filtersOnPages) {
+  typedef boost::mpl::vector<boost_hash<size_t, 1>,
+			     boost_hash<size_t, 2> > HashFns;
+  // 64 MiB of bits on huge pages, faulted in up front
+  typedef page_allocator<size_t, 64,
+			 transparent_huge_pages | prefault_pages> pages;
+  dynamic_bloom_filter<size_t, HashFns, size_t, pages>
+    bloom(static_cast<size_t>(1) << 29);
+  dynamic_counting_bloom_filter<size_t, 4, HashFns, size_t, pages>
+    counting(static_cast<size_t>(1) << 22);
+
+  BOOST_CHECK(bloom.empty());
+  BOOST_CHECK(counting.empty());
+
+  for (size_t i = 0; i < 10000; ++i) {
+    bloom.insert(i);
+    counting.insert(i);
+  }
+
+  for (size_t i = 0; i < 10000; ++i) {
+    BOOST_CHECK(bloom.probably_contains(i));
+    BOOST_CHECK(counting.probably_contains(i));
+  }
+
+  dynamic_bloom_filter<size_t, HashFns, size_t, pages> copy(bloom);
+  BOOST_CHECK(copy == bloom);
+
+  // the fixed size filters take it through allocated_storage
+  typedef boost::bloom_filters::allocated_storage<
+    page_allocator<char, 4096> > page_storage;
+  boost::bloom_filters::basic_bloom_filter<
+    size_t, 8 * 4 * MiB, HashFns,
+    boost::bloom_filters::mask_reduction, page_storage> fixed;
+  BOOST_CHECK_EQUAL(reinterpret_cast<size_t>(&fixed.data()) % (2 * MiB), 0ul);
+  fixed.insert(3);
+  BOOST_CHECK(fixed.probably_contains(3));
+}
@@ -0,0 +1,132 @@
+//////////////////////////////////////////////////////////////////////////////
+//
+// (C) Copyright Alejandro Cabrera 2011.
+// Distributed under the Boost
+// Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or
+// copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// See http://www.boost.org/libs/bloom_filter for documentation.
+//
+//////////////////////////////////////////////////////////////////////////////
+
+#define BOOST_TEST_DYN_LINK 1
+#define BOOST_TEST_MODULE "Boost Bloom Filter" 1
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <boost/bloom_filter/basic_bloom_filter.hpp>
+#include <boost/bloom_filter/dynamic_bloom_filter.hpp>
+#include <boost/bloom_filter/parallel_build.hpp>
+#include <boost/bloom_filter/twohash_dynamic_basic_bloom_filter.hpp>
+#include <boost/bloom_filter/hash/murmurhash3.hpp>
+#include <boost/lexical_cast.hpp>
+#include <boost/test/unit_test.hpp>
+
+using namespace boost::bloom_filters;
+
+typedef boost::mpl::vector<murmurhash3<size_t, 1>,
+			   murmurhash3<size_t, 2>,
+			   murmurhash3<size_t, 3> > ThreeHashes;
+
+// throws for one key, as a hash function of keys it can't hash might
+struct throwing_hash {
+  size_t operator()(const size_t key) const {
+    if (key == 12345 * 7919)
+      throw std::runtime_error("unhashable");
+    return key;
+  }
+};
+
+static std::vector<size_t> make_keys(const size_t n)
+{
+  std::vector<size_t> keys;
+  for (size_t i = 0; i < n; ++i)
+    keys.push_back(i * 7919);
+  return keys;
+}
+
+BOOST_AUTO_TEST_CASE(dynamicSetsTheBitsOfInsert) {
+  const std::vector<size_t> keys = make_keys(100000);
+  dynamic_bloom_filter<size_t, ThreeHashes> serial(1000003);
+  serial.insert(keys.begin(), keys.end());
+
+  for (size_t threads = 1; threads <= 8; ++threads) {
+    dynamic_bloom_filter<size_t, ThreeHashes> parallel(1000003);
+    parallel_insert(parallel, keys.begin(), keys.end(), threads);
+    BOOST_CHECK(parallel == serial);
+    BOOST_CHECK_EQUAL(parallel.count(), serial.count());
+  }
+}
+
+BOOST_AUTO_TEST_CASE(addsToWhatIsThere) {
+  const std::vector<size_t> keys = make_keys(50000);
+  dynamic_bloom_filter<size_t, ThreeHashes> serial(200000);
+  dynamic_bloom_filter<size_t, ThreeHashes> parallel(200000);
+  serial.insert(keys.begin(), keys.end());
+  parallel.insert(keys.begin(), keys.begin() + 1000);
+
+  parallel_insert(parallel, keys.begin() + 1000, keys.end(), 4);
+  BOOST_CHECK(parallel == serial);
+  BOOST_CHECK_EQUAL(parallel.count(), serial.count());
+}
+
+BOOST_AUTO_TEST_CASE(fixedSizeAndTwohash) {
+  const std::vector<size_t> keys = make_keys(3000);
+
+  basic_bloom_filter<size_t, 65536, ThreeHashes> basic_serial;
+  basic_bloom_filter<size_t, 65536, ThreeHashes> basic_parallel;
+  basic_serial.insert(keys.begin(), keys.end());
+  parallel_insert(basic_parallel, keys.begin(), keys.end(), 3);
+  BOOST_CHECK(basic_parallel == basic_serial);
+  BOOST_CHECK_EQUAL(basic_parallel.count(), basic_serial.count());
+
+  twohash_dynamic_basic_bloom_filter<size_t, 5> twohash_serial(30011);
+  twohash_dynamic_basic_bloom_filter<size_t, 5> twohash_parallel(30011);
+  twohash_serial.insert(keys.begin(), keys.end());
+  parallel_insert(twohash_parallel, keys.begin(), keys.end(), 5);
+  BOOST_CHECK(twohash_parallel == twohash_serial);
+}
+
+BOOST_AUTO_TEST_CASE(edgeCases) {
+  std::vector<std::string> keys;
+  for (size_t i = 0; i < 100; ++i)
+    keys.push_back(boost::lexical_cast<std::string>(i));
+
+  // fewer bits than threads have parts for
+  dynamic_bloom_filter<std::string> tiny(100);
+  dynamic_bloom_filter<std::string> tiny_serial(100);
+  parallel_insert(tiny, keys.begin(), keys.end(), 16);
+  tiny_serial.insert(keys.begin(), keys.end());
+  BOOST_CHECK(tiny == tiny_serial);
+
+  dynamic_bloom_filter<std::string> none(1024);
+  parallel_insert(none, keys.begin(), keys.begin(), 4);
+  BOOST_CHECK(none.empty());
+
+  dynamic_bloom_filter<std::string> any(1024);
+  parallel_insert(any, keys.begin(), keys.end());
+  for (size_t i = 0; i < keys.size(); ++i)
+    BOOST_CHECK(any.probably_contains(keys[i]));
+}
+
+BOOST_AUTO_TEST_CASE(hashExceptionsReachTheCaller) {
+  typedef boost::mpl::vector<murmurhash3<size_t, 1>,
+			     throwing_hash> Throwing;
+  const std::vector<size_t> keys = make_keys(100000);
+
+  for (size_t threads = 1; threads <= 4; ++threads) {
+    dynamic_bloom_filter<size_t, Throwing> bloom(1000003);
+    BOOST_CHECK_THROW(parallel_insert(bloom, keys.begin(), keys.end(),
+				      threads),
+		      std::runtime_error);
+    BOOST_CHECK_EQUAL(bloom.count(),
+		      boost::bloom_filters::detail::count_bits(bloom.data()));
+
+    // the threads are gone and the filter can be used again
+    parallel_insert(bloom, keys.begin(), keys.begin() + 12345, threads);
+    for (size_t i = 0; i < 12345; ++i)
+      BOOST_CHECK(bloom.probably_contains(keys[i]));
+  }
+}
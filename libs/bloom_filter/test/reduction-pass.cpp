@@ -0,0 +1,138 @@
+//////////////////////////////////////////////////////////////////////////////
+//
+// (C) Copyright Alejandro Cabrera 2011.
+// Distributed under the Boost
+// Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or
+// copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// See http://www.boost.org/libs/bloom_filter for documentation.
+//
+//////////////////////////////////////////////////////////////////////////////
+
+#define BOOST_TEST_DYN_LINK 1
+#define BOOST_TEST_MODULE "Boost Bloom Filter" 1
+#include <vector>
+
+#include <boost/bloom_filter/reduction.hpp>
+#include <boost/bloom_filter/basic_bloom_filter.hpp>
+#include <boost/bloom_filter/dynamic_bloom_filter.hpp>
+#include <boost/bloom_filter/twohash_basic_bloom_filter.hpp>
+#include <boost/bloom_filter/twohash_dynamic_basic_bloom_filter.hpp>
+#include <boost/bloom_filter/counting_bloom_filter.hpp>
+#include <boost/bloom_filter/dynamic_counting_bloom_filter.hpp>
+#include <boost/type_traits/is_same.hpp>
+#include <boost/test/unit_test.hpp>
+
+using boost::bloom_filters::modulo_reduction;
+using boost::bloom_filters::mask_reduction;
+using boost::bloom_filters::fastrange_reduction;
+using boost::bloom_filters::default_reduction;
+using boost::bloom_filters::murmurhash3;
+
+BOOST_AUTO_TEST_CASE(moduloReduction) {
+  BOOST_CHECK_EQUAL(modulo_reduction::reduce(17, 5), 2ul);
+  BOOST_CHECK_EQUAL(modulo_reduction::reduce(4, 5), 4ul);
+  BOOST_CHECK_EQUAL(modulo_reduction::reduce(0, 1), 0ul);
+}
+
+BOOST_AUTO_TEST_CASE(maskMatchesModuloForPowersOfTwo) {
+  for (size_t range = 1; range <= 4096; range *= 2)
+    for (size_t hash = 0; hash < 1000; hash += 7)
+      BOOST_CHECK_EQUAL(mask_reduction::reduce(hash * 2654435761ul, range),
+			modulo_reduction::reduce(hash * 2654435761ul, range));
+}
+
+BOOST_AUTO_TEST_CASE(fastrangeStaysInRange) {
+  const size_t top = static_cast<size_t>(0) - 1;
+  const size_t ranges[] = {1, 3, 1000, 1ul << 20, top};
+
+  for (size_t r = 0; r < sizeof(ranges) / sizeof(ranges[0]); ++r) {
+    BOOST_CHECK_EQUAL(fastrange_reduction::reduce(0, ranges[r]), 0ul);
+    BOOST_CHECK_EQUAL(fastrange_reduction::reduce(top, ranges[r]),
+		      ranges[r] - 1);
+  }
+
+  // the top half of the hash space maps to the top half of the range
+  const size_t half = top / 2 + 1;
+  BOOST_CHECK_EQUAL(fastrange_reduction::reduce(half, 1000), 500ul);
+}
+
+BOOST_AUTO_TEST_CASE(fastrangeSpreadsEvenly) {
+  static const size_t range = 10;
+  std::vector<size_t> histogram(range, 0);
+  murmurhash3<size_t> hasher;
+
+  for (size_t i = 0; i < 10000; ++i)
+    ++histogram[fastrange_reduction::reduce(hasher(i), range)];
+
+  for (size_t i = 0; i < range; ++i) {
+    BOOST_CHECK_GT(histogram[i], 900ul);
+    BOOST_CHECK_LT(histogram[i], 1100ul);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(defaultReduction) {
+  BOOST_CHECK((boost::is_same<default_reduction<1>::type,
+	                      mask_reduction>::value));
+  BOOST_CHECK((boost::is_same<default_reduction<1024>::type,
+	                      mask_reduction>::value));
+  BOOST_CHECK((boost::is_same<default_reduction<1000>::type,
+	                      modulo_reduction>::value));
+
+  typedef boost::bloom_filters::basic_bloom_filter<int, 64> pow2_bloom;
+  typedef boost::bloom_filters::basic_bloom_filter<int, 100> other_bloom;
+  typedef boost::bloom_filters::dynamic_bloom_filter<int> dynamic_bloom;
+
+  BOOST_CHECK((boost::is_same<pow2_bloom::reduction_type,
+	                      mask_reduction>::value));
+  BOOST_CHECK((boost::is_same<other_bloom::reduction_type,
+	                      modulo_reduction>::value));
+  BOOST_CHECK((boost::is_same<dynamic_bloom::reduction_type,
+	                      modulo_reduction>::value));
+}
+
+template <typename Bloom>
+void checkNoFalseNegatives(Bloom& bloom) {
+  for (size_t i = 0; i < 100; ++i)
+    bloom.insert(i);
+
+  for (size_t i = 0; i < 100; ++i)
+    BOOST_CHECK_EQUAL(bloom.probably_contains(i), true);
+}
+
+BOOST_AUTO_TEST_CASE(filtersUseReduction) {
+  using namespace boost::bloom_filters;
+  typedef boost::mpl::vector<murmurhash3<size_t, 1>,
+			     murmurhash3<size_t, 2> > hashes;
+
+  basic_bloom_filter<size_t, 1000, hashes, fastrange_reduction> b1;
+  dynamic_bloom_filter<size_t, hashes, size_t,
+		       std::allocator<size_t>, mask_reduction> b2(1024);
+  twohash_basic_bloom_filter<size_t, 1000, 3, 0,
+			     murmurhash3<size_t, 1>, murmurhash3<size_t, 2>,
+			     detail::square, fastrange_reduction> b3;
+  twohash_dynamic_basic_bloom_filter<size_t, 3, 0,
+				     murmurhash3<size_t, 1>,
+				     murmurhash3<size_t, 2>,
+				     detail::square, size_t,
+				     std::allocator<size_t>,
+				     fastrange_reduction> b4(1000);
+  counting_bloom_filter<size_t, 1000, 4, hashes, size_t,
+			fastrange_reduction> b5;
+  dynamic_counting_bloom_filter<size_t, 4, hashes, size_t,
+				std::allocator<size_t>,
+				mask_reduction> b6(1024);
+
+  checkNoFalseNegatives(b1);
+  checkNoFalseNegatives(b2);
+  checkNoFalseNegatives(b3);
+  checkNoFalseNegatives(b4);
+  checkNoFalseNegatives(b5);
+  checkNoFalseNegatives(b6);
+
+  // a multiply-shift doesn't have to put keys where % did
+  basic_bloom_filter<size_t, 1000, hashes, modulo_reduction> b7;
+  checkNoFalseNegatives(b7);
+  BOOST_CHECK(b1.data() != b7.data());
+}
@@ -0,0 +1,492 @@
+//////////////////////////////////////////////////////////////////////////////
+//
+// (C) Copyright Alejandro Cabrera 2011.
+// Distributed under the Boost
+// Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or
+// copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// See http://www.boost.org/libs/bloom_filter for documentation.
+//
+//////////////////////////////////////////////////////////////////////////////
+
+#define BOOST_TEST_DYN_LINK 1
+#define BOOST_TEST_MODULE "Boost Bloom Filter" 1
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <boost/bloom_filter/basic_bloom_filter.hpp>
+#include <boost/bloom_filter/blocked_bloom_filter.hpp>
+#include <boost/bloom_filter/counting_bloom_filter.hpp>
+#include <boost/bloom_filter/dynamic_bloom_filter.hpp>
+#include <boost/bloom_filter/dynamic_counting_bloom_filter.hpp>
+#include <boost/bloom_filter/mapped_file.hpp>
+#include <boost/bloom_filter/serialization.hpp>
+#include <boost/bloom_filter/twohash_basic_bloom_filter.hpp>
+#include <boost/bloom_filter/twohash_counting_bloom_filter.hpp>
+#include <boost/bloom_filter/twohash_dynamic_basic_bloom_filter.hpp>
+#include <boost/bloom_filter/twohash_dynamic_counting_bloom_filter.hpp>
+#include <boost/test/unit_test.hpp>
+
+using namespace boost::bloom_filters;
+using boost::bloom_filters::detail::serialization_exception;
+
+typedef boost::mpl::vector<boost_hash<size_t, 1>,
+			   boost_hash<size_t, 2>,
+			   boost_hash<size_t, 3> > ThreeHashes;
+typedef boost::mpl::vector<boost_hash<size_t, 1> > OneHash;
+
+// saves filter, loads it into a default constructed filter of the same
+// type, and checks that nothing was lost
+template <typename Filter>
+void round_trip(Filter& filter)
+{
+  for (size_t i = 0; i < 200; ++i)
+    filter.insert(i * 7);
+
+  std::stringstream stream;
+  save(filter, stream);
+  BOOST_CHECK_EQUAL(stream.str().size(), serialized_size(filter));
+  BOOST_CHECK_EQUAL(stream.str().size() % 8, 0ul);
+
+  Filter loaded;
+  load(loaded, stream);
+  BOOST_CHECK(loaded == filter);
+  BOOST_CHECK_EQUAL(loaded.count(), filter.count());
+  BOOST_CHECK_EQUAL(loaded.num_hash_functions(),
+		    filter.num_hash_functions());
+  for (size_t i = 0; i < 200; ++i)
+    BOOST_CHECK(loaded.probably_contains(i * 7));
+}
+
+BOOST_AUTO_TEST_CASE(everyFilterRoundTrips) {
+  basic_bloom_filter<size_t, 4096, ThreeHashes> basic;
+  counting_bloom_filter<size_t, 1000, 4, ThreeHashes> counting;
+  dynamic_bloom_filter<size_t, ThreeHashes> dynamic(10007);
+  dynamic_counting_bloom_filter<size_t, 4, ThreeHashes> dynamic_counting(999);
+  twohash_basic_bloom_filter<size_t, 4096, 3> twohash;
+  twohash_counting_bloom_filter<size_t, 1000> twohash_counting;
+  twohash_dynamic_basic_bloom_filter<size_t> twohash_dynamic(5003);
+  twohash_dynamic_counting_bloom_filter<size_t> twohash_dynamic_counting(777);
+  blocked_bloom_filter<size_t> blocked(8192);
+
+  round_trip(basic);
+  round_trip(counting);
+  round_trip(dynamic);
+  round_trip(dynamic_counting);
+  round_trip(twohash);
+  round_trip(twohash_counting);
+  round_trip(twohash_dynamic);
+  round_trip(twohash_dynamic_counting);
+  round_trip(blocked);
+}
+
+BOOST_AUTO_TEST_CASE(loadedCountersKeepCounting) {
+  dynamic_counting_bloom_filter<size_t, 4, ThreeHashes> counting(500);
+  counting.insert(1);
+  counting.insert(1);
+
+  std::stringstream stream;
+  save(counting, stream);
+  dynamic_counting_bloom_filter<size_t, 4, ThreeHashes> loaded;
+  load(loaded, stream);
+
+  BOOST_CHECK_EQUAL(loaded.num_bins(), 500ul);
+  loaded.remove(1);
+  BOOST_CHECK(loaded.probably_contains(1));
+  loaded.remove(1);
+  BOOST_CHECK(loaded.empty());
+}
+
+BOOST_AUTO_TEST_CASE(fixedAndDynamicShareTheirBits) {
+  basic_bloom_filter<size_t, 8192, ThreeHashes> fixed;
+  for (size_t i = 0; i < 300; ++i)
+    fixed.insert(i);
+
+  std::stringstream stream;
+  save(fixed, stream);
+  dynamic_bloom_filter<size_t, ThreeHashes> dynamic;
+  load(dynamic, stream);
+  BOOST_CHECK_EQUAL(dynamic.bit_capacity(), 8192ul);
+  BOOST_CHECK_EQUAL(dynamic.count(), fixed.count());
+  for (size_t i = 0; i < 300; ++i)
+    BOOST_CHECK(dynamic.probably_contains(i));
+
+  basic_bloom_filter<size_t, 8192, ThreeHashes> back;
+  std::stringstream again;
+  save(dynamic, again);
+  load(back, again);
+  BOOST_CHECK(back == fixed);
+
+  // but a fixed filter only takes its own size
+  dynamic_bloom_filter<size_t, ThreeHashes> other_size(4096);
+  std::stringstream smaller;
+  save(other_size, smaller);
+  BOOST_CHECK_THROW(load(back, smaller), serialization_exception);
+  BOOST_CHECK(back == fixed);
+}
+
+BOOST_AUTO_TEST_CASE(buffers) {
+  twohash_dynamic_counting_bloom_filter<size_t, 4, 3> filter(1000);
+  for (size_t i = 0; i < 100; ++i)
+    filter.insert(i);
+
+  std::vector<char> buffer(serialized_size(filter));
+  BOOST_CHECK_EQUAL(save(filter, &buffer[0], buffer.size()), buffer.size());
+  BOOST_CHECK_THROW(save(filter, &buffer[0], buffer.size() - 1),
+		    serialization_exception);
+
+  const std::vector<char>& image = buffer;
+  twohash_dynamic_counting_bloom_filter<size_t, 4, 3> loaded;
+  BOOST_CHECK_EQUAL(load(loaded, &image[0], image.size()), image.size());
+  BOOST_CHECK(loaded == filter);
+
+  BOOST_CHECK_THROW(load(loaded, &image[0], image.size() - 8),
+		    serialization_exception);
+  BOOST_CHECK_THROW(load(loaded, &image[0], 10), serialization_exception);
+}
+
+BOOST_AUTO_TEST_CASE(severalFiltersInOneStream) {
+  dynamic_bloom_filter<size_t, ThreeHashes, unsigned char> a(13);
+  dynamic_bloom_filter<size_t, ThreeHashes, unsigned char> b(1001);
+  a.insert(1);
+  b.insert(2);
+
+  std::stringstream stream;
+  save(a, stream);
+  save(b, stream);
+
+  dynamic_bloom_filter<size_t, ThreeHashes, unsigned char> first, second;
+  load(first, stream);
+  load(second, stream);
+  BOOST_CHECK(first == a);
+  BOOST_CHECK(second == b);
+}
+
+BOOST_AUTO_TEST_CASE(blockTypeDoesNotChangeTheBits) {
+  dynamic_bloom_filter<size_t, ThreeHashes, unsigned char> bytes(1001);
+  blocked_bloom_filter<size_t, 4, murmurhash3<size_t>,
+		       unsigned short> shorts(2048);
+  for (size_t i = 0; i < 50; ++i) {
+    bytes.insert(i);
+    shorts.insert(i);
+  }
+
+  std::stringstream stream;
+  save(bytes, stream);
+  save(shorts, stream);
+
+  dynamic_bloom_filter<size_t, ThreeHashes, boost::uint64_t> words;
+  blocked_bloom_filter<size_t> wide;
+  load(words, stream);
+  load(wide, stream);
+  BOOST_CHECK_EQUAL(words.count(), bytes.count());
+  BOOST_CHECK_EQUAL(wide.count(), shorts.count());
+  for (size_t i = 0; i < 50; ++i) {
+    BOOST_CHECK(words.probably_contains(i));
+    BOOST_CHECK(wide.probably_contains(i));
+  }
+
+  // the bins of a counting filter depend on it
+  dynamic_counting_bloom_filter<size_t, 4, ThreeHashes, unsigned int> ints;
+  std::stringstream counters;
+  save(dynamic_counting_bloom_filter<size_t, 4, ThreeHashes>(64), counters);
+  BOOST_CHECK_THROW(load(ints, counters), serialization_exception);
+}
+
+BOOST_AUTO_TEST_CASE(runtimeHashValuesAreRestored) {
+  twohash_dynamic_basic_bloom_filter<size_t, runtime_hash_values>
+    filter(1000, 0.0001);
+  BOOST_CHECK(filter.num_hash_functions() > 2);
+  filter.insert(5);
+
+  std::stringstream stream;
+  save(filter, stream);
+  twohash_dynamic_basic_bloom_filter<size_t, runtime_hash_values> loaded;
+  load(loaded, stream);
+  BOOST_CHECK_EQUAL(loaded.num_hash_functions(),
+		    filter.num_hash_functions());
+  BOOST_CHECK(loaded == filter);
+}
+
+BOOST_AUTO_TEST_CASE(mismatchesAreRejected) {
+  dynamic_bloom_filter<size_t, ThreeHashes> filter(256);
+  filter.insert(3);
+  std::stringstream stream;
+  save(filter, stream);
+  const std::string image = stream.str();
+
+  typedef boost::mpl::vector<boost_hash<size_t, 1>,
+			     boost_hash<size_t, 2>,
+			     boost_hash<size_t, 4> > OtherSeed;
+  typedef boost::mpl::vector<boost_hash<size_t, 1>,
+			     boost_hash<size_t, 2> > TwoHashes;
+
+  dynamic_bloom_filter<size_t, OtherSeed> other_seed(16);
+  dynamic_bloom_filter<size_t, TwoHashes> two_hashes(16);
+  dynamic_bloom_filter<size_t, ThreeHashes, size_t, std::allocator<size_t>,
+		       fastrange_reduction> fastrange(16);
+  dynamic_counting_bloom_filter<size_t, 4, ThreeHashes> counting(16);
+  twohash_dynamic_basic_bloom_filter<size_t> twohash(16);
+
+  std::istringstream in1(image), in2(image), in3(image), in4(image),
+    in5(image);
+  BOOST_CHECK_THROW(load(other_seed, in1), serialization_exception);
+  BOOST_CHECK_THROW(load(two_hashes, in2), serialization_exception);
+  BOOST_CHECK_THROW(load(fastrange, in3), serialization_exception);
+  BOOST_CHECK_THROW(load(counting, in4), serialization_exception);
+  BOOST_CHECK_THROW(load(twohash, in5), serialization_exception);
+
+  // a filter that can't take the saved one is left as it was
+  BOOST_CHECK_EQUAL(other_seed.bit_capacity(), 16ul);
+  BOOST_CHECK_EQUAL(counting.num_bins(), 16ul);
+
+  // nor can it take junk, or a filter cut short
+  std::istringstream junk("not a filter at all, not by a long way, no");
+  std::istringstream cut(image.substr(0, image.size() - 8));
+  dynamic_bloom_filter<size_t, ThreeHashes> target;
+  BOOST_CHECK_THROW(load(target, junk), serialization_exception);
+  BOOST_CHECK_THROW(load(target, cut), serialization_exception);
+}
+
+BOOST_AUTO_TEST_CASE(wireFormat) {
+  dynamic_bloom_filter<size_t, ThreeHashes, unsigned short> filter(100);
+  for (size_t i = 0; i < 10; ++i)
+    filter.insert(i);
+
+  std::stringstream stream;
+  save(filter, stream);
+  const std::string image = stream.str();
+  const unsigned char *const bytes =
+    reinterpret_cast<const unsigned char *>(image.data());
+
+  BOOST_CHECK_EQUAL(image.size(), 64ul + 16ul);
+  BOOST_CHECK_EQUAL(image.substr(0, 8), std::string("bstbloom"));
+  BOOST_CHECK_EQUAL(bytes[8], 1);
+  BOOST_CHECK_EQUAL(bytes[9], 0);
+  BOOST_CHECK_EQUAL(bytes[13], sizeof(unsigned short));
+  BOOST_CHECK_EQUAL(bytes[16], 3);
+  BOOST_CHECK_EQUAL(bytes[24], 100);
+  BOOST_CHECK_EQUAL(bytes[25], 0);
+
+  // bit i is bit i % 8 of byte i / 8
+  for (size_t i = 0; i < 100; ++i)
+    BOOST_CHECK_EQUAL(filter.data()[i],
+		      ((bytes[64 + i / 8] >> (i % 8)) & 1) != 0);
+}
+
+BOOST_AUTO_TEST_CASE(loadInPlace) {
+  typedef dynamic_bloom_filter<size_t, ThreeHashes, size_t,
+			       mapped_file> MappedBloom;
+  typedef dynamic_counting_bloom_filter<size_t, 4, ThreeHashes, size_t,
+					mapped_file> MappedCounting;
+
+  dynamic_bloom_filter<size_t, ThreeHashes> filter(10007);
+  for (size_t i = 0; i < 500; ++i)
+    filter.insert(i);
+
+  // size_t storage keeps the buffer aligned for the blocks
+  const size_t size = serialized_size(filter);
+  std::vector<size_t> storage(size / sizeof(size_t));
+  char *const buffer = reinterpret_cast<char *>(&storage[0]);
+  save(filter, buffer, size);
+
+  MappedBloom in_place;
+  BOOST_CHECK_EQUAL(load_in_place(in_place, buffer, size), size);
+  BOOST_CHECK_EQUAL(in_place.bit_capacity(), 10007ul);
+  BOOST_CHECK_EQUAL(in_place.count(), filter.count());
+  for (size_t i = 0; i < 500; ++i)
+    BOOST_CHECK(in_place.probably_contains(i));
+
+  // the filter is the buffer
+  in_place.insert(100000);
+  dynamic_bloom_filter<size_t, ThreeHashes> reloaded;
+  load(reloaded, buffer, size);
+  BOOST_CHECK(reloaded.probably_contains(100000));
+
+  // copies are the filter's own
+  MappedBloom copy(in_place);
+  copy.insert(100001);
+  load(reloaded, buffer, size);
+  BOOST_CHECK_EQUAL(reloaded.count(), in_place.count());
+
+  // blocks that aren't aligned can't be used in place
+  std::vector<char> shifted(size + 1);
+  std::copy(buffer, buffer + size, shifted.begin() + 1);
+  BOOST_CHECK_THROW(load_in_place(in_place, &shifted[1], size),
+		    serialization_exception);
+
+  dynamic_counting_bloom_filter<size_t, 4, ThreeHashes> counting(300);
+  counting.insert(7);
+  std::vector<size_t> counters(serialized_size(counting) / sizeof(size_t));
+  save(counting, &counters[0], counters.size() * sizeof(size_t));
+
+  MappedCounting counting_in_place;
+  load_in_place(counting_in_place, &counters[0],
+		counters.size() * sizeof(size_t));
+  BOOST_CHECK_EQUAL(counting_in_place.num_bins(), 300ul);
+  counting_in_place.remove(7);
+  BOOST_CHECK(counting_in_place.empty());
+}
+
+BOOST_AUTO_TEST_CASE(savedFilesCanBeMapped) {
+  const std::string name = "serialization-pass.bloom";
+  dynamic_bloom_filter<size_t, ThreeHashes> filter(4099);
+  for (size_t i = 0; i < 100; ++i)
+    filter.insert(i);
+  {
+    std::ofstream out(name.c_str(), std::ios::binary);
+    save(filter, out);
+  }
+
+  {
+    dynamic_bloom_filter<size_t, ThreeHashes, size_t, mapped_file>
+      mapped(mapped_file_params(name, mapped_read_only));
+    BOOST_CHECK_EQUAL(mapped.bit_capacity(), 4099ul);
+    BOOST_CHECK_EQUAL(mapped.count(), filter.count());
+
+    // and mapped files can be loaded
+    std::ifstream in(name.c_str(), std::ios::binary);
+    dynamic_bloom_filter<size_t, ThreeHashes> loaded;
+    load(loaded, in);
+    BOOST_CHECK(loaded == filter);
+  }
+  std::remove(name.c_str());
+}
+
+BOOST_AUTO_TEST_CASE(compressedRoundTrips) {
+  // sparse: one hash function, many bits per key
+  dynamic_bloom_filter<size_t, OneHash> sparse(100000);
+  basic_bloom_filter<size_t, 65536, ThreeHashes> fixed;
+  twohash_dynamic_basic_bloom_filter<size_t, runtime_hash_values>
+    twohash(1000, 0.05);
+  dynamic_counting_bloom_filter<size_t, 4, ThreeHashes> counting(20000);
+  for (size_t i = 0; i < 1000; ++i) {
+    sparse.insert(i * 31);
+    fixed.insert(i * 31);
+    twohash.insert(i * 31);
+    counting.insert(i * 31);
+  }
+
+  std::stringstream stream;
+  save_compressed(sparse, stream);
+  save_compressed(fixed, stream);
+  save_compressed(twohash, stream);
+  save_compressed(counting, stream);
+  BOOST_CHECK_EQUAL(stream.str().size(),
+		    compressed_size(sparse) + compressed_size(fixed) +
+		    compressed_size(twohash) + compressed_size(counting));
+  BOOST_CHECK(compressed_size(sparse) * 4 < serialized_size(sparse));
+  BOOST_CHECK(compressed_size(fixed) < serialized_size(fixed));
+
+  dynamic_bloom_filter<size_t, OneHash> sparse_loaded;
+  basic_bloom_filter<size_t, 65536, ThreeHashes> fixed_loaded;
+  twohash_dynamic_basic_bloom_filter<size_t, runtime_hash_values>
+    twohash_loaded;
+  dynamic_counting_bloom_filter<size_t, 4, ThreeHashes> counting_loaded;
+  load(sparse_loaded, stream);
+  load(fixed_loaded, stream);
+  load(twohash_loaded, stream);
+  load(counting_loaded, stream);
+  BOOST_CHECK(sparse_loaded == sparse);
+  BOOST_CHECK(fixed_loaded == fixed);
+  BOOST_CHECK(twohash_loaded == twohash);
+  BOOST_CHECK(counting_loaded == counting);
+
+  // buffers too
+  std::vector<char> buffer(compressed_size(sparse));
+  BOOST_CHECK_EQUAL(save_compressed(sparse, &buffer[0], buffer.size()),
+		    buffer.size());
+  BOOST_CHECK_THROW(save_compressed(sparse, &buffer[0], buffer.size() - 1),
+		    serialization_exception);
+  dynamic_bloom_filter<size_t, OneHash> from_buffer;
+  BOOST_CHECK_EQUAL(load(from_buffer, &buffer[0], buffer.size()),
+		    buffer.size());
+  BOOST_CHECK(from_buffer == sparse);
+}
+
+BOOST_AUTO_TEST_CASE(denseFiltersAreSavedUncompressed) {
+  dynamic_bloom_filter<size_t, ThreeHashes> dense(1000);
+  for (size_t i = 0; i < 1000; ++i)
+    dense.insert(i);
+
+  BOOST_CHECK_EQUAL(compressed_size(dense), serialized_size(dense));
+  std::stringstream stream;
+  save_compressed(dense, stream);
+  const std::string image = stream.str();
+  BOOST_CHECK_EQUAL(image[20], 0);
+
+  // and empty ones code to almost nothing
+  dynamic_bloom_filter<size_t, ThreeHashes> empty(1000000);
+  BOOST_CHECK_EQUAL(compressed_size(empty), 64ul + 16ul);
+  std::stringstream nothing;
+  save_compressed(empty, nothing);
+  dynamic_bloom_filter<size_t, ThreeHashes> loaded(5);
+  loaded.insert(1);
+  load(loaded, nothing);
+  BOOST_CHECK_EQUAL(loaded.bit_capacity(), 1000000ul);
+  BOOST_CHECK(loaded.empty());
+}
+
+BOOST_AUTO_TEST_CASE(compressedFiltersCantBeUsedInPlace) {
+  dynamic_bloom_filter<size_t, ThreeHashes> filter(100000);
+  filter.insert(1);
+  std::vector<size_t> storage(compressed_size(filter) / sizeof(size_t));
+  save_compressed(filter, &storage[0], storage.size() * sizeof(size_t));
+
+  dynamic_bloom_filter<size_t, ThreeHashes, size_t, mapped_file> in_place;
+  BOOST_CHECK_THROW(load_in_place(in_place, &storage[0],
+				  storage.size() * sizeof(size_t)),
+		    serialization_exception);
+}
+
+BOOST_AUTO_TEST_CASE(corruptGapsAreRejected) {
+  dynamic_bloom_filter<size_t, ThreeHashes> filter(100000);
+  for (size_t i = 0; i < 100; ++i)
+    filter.insert(i);
+
+  std::stringstream stream;
+  save_compressed(filter, stream);
+  const std::string image = stream.str();
+  BOOST_CHECK_EQUAL(image[20], 1);
+
+  // more set bits than were coded
+  std::string more(image);
+  more[64] = static_cast<char>(more[64] + 100);
+  dynamic_bloom_filter<size_t, ThreeHashes> loaded;
+  BOOST_CHECK_THROW(load(loaded, &more[0], more.size()),
+		    serialization_exception);
+  BOOST_CHECK(loaded.empty());
+
+  // a bit past the end of the filter
+  std::string past(image);
+  std::memset(&past[64 + 9], 0xff, past.size() - 64 - 9);
+  BOOST_CHECK_THROW(load(loaded, &past[0], past.size()),
+		    serialization_exception);
+}
+
+BOOST_AUTO_TEST_CASE(compressedCapacity) {
+  const size_t n = 10000;
+  const size_t bytes = 12000;
+
+  // uncompressed, 12000 bytes hold 96000 bits
+  BOOST_CHECK_EQUAL(compressed_bit_capacity(n, 8, 1), 8ul);
+  const size_t m = compressed_bit_capacity(n, 1, bytes);
+  BOOST_CHECK(m > 3 * bytes * 8);
+
+  // the estimate is close to what coding gives
+  dynamic_bloom_filter<size_t, boost::mpl::vector<murmurhash3<size_t> > >
+    filter(m);
+  for (size_t i = 0; i < n; ++i)
+    filter.insert(i);
+  const size_t actual = compressed_size(filter) - 64;
+  BOOST_CHECK(actual <= bytes + bytes / 100);
+  BOOST_CHECK(actual >= bytes - bytes / 100);
+
+  BOOST_CHECK_THROW(compressed_bit_capacity(0, 1, bytes),
+		    boost::bloom_filters::detail::invalid_parameter_exception);
+}
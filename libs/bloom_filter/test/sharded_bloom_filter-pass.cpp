@@ -0,0 +1,123 @@
+//////////////////////////////////////////////////////////////////////////////
+//
+// (C) Copyright Alejandro Cabrera 2011.
+// Distributed under the Boost
+// Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or
+// copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// See http://www.boost.org/libs/bloom_filter for documentation.
+//
+//////////////////////////////////////////////////////////////////////////////
+
+#define BOOST_TEST_DYN_LINK 1
+#define BOOST_TEST_MODULE "Boost Bloom Filter" 1
+#include <vector>
+
+#include <boost/bloom_filter/dynamic_bloom_filter.hpp>
+#include <boost/bloom_filter/sharded_bloom_filter.hpp>
+#include <boost/bloom_filter/hash/murmurhash3.hpp>
+#include <boost/bloom_filter/hash/wyhash.hpp>
+#include <boost/thread/thread.hpp>
+#include <boost/test/unit_test.hpp>
+
+using namespace boost::bloom_filters;
+
+typedef boost::mpl::vector<murmurhash3<size_t, 1>,
+			   murmurhash3<size_t, 2>,
+			   murmurhash3<size_t, 3> > ThreeHashes;
+
+static const size_t num_threads = 8;
+static const size_t keys_per_thread = 5000;
+
+// inserts the keys of thread into its own shard
+template <typename Sharded>
+struct writer {
+  writer(Sharded& filter, const size_t thread)
+    : filter(filter), thread(thread) {}
+
+  void operator()() const
+  {
+    std::vector<size_t> keys;
+    for (size_t i = 0; i < keys_per_thread; ++i)
+      keys.push_back(i * num_threads + thread);
+
+    if (thread % 2 == 0)
+      filter.insert(thread, keys.begin(), keys.end());
+    else
+      for (size_t i = 0; i < keys.size(); ++i)
+	filter.insert(thread, keys[i]);
+  }
+
+  Sharded& filter;
+  size_t thread;
+};
+
+BOOST_AUTO_TEST_CASE(shardsShareGeometry) {
+  sharded_bloom_filter<size_t, ThreeHashes> sharded(4, 1000, 0.01);
+  dynamic_bloom_filter<size_t, ThreeHashes> serial(1000, 0.01);
+
+  BOOST_CHECK_EQUAL(sharded.num_shards(), 4ul);
+  BOOST_CHECK_EQUAL(sharded.bit_capacity(), serial.bit_capacity());
+  for (size_t i = 0; i < sharded.num_shards(); ++i)
+    BOOST_CHECK_EQUAL(sharded.shard(i).bit_capacity(),
+		      serial.bit_capacity());
+  BOOST_CHECK(sharded.empty());
+  BOOST_CHECK_EQUAL(sharded.false_positive_rate(), 0.0);
+}
+
+BOOST_AUTO_TEST_CASE(mergedIsTheSerialFilter) {
+  typedef sharded_bloom_filter<size_t, ThreeHashes> Sharded;
+  Sharded sharded(num_threads, 400009);
+  dynamic_bloom_filter<size_t, ThreeHashes> serial(400009);
+
+  boost::thread_group threads;
+  for (size_t t = 0; t < num_threads; ++t)
+    threads.create_thread(writer<Sharded>(sharded, t));
+  threads.join_all();
+
+  for (size_t i = 0; i < num_threads * keys_per_thread; ++i) {
+    serial.insert(i);
+    BOOST_CHECK(sharded.probably_contains(i));
+  }
+
+  BOOST_CHECK(sharded.merged().empty());
+  BOOST_CHECK(sharded.merge() == serial);
+  BOOST_CHECK_EQUAL(sharded.merged().count(), serial.count());
+}
+
+BOOST_AUTO_TEST_CASE(mergedIsASnapshot) {
+  sharded_bloom_filter<size_t, ThreeHashes> sharded(2, 4096);
+  sharded.insert(0, 1);
+  sharded.insert_hash(1, sharded.hash_key(2));
+  sharded.merge();
+
+  sharded.insert(1, 3);
+  BOOST_CHECK(sharded.probably_contains(3));
+  BOOST_CHECK(sharded.merged().probably_contains(1));
+  BOOST_CHECK(sharded.merged().probably_contains(2));
+  BOOST_CHECK(!sharded.merged().probably_contains(3));
+  BOOST_CHECK(sharded.false_positive_rate() > 0.0);
+
+  sharded.clear();
+  BOOST_CHECK(sharded.empty());
+  BOOST_CHECK(sharded.merged().empty());
+}
+
+BOOST_AUTO_TEST_CASE(otherHashers) {
+  typedef boost::mpl::vector<wyhash<size_t, 1>,
+			     wyhash<size_t, 2> > TwoHashes;
+  sharded_bloom_filter<size_t, TwoHashes> a(3, 2048);
+  sharded_bloom_filter<size_t, TwoHashes> b(1, 1024);
+  for (size_t i = 0; i < 300; ++i)
+    a.insert(i % 3, i);
+  b.insert(0, 7);
+
+  for (size_t i = 0; i < 300; ++i)
+    BOOST_CHECK(a.probably_contains(i));
+
+  swap(a, b);
+  BOOST_CHECK_EQUAL(a.num_shards(), 1ul);
+  BOOST_CHECK(a.probably_contains(7));
+  BOOST_CHECK_EQUAL(b.bit_capacity(), 2048ul);
+}
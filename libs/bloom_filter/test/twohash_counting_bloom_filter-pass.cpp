@@ -427,3 +427,79 @@ BOOST_FIXTURE_TEST_CASE(inequalityOperator, PairwiseOpsFixture) {
   bloom2.insert(1);
   BOOST_CHECK_EQUAL(bloom1 != bloom2, false);
 }
+
+BOOST_AUTO_TEST_CASE(batchOperations) {
+  typedef twohash_counting_bloom_filter<size_t, 8192, 4, 3> Bloom;
+  Bloom single;
+  Bloom batch;
+  size_t keys[300];
+  boost::uint64_t out[(300 + 63) / 64];
+
+  for (size_t i = 0; i < 300; ++i)
+    keys[i] = i * 7;
+
+  single.insert(keys, keys + 150);
+  batch.insert_batch(keys, keys + 150);
+  BOOST_CHECK(single == batch);
+
+  const size_t found = batch.probably_contains_batch(keys, keys + 300, out);
+
+  size_t expected = 0;
+  for (size_t i = 0; i < 300; ++i) {
+    const bool bit = ((out[i / 64] >> (i % 64)) & 1) != 0;
+    BOOST_CHECK_EQUAL(bit, single.probably_contains(keys[i]));
+    expected += bit;
+  }
+
+  BOOST_CHECK_EQUAL(found, expected);
+  BOOST_CHECK_GE(found, 150ul);
+}
+
+BOOST_AUTO_TEST_CASE(reductionPolicy) {
+  twohash_counting_bloom_filter<size_t, 1000, 4, 3, 0,
+				murmurhash3<size_t, 1>, murmurhash3<size_t>,
+				zero, size_t,
+				boost::bloom_filters::fastrange_reduction> bloom;
+
+  for (size_t i = 0; i < 100; ++i)
+    bloom.insert(i);
+
+  for (size_t i = 0; i < 100; ++i)
+    BOOST_CHECK_EQUAL(bloom.probably_contains(i), true);
+
+  for (size_t i = 0; i < 100; ++i)
+    bloom.remove(i);
+
+  BOOST_CHECK_EQUAL(bloom.empty(), true);
+}
+
+BOOST_AUTO_TEST_CASE(preHashed) {
+  typedef twohash_counting_bloom_filter<size_t, 8192, 4, 3> Bloom;
+  typedef twohash_counting_bloom_filter<size_t, 1000, 4, 3> Other;
+  Bloom plain;
+  Bloom hashed;
+  Other other;
+
+  // one digest per key serves filters of both sizes
+  for (size_t i = 0; i < 100; ++i) {
+    const Bloom::digest_type digest = Bloom::hash_key(i * 7);
+    BOOST_CHECK(digest == Other::hash_key(i * 7));
+
+    plain.insert(i * 7);
+    hashed.insert_hash(digest);
+    other.insert_hash(digest);
+  }
+
+  BOOST_CHECK(plain == hashed);
+
+  for (size_t i = 0; i < 100; ++i) {
+    BOOST_CHECK_EQUAL(hashed.probably_contains_hash(Bloom::hash_key(i * 7)),
+		      true);
+    BOOST_CHECK_EQUAL(other.probably_contains(i * 7), true);
+  }
+
+  for (size_t i = 0; i < 100; ++i)
+    hashed.remove_hash(Bloom::hash_key(i * 7));
+
+  BOOST_CHECK(hashed.empty());
+}
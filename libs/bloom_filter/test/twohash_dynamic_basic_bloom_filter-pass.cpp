@@ -12,8 +12,10 @@
 
 #define BOOST_TEST_DYN_LINK 1
 #define BOOST_TEST_MODULE "Boost Bloom Filter" 1
+#include <utility>
 
 #include <boost/bloom_filter/twohash_dynamic_basic_bloom_filter.hpp>
+#include <boost/type_traits/is_nothrow_move_constructible.hpp>
 #include <boost/test/unit_test.hpp>
 #include <boost/test/floating_point_comparison.hpp>
 
@@ -22,6 +24,8 @@ using boost::bloom_filters::boost_hash;
 using boost::bloom_filters::murmurhash3;
 using boost::bloom_filters::detail::cube;
 using boost::bloom_filters::detail::incompatible_size_exception;
+using boost::bloom_filters::detail::invalid_parameter_exception;
+using boost::bloom_filters::runtime_hash_values;
 
 BOOST_AUTO_TEST_CASE(defaultConstructor) {
   twohash_dynamic_basic_bloom_filter<int> bloom;
@@ -148,6 +152,13 @@ BOOST_AUTO_TEST_CASE(num_hash_values)
   BOOST_CHECK_EQUAL(bloom_8h.num_hash_functions(), 8ul);
   BOOST_CHECK_EQUAL(bloom_256h.num_hash_functions(), 256ul);
   BOOST_CHECK_EQUAL(bloom_2048h.num_hash_functions(), 2048ul);
+
+  // a fixed number of hash values is known from the type alone
+  typedef twohash_dynamic_basic_bloom_filter<size_t, 8> Bloom;
+#ifndef BOOST_NO_CXX11_CONSTEXPR
+  BOOST_STATIC_ASSERT(Bloom::num_hash_functions() == 8);
+#endif
+  BOOST_CHECK_EQUAL(Bloom::num_hash_functions(), 8ul);
 }
 
 BOOST_AUTO_TEST_CASE(expected_insertion_count)
@@ -404,3 +415,214 @@ BOOST_AUTO_TEST_CASE(exceptionThrown_equality)
 
   BOOST_CHECK_EQUAL(exceptionThrown, true);
 }
+
+BOOST_AUTO_TEST_CASE(batchOperations) {
+  typedef twohash_dynamic_basic_bloom_filter<size_t, 3> Bloom;
+  Bloom single(4096);
+  Bloom batch(4096);
+  size_t keys[300];
+  boost::uint64_t out[(300 + 63) / 64];
+
+  for (size_t i = 0; i < 300; ++i)
+    keys[i] = i * 7;
+
+  single.insert(keys, keys + 150);
+  batch.insert_batch(keys, keys + 150);
+  BOOST_CHECK(single == batch);
+
+  const size_t found = batch.probably_contains_batch(keys, keys + 300, out);
+
+  size_t expected = 0;
+  for (size_t i = 0; i < 300; ++i) {
+    const bool bit = ((out[i / 64] >> (i % 64)) & 1) != 0;
+    BOOST_CHECK_EQUAL(bit, single.probably_contains(keys[i]));
+    expected += bit;
+  }
+
+  BOOST_CHECK_EQUAL(found, expected);
+  BOOST_CHECK_GE(found, 150ul);
+}
+
+BOOST_AUTO_TEST_CASE(preHashed) {
+  typedef twohash_dynamic_basic_bloom_filter<size_t, 3> Bloom;
+  typedef Bloom Other;
+  Bloom plain(4096);
+  Bloom hashed(4096);
+  Other other(1000);
+
+  // one digest per key serves filters of both sizes
+  for (size_t i = 0; i < 100; ++i) {
+    const Bloom::digest_type digest = Bloom::hash_key(i * 7);
+    BOOST_CHECK(digest == Other::hash_key(i * 7));
+
+    plain.insert(i * 7);
+    hashed.insert_hash(digest);
+    other.insert_hash(digest);
+  }
+
+  BOOST_CHECK(plain == hashed);
+
+  for (size_t i = 0; i < 100; ++i) {
+    BOOST_CHECK_EQUAL(hashed.probably_contains_hash(Bloom::hash_key(i * 7)),
+		      true);
+    BOOST_CHECK_EQUAL(other.probably_contains(i * 7), true);
+  }
+}
+
+template <typename Bloom>
+size_t falsePositives(Bloom& bloom, const size_t n, const size_t tries)
+{
+  for (size_t i = 0; i < n; ++i)
+    bloom.insert(i);
+
+  size_t false_positives = 0;
+  for (size_t i = n; i < n + tries; ++i)
+    false_positives += bloom.probably_contains(i);
+
+  return false_positives;
+}
+
+BOOST_AUTO_TEST_CASE(sizedForRate) {
+  // the number of hash values is chosen with the size: 7 for 1%
+  typedef twohash_dynamic_basic_bloom_filter<size_t,
+					     runtime_hash_values> Bloom;
+  Bloom bloom(1000, 0.01);
+  BOOST_CHECK_EQUAL(bloom.num_hash_functions(), 7ul);
+  BOOST_CHECK_GE(bloom.bit_capacity(), 9500ul);
+  BOOST_CHECK_LE(bloom.bit_capacity(), 9700ul);
+  BOOST_CHECK_LT(falsePositives(bloom, 1000, 20000), 260ul);
+
+  Bloom strict(1000, 0.0001);
+  BOOST_CHECK_EQUAL(strict.num_hash_functions(), 13ul);
+  BOOST_CHECK_LT(falsePositives(strict, 1000, 100000), 20ul);
+
+  // a fixed number of hash values keeps it; only the size is chosen
+  twohash_dynamic_basic_bloom_filter<size_t, 3> fixed(1000, 0.01);
+  BOOST_CHECK_EQUAL(fixed.num_hash_functions(), 3ul);
+  BOOST_CHECK_GE(fixed.bit_capacity(), 12300ul);
+  BOOST_CHECK_LE(fixed.bit_capacity(), 12400ul);
+  BOOST_CHECK_LT(falsePositives(fixed, 1000, 20000), 260ul);
+
+  BOOST_CHECK_THROW(Bloom(0, 0.01), invalid_parameter_exception);
+  BOOST_CHECK_THROW(Bloom(1000, 1.5), invalid_parameter_exception);
+}
+
+BOOST_AUTO_TEST_CASE(runtimeHashValuesFromSize) {
+  // without a rate, optimal for ExpectedInsertionCount keys if given
+  twohash_dynamic_basic_bloom_filter<size_t, runtime_hash_values> plain(4096);
+  twohash_dynamic_basic_bloom_filter<size_t, runtime_hash_values,
+				     1000> expected(9586);
+
+  BOOST_CHECK_EQUAL(plain.num_hash_functions(), 2ul);
+  BOOST_CHECK_EQUAL(expected.num_hash_functions(), 7ul);
+}
+
+BOOST_AUTO_TEST_CASE(runtimeHashValuesOps) {
+  typedef twohash_dynamic_basic_bloom_filter<size_t,
+					     runtime_hash_values> Bloom;
+  Bloom single(2000, 0.001);
+  Bloom batch(2000, 0.001);
+  Bloom hashed(2000, 0.001);
+  size_t keys[300];
+  boost::uint64_t out[(300 + 63) / 64];
+
+  for (size_t i = 0; i < 300; ++i)
+    keys[i] = i * 7;
+
+  single.insert(keys, keys + 150);
+  batch.insert_batch(keys, keys + 150);
+  for (size_t i = 0; i < 150; ++i)
+    hashed.insert_hash(Bloom::hash_key(keys[i]));
+
+  BOOST_CHECK(single == batch);
+  BOOST_CHECK(single == hashed);
+  BOOST_CHECK_EQUAL(single.num_hash_functions(), 10ul);
+  BOOST_CHECK_GT(single.count(), 1400ul);
+
+  const size_t found = batch.probably_contains_batch(keys, keys + 300, out);
+
+  size_t expected = 0;
+  for (size_t i = 0; i < 300; ++i) {
+    const bool bit = ((out[i / 64] >> (i % 64)) & 1) != 0;
+    BOOST_CHECK_EQUAL(bit, single.probably_contains(keys[i]));
+    BOOST_CHECK_EQUAL(bit, hashed.probably_contains_hash(
+			     Bloom::hash_key(keys[i])));
+    expected += bit;
+  }
+
+  BOOST_CHECK_EQUAL(found, expected);
+  BOOST_CHECK_EQUAL(found, 150ul);
+
+  // same size, different number of hash values
+  Bloom other(single.bit_capacity());
+  BOOST_CHECK_THROW(single |= other, incompatible_size_exception);
+}
+
+BOOST_AUTO_TEST_CASE(moveAndSwap) {
+  typedef twohash_dynamic_basic_bloom_filter<size_t> Bloom;
+  Bloom a(1024);
+  Bloom b(2048);
+
+  a.insert(1);
+  b.insert(2);
+
+  // swapping exchanges storage instead of copying it
+  a.swap(b);
+  BOOST_CHECK_EQUAL(a.bit_capacity(), 2048ul);
+  BOOST_CHECK_EQUAL(b.bit_capacity(), 1024ul);
+  BOOST_CHECK_EQUAL(a.probably_contains(2), true);
+  BOOST_CHECK_EQUAL(b.probably_contains(1), true);
+
+#ifndef BOOST_NO_CXX11_RVALUE_REFERENCES
+  BOOST_CHECK(boost::is_nothrow_move_constructible<Bloom>::value);
+
+  Bloom c(std::move(a));
+  BOOST_CHECK_EQUAL(c.bit_capacity(), 2048ul);
+  BOOST_CHECK_EQUAL(c.probably_contains(2), true);
+  BOOST_CHECK_EQUAL(a.bit_capacity(), 0ul);
+
+  // a moved-from filter can be assigned to again
+  a = std::move(c);
+  BOOST_CHECK_EQUAL(a.bit_capacity(), 2048ul);
+  BOOST_CHECK_EQUAL(a.probably_contains(2), true);
+  BOOST_CHECK_EQUAL(c.bit_capacity(), 0ul);
+
+  // an rvalue left operand lends its storage to the result
+  Bloom d(2048);
+  d.insert(3);
+  Bloom u = Bloom(a) | d;
+  Bloom i = std::move(u) & a;
+  BOOST_CHECK_EQUAL(u.bit_capacity(), 0ul);
+  BOOST_CHECK(i == a);
+#endif
+}
+
+BOOST_AUTO_TEST_CASE(fold) {
+  typedef twohash_dynamic_basic_bloom_filter<size_t, 3> Bloom;
+
+  Bloom big(4096), small(512), other(1024);
+  for (size_t i = 0; i < 100; ++i) {
+    big.insert(i);
+    small.insert(i);
+    other.insert(i + 1000);
+  }
+
+  big.fold(8);
+  BOOST_CHECK_EQUAL(big.bit_capacity(), 512ul);
+  BOOST_CHECK_EQUAL(big.num_hash_functions(), 3ul);
+  BOOST_CHECK(big == small);
+  BOOST_CHECK_EQUAL(big.count(), small.count());
+  BOOST_CHECK_THROW(big.fold(3), incompatible_size_exception);
+
+  // other is folded into big's size
+  big.fold_union(other);
+  BOOST_CHECK_EQUAL(big.bit_capacity(), 512ul);
+  for (size_t i = 0; i < 100; ++i) {
+    BOOST_CHECK_EQUAL(big.probably_contains(i), true);
+    BOOST_CHECK_EQUAL(big.probably_contains(i + 1000), true);
+  }
+
+  Bloom(1000).fold_union(Bloom(3000));
+  BOOST_CHECK_THROW(Bloom(1000).fold_union(Bloom(1500)),
+		    incompatible_size_exception);
+}
@@ -12,8 +12,10 @@
 
 #define BOOST_TEST_DYN_LINK 1
 #define BOOST_TEST_MODULE "Boost Bloom Filter" 1
+#include <utility>
 
 #include <boost/bloom_filter/twohash_dynamic_counting_bloom_filter.hpp>
+#include <boost/type_traits/is_nothrow_move_constructible.hpp>
 #include <boost/test/unit_test.hpp>
 #include <boost/test/floating_point_comparison.hpp>
 
@@ -25,6 +27,8 @@ using boost::bloom_filters::twohash_dynamic_counting_bloom_filter;
 using boost::bloom_filters::detail::bin_underflow_exception;
 using boost::bloom_filters::detail::bin_overflow_exception;
 using boost::bloom_filters::detail::incompatible_size_exception;
+using boost::bloom_filters::detail::invalid_parameter_exception;
+using boost::bloom_filters::runtime_hash_values;
 using boost::bloom_filters::boost_hash;
 using boost::bloom_filters::murmurhash3;
 using boost::bloom_filters::detail::zero;
@@ -243,6 +247,10 @@ BOOST_AUTO_TEST_CASE(numHashFunctions) {
   BOOST_CHECK_EQUAL(bloom_1h.num_hash_functions(), 1ul);
   BOOST_CHECK_EQUAL(bloom_2h.num_hash_functions(), 2ul);
   BOOST_CHECK_EQUAL(bloom_7h.num_hash_functions(), 7ul);
+
+  // a fixed number of hash values is known from the type alone
+  typedef twohash_dynamic_counting_bloom_filter<int, 2, 7> Bloom;
+  BOOST_CHECK_EQUAL(Bloom::num_hash_functions(), 7ul);
 }
 
 BOOST_AUTO_TEST_CASE(probably_contains) {
@@ -421,3 +429,170 @@ BOOST_FIXTURE_TEST_CASE(inequalityOperator, PairwiseOpsFixture) {
   bloom2.insert(1);
   BOOST_CHECK_EQUAL(bloom1 != bloom2, false);
 }
+
+BOOST_AUTO_TEST_CASE(batchOperations) {
+  typedef twohash_dynamic_counting_bloom_filter<size_t, 4, 3> Bloom;
+  Bloom single(8192);
+  Bloom batch(8192);
+  size_t keys[300];
+  boost::uint64_t out[(300 + 63) / 64];
+
+  for (size_t i = 0; i < 300; ++i)
+    keys[i] = i * 7;
+
+  single.insert(keys, keys + 150);
+  batch.insert_batch(keys, keys + 150);
+  BOOST_CHECK(single == batch);
+
+  const size_t found = batch.probably_contains_batch(keys, keys + 300, out);
+
+  size_t expected = 0;
+  for (size_t i = 0; i < 300; ++i) {
+    const bool bit = ((out[i / 64] >> (i % 64)) & 1) != 0;
+    BOOST_CHECK_EQUAL(bit, single.probably_contains(keys[i]));
+    expected += bit;
+  }
+
+  BOOST_CHECK_EQUAL(found, expected);
+  BOOST_CHECK_GE(found, 150ul);
+}
+
+BOOST_AUTO_TEST_CASE(reductionPolicy) {
+  twohash_dynamic_counting_bloom_filter<size_t, 4, 3, 0,
+					boost_hash<size_t>, murmurhash3<size_t>,
+					zero, size_t, std::allocator<size_t>,
+					boost::bloom_filters::mask_reduction>
+    bloom(1024);
+
+  for (size_t i = 0; i < 100; ++i)
+    bloom.insert(i);
+
+  for (size_t i = 0; i < 100; ++i)
+    BOOST_CHECK_EQUAL(bloom.probably_contains(i), true);
+
+  for (size_t i = 0; i < 100; ++i)
+    bloom.remove(i);
+
+  BOOST_CHECK_EQUAL(bloom.empty(), true);
+}
+
+BOOST_AUTO_TEST_CASE(preHashed) {
+  typedef twohash_dynamic_counting_bloom_filter<size_t, 4, 3> Bloom;
+  typedef Bloom Other;
+  Bloom plain(8192);
+  Bloom hashed(8192);
+  Other other(1000);
+
+  // one digest per key serves filters of both sizes
+  for (size_t i = 0; i < 100; ++i) {
+    const Bloom::digest_type digest = Bloom::hash_key(i * 7);
+    BOOST_CHECK(digest == Other::hash_key(i * 7));
+
+    plain.insert(i * 7);
+    hashed.insert_hash(digest);
+    other.insert_hash(digest);
+  }
+
+  BOOST_CHECK(plain == hashed);
+
+  for (size_t i = 0; i < 100; ++i) {
+    BOOST_CHECK_EQUAL(hashed.probably_contains_hash(Bloom::hash_key(i * 7)),
+		      true);
+    BOOST_CHECK_EQUAL(other.probably_contains(i * 7), true);
+  }
+
+  for (size_t i = 0; i < 100; ++i)
+    hashed.remove_hash(Bloom::hash_key(i * 7));
+
+  BOOST_CHECK(hashed.empty());
+}
+
+BOOST_AUTO_TEST_CASE(sizedForRate) {
+  typedef twohash_dynamic_counting_bloom_filter<size_t, 4,
+						runtime_hash_values> Bloom;
+  Bloom bloom(1000, 0.01);
+  BOOST_CHECK_EQUAL(bloom.num_hash_functions(), 7ul);
+  BOOST_CHECK_GE(bloom.num_bins(), 9500ul);
+  BOOST_CHECK_LE(bloom.num_bins(), 9700ul);
+
+  for (size_t i = 0; i < 1000; ++i)
+    bloom.insert(i);
+
+  size_t false_positives = 0;
+  for (size_t i = 1000; i < 21000; ++i)
+    false_positives += bloom.probably_contains(i);
+
+  BOOST_CHECK_LT(false_positives, 260ul);
+
+  // removal uses the same number of hash values
+  for (size_t i = 0; i < 1000; ++i)
+    bloom.remove(i);
+
+  BOOST_CHECK_EQUAL(bloom.empty(), true);
+  BOOST_CHECK_THROW(Bloom(1000, 0.0), invalid_parameter_exception);
+}
+
+BOOST_AUTO_TEST_CASE(runtimeHashValuesOps) {
+  typedef twohash_dynamic_counting_bloom_filter<size_t, 4,
+						runtime_hash_values> Bloom;
+  Bloom single(500, 0.001);
+  Bloom batch(500, 0.001);
+  Bloom hashed(500, 0.001);
+  size_t keys[300];
+  boost::uint64_t out[(300 + 63) / 64];
+
+  for (size_t i = 0; i < 300; ++i)
+    keys[i] = i * 7;
+
+  single.insert(keys, keys + 150);
+  batch.insert_batch(keys, keys + 150);
+  for (size_t i = 0; i < 150; ++i)
+    hashed.insert_hash(Bloom::hash_key(keys[i]));
+
+  BOOST_CHECK(single == batch);
+  BOOST_CHECK(single == hashed);
+
+  const size_t found = batch.probably_contains_batch(keys, keys + 300, out);
+  BOOST_CHECK_EQUAL(found, 150ul);
+
+  for (size_t i = 0; i < 150; ++i)
+    hashed.remove_hash(Bloom::hash_key(keys[i]));
+
+  BOOST_CHECK_EQUAL(hashed.empty(), true);
+}
+
+BOOST_AUTO_TEST_CASE(moveAndSwap) {
+  typedef twohash_dynamic_counting_bloom_filter<size_t> Bloom;
+  Bloom a(1024);
+  Bloom b(2048);
+  const size_t *const a_storage = &a.data()[0];
+  const size_t *const b_storage = &b.data()[0];
+
+  a.insert(1);
+  b.insert(2);
+
+  // swapping exchanges storage instead of copying it
+  a.swap(b);
+  BOOST_CHECK_EQUAL(a.num_bins(), 2048ul);
+  BOOST_CHECK_EQUAL(b.num_bins(), 1024ul);
+  BOOST_CHECK_EQUAL(a.probably_contains(2), true);
+  BOOST_CHECK_EQUAL(b.probably_contains(1), true);
+  BOOST_CHECK(&a.data()[0] == b_storage);
+  BOOST_CHECK(&b.data()[0] == a_storage);
+
+#ifndef BOOST_NO_CXX11_RVALUE_REFERENCES
+  BOOST_CHECK(boost::is_nothrow_move_constructible<Bloom>::value);
+
+  Bloom c(std::move(a));
+  BOOST_CHECK_EQUAL(c.num_bins(), 2048ul);
+  BOOST_CHECK_EQUAL(c.probably_contains(2), true);
+  BOOST_CHECK_EQUAL(a.num_bins(), 0ul);
+  BOOST_CHECK(&c.data()[0] == b_storage);
+
+  // a moved-from filter can be assigned to again
+  a = std::move(c);
+  BOOST_CHECK_EQUAL(a.num_bins(), 2048ul);
+  BOOST_CHECK_EQUAL(a.probably_contains(2), true);
+  BOOST_CHECK_EQUAL(c.num_bins(), 0ul);
+#endif
+}
@@ -0,0 +1,214 @@
+//////////////////////////////////////////////////////////////////////////////
+//
+// (C) Copyright Alejandro Cabrera 2011.
+// Distributed under the Boost
+// Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or
+// copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// See http://www.boost.org/libs/bloom_filter for documentation.
+//
+//////////////////////////////////////////////////////////////////////////////
+
+#define BOOST_TEST_DYN_LINK 1
+#define BOOST_TEST_MODULE "Boost Bloom Filter" 1
+#include <set>
+#include <string>
+#include <vector>
+
+#include <boost/bloom_filter/hash/wyhash.hpp>
+#include <boost/bloom_filter/hash/double_hashing.hpp>
+#include <boost/bloom_filter/basic_bloom_filter.hpp>
+#include <boost/bloom_filter/dynamic_bloom_filter.hpp>
+#include <boost/bloom_filter/twohash_basic_bloom_filter.hpp>
+#include <boost/bloom_filter/twohash_dynamic_basic_bloom_filter.hpp>
+#include <boost/endian/conversion.hpp>
+#include <boost/test/unit_test.hpp>
+
+using boost::bloom_filters::wyhash;
+using boost::bloom_filters::wyhash_128;
+
+BOOST_AUTO_TEST_CASE(deterministicAndSeeded) {
+  const std::string s("http://www.boost.org/");
+
+  BOOST_CHECK_EQUAL(wyhash<std::string>()(s), wyhash<std::string>()(s));
+  BOOST_CHECK((wyhash<std::string>()(s) != wyhash<std::string, 1>()(s)));
+  BOOST_CHECK(wyhash<size_t>()(1) != wyhash<size_t>()(2));
+}
+
+// every length takes one of the short, medium or bulk paths; none of
+// them may ignore a byte or read past the end
+BOOST_AUTO_TEST_CASE(everyLengthAndByteMatters) {
+  std::set<size_t> seen;
+  std::string text;
+
+  for (size_t len = 0; len <= 200; ++len) {
+    const std::string prefix(text);
+    BOOST_CHECK(seen.insert(wyhash<std::string>()(prefix)).second);
+
+    for (size_t i = 0; i < len; ++i) {
+      std::string flipped(prefix);
+      flipped[i] ^= 1;
+      BOOST_CHECK(wyhash<std::string>()(flipped) !=
+		  wyhash<std::string>()(prefix));
+    }
+
+    text.push_back(static_cast<char>('a' + len % 26));
+  }
+
+  // a prefix hashes the same wherever its buffer ends
+  const std::string a("0123456789abcdefghijklmnopqrstuvwxyz");
+  for (size_t len = 0; len <= a.size(); ++len)
+    BOOST_CHECK_EQUAL(wyhash<boost::string_view>()(
+			boost::string_view(a.data(), len)),
+		      wyhash<std::string>()(a.substr(0, len)));
+}
+
+BOOST_AUTO_TEST_CASE(bitsAvalanche) {
+  // flipping one input bit flips about half of the output bits
+  static const size_t keys = 1000;
+  size_t flipped = 0;
+
+  for (size_t i = 0; i < keys; ++i) {
+    const boost::uint64_t h = wyhash<size_t>()(i);
+    const boost::uint64_t g = wyhash<size_t>()(i ^ (1ul << (i % 64)));
+    for (boost::uint64_t d = h ^ g; d; d &= d - 1)
+      ++flipped;
+  }
+
+  BOOST_CHECK_GT(flipped, keys * 30);
+  BOOST_CHECK_LT(flipped, keys * 34);
+}
+
+BOOST_AUTO_TEST_CASE(wideHash) {
+  const std::string s("http://www.boost.org/");
+  const wyhash_128<std::string>::result_type wide =
+    wyhash_128<std::string>()(s);
+
+  BOOST_CHECK_EQUAL(wide.first, wyhash<std::string>()(s));
+  BOOST_CHECK(wide.first != wide.second);
+}
+
+template <size_t Seed>
+void checkKnownAnswer(const std::string& key, const boost::uint64_t first,
+		      const boost::uint64_t second = 0) {
+  wyhash<std::string, Seed> narrow;
+  wyhash_128<std::string, Seed> wide;
+  const typename wyhash_128<std::string, Seed>::result_type both =
+    wide(key);
+
+  BOOST_CHECK_EQUAL(narrow(key), static_cast<size_t>(first));
+  BOOST_CHECK_EQUAL(both.first, first);
+  if (second != 0)
+    BOOST_CHECK_EQUAL(both.second, second);
+}
+
+// against the reference wyhash.h, final 4, with its default secret.
+// wyhash_128's second half is the reference's final mix with the
+// secret's last two words.
+BOOST_AUTO_TEST_CASE(knownAnswers) {
+  // blocks are read in native order; these are little-endian values
+  if (boost::endian::order::native != boost::endian::order::little)
+    return;
+
+  // the reference's own test vectors: message i with seed i
+  checkKnownAnswer<0>("", 0x0409638ee2bde459ull);
+  checkKnownAnswer<1>("a", 0xa8412d091b5fe0a9ull);
+  checkKnownAnswer<2>("abc", 0x32dd92e4b2915153ull);
+  checkKnownAnswer<3>("message digest", 0x8619124089a3a16bull);
+  checkKnownAnswer<4>("abcdefghijklmnopqrstuvwxyz", 0x7a43afb61d7f5f40ull);
+  checkKnownAnswer<5>("ABCDEFGHIJKLMNOPQRSTUVWXYZ"
+		      "abcdefghijklmnopqrstuvwxyz0123456789",
+		      0xff42329b90e50d58ull);
+  checkKnownAnswer<6>("1234567890123456789012345678901234567890"
+		      "1234567890123456789012345678901234567890",
+		      0xc39cab13b115aad3ull);
+
+  // a..z repeated, cut at the edges of the short, medium and bulk
+  // paths
+  std::string text;
+  for (size_t i = 0; i < 100; ++i)
+    text.push_back(static_cast<char>('a' + i % 26));
+
+  checkKnownAnswer<0>(text.substr(0, 0),
+		      0x0409638ee2bde459ull, 0xd99f0cc8e1b80c02ull);
+  checkKnownAnswer<0>(text.substr(0, 3),
+		      0x02a4f1d7cb516c72ull, 0xc5d473fb33e56663ull);
+  checkKnownAnswer<0>(text.substr(0, 16),
+		      0xcfcc03b35e1ecf15ull, 0x9f8b1196bf75d92full);
+  checkKnownAnswer<0>(text.substr(0, 17),
+		      0xbb324a4c7dc9229bull, 0x56269fcd454c6639ull);
+  checkKnownAnswer<0>(text.substr(0, 48),
+		      0x9e97ee1d5db2e2caull, 0xe0d68d21865c604dull);
+  checkKnownAnswer<0>(text.substr(0, 49),
+		      0xa9c01f347e69478bull, 0x645f94128d5746d3ull);
+  checkKnownAnswer<0>(text,
+		      0xa872978b456e9e0eull, 0x4d00efa2388d39edull);
+
+  checkKnownAnswer<0x9e3779b9>(text.substr(0, 0),
+			       0xbdfcb0fcab8c46ebull, 0xc9e062a15995d30bull);
+  checkKnownAnswer<0x9e3779b9>(text.substr(0, 3),
+			       0x5d2ae17862531a74ull, 0x01984a185ec2dd51ull);
+  checkKnownAnswer<0x9e3779b9>(text.substr(0, 16),
+			       0x97d70b49ef6e0c27ull, 0x65059c9322a8bd9full);
+  checkKnownAnswer<0x9e3779b9>(text.substr(0, 17),
+			       0xc35a4d78e13d30c7ull, 0xf9c98ec65db9641dull);
+  checkKnownAnswer<0x9e3779b9>(text.substr(0, 48),
+			       0x8fc6a8305825e113ull, 0x2df67d1d59cf1c92ull);
+  checkKnownAnswer<0x9e3779b9>(text.substr(0, 49),
+			       0x918b2de60c83fdbaull, 0x1c50f504c8fb4c34ull);
+  checkKnownAnswer<0x9e3779b9>(text,
+			       0x19a41cb0ad56c1edull, 0xb50e617ff7a37ef5ull);
+}
+
+BOOST_AUTO_TEST_CASE(multiplyHigh) {
+  using boost::bloom_filters::detail::wymum;
+  boost::uint64_t a = 0xffffffffffffffffull, b = 0xffffffffffffffffull;
+  wymum(a, b);
+  BOOST_CHECK_EQUAL(a, 1ull);
+  BOOST_CHECK_EQUAL(b, 0xfffffffffffffffeull);
+
+  a = 1ull << 63;
+  b = 6;
+  wymum(a, b);
+  BOOST_CHECK_EQUAL(a, 0ull);
+  BOOST_CHECK_EQUAL(b, 3ull);
+}
+
+template <typename Bloom>
+void checkDropIn(Bloom& bloom) {
+  for (size_t i = 0; i < 500; ++i)
+    bloom.insert(i);
+
+  size_t false_positives = 0;
+  for (size_t i = 0; i < 500; ++i) {
+    BOOST_CHECK_EQUAL(bloom.probably_contains(i), true);
+    false_positives += bloom.probably_contains(i + 500);
+  }
+
+  BOOST_CHECK_LT(false_positives, 50ul);
+}
+
+BOOST_AUTO_TEST_CASE(filtersAcceptWyhash) {
+  using namespace boost::bloom_filters;
+  typedef boost::mpl::vector<wyhash<size_t, 1>,
+			     wyhash<size_t, 2>,
+			     wyhash<size_t, 3> > hashes;
+
+  basic_bloom_filter<size_t, 8192, hashes> b1;
+  dynamic_bloom_filter<size_t, hashes> b2(8192);
+  basic_bloom_filter<size_t, 8192,
+		     enhanced_double_hashing<size_t, 3,
+					     wyhash_128<size_t> > > b3;
+  twohash_basic_bloom_filter<size_t, 8192, 3, 0,
+			     wyhash<size_t, 1>, wyhash<size_t, 2> > b4;
+  twohash_dynamic_basic_bloom_filter<size_t, 3, 0,
+				     wyhash<size_t, 1>,
+				     wyhash<size_t, 2> > b5(8192);
+
+  checkDropIn(b1);
+  checkDropIn(b2);
+  checkDropIn(b3);
+  checkDropIn(b4);
+  checkDropIn(b5);
+}